@@ -6,12 +6,15 @@
  */
 
 #include <cascade/config.h>
+#include "detail/concurrent_ordered_map.hpp"
 
 #include <derecho/core/derecho.hpp>
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
 #include <derecho/persistent/Persistent.hpp>
 
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -57,6 +60,36 @@ public:
                             const typename CascadeType::ObjectType& value,
                             ICascadeContext* cascade_ctxt,
                             bool is_trigger = false) {}
+
+    /**
+     * The function returning a shared handle to the copy of a value held by a store.
+     */
+    using share_value_func_t = std::function<std::shared_ptr<const typename CascadeType::ObjectType>()>;
+
+    /**
+     * The critical data path behaviour for a value applied to the store on the critical data path of `ordered_send`.
+     * Besides the value, the observer is given a function returning a shared handle to the copy of the value held by
+     * the store, which stays valid after the key is updated or removed. The observer can keep the handle, for example,
+     * to pass the value to the off critical data path without copying it. The function can only be called during this
+     * call. The default behaviour is to call operator().
+     *
+     * @param[in]   subgroup_idx      The subgroup index
+     * @param[in]   shard_idx         The shard index
+     * @param[in]   sender_id         The node id of the sender of the K/V pair
+     * @param[in]   key               The key of the K/V pair
+     * @param[in]   value             The value of the K/V pair
+     * @param[in]   share_value       The function returning a shared handle to the stored value
+     * @param[in]   cascade_ctxt      The cascade context to be used later
+     */
+    virtual void observe_shared(const uint32_t subgroup_idx,
+                                const uint32_t shard_idx,
+                                const node_id_t sender_id,
+                                const typename CascadeType::KeyType& key,
+                                const typename CascadeType::ObjectType& value,
+                                const share_value_func_t& share_value,
+                                ICascadeContext* cascade_ctxt) {
+        (*this)(subgroup_idx,shard_idx,sender_id,key,value,cascade_ctxt,false);
+    }
 };
 
 /**
@@ -65,6 +98,15 @@ public:
  */
 using version_tuple = std::tuple<persistent::version_t, uint64_t>;
 
+/**
+ * A page of a scan: the objects in the page, the cursor to resume the scan from, and the version the page is read at.
+ * The cursor is the invalid key if the scan is complete. The version is CURRENT_VERSION if the page is read from the
+ * latest objects; otherwise, the following pages should be requested at that version to see the same state. This is
+ * the return type of CascadeStore::scan().
+ */
+template <typename KT, typename VT>
+using scan_page_tuple = std::tuple<std::vector<VT>, KT, persistent::version_t>;
+
 /**
  * @brief   The cascade store interface.
  * This interface is for different Cascade Subgroup Types which provides different persistence guarantees.
@@ -112,6 +154,35 @@ public:
      */
     virtual void put_and_forget(const VT& value, bool as_trigger) const = 0;
 
+    /**
+     * @brief   put_batch(const std::vector<VT>&, bool)
+     *
+     * Put a batch of values atomically. All values are applied under one version with one delta, or none of them is
+     * applied if any value fails the validation or the previous version verification, or if two values share the same
+     * key. Each value is verified against the state before the batch. It is validated against that state, and then
+     * against the values before it in the batch, which the state does not have yet.
+     *
+     * @param[in]   values      The K/V pair values, which must belong to this shard.
+     * @param[in]   as_trigger  The objects will NOT be used to update the K/V state.
+     *
+     * @return      a tuple including the version number (version_t) shared by all values and a timestamp in
+     *              microseconds. The version is INVALID_VERSION if the batch is rejected.
+     */
+    virtual version_tuple put_batch(const std::vector<VT>& values, bool as_trigger) const = 0;
+
+    /**
+     * @brief   put_batch_and_forget(const std::vector<VT>&, bool)
+     *
+     * Put a sequence of values under one version and one delta, ignoring any return value. Unlike put_batch, the
+     * values are not applied atomically: they are applied in order as if they were put one by one, so a key may
+     * appear more than once, and a value failing the validation or the previous version verification is dropped
+     * without affecting the others. This is how the coalesced put_and_forget writes of a client reach a shard.
+     *
+     * @param[in]   values      The K/V pair values, which must belong to this shard.
+     * @param[in]   as_trigger  The objects will NOT be used to update the K/V state.
+     */
+    virtual void put_batch_and_forget(const std::vector<VT>& values, bool as_trigger) const = 0;
+
 #ifdef ENABLE_EVALUATION
     /**
      * @brief   A function to evaluate the performance of an internal shard
@@ -160,6 +231,21 @@ public:
      */
     virtual const VT get(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const = 0;
 
+    /**
+     * @brief   multi_key_get(const std::vector<KT>&, const persistent::version_t&, const bool)
+     *
+     * Get the values of a list of keys by version in one call. Each key is resolved like in get() with exact set to
+     * false, but the stable version is resolved only once for the whole list, and the values are read in one
+     * lockless pass at that version.
+     *
+     * @param[in]   keys    The keys of the K/V pairs to be retrieved.
+     * @param[in]   ver     Version: if `version == CURRENT_VERSION`, get the latest values.
+     * @param[in]   stable  See get().
+     *
+     * @return The values in the order of the keys. An invalid value is returned for a key that is not found.
+     */
+    virtual std::vector<VT> multi_key_get(const std::vector<KT>& keys, const persistent::version_t& ver, const bool stable) const = 0;
+
     /**
      * @brief   multi_get(const KT&)
      *
@@ -249,6 +335,29 @@ public:
      */
     virtual std::vector<KT> list_keys_by_time(const std::string& prefix, const uint64_t& ts_us, const bool stable) const = 0;
 
+    /**
+     * @brief   scan(const std::string&, const persistent::version_t&, const bool, const KT&, const uint32_t&, const uint64_t&)
+     *
+     * Scan the objects matching a prefix at version in key order, one bounded page at a time. Unlike list_keys(), a
+     * page carries the objects, so the caller does not have to get them one by one, and neither the reply nor the
+     * server thread is tied up by a large shard. The null objects left by remove are skipped.
+     *
+     * @param[in]   prefix      Prefix, only the objects whose keys match this prefix are returned, like in list_keys().
+     * @param[in]   ver         The version, if `ver == CURRENT_VERSION`, scan the latest objects. See list_keys() for
+     *                          the cost of scanning an older version.
+     * @param[in]   stable      See list_keys().
+     * @param[in]   cursor      Where to resume: the cursor returned with the previous page, or the invalid key to
+     *                          start a new scan.
+     * @param[in]   max_items   The maximum number of objects in a page, 0 for no limit.
+     * @param[in]   max_bytes   The maximum serialized size of the objects in a page, 0 for no limit. A page always
+     *                          has at least one object unless the scan is complete.
+     *
+     * @return  A page, with the cursor to get the next page, or the invalid key if there are no more objects, and the
+     *          version to get the next page at, which pins a stable scan to the frontier resolved for its first page.
+     */
+    virtual scan_page_tuple<KT, VT> scan(const std::string& prefix, const persistent::version_t& ver, const bool stable,
+                                         const KT& cursor, const uint32_t& max_items, const uint64_t& max_bytes) const = 0;
+
     /**
      * @brief multi_get_size(const KT&)
      *
@@ -349,6 +458,25 @@ protected:
      */
     virtual void ordered_put_and_forget(const VT& value, bool as_trigger) = 0;
 
+    /**
+     * @brief   ordered_put_batch
+     *
+     * @param[in]   values      The K/V pair objects.
+     * @param[in]   as_trigger  If true, the values will NOT apply to the K/V state.
+     *
+     * @return  A tuple including the version number (version_t) shared by all objects and a timestamp in
+     *          microseconds.
+     */
+    virtual version_tuple ordered_put_batch(const std::vector<VT>& values, bool as_trigger) = 0;
+
+    /**
+     * @brief   ordered_put_batch_and_forget
+     *
+     * @param[in]   values      The K/V pair objects, applied in order.
+     * @param[in]   as_trigger  If true, the values will NOT apply to the K/V state.
+     */
+    virtual void ordered_put_batch_and_forget(const std::vector<VT>& values, bool as_trigger) = 0;
+
     /**
      * @brief   ordered_remove
      *
@@ -586,11 +714,40 @@ public:
     /**
      * @brief   A callback on PersistentCascadeStore::ordered_put or VolatileCascadeStore::ordered_put.
      *
-     * @param[in]   kv_map      The reference to the current shard state as a map from `KT` to `VT`.
+     * @param[in]   kv_map      The reference to the current shard state as a map from `KT` to `VT`. The validator is
+     *                          called on the predicate thread, so it is safe to use the iterator interface. In a batch,
+     *                          the validator is called again with a map of the values before it in the batch, so it
+     *                          should reject a value conflicting with any entry of the map.
      *
      * @return  Returns `true` if validation is successful, otherwise, `false`.
      */
-    virtual bool validate(const std::map<KT, VT>& kv_map) const = 0;
+    virtual bool validate(const ConcurrentOrderedMap<KT, VT>& kv_map) const = 0;
+};
+
+/**
+ * @brief   An optional interface for Cascade objects to enable zero-copy reads.
+ *
+ * If the VT type for PersistentCascadeStore/VolatileCascadeStore implements ISharedView interface, a `get` of the
+ * current version returns a view created by `create_shared_view` instead of a copy of the stored object. The view
+ * shares the ownership of the stored object through a reference-counted handle, so it stays valid after the key is
+ * updated, and the object data is copied only when the view is serialized into the RPC reply.
+ *
+ * @tparam  VT      The value type
+ */
+template <typename VT>
+class ISharedView {
+public:
+
+    /**
+     * @brief   Create a view of this object.
+     *
+     * @param[in]   self    A shared handle to this object, which the view keeps alive for as long as it needs the
+     *                      data.
+     *
+     * @return  A view that reads and serializes the same bytes as this object. Copying the view gives another view
+     *          sharing the same data; assigning a blob to a view makes it own a copy of the new data.
+     */
+    virtual VT create_shared_view(const std::shared_ptr<const VT>& self) const = 0;
 };
 
 #ifdef ENABLE_EVALUATION
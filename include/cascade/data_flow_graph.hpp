@@ -1,5 +1,6 @@
 #pragma once
 #include <cascade/config.h>
+#include <cstdint>
 #include <string>
 #include <sstream>
 #include <unordered_map>
@@ -49,6 +50,10 @@ namespace cascade {
  *                 {"udl_config_op1":"val1","udl_config_op2":"val2"},
  *                 {"udl_config_op1":"val1","udl_config_op2":"val2"}
  *             ],
+ *             "user_defined_logic_batch_list": [
+ *                 {"max_batch_size":32,"max_wait_us":500},
+ *                 {}
+ *             ],
  *             "destinations": [
  *                 {"/pool1.1/":"put","/pool1.2/":"trigger_put"},
  *                 {"/pool2/":"put"}
@@ -101,10 +106,18 @@ namespace cascade {
  * 7) The OPTIONAL "user_defined_logic_config_list" is for a list of the json configurations for all UDLs listed in
  * "user_Defined_logic_list".
  *
- * 8) The "destinations" attribute lists the vertices where the output of UDLs should go. Each element of the 
+ * 8) The OPTIONAL "user_defined_logic_batch_list" attribute lets the off critical data path workers hand the actions
+ * of a UDL to it in batches. A worker that dequeues an action of the UDL keeps dequeuing until it has "max_batch_size"
+ * actions of the UDL, or until "max_wait_us" microseconds have passed since the first one, and then calls the batch
+ * entry point of the UDL with all of them. While a batch is incomplete, the worker waits for new actions up to the
+ * "max_wait_us" deadline of the batch, so an incomplete batch adds up to "max_wait_us" to the latency of its first
+ * action; the other actions the worker dequeues meanwhile are handled as usual. The default "max_batch_size" is 1,
+ * which disables batching, and the default "max_wait_us" is 0.
+ *
+ * 9) The "destinations" attribute lists the vertices where the output of UDLs should go. Each element of the 
  * "destinations" value is a dictionary specifying the vertex and the method (put/trigger_put).
  *
- * Please note that the lengthes of attributes 2)-8) must match each other.
+ * Please note that the lengthes of attributes 2)-9) must match each other.
  */
 
 #define DFG_JSON_ID                     "id"
@@ -118,6 +131,9 @@ namespace cascade {
 #define DFG_JSON_UDL_STATEFUL_LIST      "user_defined_logic_stateful_list"
 #define DFG_JSON_UDL_HOOK_LIST          "user_defined_logic_hook_list"
 #define DFG_JSON_UDL_CONFIG_LIST        "user_defined_logic_config_list"
+#define DFG_JSON_UDL_BATCH_LIST         "user_defined_logic_batch_list"
+#define DFG_JSON_MAX_BATCH_SIZE         "max_batch_size"
+#define DFG_JSON_MAX_WAIT_US            "max_wait_us"
 #define DFG_JSON_DESTINATIONS           "destinations"
 #define DFG_JSON_PUT                    "put"
 #define DFG_JSON_TRIGGER_PUT            "trigger_put"
@@ -154,6 +170,14 @@ public:
         UNKNOWN_S = 0xffff
     };
 
+    /**
+     * How the actions of a UDL are batched. A max_batch_size of 1 disables batching.
+     */
+    struct VertexBatching {
+        uint32_t max_batch_size = 1;
+        uint64_t max_wait_us = 0;
+    };
+
     // the Hex UUID
     const std::string id;
     // description of the DFG
@@ -175,6 +199,8 @@ public:
         std::vector<Statefulness> stateful;
         // hooks
         std::vector<VertexHook> hooks;
+        // batching
+        std::vector<VertexBatching> batching;
         // The optional initialization string for each UUID
         std::vector<json> configurations;
         // An entry "[pool1:true,pool2:false,pool3:false]" means three edges from the current vertex to three destination
@@ -193,6 +219,7 @@ public:
                 out << indent << "\t\texecution.conf:" << execution_environment_conf[i] << "\n";
                 out << indent << "\t\tstateful:" << stateful[i] << "\n";
                 out << indent << "\t\thook:" << hooks[i] << "\n";
+                out << indent << "\t\tbatching:" << batching[i].max_batch_size << "/" << batching[i].max_wait_us << "us\n";
                 out << indent << "\t\tconfiguration:" << configurations[i] << "\n";
                 out << indent << "\t\tedges:" << "\n";
                 for (auto& pool:edges[i]) {
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * @class ActionQueue
+ * @brief A bounded lock-free ring queue of actions, from the critical data path to the off-critical data path workers.
+ *
+ * The ring follows the per-slot sequence number design: a slot carries the position it is ready for, so the producer
+ * and the consumers only contend on the head or the tail, each in its own cache line, and never take a lock when the
+ * queue is neither empty nor full. The queue has one producer in cascade, but the tail is claimed with a CAS anyway,
+ * so that posting from more threads stays correct.
+ *
+ * A consumer that finds the queue empty spins for a while, then yields, then parks on a condition variable; the
+ * producer only touches the condition variable if some consumer is parked. A producer that finds the queue full does
+ * the same the other way around.
+ *
+ * @tparam T    - the element type, which must be default constructible and move assignable.
+ */
+template <typename T>
+class ActionQueue {
+private:
+    static constexpr std::size_t cache_line_size = 64;
+    /** The spins before yielding, and the yields before parking. */
+    static constexpr uint32_t max_spins = 1024;
+    static constexpr uint32_t max_yields = 16;
+
+    struct alignas(cache_line_size) slot_t {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    const std::size_t capacity;
+    const std::size_t mask;
+    std::unique_ptr<slot_t[]> slots;
+
+    alignas(cache_line_size) std::atomic<std::size_t> head;
+    alignas(cache_line_size) std::atomic<std::size_t> tail;
+
+    /** The parked consumers and producers, and what they park on. */
+    alignas(cache_line_size) std::atomic<uint32_t> parked_consumers;
+    std::atomic<uint32_t> parked_producers;
+    std::mutex park_mutex;
+    std::condition_variable data_cv;
+    std::condition_variable slot_cv;
+
+    /** Wake up a parked consumer, if any. */
+    inline void wake_consumer();
+    /** Wake up a parked producer, if any. */
+    inline void wake_producer();
+    /** Dequeue an element, waiting for one while is_running is true, until the deadline if there is one. */
+    bool dequeue_impl(T& value, const std::atomic<bool>& is_running,
+                      const std::chrono::steady_clock::time_point* deadline);
+
+public:
+    /**
+     * Constructor
+     *
+     * @param[in] capacity  - the number of slots, rounded up to a power of two.
+     */
+    explicit ActionQueue(std::size_t capacity);
+
+    ActionQueue(const ActionQueue&) = delete;
+    ActionQueue& operator=(const ActionQueue&) = delete;
+
+    /**
+     * Empty the queue. It must not be used by other threads at the same time.
+     */
+    void reset();
+
+    /**
+     * Enqueue an element without waiting.
+     *
+     * @param[in] value     - the element, which is left untouched if the queue is full.
+     *
+     * @return false if the queue is full.
+     */
+    bool try_enqueue(T&& value);
+
+    /**
+     * Enqueue an element, waiting for a free slot if the queue is full.
+     *
+     * @param[in] value     - the element.
+     */
+    void enqueue(T&& value);
+
+    /**
+     * Dequeue an element without waiting.
+     *
+     * @param[out] value    - the element.
+     *
+     * @return false if the queue is empty.
+     */
+    bool try_dequeue(T& value);
+
+    /**
+     * Dequeue an element, waiting for one while is_running is true.
+     *
+     * @param[out] value        - the element.
+     * @param[in]  is_running   - the flag to stop waiting. Call notify_all() after clearing it.
+     *
+     * @return false if the queue is empty and is_running is false.
+     */
+    bool dequeue(T& value, const std::atomic<bool>& is_running);
+
+    /**
+     * Dequeue an element, waiting for one while is_running is true, but no later than a deadline.
+     *
+     * @param[out] value        - the element.
+     * @param[in]  is_running   - the flag to stop waiting. Call notify_all() after clearing it.
+     * @param[in]  deadline     - the deadline.
+     *
+     * @return false if the queue is still empty at the deadline, or empty and is_running is false.
+     */
+    bool dequeue_until(T& value, const std::atomic<bool>& is_running,
+                       const std::chrono::steady_clock::time_point& deadline);
+
+    /**
+     * @return the number of elements in the queue, which can be stale by the time it returns.
+     */
+    std::size_t size() const;
+
+    /**
+     * Wake up all parked producers and consumers, for shutdown.
+     */
+    void notify_all();
+};
+
+}
+}
+
+#include "action_queue_impl.hpp"
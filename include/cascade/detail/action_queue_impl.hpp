@@ -0,0 +1,209 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace derecho {
+namespace cascade {
+
+namespace action_queue_detail {
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+inline std::size_t round_up_to_power_of_two(std::size_t n) {
+    std::size_t ret = 2;
+    while (ret < n) {
+        ret <<= 1;
+    }
+    return ret;
+}
+}
+
+template <typename T>
+ActionQueue<T>::ActionQueue(std::size_t _capacity):
+    capacity(action_queue_detail::round_up_to_power_of_two(_capacity)),
+    mask(capacity - 1),
+    slots(new slot_t[capacity]),
+    head(0),
+    tail(0),
+    parked_consumers(0),
+    parked_producers(0) {
+    reset();
+}
+
+template <typename T>
+void ActionQueue<T>::reset() {
+    for (std::size_t i = 0; i < capacity; i++) {
+        slots[i].sequence.store(i,std::memory_order_relaxed);
+        slots[i].value = T{};
+    }
+    head.store(0,std::memory_order_relaxed);
+    tail.store(0,std::memory_order_release);
+}
+
+template <typename T>
+inline void ActionQueue<T>::wake_consumer() {
+    // pairs with the fence in dequeue_impl(): either the consumer sees the new element, or we see it parked.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked_consumers.load(std::memory_order_relaxed) > 0) {
+        // taking the mutex makes sure a consumer that is about to park is waiting before it is notified.
+        { std::lock_guard<std::mutex> lck(park_mutex); }
+        data_cv.notify_one();
+    }
+}
+
+template <typename T>
+inline void ActionQueue<T>::wake_producer() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked_producers.load(std::memory_order_relaxed) > 0) {
+        { std::lock_guard<std::mutex> lck(park_mutex); }
+        slot_cv.notify_one();
+    }
+}
+
+template <typename T>
+bool ActionQueue<T>::try_enqueue(T&& value) {
+    std::size_t pos = tail.load(std::memory_order_relaxed);
+    slot_t* slot;
+    while (true) {
+        slot = &slots[pos & mask];
+        std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (tail.compare_exchange_weak(pos,pos + 1,std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // the slot still holds the element from the last lap.
+            return false;
+        } else {
+            pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+    slot->value = std::move(value);
+    slot->sequence.store(pos + 1,std::memory_order_release);
+    wake_consumer();
+    return true;
+}
+
+template <typename T>
+bool ActionQueue<T>::try_dequeue(T& value) {
+    std::size_t pos = head.load(std::memory_order_relaxed);
+    slot_t* slot;
+    while (true) {
+        slot = &slots[pos & mask];
+        std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (head.compare_exchange_weak(pos,pos + 1,std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = head.load(std::memory_order_relaxed);
+        }
+    }
+    value = std::move(slot->value);
+    slot->sequence.store(pos + capacity,std::memory_order_release);
+    wake_producer();
+    return true;
+}
+
+template <typename T>
+void ActionQueue<T>::enqueue(T&& value) {
+    uint32_t rounds = 0;
+    while (!try_enqueue(std::move(value))) {
+        if (rounds < max_spins) {
+            action_queue_detail::cpu_relax();
+        } else if (rounds < max_spins + max_yields) {
+            std::this_thread::yield();
+        } else {
+            std::unique_lock<std::mutex> lck(park_mutex);
+            parked_producers.fetch_add(1,std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::size_t pos = tail.load(std::memory_order_relaxed);
+            if (static_cast<intptr_t>(slots[pos & mask].sequence.load(std::memory_order_relaxed)) -
+                static_cast<intptr_t>(pos) < 0) {
+                slot_cv.wait_for(lck,std::chrono::milliseconds(10));
+            }
+            parked_producers.fetch_sub(1,std::memory_order_relaxed);
+            continue;
+        }
+        rounds++;
+    }
+}
+
+template <typename T>
+bool ActionQueue<T>::dequeue_impl(T& value, const std::atomic<bool>& is_running,
+                                  const std::chrono::steady_clock::time_point* deadline) {
+    uint32_t rounds = 0;
+    while (!try_dequeue(value)) {
+        if (!is_running.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (rounds < max_spins) {
+            action_queue_detail::cpu_relax();
+        } else if (rounds < max_spins + max_yields) {
+            std::this_thread::yield();
+        } else {
+            // the timeout only guards against a missed shutdown; new elements always notify.
+            auto wake_up_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+            if (deadline != nullptr) {
+                if (std::chrono::steady_clock::now() >= *deadline) {
+                    return false;
+                }
+                wake_up_time = std::min(wake_up_time,*deadline);
+            }
+            std::unique_lock<std::mutex> lck(park_mutex);
+            parked_consumers.fetch_add(1,std::memory_order_relaxed);
+            // pairs with the fence in wake_consumer().
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::size_t pos = head.load(std::memory_order_relaxed);
+            if (static_cast<intptr_t>(slots[pos & mask].sequence.load(std::memory_order_relaxed)) -
+                static_cast<intptr_t>(pos + 1) < 0 && is_running.load(std::memory_order_relaxed)) {
+                data_cv.wait_until(lck,wake_up_time);
+            }
+            parked_consumers.fetch_sub(1,std::memory_order_relaxed);
+            continue;
+        }
+        rounds++;
+        if (deadline != nullptr && (rounds & 0xff) == 0 && std::chrono::steady_clock::now() >= *deadline) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+bool ActionQueue<T>::dequeue(T& value, const std::atomic<bool>& is_running) {
+    return dequeue_impl(value,is_running,nullptr);
+}
+
+template <typename T>
+bool ActionQueue<T>::dequeue_until(T& value, const std::atomic<bool>& is_running,
+                                   const std::chrono::steady_clock::time_point& deadline) {
+    return dequeue_impl(value,is_running,&deadline);
+}
+
+template <typename T>
+std::size_t ActionQueue<T>::size() const {
+    std::size_t h = head.load(std::memory_order_relaxed);
+    std::size_t t = tail.load(std::memory_order_relaxed);
+    return (t > h) ? (t - h) : 0;
+}
+
+template <typename T>
+void ActionQueue<T>::notify_all() {
+    { std::lock_guard<std::mutex> lck(park_mutex); }
+    data_cv.notify_all();
+    slot_cv.notify_all();
+}
+
+}
+}
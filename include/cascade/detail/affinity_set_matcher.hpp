@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <hs/hs.h>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * @class AffinitySetMatcher
+ * @brief Extracts the affinity sets of keys with the affinity set regexes of all object pools compiled into one
+ * multi-pattern Hyperscan database.
+ *
+ * The id of a pattern is its index in the owner list, so the match reported by a scan tells which object pool the
+ * pattern belongs to. A matcher is immutable after construction. Hyperscan scratch space cannot be shared by
+ * concurrent scans, so each thread scans with its own scratch, which is grown on first use with every new matcher.
+ *
+ * @tparam T    - the owner type of an affinity set regex, interned once per object pool.
+ */
+template <typename T>
+class AffinitySetMatcher {
+private:
+    /** The compiled database, or nullptr if there is no valid regex. */
+    hs_database_t* database;
+    /** The owner of each pattern, indexed by pattern id. */
+    std::vector<const T*> owners;
+    /** A process-wide unique generation number, which tells a thread whether its scratch fits this database. */
+    const uint64_t generation;
+
+    /** The generation source, starting from 1 so that 0 means 'no database'. */
+    static std::atomic<uint64_t> next_generation;
+
+    /**
+     * @brief The per-thread scratch space, freed on thread exit.
+     */
+    struct thread_scratch_t {
+        hs_scratch_t* scratch = nullptr;
+        /** The generation of the last database the scratch has been grown for. */
+        uint64_t generation = 0;
+        ~thread_scratch_t();
+    };
+
+    /**
+     * Get the scratch of the calling thread, grown for this database if needed.
+     *
+     * @return the scratch.
+     *
+     * @throws derecho::derecho_exception if the scratch cannot be allocated.
+     */
+    inline hs_scratch_t* get_thread_scratch() const;
+public:
+    /**
+     * Constructor
+     * An invalid regex is logged and left out, so the keys of its object pool fall back to the key itself as the
+     * affinity set, instead of failing the other object pools.
+     *
+     * @param[in] regexes   - the (owner, affinity set regex) pairs. Owners with an empty regex are ignored.
+     */
+    AffinitySetMatcher(const std::vector<std::pair<const T*,std::string>>& regexes);
+
+    AffinitySetMatcher(const AffinitySetMatcher&) = delete;
+    AffinitySetMatcher& operator=(const AffinitySetMatcher&) = delete;
+
+    /**
+     * Destructor
+     */
+    virtual ~AffinitySetMatcher();
+
+    /**
+     * Extract the affinity set of a key with one scan of the database. Only the matches of the patterns owned by
+     * 'owner' count; like the single-pattern scan, the last reported match wins.
+     *
+     * @param[in] owner     - the owner of the key, found by the routing table.
+     * @param[in] key       - the key.
+     *
+     * @return a view of the affinity set inside 'key', or 'key' itself if no pattern of 'owner' matches.
+     */
+    std::string_view match(const T* owner, const std::string_view& key) const;
+
+    /**
+     * @return the number of compiled patterns.
+     */
+    std::size_t size() const;
+};
+
+}
+}
+
+#include "affinity_set_matcher_impl.hpp"
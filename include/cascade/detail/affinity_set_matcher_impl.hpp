@@ -0,0 +1,119 @@
+#pragma once
+#include <derecho/core/derecho_exception.hpp>
+#include <derecho/utils/logger.hpp>
+
+namespace derecho {
+namespace cascade {
+
+template <typename T>
+std::atomic<uint64_t> AffinitySetMatcher<T>::next_generation{1};
+
+template <typename T>
+AffinitySetMatcher<T>::thread_scratch_t::~thread_scratch_t() {
+    if (scratch != nullptr) {
+        hs_free_scratch(scratch);
+    }
+}
+
+template <typename T>
+AffinitySetMatcher<T>::AffinitySetMatcher(const std::vector<std::pair<const T*,std::string>>& regexes):
+    database(nullptr),
+    generation(next_generation.fetch_add(1,std::memory_order_relaxed)) {
+    std::vector<std::pair<const T*,std::string>> patterns;
+    for (const auto& regex: regexes) {
+        if (!regex.second.empty()) {
+            patterns.emplace_back(regex);
+        }
+    }
+    // compile all patterns at once; drop the invalid ones and retry.
+    while (!patterns.empty()) {
+        std::vector<const char*> expressions;
+        std::vector<unsigned int> flags(patterns.size(), HS_FLAG_DOTALL|HS_FLAG_SOM_LEFTMOST);
+        std::vector<unsigned int> ids;
+        for (std::size_t i = 0; i < patterns.size(); i++) {
+            expressions.emplace_back(patterns[i].second.c_str());
+            ids.emplace_back(static_cast<unsigned int>(i));
+        }
+        hs_compile_error_t* compile_err = nullptr;
+        if (hs_compile_multi(expressions.data(), flags.data(), ids.data(), static_cast<unsigned int>(patterns.size()),
+                             HS_MODE_BLOCK, nullptr, &database, &compile_err) == HS_SUCCESS) {
+            break;
+        }
+        database = nullptr;
+        int bad = compile_err->expression;
+        if (bad < 0) {
+            dbg_default_error("Compilation of {} affinity set regexes failed with message:{}", patterns.size(), compile_err->message);
+            hs_free_compile_error(compile_err);
+            patterns.clear();
+            break;
+        }
+        dbg_default_error("Compilation of affinity set regex:{} failed with message:{}", patterns[bad].second, compile_err->message);
+        hs_free_compile_error(compile_err);
+        patterns.erase(patterns.begin() + bad);
+    }
+    for (const auto& pattern: patterns) {
+        owners.emplace_back(pattern.first);
+    }
+}
+
+template <typename T>
+AffinitySetMatcher<T>::~AffinitySetMatcher() {
+    if (database != nullptr) {
+        hs_free_database(database);
+        database = nullptr;
+    }
+}
+
+template <typename T>
+inline hs_scratch_t* AffinitySetMatcher<T>::get_thread_scratch() const {
+    static thread_local thread_scratch_t thread_scratch;
+    if (thread_scratch.generation != generation) {
+        // hs_alloc_scratch() only grows the scratch, so it stays valid for the databases it was grown for before.
+        if (hs_alloc_scratch(database, &thread_scratch.scratch) != HS_SUCCESS) {
+            dbg_default_error("failed to allocate hyperscan scratch space.");
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) +
+                    " failed to allocate hyperscan scratch space.");
+        }
+        thread_scratch.generation = generation;
+    }
+    return thread_scratch.scratch;
+}
+
+template <typename T>
+std::string_view AffinitySetMatcher<T>::match(const T* owner, const std::string_view& key) const {
+    if (database == nullptr || key.empty()) {
+        return key;
+    }
+
+    struct hs_scan_ctxt {
+        const std::vector<const T*>* owners;
+        const T* owner;
+        unsigned long long from = 0;
+        unsigned long long to = 0;
+    } ctxt{&owners,owner};
+
+    hs_scan(database, key.data(), static_cast<unsigned int>(key.size()), 0, get_thread_scratch(),
+            [](unsigned int id, unsigned long long from,
+               unsigned long long to, unsigned int /*flags*/,
+               void* ctxt)->int {
+                struct hs_scan_ctxt* p_hs_ctxt = static_cast<struct hs_scan_ctxt*>(ctxt);
+                if ((*p_hs_ctxt->owners)[id] == p_hs_ctxt->owner) {
+                    p_hs_ctxt->from = from;
+                    p_hs_ctxt->to = to;
+                }
+                return 0; // do the longest match
+            },
+            &ctxt);
+    if (ctxt.to > ctxt.from) {
+        return key.substr(ctxt.from,(ctxt.to-ctxt.from));
+    }
+    return key;
+}
+
+template <typename T>
+std::size_t AffinitySetMatcher<T>::size() const {
+    return owners.size();
+}
+
+}
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cascade/cascade_interface.hpp>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * @class ClientReadCache
+ * @brief A bounded cache of the objects read by a ServiceClient, keyed by (key, version), with CLOCK eviction under a
+ * byte budget.
+ *
+ * An object read at a given version never changes, so it is served until evicted. An object read at CURRENT_VERSION
+ * is also remembered as the latest version of its key, which is served to current-version reads until it is
+ * invalidated: by a notification of a newer version, by the client's own write to the key, or by the staleness bound.
+ *
+ * A read that misses the cache takes an invalidation stamp of the key before it is sent, and its reply is only filled
+ * in if the key has not been invalidated since, so that a reply racing an invalidation cannot bring a stale value back.
+ * The client's own writes also set a version floor on the key: the latest version is not filled again until a reply
+ * at least as new as the write is seen, which preserves read-your-writes. Until the version of the write is known,
+ * the floor blocks every fill of the key, up to the staleness bound: the version of a write is only known once its
+ * reply is consumed, and a write whose reply is not consumed in time is left to the invalidations and the staleness
+ * bound, like the writes of the other clients.
+ *
+ * The cached objects are handed to the callers as views sharing the cached object data, if ObjectType implements
+ * ISharedView.
+ *
+ * Lookups only take a shared lock; CLOCK needs nothing more than setting the reference bit of the entry.
+ *
+ * @tparam ObjectType   - the object type, which must have is_valid() and get_version().
+ */
+template <typename ObjectType>
+class ClientReadCache {
+public:
+    /**
+     * @brief The cache counters.
+     */
+    struct stats_t {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t fills;
+        uint64_t evictions;
+        uint64_t invalidations;
+        std::size_t entries;
+        std::size_t bytes;
+    };
+
+private:
+    struct entry_t {
+        std::string key;
+        persistent::version_t version;
+        /** The subgroup the object is read from. */
+        uint64_t owner;
+        std::shared_ptr<const ObjectType> object;
+        std::size_t bytes;
+        /** When the entry was last confirmed as the latest version, in microseconds. */
+        uint64_t latest_since_us;
+        /** True if the entry was filled by a stable read. */
+        bool stable;
+        /** The CLOCK reference bit. */
+        mutable std::atomic<bool> referenced{true};
+    };
+
+    struct version_key_hash {
+        std::size_t operator()(const std::pair<std::string,persistent::version_t>& k) const {
+            return std::hash<std::string>{}(k.first) ^ (std::hash<persistent::version_t>{}(k.second) * 0x9E3779B97F4A7C15ull);
+        }
+    };
+
+    static constexpr std::size_t num_invalidation_stripes = 1024;
+    static constexpr std::size_t max_write_floors = 4096;
+    /** The floor of a key written by this client whose version is not known yet. */
+    static constexpr persistent::version_t unknown_write_version = std::numeric_limits<persistent::version_t>::max();
+
+    const std::size_t capacity_bytes;
+    /** The staleness bound of the latest versions in microseconds, or 0 for none. */
+    const uint64_t max_staleness_us;
+
+    mutable std::shared_mutex cache_mutex;
+    /** The CLOCK ring; a null slot is free. */
+    std::vector<std::unique_ptr<entry_t>> slots;
+    std::vector<std::size_t> free_slots;
+    std::size_t clock_hand;
+    std::size_t used_bytes;
+    std::unordered_map<std::pair<std::string,persistent::version_t>,std::size_t,version_key_hash> index;
+    /** The slot of the latest version of a key. */
+    std::unordered_map<std::string,std::size_t> latest;
+    struct write_floor_t {
+        persistent::version_t version;
+        /** When the last write to the key began, in microseconds. */
+        uint64_t since_us;
+    };
+    /** The version floors of the keys written by this client, dropped in FIFO order beyond max_write_floors. */
+    std::unordered_map<std::string,write_floor_t> write_floors;
+    std::deque<std::string> write_floor_order;
+
+    /** The invalidation stamps, striped by key. */
+    std::array<std::atomic<uint64_t>,num_invalidation_stripes> invalidation_stamps{};
+
+    mutable std::atomic<uint64_t> hits{0};
+    mutable std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> fills{0};
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<uint64_t> invalidations{0};
+
+    inline std::atomic<uint64_t>& invalidation_stamp_of(const std::string& key);
+    /** Evict entries until 'bytes' more fit. The cache mutex must be held exclusively. */
+    void evict_for(std::size_t bytes);
+    /** Remove the entry in a slot. The cache mutex must be held exclusively. */
+    void remove_slot(std::size_t slot);
+    /** Drop the latest version of a key older than 'version'. The cache mutex must be held exclusively. */
+    void drop_latest(const std::string& key, const persistent::version_t& version);
+
+public:
+    /**
+     * Constructor
+     *
+     * @param[in] capacity_bytes    - the byte budget of the cached objects.
+     * @param[in] max_staleness_us  - how long a latest version is served without being confirmed, or 0 for no bound.
+     */
+    ClientReadCache(std::size_t capacity_bytes, uint64_t max_staleness_us);
+
+    ClientReadCache(const ClientReadCache&) = delete;
+    ClientReadCache& operator=(const ClientReadCache&) = delete;
+
+    /**
+     * Look up an object.
+     *
+     * @param[in] owner     - the subgroup the object is read from.
+     * @param[in] key       - the key.
+     * @param[in] version   - the version, or CURRENT_VERSION for the latest one.
+     * @param[in] stable    - if true, only the objects filled by stable reads are returned.
+     *
+     * @return the object, or nullptr on a miss.
+     */
+    std::shared_ptr<const ObjectType> find(uint64_t owner, const std::string& key,
+                                           const persistent::version_t& version, bool stable) const;
+
+    /**
+     * Get a cached object for a caller without copying the object data.
+     *
+     * @param[in] object    - the cached object.
+     *
+     * @return a view sharing the object data if ObjectType implements ISharedView, otherwise a copy of the object.
+     */
+    static ObjectType share(const std::shared_ptr<const ObjectType>& object);
+
+    /**
+     * Take the invalidation stamp of a key before reading it from the store.
+     *
+     * @param[in] key
+     *
+     * @return the stamp to pass to fill().
+     */
+    uint64_t stamp(const std::string& key);
+
+    /**
+     * Fill in an object read from the store.
+     *
+     * Invalid objects, which are returned for missing keys, are not cached.
+     *
+     * @param[in] owner     - the subgroup the object is read from.
+     * @param[in] key       - the key.
+     * @param[in] version   - the version requested by the read, or CURRENT_VERSION.
+     * @param[in] stable    - if the read was stable.
+     * @param[in] stamp     - the invalidation stamp taken before the read.
+     * @param[in] object    - the object.
+     * @param[in] bytes     - the size of the object.
+     */
+    void fill(uint64_t owner, const std::string& key, const persistent::version_t& version, bool stable,
+              uint64_t stamp, const std::shared_ptr<const ObjectType>& object, std::size_t bytes);
+
+    /**
+     * Invalidate the latest version of a key.
+     *
+     * @param[in] key
+     * @param[in] version   - the new version of the key. Only older latest versions are dropped. CURRENT_VERSION drops
+     *                        the latest version anyway.
+     */
+    void invalidate(const std::string& key, const persistent::version_t& version);
+
+    /**
+     * Invalidate a key written by this client, and block the fills of its latest version until the version of the
+     * write is known.
+     *
+     * @param[in] key
+     */
+    void begin_write(const std::string& key);
+
+    /**
+     * Set the version of a write by this client; only replies at least as new as the write are filled in after it.
+     *
+     * @param[in] key
+     * @param[in] version
+     */
+    void end_write(const std::string& key, const persistent::version_t& version);
+
+    /**
+     * @return the staleness bound in microseconds, or 0 for none.
+     */
+    uint64_t get_max_staleness_us() const;
+
+    /**
+     * @return the counters.
+     */
+    stats_t get_stats() const;
+};
+
+}
+}
+
+#include "client_read_cache_impl.hpp"
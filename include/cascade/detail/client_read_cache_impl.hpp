@@ -0,0 +1,233 @@
+#pragma once
+#include <cascade/utils.hpp>
+#include <mutex>
+#include <type_traits>
+
+namespace derecho {
+namespace cascade {
+
+template <typename ObjectType>
+ClientReadCache<ObjectType>::ClientReadCache(std::size_t _capacity_bytes, uint64_t _max_staleness_us):
+    capacity_bytes(_capacity_bytes),
+    max_staleness_us(_max_staleness_us),
+    clock_hand(0),
+    used_bytes(0) {}
+
+template <typename ObjectType>
+inline std::atomic<uint64_t>& ClientReadCache<ObjectType>::invalidation_stamp_of(const std::string& key) {
+    return invalidation_stamps[std::hash<std::string>{}(key) % num_invalidation_stripes];
+}
+
+template <typename ObjectType>
+void ClientReadCache<ObjectType>::remove_slot(std::size_t slot) {
+    auto& entry = slots[slot];
+    auto latest_it = latest.find(entry->key);
+    if (latest_it != latest.end() && latest_it->second == slot) {
+        latest.erase(latest_it);
+    }
+    index.erase(std::make_pair(entry->key,entry->version));
+    used_bytes -= entry->bytes;
+    entry.reset();
+    free_slots.emplace_back(slot);
+}
+
+template <typename ObjectType>
+void ClientReadCache<ObjectType>::evict_for(std::size_t bytes) {
+    // every entry is passed at most twice: once to clear its reference bit, and once to evict it.
+    std::size_t budget = 2 * slots.size();
+    while (used_bytes + bytes > capacity_bytes && budget-- > 0) {
+        clock_hand = (clock_hand + 1) % slots.size();
+        auto& entry = slots[clock_hand];
+        if (!entry) {
+            continue;
+        }
+        if (entry->referenced.exchange(false,std::memory_order_relaxed)) {
+            continue;
+        }
+        remove_slot(clock_hand);
+        evictions.fetch_add(1,std::memory_order_relaxed);
+    }
+}
+
+template <typename ObjectType>
+void ClientReadCache<ObjectType>::drop_latest(const std::string& key, const persistent::version_t& version) {
+    auto latest_it = latest.find(key);
+    if (latest_it != latest.end() &&
+        (version == CURRENT_VERSION || slots[latest_it->second]->version < version)) {
+        latest.erase(latest_it);
+    }
+}
+
+template <typename ObjectType>
+std::shared_ptr<const ObjectType> ClientReadCache<ObjectType>::find(uint64_t owner, const std::string& key,
+                                                                    const persistent::version_t& version,
+                                                                    bool stable) const {
+    std::shared_lock rlck(cache_mutex);
+    const entry_t* entry = nullptr;
+    if (version == CURRENT_VERSION) {
+        auto latest_it = latest.find(key);
+        if (latest_it != latest.end()) {
+            entry = slots[latest_it->second].get();
+            if (max_staleness_us != 0 &&
+                get_time_us(false) - entry->latest_since_us > max_staleness_us) {
+                entry = nullptr;
+            }
+        }
+    } else {
+        auto index_it = index.find(std::make_pair(key,version));
+        if (index_it != index.end()) {
+            entry = slots[index_it->second].get();
+        }
+    }
+    if (entry == nullptr || entry->owner != owner || (stable && !entry->stable)) {
+        misses.fetch_add(1,std::memory_order_relaxed);
+        return nullptr;
+    }
+    entry->referenced.store(true,std::memory_order_relaxed);
+    hits.fetch_add(1,std::memory_order_relaxed);
+    return entry->object;
+}
+
+template <typename ObjectType>
+ObjectType ClientReadCache<ObjectType>::share(const std::shared_ptr<const ObjectType>& object) {
+    if constexpr (std::is_base_of_v<ISharedView<ObjectType>,ObjectType>) {
+        return object->create_shared_view(object);
+    } else {
+        return *object;
+    }
+}
+
+template <typename ObjectType>
+uint64_t ClientReadCache<ObjectType>::stamp(const std::string& key) {
+    return invalidation_stamp_of(key).load(std::memory_order_acquire);
+}
+
+template <typename ObjectType>
+void ClientReadCache<ObjectType>::fill(uint64_t owner, const std::string& key, const persistent::version_t& version,
+                                       bool stable, uint64_t stamp, const std::shared_ptr<const ObjectType>& object,
+                                       std::size_t bytes) {
+    if (!object || !object->is_valid() || object->get_version() == persistent::INVALID_VERSION ||
+        bytes > capacity_bytes) {
+        return;
+    }
+    const persistent::version_t object_version = object->get_version();
+    std::unique_lock wlck(cache_mutex);
+    // A version never changes, but whether it is the latest one can be stale if the key has been invalidated or
+    // written by this client since the read was sent.
+    bool is_latest = (version == CURRENT_VERSION) &&
+                     (invalidation_stamp_of(key).load(std::memory_order_acquire) == stamp);
+    if (is_latest) {
+        auto floor_it = write_floors.find(key);
+        if (floor_it != write_floors.end()) {
+            auto& floor = floor_it->second;
+            if (floor.version == unknown_write_version && max_staleness_us != 0 &&
+                get_time_us(false) - floor.since_us > max_staleness_us) {
+                // the reply of the write is not consumed in time; leave the write to the staleness bound.
+                floor.version = 0;
+            }
+            if (object_version < floor.version) {
+                is_latest = false;
+            }
+        }
+    }
+    if (is_latest) {
+        auto latest_it = latest.find(key);
+        if (latest_it != latest.end() && slots[latest_it->second]->version > object_version) {
+            is_latest = false;
+        }
+    }
+
+    std::size_t slot;
+    auto index_it = index.find(std::make_pair(key,object_version));
+    if (index_it != index.end()) {
+        slot = index_it->second;
+        slots[slot]->stable = slots[slot]->stable || stable;
+    } else {
+        evict_for(bytes);
+        if (used_bytes + bytes > capacity_bytes) {
+            return;
+        }
+        if (free_slots.empty()) {
+            slot = slots.size();
+            slots.emplace_back();
+        } else {
+            slot = free_slots.back();
+            free_slots.pop_back();
+        }
+        slots[slot] = std::make_unique<entry_t>();
+        auto& entry = *slots[slot];
+        entry.key = key;
+        entry.version = object_version;
+        entry.owner = owner;
+        entry.object = object;
+        entry.bytes = bytes;
+        entry.latest_since_us = 0;
+        entry.stable = stable;
+        index.emplace(std::make_pair(key,object_version),slot);
+        used_bytes += bytes;
+        fills.fetch_add(1,std::memory_order_relaxed);
+    }
+    if (is_latest) {
+        slots[slot]->latest_since_us = get_time_us(false);
+        latest[key] = slot;
+    }
+}
+
+template <typename ObjectType>
+void ClientReadCache<ObjectType>::invalidate(const std::string& key, const persistent::version_t& version) {
+    invalidation_stamp_of(key).fetch_add(1,std::memory_order_acq_rel);
+    std::unique_lock wlck(cache_mutex);
+    drop_latest(key,version);
+    invalidations.fetch_add(1,std::memory_order_relaxed);
+}
+
+template <typename ObjectType>
+void ClientReadCache<ObjectType>::begin_write(const std::string& key) {
+    invalidation_stamp_of(key).fetch_add(1,std::memory_order_acq_rel);
+    std::unique_lock wlck(cache_mutex);
+    drop_latest(key,CURRENT_VERSION);
+    if (write_floors.find(key) == write_floors.end()) {
+        write_floor_order.emplace_back(key);
+        if (write_floor_order.size() > max_write_floors) {
+            write_floors.erase(write_floor_order.front());
+            write_floor_order.pop_front();
+        }
+    }
+    write_floors[key] = write_floor_t{unknown_write_version,get_time_us(false)};
+}
+
+template <typename ObjectType>
+void ClientReadCache<ObjectType>::end_write(const std::string& key, const persistent::version_t& version) {
+    std::unique_lock wlck(cache_mutex);
+    auto floor_it = write_floors.find(key);
+    if (floor_it == write_floors.end()) {
+        return;
+    }
+    auto& floor = floor_it->second;
+    if (floor.version == unknown_write_version) {
+        // a rejected write leaves nothing to wait for.
+        floor.version = (version == persistent::INVALID_VERSION) ? 0 : version;
+    } else if (version != persistent::INVALID_VERSION && version > floor.version) {
+        floor.version = version;
+    }
+}
+
+template <typename ObjectType>
+uint64_t ClientReadCache<ObjectType>::get_max_staleness_us() const {
+    return max_staleness_us;
+}
+
+template <typename ObjectType>
+typename ClientReadCache<ObjectType>::stats_t ClientReadCache<ObjectType>::get_stats() const {
+    std::shared_lock rlck(cache_mutex);
+    return stats_t{hits.load(std::memory_order_relaxed),
+                   misses.load(std::memory_order_relaxed),
+                   fills.load(std::memory_order_relaxed),
+                   evictions.load(std::memory_order_relaxed),
+                   invalidations.load(std::memory_order_relaxed),
+                   index.size(),
+                   used_bytes};
+}
+
+}
+}
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <derecho/mutils-serialization/SerializationSupport.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * @class EpochDomain
+ * @brief Epoch-based memory reclamation shared by all ConcurrentOrderedMap instances in a process.
+ *
+ * A reader thread claims a reader slot and announces the global epoch in it when it enters a read-side critical
+ * section, and clears and releases the slot when it leaves, so the slots are only held by the threads inside critical
+ * sections. A writer retires the memory it unlinked together with the global epoch observed at retirement, and frees it
+ * only after every reader that is still inside a critical section has announced a later epoch. A reader pays a
+ * compare-and-swap on the slot it used last time, two stores and a fence per critical section.
+ */
+class EpochDomain {
+public:
+    /** The maximum number of threads that can be inside read-side critical sections at the same time. */
+    static constexpr uint32_t max_reader_slots = 1024;
+    /** The epoch value of a reader slot that is not in a critical section. */
+    static constexpr uint64_t inactive_epoch = 0;
+
+private:
+    struct alignas(64) reader_slot_t {
+        std::atomic<uint64_t> epoch;
+        std::atomic<bool> in_use;
+    };
+    /** Per-thread registration. The slot is held from the outermost enter() to the matching leave(). */
+    struct thread_registration_t {
+        int32_t slot_index = -1;
+        /** The slot held last time, which is tried first by the next critical section. */
+        int32_t last_slot_index = -1;
+        uint32_t depth = 0;
+        ~thread_registration_t();
+    };
+
+    reader_slot_t reader_slots[max_reader_slots];
+    alignas(64) std::atomic<uint64_t> global_epoch;
+
+    EpochDomain();
+    static thread_registration_t& get_thread_registration();
+    /**
+     * Claim a free reader slot, trying 'hint' first. If more than max_reader_slots threads are inside critical
+     * sections at the same time, wait for one of them to leave.
+     */
+    int32_t claim_reader_slot(int32_t hint);
+
+public:
+    /**
+     * @brief Get the process-wide epoch domain.
+     */
+    static EpochDomain& get();
+    /**
+     * @brief Enter a read-side critical section. Nesting is allowed. The outermost critical section claims a reader
+     * slot, waiting if all max_reader_slots slots are held by other threads inside critical sections.
+     */
+    void enter();
+    /**
+     * @brief Leave a read-side critical section. The outermost critical section releases its reader slot.
+     */
+    void leave();
+    /**
+     * @brief Get the epoch to tag retired memory with. Called by a writer after unlinking the memory.
+     *
+     * @return The current global epoch.
+     */
+    uint64_t retire_epoch();
+    /**
+     * @brief Advance the global epoch.
+     */
+    void advance();
+    /**
+     * @brief Get the oldest epoch announced by the readers in critical sections.
+     *
+     * @return The oldest epoch, or UINT64_MAX if no reader is in a critical section.
+     */
+    uint64_t oldest_active_epoch() const;
+};
+
+/**
+ * @class EpochGuard
+ * @brief RAII helper for a read-side critical section in EpochDomain.
+ */
+class EpochGuard {
+public:
+    EpochGuard() { EpochDomain::get().enter(); }
+    ~EpochGuard() { EpochDomain::get().leave(); }
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+/**
+ * @class ConcurrentOrderedMap
+ * @brief An ordered map with a single writer and any number of lockless readers.
+ *
+ * The map is a skiplist. All mutations (insert_or_assign/erase/clear) must come from one thread at a time, which is
+ * the predicate thread for the cascade stores. Other threads read through `read`, `read_size`, and `for_each`, which
+ * run inside an EpochGuard and never retry: a replaced value or an erased node stays valid until no reader can still
+ * see it. A reader can also take a reference-counted handle to a value with `read_shared`, which keeps the value alive
+ * after the EpochGuard is released and the key is updated or erased. The iterator interface (find/at/begin/end) does not hold an EpochGuard and therefore must only be used from
+ * the writer thread or on a map no other thread is modifying.
+ *
+ * The serialized format is the number of entries followed by the serialized keys and values in key order.
+ * Serialization must not race with the writer.
+ *
+ * @tparam KT   The key type
+ * @tparam VT   The value type
+ */
+template <typename KT, typename VT>
+class ConcurrentOrderedMap : public mutils::ByteRepresentable {
+public:
+    static constexpr uint32_t max_level = 16;
+
+private:
+    /**
+     * A value with its reference count. The map holds one reference until the value is replaced or erased and then
+     * reclaimed; every handle returned by `read_shared` holds another one.
+     */
+    struct value_box_t {
+        std::atomic<uint64_t> refs;
+        const VT value;
+        explicit value_box_t(const VT& _value) : refs(1), value(_value) {}
+    };
+    static void release_value(value_box_t* box);
+
+    struct Node {
+        const KT key;
+        std::atomic<value_box_t*> value;
+        const uint32_t height;
+        std::unique_ptr<std::atomic<Node*>[]> next;
+        Node(const KT& _key, value_box_t* _value, uint32_t _height);
+        ~Node();
+    };
+    /** Memory unlinked by the writer, waiting for the readers to move on. */
+    struct retired_t {
+        uint64_t epoch;
+        value_box_t* value;
+        Node* node;
+    };
+
+    std::atomic<Node*> head[max_level];
+    std::atomic<std::size_t> num_entries;
+    /** The following members are touched by the writer only. */
+    std::vector<retired_t> retired;
+    uint64_t level_seed;
+
+    uint32_t random_height();
+    /**
+     * @brief Find the node with the key, and collect the links pointing to the first node not less than key.
+     * Called by the writer only.
+     */
+    Node* find_node_for_update(const KT& key, std::atomic<Node*>** preds);
+    /**
+     * @brief Locklessly find the first node not less than the key. The caller must hold an EpochGuard unless it is the
+     * writer.
+     */
+    const Node* lower_bound_node(const KT& key) const;
+    /**
+     * @brief Locklessly find the node with the key. The caller must hold an EpochGuard unless it is the writer.
+     */
+    const Node* find_node(const KT& key) const;
+    void retire(value_box_t* value, Node* node);
+    void free_all();
+
+public:
+    /**
+     * @class const_iterator
+     * @brief Forward iterator in key order. It is not protected against concurrent erase.
+     */
+    class const_iterator {
+        const Node* node;
+        friend class ConcurrentOrderedMap;
+        explicit const_iterator(const Node* n) : node(n) {}
+
+    public:
+        using value_type = std::pair<const KT&, const VT&>;
+        struct arrow_proxy {
+            value_type kv;
+            const value_type* operator->() const { return &kv; }
+        };
+        const_iterator() : node(nullptr) {}
+        value_type operator*() const { return {node->key, node->value.load(std::memory_order_acquire)->value}; }
+        arrow_proxy operator->() const { return {**this}; }
+        const_iterator& operator++() {
+            node = node->next[0].load(std::memory_order_acquire);
+            return *this;
+        }
+        bool operator==(const const_iterator& rhs) const { return node == rhs.node; }
+        bool operator!=(const const_iterator& rhs) const { return node != rhs.node; }
+    };
+
+    /**
+     * @brief Insert a new entry or replace the value of an existing one. Writer only.
+     *
+     * @param[in]   key     The key
+     * @param[in]   value   The value, which is copied into the map.
+     *
+     * @return true if a new entry is inserted, false if an existing value is replaced.
+     */
+    bool insert_or_assign(const KT& key, const VT& value);
+    /**
+     * @brief Erase an entry. Writer only.
+     *
+     * @param[in]   key     The key
+     *
+     * @return The number of entries erased.
+     */
+    std::size_t erase(const KT& key);
+    /**
+     * @brief Erase all entries. Writer only.
+     */
+    void clear();
+    /**
+     * @brief Free the retired memory no reader can see anymore. Writer only. It is called automatically on updates.
+     */
+    void reclaim();
+
+    /**
+     * @brief Locklessly read the value of a key.
+     *
+     * @tparam ReaderFunc   void(const VT&)
+     * @param[in]   key     The key
+     * @param[in]   reader  The lambda to consume the value. The value is only valid inside the lambda.
+     *
+     * @return true if the key is found and the reader is called, otherwise false.
+     */
+    template <typename ReaderFunc>
+    bool read(const KT& key, ReaderFunc&& reader) const;
+    /**
+     * @brief Locklessly get a shared handle to the value of a key.
+     * The handle pins the value as it is now: a later update or erase of the key does not change or free it. The
+     * handle can be passed to and released by any thread.
+     *
+     * @param[in]   key     The key
+     *
+     * @return A handle to the value, or an empty handle if the key is not found.
+     */
+    std::shared_ptr<const VT> read_shared(const KT& key) const;
+    /**
+     * @brief Locklessly visit the entries in key order.
+     * The visit is not an atomic snapshot: each entry is visited with the value it had when the visitor reached it.
+     *
+     * @tparam VisitorFunc  void(const KT&, const VT&)
+     * @param[in]   visitor The lambda to consume the entries.
+     */
+    template <typename VisitorFunc>
+    void for_each(VisitorFunc&& visitor) const;
+    /**
+     * @brief Locklessly visit the entries in key order, starting from the first key not less than `start`, until the
+     * visitor returns false. Like for_each, the visit is not an atomic snapshot.
+     *
+     * @tparam VisitorFunc  bool(const KT&, const VT&)
+     * @param[in]   start   The key to start from.
+     * @param[in]   visitor The lambda to consume the entries. Returning false stops the visit.
+     */
+    template <typename VisitorFunc>
+    void for_each_from(const KT& start, VisitorFunc&& visitor) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator find(const KT& key) const;
+    /**
+     * @brief Get the iterator to the first entry whose key is not less than the given key.
+     */
+    const_iterator lower_bound(const KT& key) const;
+    /**
+     * @brief Get the value of a key. std::out_of_range is thrown if the key does not exist.
+     */
+    const VT& at(const KT& key) const;
+    std::size_t count(const KT& key) const;
+    std::size_t size() const;
+    bool empty() const;
+
+    // serialization support
+    virtual std::size_t to_bytes(uint8_t* buf) const override;
+    virtual void post_object(const std::function<void(uint8_t const* const, std::size_t)>& f) const override;
+    virtual std::size_t bytes_size() const override;
+    virtual void ensure_registered(mutils::DeserializationManager&) {}
+    static std::unique_ptr<ConcurrentOrderedMap> from_bytes(mutils::DeserializationManager* dsm, const uint8_t* const buf);
+    static mutils::context_ptr<ConcurrentOrderedMap> from_bytes_noalloc(mutils::DeserializationManager* dsm, const uint8_t* const buf);
+    static mutils::context_ptr<const ConcurrentOrderedMap> from_bytes_noalloc_const(mutils::DeserializationManager* dsm, const uint8_t* const buf);
+
+    // constructors
+    ConcurrentOrderedMap();
+    ConcurrentOrderedMap(const std::map<KT, VT>& kvm);
+    /**
+     * @brief Copy constructor. The source must not be modified concurrently.
+     */
+    ConcurrentOrderedMap(const ConcurrentOrderedMap& other);
+    /**
+     * @brief Move constructor. Neither map may be accessed concurrently.
+     */
+    ConcurrentOrderedMap(ConcurrentOrderedMap&& other);
+
+    // destructor
+    virtual ~ConcurrentOrderedMap();
+};
+
+}  // namespace cascade
+}  // namespace derecho
+
+#include "concurrent_ordered_map_impl.hpp"
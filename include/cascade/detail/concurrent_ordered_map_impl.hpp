@@ -0,0 +1,470 @@
+#pragma once
+#include "concurrent_ordered_map.hpp"
+
+#include <derecho/utils/logger.hpp>
+
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace derecho {
+namespace cascade {
+
+inline EpochDomain::EpochDomain() : global_epoch(1) {
+    for (auto& slot : reader_slots) {
+        slot.epoch.store(inactive_epoch, std::memory_order_relaxed);
+        slot.in_use.store(false, std::memory_order_relaxed);
+    }
+}
+
+inline EpochDomain& EpochDomain::get() {
+    static EpochDomain domain;
+    return domain;
+}
+
+inline EpochDomain::thread_registration_t::~thread_registration_t() {
+    // a thread exiting inside a critical section still gives its slot back.
+    if (slot_index >= 0) {
+        auto& slot = EpochDomain::get().reader_slots[slot_index];
+        slot.epoch.store(inactive_epoch, std::memory_order_release);
+        slot.in_use.store(false, std::memory_order_release);
+    }
+}
+
+inline EpochDomain::thread_registration_t& EpochDomain::get_thread_registration() {
+    static thread_local thread_registration_t registration;
+    return registration;
+}
+
+inline int32_t EpochDomain::claim_reader_slot(int32_t hint) {
+    // start from the slot used last time, which is free unless another thread took it since.
+    const uint32_t start = (hint >= 0) ? static_cast<uint32_t>(hint) : 0;
+    bool warned = false;
+    while (true) {
+        for (uint32_t n = 0; n < max_reader_slots; n++) {
+            const uint32_t i = (start + n) % max_reader_slots;
+            bool expected = false;
+            if (!reader_slots[i].in_use.load(std::memory_order_relaxed) &&
+                reader_slots[i].in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                return static_cast<int32_t>(i);
+            }
+        }
+        // The slots are only held inside critical sections, which do not block, so one is released soon.
+        if (!warned) {
+            dbg_default_warn("EpochDomain: all {} reader slots are held, waiting for one.", max_reader_slots);
+            warned = true;
+        }
+        std::this_thread::yield();
+    }
+}
+
+inline void EpochDomain::enter() {
+    auto& registration = get_thread_registration();
+    if (registration.depth > 0) {
+        registration.depth++;
+        return;
+    }
+    registration.slot_index = claim_reader_slot(registration.last_slot_index);
+    registration.depth = 1;
+    reader_slots[registration.slot_index].epoch.store(global_epoch.load(std::memory_order_seq_cst), std::memory_order_relaxed);
+    // pairs with the fence in retire_epoch(): either the writer sees this announcement, or this reader sees the unlink.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+inline void EpochDomain::leave() {
+    auto& registration = get_thread_registration();
+    if (--registration.depth == 0) {
+        auto& slot = reader_slots[registration.slot_index];
+        slot.epoch.store(inactive_epoch, std::memory_order_release);
+        slot.in_use.store(false, std::memory_order_release);
+        registration.last_slot_index = registration.slot_index;
+        registration.slot_index = -1;
+    }
+}
+
+inline uint64_t EpochDomain::retire_epoch() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return global_epoch.load(std::memory_order_seq_cst);
+}
+
+inline void EpochDomain::advance() {
+    global_epoch.fetch_add(1, std::memory_order_seq_cst);
+}
+
+inline uint64_t EpochDomain::oldest_active_epoch() const {
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (const auto& slot : reader_slots) {
+        uint64_t epoch = slot.epoch.load(std::memory_order_acquire);
+        if (epoch != inactive_epoch && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    return oldest;
+}
+
+/** Number of retired objects that triggers a reclamation. */
+#define CONCURRENT_ORDERED_MAP_RECLAIM_THRESHOLD (64)
+
+template <typename KT, typename VT>
+void ConcurrentOrderedMap<KT, VT>::release_value(value_box_t* box) {
+    if (box != nullptr && box->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete box;
+    }
+}
+
+template <typename KT, typename VT>
+ConcurrentOrderedMap<KT, VT>::Node::Node(const KT& _key, value_box_t* _value, uint32_t _height) : key(_key),
+                                                                                               value(_value),
+                                                                                               height(_height),
+                                                                                               next(new std::atomic<Node*>[_height]) {
+    for (uint32_t i = 0; i < height; i++) {
+        next[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+template <typename KT, typename VT>
+ConcurrentOrderedMap<KT, VT>::Node::~Node() {
+    release_value(value.load(std::memory_order_relaxed));
+}
+
+template <typename KT, typename VT>
+uint32_t ConcurrentOrderedMap<KT, VT>::random_height() {
+    // xorshift64, with a branching factor of 4.
+    level_seed ^= level_seed << 13;
+    level_seed ^= level_seed >> 7;
+    level_seed ^= level_seed << 17;
+    uint32_t height = 1;
+    uint64_t bits = level_seed;
+    while (height < max_level && (bits & 0x3) == 0) {
+        height++;
+        bits >>= 2;
+    }
+    return height;
+}
+
+template <typename KT, typename VT>
+typename ConcurrentOrderedMap<KT, VT>::Node* ConcurrentOrderedMap<KT, VT>::find_node_for_update(const KT& key, std::atomic<Node*>** preds) {
+    std::atomic<Node*>* links = head;
+    for (int32_t level = max_level - 1; level >= 0; level--) {
+        Node* n = links[level].load(std::memory_order_relaxed);
+        while (n != nullptr && n->key < key) {
+            links = n->next.get();
+            n = links[level].load(std::memory_order_relaxed);
+        }
+        preds[level] = &links[level];
+    }
+    Node* n = preds[0]->load(std::memory_order_relaxed);
+    if (n != nullptr && !(key < n->key)) {
+        return n;
+    }
+    return nullptr;
+}
+
+template <typename KT, typename VT>
+const typename ConcurrentOrderedMap<KT, VT>::Node* ConcurrentOrderedMap<KT, VT>::lower_bound_node(const KT& key) const {
+    const std::atomic<Node*>* links = head;
+    const Node* n = nullptr;
+    for (int32_t level = max_level - 1; level >= 0; level--) {
+        n = links[level].load(std::memory_order_acquire);
+        while (n != nullptr && n->key < key) {
+            links = n->next.get();
+            n = links[level].load(std::memory_order_acquire);
+        }
+    }
+    return n;
+}
+
+template <typename KT, typename VT>
+const typename ConcurrentOrderedMap<KT, VT>::Node* ConcurrentOrderedMap<KT, VT>::find_node(const KT& key) const {
+    const Node* n = lower_bound_node(key);
+    if (n != nullptr && !(key < n->key)) {
+        return n;
+    }
+    return nullptr;
+}
+
+template <typename KT, typename VT>
+void ConcurrentOrderedMap<KT, VT>::retire(value_box_t* value, Node* node) {
+    retired.push_back({EpochDomain::get().retire_epoch(), value, node});
+    if (retired.size() >= CONCURRENT_ORDERED_MAP_RECLAIM_THRESHOLD) {
+        EpochDomain::get().advance();
+        reclaim();
+    }
+}
+
+template <typename KT, typename VT>
+void ConcurrentOrderedMap<KT, VT>::reclaim() {
+    if (retired.empty()) {
+        return;
+    }
+    uint64_t oldest = EpochDomain::get().oldest_active_epoch();
+    auto keep = retired.begin();
+    for (auto it = retired.begin(); it != retired.end(); it++) {
+        if (it->epoch < oldest) {
+            release_value(it->value);
+            delete it->node;
+        } else {
+            *keep++ = *it;
+        }
+    }
+    retired.erase(keep, retired.end());
+}
+
+template <typename KT, typename VT>
+bool ConcurrentOrderedMap<KT, VT>::insert_or_assign(const KT& key, const VT& value) {
+    std::atomic<Node*>* preds[max_level];
+    Node* n = find_node_for_update(key, preds);
+    if (n != nullptr) {
+        value_box_t* old_value = n->value.exchange(new value_box_t(value), std::memory_order_acq_rel);
+        retire(old_value, nullptr);
+        return false;
+    }
+    uint32_t height = random_height();
+    n = new Node(key, new value_box_t(value), height);
+    for (uint32_t level = 0; level < height; level++) {
+        n->next[level].store(preds[level]->load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    // publish bottom-up, so that a reader finds the node as soon as it is linked at level 0.
+    for (uint32_t level = 0; level < height; level++) {
+        preds[level]->store(n, std::memory_order_release);
+    }
+    num_entries.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+template <typename KT, typename VT>
+std::size_t ConcurrentOrderedMap<KT, VT>::erase(const KT& key) {
+    std::atomic<Node*>* preds[max_level];
+    Node* n = find_node_for_update(key, preds);
+    if (n == nullptr) {
+        return 0;
+    }
+    // unlink top-down. The next pointers of n are left intact for the readers standing on it.
+    for (int32_t level = n->height - 1; level >= 0; level--) {
+        preds[level]->store(n->next[level].load(std::memory_order_relaxed), std::memory_order_release);
+    }
+    num_entries.fetch_sub(1, std::memory_order_relaxed);
+    retire(nullptr, n);
+    return 1;
+}
+
+template <typename KT, typename VT>
+void ConcurrentOrderedMap<KT, VT>::clear() {
+    Node* n = head[0].load(std::memory_order_relaxed);
+    for (uint32_t level = 0; level < max_level; level++) {
+        head[level].store(nullptr, std::memory_order_release);
+    }
+    num_entries.store(0, std::memory_order_relaxed);
+    while (n != nullptr) {
+        Node* next = n->next[0].load(std::memory_order_relaxed);
+        retire(nullptr, n);
+        n = next;
+    }
+}
+
+template <typename KT, typename VT>
+template <typename ReaderFunc>
+bool ConcurrentOrderedMap<KT, VT>::read(const KT& key, ReaderFunc&& reader) const {
+    EpochGuard guard;
+    const Node* n = find_node(key);
+    if (n == nullptr) {
+        return false;
+    }
+    reader(n->value.load(std::memory_order_acquire)->value);
+    return true;
+}
+
+template <typename KT, typename VT>
+std::shared_ptr<const VT> ConcurrentOrderedMap<KT, VT>::read_shared(const KT& key) const {
+    EpochGuard guard;
+    const Node* n = find_node(key);
+    if (n == nullptr) {
+        return nullptr;
+    }
+    value_box_t* box = n->value.load(std::memory_order_acquire);
+    // The map's own reference is released only on reclamation, which waits for this EpochGuard.
+    box->refs.fetch_add(1, std::memory_order_relaxed);
+    return std::shared_ptr<const VT>(&box->value, [box](const VT*) { release_value(box); });
+}
+
+template <typename KT, typename VT>
+template <typename VisitorFunc>
+void ConcurrentOrderedMap<KT, VT>::for_each(VisitorFunc&& visitor) const {
+    EpochGuard guard;
+    const Node* n = head[0].load(std::memory_order_acquire);
+    while (n != nullptr) {
+        visitor(n->key, n->value.load(std::memory_order_acquire)->value);
+        n = n->next[0].load(std::memory_order_acquire);
+    }
+}
+
+template <typename KT, typename VT>
+template <typename VisitorFunc>
+void ConcurrentOrderedMap<KT, VT>::for_each_from(const KT& start, VisitorFunc&& visitor) const {
+    EpochGuard guard;
+    const Node* n = lower_bound_node(start);
+    while (n != nullptr) {
+        if (!visitor(n->key, n->value.load(std::memory_order_acquire)->value)) {
+            break;
+        }
+        n = n->next[0].load(std::memory_order_acquire);
+    }
+}
+
+template <typename KT, typename VT>
+typename ConcurrentOrderedMap<KT, VT>::const_iterator ConcurrentOrderedMap<KT, VT>::begin() const {
+    return const_iterator(head[0].load(std::memory_order_acquire));
+}
+
+template <typename KT, typename VT>
+typename ConcurrentOrderedMap<KT, VT>::const_iterator ConcurrentOrderedMap<KT, VT>::end() const {
+    return const_iterator(nullptr);
+}
+
+template <typename KT, typename VT>
+typename ConcurrentOrderedMap<KT, VT>::const_iterator ConcurrentOrderedMap<KT, VT>::find(const KT& key) const {
+    return const_iterator(find_node(key));
+}
+
+template <typename KT, typename VT>
+typename ConcurrentOrderedMap<KT, VT>::const_iterator ConcurrentOrderedMap<KT, VT>::lower_bound(const KT& key) const {
+    return const_iterator(lower_bound_node(key));
+}
+
+template <typename KT, typename VT>
+const VT& ConcurrentOrderedMap<KT, VT>::at(const KT& key) const {
+    const Node* n = find_node(key);
+    if (n == nullptr) {
+        throw std::out_of_range("ConcurrentOrderedMap::at: key does not exist.");
+    }
+    return n->value.load(std::memory_order_acquire)->value;
+}
+
+template <typename KT, typename VT>
+std::size_t ConcurrentOrderedMap<KT, VT>::count(const KT& key) const {
+    return (find_node(key) == nullptr) ? 0 : 1;
+}
+
+template <typename KT, typename VT>
+std::size_t ConcurrentOrderedMap<KT, VT>::size() const {
+    return num_entries.load(std::memory_order_relaxed);
+}
+
+template <typename KT, typename VT>
+bool ConcurrentOrderedMap<KT, VT>::empty() const {
+    return size() == 0;
+}
+
+template <typename KT, typename VT>
+std::size_t ConcurrentOrderedMap<KT, VT>::to_bytes(uint8_t* buf) const {
+    std::size_t offset = mutils::to_bytes(size(), buf);
+    for_each([&offset, buf](const KT& key, const VT& value) {
+        offset += mutils::to_bytes(key, buf + offset);
+        offset += mutils::to_bytes(value, buf + offset);
+    });
+    return offset;
+}
+
+template <typename KT, typename VT>
+void ConcurrentOrderedMap<KT, VT>::post_object(const std::function<void(uint8_t const* const, std::size_t)>& f) const {
+    mutils::post_object(f, size());
+    for_each([&f](const KT& key, const VT& value) {
+        mutils::post_object(f, key);
+        mutils::post_object(f, value);
+    });
+}
+
+template <typename KT, typename VT>
+std::size_t ConcurrentOrderedMap<KT, VT>::bytes_size() const {
+    std::size_t size = mutils::bytes_size(static_cast<std::size_t>(0));
+    for_each([&size](const KT& key, const VT& value) {
+        size += mutils::bytes_size(key);
+        size += mutils::bytes_size(value);
+    });
+    return size;
+}
+
+template <typename KT, typename VT>
+std::unique_ptr<ConcurrentOrderedMap<KT, VT>> ConcurrentOrderedMap<KT, VT>::from_bytes(
+        mutils::DeserializationManager* dsm, const uint8_t* const buf) {
+    auto map_ptr = std::make_unique<ConcurrentOrderedMap<KT, VT>>();
+    std::size_t num = *mutils::from_bytes_noalloc<std::size_t>(dsm, buf);
+    std::size_t offset = mutils::bytes_size(num);
+    while (num--) {
+        auto key_ptr = mutils::from_bytes<KT>(dsm, buf + offset);
+        offset += mutils::bytes_size(*key_ptr);
+        offset += mutils::deserialize_and_run(dsm, buf + offset, [&map_ptr, &key_ptr](const VT& value) {
+            map_ptr->insert_or_assign(*key_ptr, value);
+            return mutils::bytes_size(value);
+        });
+    }
+    return map_ptr;
+}
+
+template <typename KT, typename VT>
+mutils::context_ptr<ConcurrentOrderedMap<KT, VT>> ConcurrentOrderedMap<KT, VT>::from_bytes_noalloc(
+        mutils::DeserializationManager* dsm, const uint8_t* const buf) {
+    return mutils::context_ptr<ConcurrentOrderedMap<KT, VT>>(from_bytes(dsm, buf).release());
+}
+
+template <typename KT, typename VT>
+mutils::context_ptr<const ConcurrentOrderedMap<KT, VT>> ConcurrentOrderedMap<KT, VT>::from_bytes_noalloc_const(
+        mutils::DeserializationManager* dsm, const uint8_t* const buf) {
+    return mutils::context_ptr<const ConcurrentOrderedMap<KT, VT>>(from_bytes(dsm, buf).release());
+}
+
+template <typename KT, typename VT>
+ConcurrentOrderedMap<KT, VT>::ConcurrentOrderedMap() : num_entries(0),
+                                                       level_seed(reinterpret_cast<uint64_t>(this) | 1ull) {
+    for (uint32_t level = 0; level < max_level; level++) {
+        head[level].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+template <typename KT, typename VT>
+ConcurrentOrderedMap<KT, VT>::ConcurrentOrderedMap(const std::map<KT, VT>& kvm) : ConcurrentOrderedMap() {
+    for (const auto& kv : kvm) {
+        insert_or_assign(kv.first, kv.second);
+    }
+}
+
+template <typename KT, typename VT>
+ConcurrentOrderedMap<KT, VT>::ConcurrentOrderedMap(const ConcurrentOrderedMap& other) : ConcurrentOrderedMap() {
+    for (const auto& kv : other) {
+        insert_or_assign(kv.first, kv.second);
+    }
+}
+
+template <typename KT, typename VT>
+ConcurrentOrderedMap<KT, VT>::ConcurrentOrderedMap(ConcurrentOrderedMap&& other) : ConcurrentOrderedMap() {
+    for (uint32_t level = 0; level < max_level; level++) {
+        head[level].store(other.head[level].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.head[level].store(nullptr, std::memory_order_relaxed);
+    }
+    num_entries.store(other.num_entries.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    other.num_entries.store(0, std::memory_order_relaxed);
+    retired.swap(other.retired);
+}
+
+template <typename KT, typename VT>
+void ConcurrentOrderedMap<KT, VT>::free_all() {
+    Node* n = head[0].load(std::memory_order_relaxed);
+    while (n != nullptr) {
+        Node* next = n->next[0].load(std::memory_order_relaxed);
+        delete n;
+        n = next;
+    }
+    for (auto& r : retired) {
+        release_value(r.value);
+        delete r.node;
+    }
+    retired.clear();
+}
+
+template <typename KT, typename VT>
+ConcurrentOrderedMap<KT, VT>::~ConcurrentOrderedMap() {
+    free_all();
+}
+
+}  // namespace cascade
+}  // namespace derecho
@@ -1,19 +1,68 @@
 #pragma once
 
 #include "cascade/cascade_interface.hpp"
+#include "concurrent_ordered_map.hpp"
 
 #include <derecho/core/derecho.hpp>
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
 
 #include <atomic>
 #include <cstdint>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace derecho {
 namespace cascade {
 
+/** "CSCDSNAP" in little endian. */
+#define KV_MAP_SNAPSHOT_MAGIC   (0x50414e5344435343ull)
+#define KV_MAP_SNAPSHOT_FORMAT  (3)
+/** The number of time buckets beyond which the time index doubles its bucket width and merges its buckets. */
+#define TIME_INDEX_MAX_BUCKETS  (65536)
+/**
+ * The distance in versions after which a tombstone is reclaimed: applying version v reclaims the tombstones up to
+ * version v - TOMBSTONE_RECLAIM_DISTANCE. It is a compile-time constant, because every replica has to reclaim the same
+ * tombstones at the same version.
+ */
+#define TOMBSTONE_RECLAIM_DISTANCE  (0x10000)
+
+/**
+ * @struct kv_map_snapshot_header_t
+ * @brief The header of a kv_map snapshot file. It is followed by the serialized keys and values in key order, so that
+ * the file can be mapped and deserialized in place.
+ */
+struct kv_map_snapshot_header_t {
+    uint64_t magic;
+    uint32_t format;
+    uint32_t reserved;
+    /** The snapshot includes all updates up to this version. */
+    persistent::version_t version;
+    /** The newest version of the entries, which can be newer than `version` because the snapshot is fuzzy. */
+    persistent::version_t max_version;
+    uint64_t num_entries;
+    /** The size of the serialized entries following the header. */
+    uint64_t payload_size;
+};
+
+/**
+ * @class KVMapSnapshotContext
+ * @brief The deserialization context with the kv_map snapshot file of a persistent store.
+ * It is given to the Persistent constructor, so that DeltaCascadeStoreCore::create() starts the recovery from the
+ * snapshot. The states rebuilt from the log later, for the historical versions, do not see it.
+ */
+class KVMapSnapshotContext : public mutils::RemoteDeserializationContext {
+public:
+    /** The snapshot file, or empty if snapshots are disabled. */
+    const std::string filename;
+    KVMapSnapshotContext(const std::string& _filename) : filename(_filename) {}
+};
+
 /**
  * Persistent Cascade Store Delta Support
  */
@@ -21,12 +70,89 @@ template <typename KT, typename VT, KT* IK, VT* IV>
 class DeltaCascadeStoreCore : public mutils::ByteRepresentable,
                               public persistent::IDeltaSupport<DeltaCascadeStoreCore<KT, VT, IK, IV>> {
 private:
-#if defined(__i386__) || defined(__x86_64__) || defined(_M_AMD64) || defined(_M_IX86)
-    mutable std::atomic<persistent::version_t> lockless_v1;
-    mutable std::atomic<persistent::version_t> lockless_v2;
-#else
-#error The lockless reader/writer works only with TSO memory reordering. Please check https://en.wikipedia.org/wiki/Memory_ordering
-#endif
+    /**
+     * @struct key_versions_t
+     * @brief The sorted versions of a key in the per-key version index.
+     */
+    struct key_versions_t {
+        /** The previous version by key of the oldest indexed version. INVALID_VERSION if the key starts there. */
+        persistent::version_t unindexed_previous_version;
+        /** The indexed versions in ascending order. */
+        std::vector<persistent::version_t> versions;
+    };
+    /**
+     * The per-key version index, updated together with kv_map and rebuilt by applyDelta on recovery. It holds the same
+     * keys as kv_map: a key leaves the index when its tombstone is reclaimed.
+     */
+    std::unordered_map<KT, key_versions_t> version_index;
+    mutable std::shared_mutex version_index_mutex;
+    /**
+     * add the version of a value to the per-key version index.
+     */
+    void index_version(const VT& value);
+    /**
+     * A bucket of the time index, holding the first and the last versions stamped within a time_bucket_us aligned span,
+     * with their timestamps.
+     */
+    struct time_bucket_t {
+        uint64_t first_ts_us;
+        persistent::version_t first_version;
+        uint64_t last_ts_us;
+        persistent::version_t last_version;
+    };
+    /**
+     * The time index of the versions applied since the core is created, in ascending order of both the timestamps and
+     * the versions. Updated together with kv_map and rebuilt by applyDelta on recovery. A bucket spans a microsecond to
+     * start with; whenever there are more than TIME_INDEX_MAX_BUCKETS buckets, the span doubles and the neighbouring
+     * buckets are merged, so the index stays bounded however long the process runs. A time between the first and the
+     * last versions of a bucket is narrowed down to the versions of the bucket, and the caller searches the log
+     * between them.
+     */
+    std::deque<time_bucket_t> time_index;
+    uint64_t time_bucket_us = 1;
+    mutable std::shared_mutex time_index_mutex;
+    /**
+     * add the timestamp and the version of a value to the time index.
+     */
+    void index_time(const VT& value);
+    /**
+     * index the versions and the tombstones in kv_map, when the core is constructed from a kv_map.
+     */
+    void index_current_state();
+    /**
+     * Get the latest version of a key, including the version of its tombstone if it is not reclaimed yet.
+     *
+     * @return The version, or INVALID_VERSION if the key is not in kv_map.
+     */
+    persistent::version_t latest_version_by_key(const KT& key) const;
+    /** The versions and keys of the tombstones in kv_map, in version order. Touched by the predicate thread only. */
+    std::deque<std::pair<persistent::version_t, KT>> tombstones;
+    /**
+     * Reclaim the tombstones, which are the null objects ordered_remove leaves in kv_map, up to version
+     * `applied_version - TOMBSTONE_RECLAIM_DISTANCE`, together with their keys in the version index. It is called by
+     * apply_ordered_put, so the reclamation is a function of the applied versions only: every replica, as well as a
+     * core recovered from the log, a snapshot, or a state transfer, reclaims the same tombstones at the same version.
+     * The delta log is untouched, so the removed objects remain available for time travel.
+     *
+     * @param[in]   applied_version     The version being applied.
+     */
+    void compact_tombstones(persistent::version_t applied_version);
+    /** The number of reclaimed tombstones. */
+    std::atomic<uint64_t> num_reclaimed_tombstones{0};
+    /** The approximated memory reclaimed with the tombstones, in bytes. */
+    std::atomic<uint64_t> reclaimed_tombstone_bytes{0};
+    /** The version of the snapshot the core is loaded from. applyDelta skips the updates up to it. */
+    persistent::version_t snapshot_version = persistent::INVALID_VERSION;
+    /** The newest version in the snapshot the core is loaded from. */
+    persistent::version_t snapshot_max_version = persistent::INVALID_VERSION;
+    /** The key of the entry at snapshot_max_version, which the log must have at that version. */
+    KT snapshot_max_version_key;
+    /**
+     * load a core from a kv_map snapshot file.
+     *
+     * @return The core, or nullptr if the file does not exist or is not a valid snapshot.
+     */
+    static std::unique_ptr<DeltaCascadeStoreCore> load_snapshot(const std::string& filename);
 
 public:
     /**
@@ -58,8 +184,8 @@ public:
     };
     /** The delta is a list of keys for the objects that are changed by put or remove. */
     std::vector<KT> delta;
-    /** The KV map */
-    std::map<KT, VT> kv_map;
+    /** The KV map, updated by the predicate thread and read locklessly by the others. */
+    ConcurrentOrderedMap<KT, VT> kv_map;
 
     //////////////////////////////////////////////////////////////////////////
     // Delta is represented by a list of objects for both put and remove
@@ -79,6 +205,22 @@ public:
      * Ordered put, and generate a delta.
      */
     virtual bool ordered_put(const VT& value, persistent::version_t prever, bool as_trigger);
+    /**
+     * Ordered put of a batch of objects with distinct keys, and generate one delta for all of them. Each object is
+     * validated and verified against the state before the batch, and validated against the objects before it in the
+     * batch; nothing is applied if any of them fails.
+     */
+    virtual bool ordered_put_batch(const std::vector<VT>& values, persistent::version_t prev_ver, bool as_trigger);
+    /**
+     * Ordered put of a sequence of objects, where a key may appear more than once, and generate one delta for all of
+     * them. The objects are applied in order, as if they were put one by one, except that they share one version: each
+     * of them is validated against the state including the objects before it, and an object failing the validation or
+     * the previous version verification is skipped without affecting the others. The previous version by key of an
+     * object is that of its key before the sequence, and the delta holds the last object applied to each key.
+     *
+     * @return a flag for each object, telling if it is applied.
+     */
+    virtual std::vector<bool> ordered_put_batch_in_order(const std::vector<VT>& values, persistent::version_t prev_ver, bool as_trigger);
     /**
      * Ordered remove, and generate a delta.
      */
@@ -88,9 +230,14 @@ public:
      */
     virtual const VT ordered_get(const KT& key) const;
     /**
-     * lockless get for the caller from a thread other than the predicate thread.
+     * lockless get for the caller from a thread other than the predicate thread. If VT implements ISharedView, the
+     * returned object is a view sharing the stored object instead of a copy.
      */
     virtual const VT lockless_get(const KT& key) const;
+    /**
+     * lockless get of a list of keys in one pass, for the caller from a thread other than the predicate thread.
+     */
+    virtual std::vector<VT> lockless_multi_key_get(const std::vector<KT>& keys) const;
     /**
      * ordered list_keys, no need to generate a delta.
      */
@@ -99,6 +246,11 @@ public:
      * locklessly list keys for the caller from a thread other than the predicate thread.
      */
     virtual std::vector<KT> lockless_list_keys(const std::string& prefix) const;
+    /**
+     * locklessly scan a page of objects for the caller from a thread other than the predicate thread.
+     */
+    virtual scan_page_tuple<KT, VT> lockless_scan(const std::string& prefix, const KT& cursor,
+                                                  uint32_t max_items, uint64_t max_bytes) const;
     /**
      * ordered get_size, not need to generate a delta.
      */
@@ -107,14 +259,85 @@ public:
      * locklessly get size of an object
      */
     virtual uint64_t lockless_get_size(const KT& key) const;
+    /**
+     * Find the latest version of a key not newer than a given version, using the per-key version index, for the
+     * caller from a thread other than the predicate thread.
+     * If the index does not reach back to 'ver', for example, because the index started from a state transfer, the
+     * oldest known version is returned, and the caller has to follow the `previous_version_by_key` chain from there
+     * as long as the version is newer than 'ver'.
+     *
+     * @param[in]   key     The key
+     * @param[in]   ver     The version
+     *
+     * @return The version of the key, or INVALID_VERSION if the key did not exist at 'ver'.
+     */
+    virtual persistent::version_t lockless_get_version_by_key(const KT& key, persistent::version_t ver) const;
+    /**
+     * Find the latest version stamped not later than a given time, using the time index, for the caller from a thread
+     * other than the predicate thread. The index only covers the versions applied since the core is created, and only
+     * down to the span of its buckets: a time before the oldest indexed version is not answered, and the caller has to
+     * search the log instead. A time between the first and the last versions of a bucket is not answered either, but
+     * the two versions are returned, and the caller only has to search the log between them.
+     *
+     * @param[in]   ts_us           The time in microseconds.
+     * @param[out]  bucket_first    The first version of the bucket containing the time, or INVALID_VERSION.
+     * @param[out]  bucket_last     The last version of the bucket containing the time, or INVALID_VERSION.
+     *
+     * @return The version, or INVALID_VERSION if the time is not answered by the index.
+     */
+    virtual persistent::version_t lockless_get_version_at_time(uint64_t ts_us,
+                                                               persistent::version_t& bucket_first,
+                                                               persistent::version_t& bucket_last) const;
+    /**
+     * Write a snapshot of kv_map to a file, for the caller from a thread other than the predicate thread. The entries
+     * are visited locklessly while the predicate thread keeps updating kv_map, so the snapshot is fuzzy: it includes
+     * every update up to 'ver', and possibly some later ones, which applyDelta applies again idempotently on recovery.
+     * The file is written to a temporary file first, renamed when it is complete, and its directory is synced so that
+     * the rename survives a crash. Only value types implementing IKeepVersion are supported.
+     * A version applied to kv_map may still be lost in a view change or a restart until it is persisted, so the
+     * temporary file is only renamed after 'wait_for_persistence' returns true for the newest version in it. A snapshot
+     * therefore never holds an update the log may not end up with.
+     *
+     * @param[in]   filename                The snapshot file.
+     * @param[in]   ver                     A version already applied to kv_map.
+     * @param[in]   wait_for_persistence    Wait until the given version is persisted, and return false if it is not
+     *                                      going to be. Every version in kv_map is treated as persisted if it is empty.
+     *
+     * @return true if the snapshot is written, otherwise false.
+     */
+    virtual bool lockless_save_snapshot(const std::string& filename, persistent::version_t ver,
+                                        const std::function<bool(persistent::version_t)>& wait_for_persistence = {}) const;
+    /**
+     * Get the newest version in the snapshot the core is loaded from, or INVALID_VERSION if it is not loaded from a
+     * snapshot. If the log ends before it, or does not hold the same entry at it, the snapshot cannot be completed by
+     * the log.
+     */
+    persistent::version_t get_snapshot_max_version() const;
+    /**
+     * Get the key of the entry at the newest version in the snapshot the core is loaded from.
+     */
+    const KT& get_snapshot_max_version_key() const;
+    /**
+     * Replace the state with a kv_map rebuilt elsewhere, for example, from the log. It must be called before the
+     * core is shared with the other threads.
+     */
+    void reset_state(const ConcurrentOrderedMap<KT, VT>& _kv_map);
+    /**
+     * Get the number of tombstones reclaimed so far.
+     */
+    uint64_t get_num_reclaimed_tombstones() const;
+    /**
+     * Get the approximated memory reclaimed with the tombstones so far, in bytes.
+     */
+    uint64_t get_reclaimed_tombstone_bytes() const;
 
     // serialization supports
     DEFAULT_SERIALIZATION_SUPPORT(DeltaCascadeStoreCore, kv_map);
 
     // constructors
     DeltaCascadeStoreCore();
-    DeltaCascadeStoreCore(const std::map<KT, VT>& _kv_map);
-    DeltaCascadeStoreCore(std::map<KT, VT>&& _kv_map);
+    DeltaCascadeStoreCore(const ConcurrentOrderedMap<KT, VT>& _kv_map);
+    DeltaCascadeStoreCore(ConcurrentOrderedMap<KT, VT>&& _kv_map);
 
     // destructor
     virtual ~DeltaCascadeStoreCore();
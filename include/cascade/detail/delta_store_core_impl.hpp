@@ -4,6 +4,7 @@
 #include "cascade/config.h"
 #include "cascade/utils.hpp"
 #include "debug_util.hpp"
+#include "store_util.hpp"
 
 #include <derecho/core/derecho.hpp>
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
@@ -13,10 +14,24 @@
 #include <derecho/utils/time.h>
 #endif
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
 #include <type_traits>
+#include <unordered_set>
 #include <vector>
 
 namespace derecho {
@@ -109,7 +124,7 @@ size_t DeltaCascadeStoreCore<KT, VT, IK, IV>::currentDeltaSize() {
     if (delta.size() > 0) {
         delta_size += mutils::bytes_size(static_cast<std::size_t>(delta.size()));
         for (const auto& k:delta) {
-            delta_size+=mutils::bytes_size(this->kv_map[k]);
+            delta_size+=mutils::bytes_size(this->kv_map.at(k));
         }
     }
     return delta_size;
@@ -125,7 +140,7 @@ size_t DeltaCascadeStoreCore<KT, VT, IK, IV>::currentDeltaToBytes(uint8_t * cons
     }
     size_t offset = mutils::to_bytes(static_cast<std::size_t>(delta.size()),buf);
     for(const auto& k:delta) {
-        offset += mutils::to_bytes(this->kv_map[k],buf+offset);
+        offset += mutils::to_bytes(this->kv_map.at(k),buf+offset);
     }
     delta.clear();
     return offset;
@@ -139,7 +154,14 @@ void DeltaCascadeStoreCore<KT, VT, IK, IV>::applyDelta(uint8_t const* const seri
         offset +=
             mutils::deserialize_and_run(nullptr, serialized_delta + offset,
                 [this](const VT& value) {
-                    this->apply_ordered_put(value);
+                    // the updates up to the snapshot version are in the snapshot already.
+                    bool in_snapshot = false;
+                    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+                        in_snapshot = (value.get_version() <= this->snapshot_version);
+                    }
+                    if(!in_snapshot) {
+                        this->apply_ordered_put(value);
+                    }
                     return mutils::bytes_size(value);
                 }
             );
@@ -148,42 +170,161 @@ void DeltaCascadeStoreCore<KT, VT, IK, IV>::applyDelta(uint8_t const* const seri
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 void DeltaCascadeStoreCore<KT, VT, IK, IV>::apply_ordered_put(const VT& value) {
-    // for lockless check
-    this->lockless_v1.store(value.get_version(), std::memory_order_relaxed);
-    // compiler reordering barrier
-#ifdef __GNUC__
-    asm volatile("" ::
-                         : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
+    // The lockless readers either see the old value or the new one. The old one is reclaimed after they are done.
+    this->kv_map.insert_or_assign(value.get_key_ref(), value);
+    index_version(value);
+    index_time(value);
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        if(value.is_null()) {
+            this->tombstones.emplace_back(value.get_version(), value.get_key_ref());
+        }
+        compact_tombstones(value.get_version());
+    }
+}
 
-    this->kv_map.erase(value.get_key_ref());
-    this->kv_map.emplace(value.get_key_ref(), value);
+template <typename KT, typename VT, KT* IK, VT* IV>
+persistent::version_t DeltaCascadeStoreCore<KT, VT, IK, IV>::latest_version_by_key(const KT& key) const {
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        {
+            std::shared_lock<std::shared_mutex> rlck(this->version_index_mutex);
+            auto it = this->version_index.find(key);
+            if(it != this->version_index.end()) {
+                return it->second.versions.empty() ? it->second.unindexed_previous_version : it->second.versions.back();
+            }
+        }
+        // every key in kv_map is indexed, so this is only a safety net.
+        persistent::version_t current_version = persistent::INVALID_VERSION;
+        this->kv_map.read(key, [&current_version](const VT& value) { current_version = value.get_version(); });
+        return current_version;
+    } else {
+        return persistent::INVALID_VERSION;
+    }
+}
 
-    // compiler reordering barrier
-#ifdef __GNUC__
-    asm volatile("" ::
-                         : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::index_version(const VT& value) {
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        persistent::version_t previous_version_by_key = persistent::INVALID_VERSION;
+        if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+            previous_version_by_key = value.previous_version_by_key;
+        }
+        std::unique_lock<std::shared_mutex> wlck(this->version_index_mutex);
+        auto& key_versions = this->version_index.try_emplace(value.get_key_ref(),
+                key_versions_t{previous_version_by_key, {}}).first->second;
+        if(key_versions.versions.empty() || key_versions.versions.back() < value.get_version()) {
+            key_versions.versions.push_back(value.get_version());
+        }
+    }
+}
 
-    // for lockless check
-    this->lockless_v2.store(value.get_version(), std::memory_order_relaxed);
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::index_time(const VT& value) {
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value && std::is_base_of<IKeepTimestamp, VT>::value) {
+        const uint64_t ts_us = value.get_timestamp();
+        const persistent::version_t version = value.get_version();
+        std::unique_lock<std::shared_mutex> wlck(this->time_index_mutex);
+        if(this->time_index.empty() || this->time_index.back().first_ts_us / this->time_bucket_us < ts_us / this->time_bucket_us) {
+            this->time_index.push_back({ts_us, version, ts_us, version});
+        } else if(this->time_index.back().last_version < version) {
+            // The versions stamped within the same bucket share one entry.
+            this->time_index.back().last_ts_us = std::max(this->time_index.back().last_ts_us, ts_us);
+            this->time_index.back().last_version = version;
+        }
+        if(this->time_index.size() > TIME_INDEX_MAX_BUCKETS) {
+            // Double the bucket span and merge the buckets falling into the same span, which halves the index.
+            this->time_bucket_us *= 2;
+            std::deque<time_bucket_t> merged;
+            for(const auto& bucket : this->time_index) {
+                if(!merged.empty() && merged.back().first_ts_us / this->time_bucket_us == bucket.first_ts_us / this->time_bucket_us) {
+                    merged.back().last_ts_us = bucket.last_ts_us;
+                    merged.back().last_version = bucket.last_version;
+                } else {
+                    merged.push_back(bucket);
+                }
+            }
+            this->time_index.swap(merged);
+            dbg_default_debug("{}: the time index buckets span {} us now.", __PRETTY_FUNCTION__, this->time_bucket_us);
+        }
+    }
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 std::unique_ptr<DeltaCascadeStoreCore<KT, VT, IK, IV>> DeltaCascadeStoreCore<KT, VT, IK, IV>::create(mutils::DeserializationManager* dm) {
-    if(dm != nullptr) {
-        try {
-            return std::make_unique<DeltaCascadeStoreCore<KT, VT, IK, IV>>();
-        } catch(...) {
+    // Only the recovery in the Persistent constructor comes with the snapshot context.
+    if(dm != nullptr && dm->registered<KVMapSnapshotContext>()) {
+        const std::string& filename = dm->mgr<KVMapSnapshotContext>().filename;
+        if(!filename.empty()) {
+            auto core = load_snapshot(filename);
+            if(core) {
+                return core;
+            }
         }
     }
     return std::make_unique<DeltaCascadeStoreCore<KT, VT, IK, IV>>();
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::unique_ptr<DeltaCascadeStoreCore<KT, VT, IK, IV>> DeltaCascadeStoreCore<KT, VT, IK, IV>::load_snapshot(const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0) {
+        if(errno != ENOENT) {
+            dbg_default_warn("{}: failed to open kv_map snapshot {}: {}", __PRETTY_FUNCTION__, filename, strerror(errno));
+        }
+        return nullptr;
+    }
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0 || static_cast<std::size_t>(file_stat.st_size) < sizeof(kv_map_snapshot_header_t)) {
+        dbg_default_warn("{}: kv_map snapshot {} is truncated.", __PRETTY_FUNCTION__, filename);
+        close(fd);
+        return nullptr;
+    }
+    const std::size_t file_size = static_cast<std::size_t>(file_stat.st_size);
+    void* addr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED) {
+        dbg_default_warn("{}: failed to map kv_map snapshot {}: {}", __PRETTY_FUNCTION__, filename, strerror(errno));
+        return nullptr;
+    }
+
+    std::unique_ptr<DeltaCascadeStoreCore<KT, VT, IK, IV>> core;
+    const auto* header = static_cast<const kv_map_snapshot_header_t*>(addr);
+    if(header->magic != KV_MAP_SNAPSHOT_MAGIC || header->format != KV_MAP_SNAPSHOT_FORMAT
+       || sizeof(kv_map_snapshot_header_t) + header->payload_size != file_size) {
+        dbg_default_warn("{}: {} is not a valid kv_map snapshot.", __PRETTY_FUNCTION__, filename);
+    } else {
+        // The entries are deserialized from the mapped file in place, and copied into the map.
+        const uint8_t* const payload = static_cast<const uint8_t*>(addr) + sizeof(kv_map_snapshot_header_t);
+        ConcurrentOrderedMap<KT, VT> snapshot_map;
+        KT max_version_key = *IK;
+        std::size_t offset = 0;
+        for(uint64_t i = 0; i < header->num_entries && offset < header->payload_size; i++) {
+            auto key_ptr = mutils::from_bytes<KT>(nullptr, payload + offset);
+            offset += mutils::bytes_size(*key_ptr);
+            offset += mutils::deserialize_and_run(nullptr, payload + offset, [&](const VT& value) {
+                if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+                    if(value.get_version() == header->max_version) {
+                        max_version_key = *key_ptr;
+                    }
+                }
+                snapshot_map.insert_or_assign(*key_ptr, value);
+                return mutils::bytes_size(value);
+            });
+        }
+        if(offset != header->payload_size || snapshot_map.size() != header->num_entries) {
+            dbg_default_warn("{}: kv_map snapshot {} is corrupted.", __PRETTY_FUNCTION__, filename);
+        } else {
+            core = std::make_unique<DeltaCascadeStoreCore<KT, VT, IK, IV>>(std::move(snapshot_map));
+            core->snapshot_version = header->version;
+            core->snapshot_max_version = header->max_version;
+            core->snapshot_max_version_key = std::move(max_version_key);
+            dbg_default_info("{}: loaded {} entries from kv_map snapshot {} at version 0x{:x}.",
+                             __PRETTY_FUNCTION__, header->num_entries, filename, header->version);
+        }
+    }
+    munmap(addr, file_size);
+    return core;
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_put(const VT& value, persistent::version_t prev_ver, bool as_trigger) {
     // call validator
@@ -193,24 +334,20 @@ bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_put(const VT& value, persist
         }
     }
 
+    // The previous version by key of a removed key is the version of its tombstone until the tombstone is reclaimed,
+    // which happens at the same version on every replica.
+    persistent::version_t prev_ver_by_key = persistent::INVALID_VERSION;
+    if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+        prev_ver_by_key = latest_version_by_key(value.get_key_ref());
+    }
     // verify version MUST happen before updating it's previous versions (prev_ver,prev_ver_by_key).
     if constexpr(std::is_base_of<IVerifyPreviousVersion, VT>::value) {
-        bool verify_result;
-        if(kv_map.find(value.get_key_ref()) != this->kv_map.end()) {
-            verify_result = value.verify_previous_version(prev_ver, this->kv_map.at(value.get_key_ref()).get_version());
-        } else {
-            verify_result = value.verify_previous_version(prev_ver, persistent::INVALID_VERSION);
-        }
-        if(!verify_result) {
+        if(!value.verify_previous_version(prev_ver, prev_ver_by_key)) {
             // reject the package if verify failed.
             return false;
         }
     }
     if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
-        persistent::version_t prev_ver_by_key = persistent::INVALID_VERSION;
-        if(kv_map.find(value.get_key_ref()) != kv_map.end()) {
-            prev_ver_by_key = kv_map.at(value.get_key_ref()).get_version();
-        }
         value.set_previous_version(prev_ver, prev_ver_by_key);
     }
     if (!as_trigger) {
@@ -223,6 +360,90 @@ bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_put(const VT& value, persist
     return true;
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_put_batch(const std::vector<VT>& values, persistent::version_t prev_ver, bool as_trigger) {
+    // validate and verify all objects before touching the state.
+    std::unordered_set<KT> batch_keys;
+    std::vector<persistent::version_t> prev_vers_by_key(values.size(), persistent::INVALID_VERSION);
+    // the objects validated so far, which the objects after them are validated against as well as kv_map.
+    ConcurrentOrderedMap<KT, VT> validated_values;
+    for(std::size_t i = 0; i < values.size(); i++) {
+        const VT& value = values[i];
+        if(!batch_keys.insert(value.get_key_ref()).second) {
+            dbg_default_warn("{}: reject the batch because key:{} appears more than once.", __PRETTY_FUNCTION__, value.get_key_ref());
+            return false;
+        }
+        if constexpr(std::is_base_of<IValidator<KT, VT>, VT>::value) {
+            if(!value.validate(this->kv_map) || !value.validate(validated_values)) {
+                return false;
+            }
+            validated_values.insert_or_assign(value.get_key_ref(), value);
+        }
+        // same as ordered_put, the previous version by key of a removed key is the version of its unreclaimed tombstone.
+        if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+            prev_vers_by_key[i] = latest_version_by_key(value.get_key_ref());
+        }
+        if constexpr(std::is_base_of<IVerifyPreviousVersion, VT>::value) {
+            if(!value.verify_previous_version(prev_ver, prev_vers_by_key[i])) {
+                return false;
+            }
+        }
+    }
+    for(std::size_t i = 0; i < values.size(); i++) {
+        if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+            values[i].set_previous_version(prev_ver, prev_vers_by_key[i]);
+        }
+    }
+    if (!as_trigger) {
+        // create one delta for the whole batch.
+        assert(this->delta.empty());
+        for(const auto& value : values) {
+            this->delta.push_back(value.get_key_ref());
+            apply_ordered_put(value);
+        }
+    }
+    return true;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<bool> DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_put_batch_in_order(const std::vector<VT>& values, persistent::version_t prev_ver, bool as_trigger) {
+    std::vector<bool> applied(values.size(), false);
+    // the previous version by key of each key applied so far, which is the one before the sequence: a key put again in
+    // the sequence must not point back at the sequence's own version.
+    std::unordered_map<KT, persistent::version_t> applied_keys;
+    assert(this->delta.empty());
+    for(std::size_t i = 0; i < values.size(); i++) {
+        const VT& value = values[i];
+        if constexpr(std::is_base_of<IValidator<KT, VT>, VT>::value) {
+            if(!value.validate(this->kv_map)) {
+                continue;
+            }
+        }
+        persistent::version_t prev_ver_by_key = persistent::INVALID_VERSION;
+        if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+            auto it = applied_keys.find(value.get_key_ref());
+            prev_ver_by_key = (it != applied_keys.end()) ? it->second : latest_version_by_key(value.get_key_ref());
+        }
+        if constexpr(std::is_base_of<IVerifyPreviousVersion, VT>::value) {
+            if(!value.verify_previous_version(prev_ver, prev_ver_by_key)) {
+                continue;
+            }
+        }
+        if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+            value.set_previous_version(prev_ver, prev_ver_by_key);
+        }
+        applied[i] = true;
+        if (!as_trigger) {
+            // the delta serializes the objects from kv_map, so a key goes to it only once.
+            if(applied_keys.emplace(value.get_key_ref(), prev_ver_by_key).second) {
+                this->delta.push_back(value.get_key_ref());
+            }
+            apply_ordered_put(value);
+        }
+    }
+    return applied;
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_remove(const VT& value, persistent::version_t prev_ver) {
     auto& key = value.get_key_ref();
@@ -257,95 +478,28 @@ const VT DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_get(const KT& key) const
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 const VT DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_get(const KT& key) const {
-    persistent::version_t v1, v2;
-    static thread_local VT copied_out;
-    do {
-        // This only for TSO memory reordering.
-        v2 = this->lockless_v2.load(std::memory_order_relaxed);
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        /* 
-         * An out_of_range exception can be thrown even if 'key' exists in
-         * kv_map. Since std::map is not thread-safe, and there is another
-         * thread modifying kv_map concurrently, the internal data structure can
-         * be changed while this thread is inside kv_map.at(key). Therefore, we
-         * keep trying until it is possible to copy either the object we are
-         * looking for, or the invalid object.
-         */
-        while(true) {
-            try {
-                if(this->kv_map.find(key) != this->kv_map.end()) {
-                    copied_out.copy_from(this->kv_map.at(key));
-                } else {
-                    copied_out.copy_from(*IV);
-                }
+    return lockless_get_view(this->kv_map, key, *IV);
+}
 
-                break;
-            } catch (const std::out_of_range&) {
-                dbg_default_debug("{}: out_of_range exception thrown while trying to get key {}", __PRETTY_FUNCTION__, key);
-            }
-        }
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        v1 = this->lockless_v1.load(std::memory_order_relaxed);
-        // busy sleep
-        std::this_thread::yield();
-    } while(v1 != v2);
-    return copied_out;
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<VT> DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_multi_key_get(const std::vector<KT>& keys) const {
+    return derecho::cascade::lockless_multi_key_get(this->kv_map, keys, *IV);
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 std::vector<KT> DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_list_keys(const std::string& prefix) const {
-    persistent::version_t v1, v2;
-    std::vector<KT> key_list;
-    do {
-        // This only for TSO memory reordering.
-        v2 = this->lockless_v2.load(std::memory_order_relaxed);
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        for(const auto& kv : kv_map) {
-            if(get_pathname<KT>(kv.first).find(prefix) == 0) {
-                key_list.push_back(kv.first);
-            }
-        }
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        v1 = this->lockless_v1.load(std::memory_order_relaxed);
-        // busy sleep
-        std::this_thread::yield();
-    } while(v1 != v2);
-    return key_list;
+    return list_keys_by_prefix(this->kv_map, prefix);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+scan_page_tuple<KT, VT> DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_scan(const std::string& prefix, const KT& cursor,
+                                                                            uint32_t max_items, uint64_t max_bytes) const {
+    return scan_by_prefix(this->kv_map, prefix, cursor, *IK, max_items, max_bytes);
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 std::vector<KT> DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_list_keys(const std::string& prefix) {
-    std::vector<KT> key_list;
-    for(const auto& kv : kv_map) {
-        if(get_pathname<KT>(kv.first).find(prefix) == 0) {
-            key_list.push_back(kv.first);
-        }
-    }
-    return key_list;
+    return list_keys_by_prefix(this->kv_map, prefix);
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
@@ -359,51 +513,221 @@ uint64_t DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_get_size(const KT& key)
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 uint64_t DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_get_size(const KT& key) const {
-    persistent::version_t v1, v2;
     uint64_t size = 0ull;
-
-    do {
-        // This only for TSO memory reordering.
-        v2 = this->lockless_v2.load(std::memory_order_relaxed);
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        if(this->kv_map.find(key) != this->kv_map.end()) {
-            size = mutils::bytes_size(this->kv_map.at(key));
-        }
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        v1 = this->lockless_v1.load(std::memory_order_relaxed);
-        // busy sleep
-        std::this_thread::yield();
-    } while(v1 != v2);
+    this->kv_map.read(key, [&size](const VT& value) { size = mutils::bytes_size(value); });
     return size;
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
-DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaCascadeStoreCore() : lockless_v1(persistent::INVALID_VERSION),
-                                                                 lockless_v2(persistent::INVALID_VERSION) {
+persistent::version_t DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_get_version_by_key(const KT& key, persistent::version_t ver) const {
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        {
+            std::shared_lock<std::shared_mutex> rlck(this->version_index_mutex);
+            auto it = this->version_index.find(key);
+            if(it != this->version_index.end()) {
+                const auto& versions = it->second.versions;
+                auto pos = std::upper_bound(versions.begin(), versions.end(), ver);
+                if(pos != versions.begin()) {
+                    return *(pos - 1);
+                }
+                return it->second.unindexed_previous_version;
+            }
+        }
+        // The key is not indexed, start from its current version.
+        persistent::version_t current_version = persistent::INVALID_VERSION;
+        this->kv_map.read(key, [&current_version](const VT& value) { current_version = value.get_version(); });
+        return current_version;
+    } else {
+        return persistent::INVALID_VERSION;
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+persistent::version_t DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_get_version_at_time(
+        uint64_t ts_us, persistent::version_t& bucket_first, persistent::version_t& bucket_last) const {
+    bucket_first = persistent::INVALID_VERSION;
+    bucket_last = persistent::INVALID_VERSION;
+    std::shared_lock<std::shared_mutex> rlck(this->time_index_mutex);
+    auto pos = std::upper_bound(this->time_index.begin(), this->time_index.end(), ts_us,
+                                [](uint64_t ts, const time_bucket_t& bucket) { return ts < bucket.first_ts_us; });
+    if(pos == this->time_index.begin()) {
+        return persistent::INVALID_VERSION;
+    }
+    // Nothing is stamped between the last version of a bucket and the first version of the next one.
+    if(ts_us < (pos - 1)->last_ts_us) {
+        bucket_first = (pos - 1)->first_version;
+        bucket_last = (pos - 1)->last_version;
+        return persistent::INVALID_VERSION;
+    }
+    return (pos - 1)->last_version;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::compact_tombstones(persistent::version_t applied_version) {
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        if(applied_version < TOMBSTONE_RECLAIM_DISTANCE) {
+            return;
+        }
+        const persistent::version_t reclaimable_version = applied_version - TOMBSTONE_RECLAIM_DISTANCE;
+        uint64_t num_reclaimed = 0;
+        uint64_t reclaimed_bytes = 0;
+        while(!this->tombstones.empty() && this->tombstones.front().first <= reclaimable_version) {
+            const auto& tombstone = this->tombstones.front();
+            auto it = this->kv_map.find(tombstone.second);
+            // skip the key if it is put again after the removal.
+            if(it != this->kv_map.end() && it->second.is_null() && it->second.get_version() == tombstone.first) {
+                reclaimed_bytes += mutils::bytes_size(tombstone.second) + mutils::bytes_size(it->second);
+                {
+                    std::unique_lock<std::shared_mutex> wlck(this->version_index_mutex);
+                    this->version_index.erase(tombstone.second);
+                }
+                this->kv_map.erase(tombstone.second);
+                num_reclaimed++;
+            }
+            this->tombstones.pop_front();
+        }
+        if(num_reclaimed > 0) {
+            this->num_reclaimed_tombstones.fetch_add(num_reclaimed, std::memory_order_relaxed);
+            this->reclaimed_tombstone_bytes.fetch_add(reclaimed_bytes, std::memory_order_relaxed);
+            dbg_default_debug("{}: reclaimed {} tombstones ({} bytes) up to version 0x{:x}, {} tombstones ({} bytes) reclaimed in total.",
+                              __PRETTY_FUNCTION__, num_reclaimed, reclaimed_bytes, reclaimable_version,
+                              this->num_reclaimed_tombstones.load(std::memory_order_relaxed),
+                              this->reclaimed_tombstone_bytes.load(std::memory_order_relaxed));
+        }
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_save_snapshot(const std::string& filename, persistent::version_t ver,
+                                                                   const std::function<bool(persistent::version_t)>& wait_for_persistence) const {
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        const std::string tmp_filename = filename + ".tmp";
+        FILE* file = fopen(tmp_filename.c_str(), "wb");
+        if(file == nullptr) {
+            dbg_default_error("{}: failed to create {}: {}", __PRETTY_FUNCTION__, tmp_filename, strerror(errno));
+            return false;
+        }
+        kv_map_snapshot_header_t header{KV_MAP_SNAPSHOT_MAGIC, KV_MAP_SNAPSHOT_FORMAT, 0, ver, ver, 0, 0};
+        bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+        const std::function<void(uint8_t const* const, std::size_t)> writer =
+                [&ok, &header, file](uint8_t const* const buf, std::size_t size) {
+                    if(ok && size > 0) {
+                        ok = (fwrite(buf, size, 1, file) == 1);
+                        header.payload_size += size;
+                    }
+                };
+        this->kv_map.for_each([&writer, &header](const KT& key, const VT& value) {
+            mutils::post_object(writer, key);
+            mutils::post_object(writer, value);
+            header.max_version = std::max(header.max_version, value.get_version());
+            header.num_entries++;
+        });
+        // rewrite the header with the entry count and the payload size.
+        ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1
+             && fflush(file) == 0 && fsync(fileno(file)) == 0;
+        ok = (fclose(file) == 0) && ok;
+        // the newest update in the file may not be persisted yet, and may be lost before it is.
+        if(ok && wait_for_persistence && !wait_for_persistence(header.max_version)) {
+            dbg_default_warn("{}: drop kv_map snapshot {} because version 0x{:x} in it is not persisted.",
+                             __PRETTY_FUNCTION__, filename, header.max_version);
+            unlink(tmp_filename.c_str());
+            return false;
+        }
+        if(!ok || rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+            dbg_default_error("{}: failed to write kv_map snapshot {}: {}", __PRETTY_FUNCTION__, filename, strerror(errno));
+            unlink(tmp_filename.c_str());
+            return false;
+        }
+        // the rename is durable only after the directory is synced.
+        const std::size_t separator_pos = filename.rfind('/');
+        const std::string dirname = (separator_pos == std::string::npos) ? "." : filename.substr(0, separator_pos + 1);
+        int dir_fd = open(dirname.c_str(), O_RDONLY | O_DIRECTORY);
+        if(dir_fd < 0 || fsync(dir_fd) != 0) {
+            dbg_default_error("{}: failed to sync directory {} of kv_map snapshot {}: {}", __PRETTY_FUNCTION__, dirname, filename, strerror(errno));
+            if(dir_fd >= 0) {
+                close(dir_fd);
+            }
+            return false;
+        }
+        close(dir_fd);
+        dbg_default_debug("{}: wrote {} entries ({} bytes) to kv_map snapshot {} at version 0x{:x}.",
+                          __PRETTY_FUNCTION__, header.num_entries, header.payload_size, filename, ver);
+        return true;
+    } else {
+        dbg_default_warn("{}: kv_map snapshots require the values to keep versions.", __PRETTY_FUNCTION__);
+        return false;
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+persistent::version_t DeltaCascadeStoreCore<KT, VT, IK, IV>::get_snapshot_max_version() const {
+    return this->snapshot_max_version;
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
-DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaCascadeStoreCore(const std::map<KT, VT>& _kv_map) : lockless_v1(persistent::INVALID_VERSION),
-                                                                                                lockless_v2(persistent::INVALID_VERSION),
-                                                                                                kv_map(_kv_map) {
+const KT& DeltaCascadeStoreCore<KT, VT, IK, IV>::get_snapshot_max_version_key() const {
+    return this->snapshot_max_version_key;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::reset_state(const ConcurrentOrderedMap<KT, VT>& _kv_map) {
+    this->kv_map.clear();
+    for(const auto& kv : _kv_map) {
+        this->kv_map.insert_or_assign(kv.first, kv.second);
+    }
+    this->delta.clear();
+    this->tombstones.clear();
+    {
+        std::unique_lock<std::shared_mutex> wlck(this->version_index_mutex);
+        this->version_index.clear();
+    }
+    {
+        std::unique_lock<std::shared_mutex> wlck(this->time_index_mutex);
+        this->time_index.clear();
+        this->time_bucket_us = 1;
+    }
+    this->snapshot_version = persistent::INVALID_VERSION;
+    this->snapshot_max_version = persistent::INVALID_VERSION;
+    this->snapshot_max_version_key = *IK;
+    index_current_state();
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+uint64_t DeltaCascadeStoreCore<KT, VT, IK, IV>::get_num_reclaimed_tombstones() const {
+    return this->num_reclaimed_tombstones.load(std::memory_order_relaxed);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+uint64_t DeltaCascadeStoreCore<KT, VT, IK, IV>::get_reclaimed_tombstone_bytes() const {
+    return this->reclaimed_tombstone_bytes.load(std::memory_order_relaxed);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::index_current_state() {
+    for(const auto& kv : this->kv_map) {
+        index_version(kv.second);
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            if(kv.second.is_null()) {
+                this->tombstones.emplace_back(kv.second.get_version(), kv.first);
+            }
+        }
+    }
+    std::sort(this->tombstones.begin(), this->tombstones.end(),
+              [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaCascadeStoreCore() {}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaCascadeStoreCore(const ConcurrentOrderedMap<KT, VT>& _kv_map) : kv_map(_kv_map) {
+    // The history before a state transfer is not in the index. It starts from the current versions.
+    index_current_state();
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
-DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaCascadeStoreCore(std::map<KT, VT>&& _kv_map) : lockless_v1(persistent::INVALID_VERSION),
-                                                                                           lockless_v2(persistent::INVALID_VERSION),
-                                                                                           kv_map(std::move(_kv_map)) {
+DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaCascadeStoreCore(ConcurrentOrderedMap<KT, VT>&& _kv_map) : kv_map(std::move(_kv_map)) {
+    index_current_state();
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <derecho/core/derecho_type_definitions.hpp>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * @class MemberLoads
+ * @brief The load of each shard member as seen by a client, which drives the adaptive member selection policies
+ * (LeastOutstandingRequests and PowerOfTwoChoices).
+ *
+ * The load of a member counts the requests sent to it whose replies have not arrived yet, and keeps the moving average
+ * of its reply latency. The loads are keyed by node id and created on the first request to a member, so members never
+ * share a load.
+ *
+ * A reply is accounted for when it arrives, not when the caller gets around to consuming it: a reply watcher thread
+ * per member, started with the first tracked request to it, waits for the tracked replies in the order they were sent.
+ * A caller consuming a reply before the watcher gets to it accounts for the reply itself, so a slow reply never delays
+ * the accounting of a faster one consumed in time.
+ */
+class MemberLoads {
+private:
+    /**
+     * A reply the watcher of a member waits for.
+     */
+    struct watched_reply_t {
+        virtual ~watched_reply_t() = default;
+        /**
+         * Wait for the reply up to a timeout, and account for it if it arrives.
+         *
+         * @param[in]   timeout
+         *
+         * @return true if the reply is accounted for, by this call or by the caller, false on timeout.
+         */
+        virtual bool watch(const std::chrono::nanoseconds& timeout) = 0;
+    };
+
+    struct alignas(64) member_t {
+        std::atomic<uint32_t> outstanding{0};
+        std::atomic<uint64_t> ewma_latency_ns{0};
+
+        /** The replies to account for, in the order they were sent. */
+        std::mutex watcher_mutex;
+        std::condition_variable watcher_cv;
+        std::deque<std::shared_ptr<watched_reply_t>> watched_replies;
+        std::once_flag watcher_flag;
+        std::thread watcher;
+
+        /**
+         * Feed the latency of a reply to the moving average, and count the request as done.
+         */
+        void on_reply(uint64_t latency_ns);
+    };
+
+    /** How long the watcher waits for a reply before checking if it is stopping. */
+    static constexpr std::chrono::milliseconds watch_interval{100};
+
+    /** The members are shared with the guards of their requests, which may outlive this object. */
+    mutable std::shared_mutex members_mutex;
+    std::unordered_map<node_id_t,std::shared_ptr<member_t>> members;
+    std::atomic<bool> stopping;
+
+    /**
+     * Get the load of a member, creating it on the first request to the member.
+     */
+    std::shared_ptr<member_t> get_member(node_id_t node_id);
+    /**
+     * The watcher thread of a member.
+     */
+    void watch_replies(member_t* member);
+
+    template <typename ReturnType>
+    struct tracked_reply_t;
+
+public:
+    /**
+     * @class load_guard_t
+     * @brief Counts a request sent to a member as outstanding, exactly once: until on_reply() is called when its reply
+     * arrives, which also feeds the reply latency to the moving average, or until the guard is dropped.
+     */
+    class load_guard_t {
+        std::shared_ptr<member_t> member;
+        const uint64_t send_ns;
+
+        load_guard_t(std::shared_ptr<member_t>&& _member);
+        friend class MemberLoads;
+
+    public:
+        load_guard_t(MemberLoads& loads, node_id_t node_id);
+        load_guard_t(const load_guard_t&) = delete;
+        load_guard_t& operator=(const load_guard_t&) = delete;
+        void on_reply();
+        ~load_guard_t();
+    };
+
+    MemberLoads();
+    MemberLoads(const MemberLoads&) = delete;
+    MemberLoads& operator=(const MemberLoads&) = delete;
+    /**
+     * Stop the reply watchers. The replies they have not accounted for yet are left to their callers.
+     */
+    ~MemberLoads();
+
+    /**
+     * Track the reply of a request sent to a member: count the request as outstanding until the reply arrives, and
+     * feed the reply latency to the moving average then.
+     *
+     * @tparam ReturnType
+     * @param[in]   node_id     The member the request is sent to.
+     * @param[in]   reply       The future of the reply.
+     *
+     * @return the future to hand to the caller in place of 'reply'.
+     */
+    template <typename ReturnType>
+    std::future<ReturnType> track(node_id_t node_id, std::future<ReturnType>&& reply);
+
+    /**
+     * Count a request sent to a member as outstanding, for the callers that account for the replies themselves.
+     *
+     * @param[in]   node_id
+     */
+    void on_send(node_id_t node_id);
+    /**
+     * Account for the reply of a request counted by on_send().
+     *
+     * @param[in]   node_id
+     * @param[in]   latency_ns  The reply latency.
+     */
+    void on_reply(node_id_t node_id, uint64_t latency_ns);
+
+    /**
+     * Get the number of outstanding requests of a member.
+     */
+    uint32_t get_outstanding(node_id_t node_id) const;
+    /**
+     * Get the moving average of the reply latency of a member, or 0 before its first reply.
+     */
+    uint64_t get_ewma_latency_ns(node_id_t node_id) const;
+
+    /**
+     * Pick the member with the fewest outstanding requests, scanning from a rotating position so that ties are broken
+     * in round-robin order.
+     *
+     * @param[in]   shard_members   The shard members, not empty.
+     * @param[in]   position        The rotating position.
+     */
+    node_id_t pick_least_outstanding(const std::vector<node_id_t>& shard_members, uint32_t position) const;
+    /**
+     * Pick the cheaper of two random members, where the cost is the expected time to drain the outstanding requests
+     * plus a new one. A member without any reply yet has no latency estimate and is explored first.
+     *
+     * @param[in]   shard_members   The shard members, not empty.
+     * @param[in]   random_engine
+     */
+    node_id_t pick_power_of_two_choices(const std::vector<node_id_t>& shard_members,
+                                        std::minstd_rand& random_engine) const;
+};
+
+}  // namespace cascade
+}  // namespace derecho
+
+#include "member_loads_impl.hpp"
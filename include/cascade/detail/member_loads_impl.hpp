@@ -0,0 +1,221 @@
+#pragma once
+#include <derecho/utils/time.h>
+
+#include <limits>
+
+namespace derecho {
+namespace cascade {
+
+inline void MemberLoads::member_t::on_reply(uint64_t latency_ns) {
+    // EWMA with alpha = 1/8
+    uint64_t old_ewma_latency_ns = ewma_latency_ns.load(std::memory_order_relaxed);
+    uint64_t new_ewma_latency_ns;
+    do {
+        new_ewma_latency_ns = (old_ewma_latency_ns == 0) ? latency_ns :
+            (old_ewma_latency_ns - (old_ewma_latency_ns >> 3) + (latency_ns >> 3));
+    } while (!ewma_latency_ns.compare_exchange_weak(old_ewma_latency_ns,new_ewma_latency_ns,
+                                                    std::memory_order_relaxed));
+    outstanding.fetch_sub(1,std::memory_order_relaxed);
+}
+
+inline MemberLoads::load_guard_t::load_guard_t(std::shared_ptr<member_t>&& _member):
+    member(std::move(_member)), send_ns(static_cast<uint64_t>(get_time())) {
+    member->outstanding.fetch_add(1,std::memory_order_relaxed);
+}
+
+inline MemberLoads::load_guard_t::load_guard_t(MemberLoads& loads, node_id_t node_id):
+    load_guard_t(loads.get_member(node_id)) {}
+
+inline void MemberLoads::load_guard_t::on_reply() {
+    if (!member) {
+        return;
+    }
+    member->on_reply(static_cast<uint64_t>(get_time()) - send_ns);
+    member.reset();
+}
+
+inline MemberLoads::load_guard_t::~load_guard_t() {
+    if (member) {
+        member->outstanding.fetch_sub(1,std::memory_order_relaxed);
+    }
+}
+
+/**
+ * The future handed to the caller and the reply watcher share the reply. Both of them only wait on the future until one
+ * of them accounts for the reply, under the mutex; the caller marks the reply consumed before it gets the value out of
+ * the future, and the watcher leaves a consumed reply alone.
+ */
+template <typename ReturnType>
+struct MemberLoads::tracked_reply_t : public MemberLoads::watched_reply_t {
+    std::mutex mutex;
+    std::future<ReturnType> reply;
+    load_guard_t guard;
+    bool accounted = false;
+    bool consumed = false;
+
+    tracked_reply_t(std::shared_ptr<member_t> member, std::future<ReturnType>&& _reply):
+        reply(std::move(_reply)), guard(std::move(member)) {}
+
+    virtual bool watch(const std::chrono::nanoseconds& timeout) override {
+        std::lock_guard<std::mutex> lck(mutex);
+        if (accounted || consumed) {
+            return true;
+        }
+        if (reply.wait_for(timeout) != std::future_status::ready) {
+            return false;
+        }
+        // a failed reply counts as a reply, too.
+        guard.on_reply();
+        accounted = true;
+        return true;
+    }
+
+    ReturnType get() {
+        reply.wait();
+        {
+            std::lock_guard<std::mutex> lck(mutex);
+            if (!accounted) {
+                guard.on_reply();
+                accounted = true;
+            }
+            consumed = true;
+        }
+        return reply.get();
+    }
+};
+
+inline MemberLoads::MemberLoads() : stopping(false) {}
+
+inline MemberLoads::~MemberLoads() {
+    stopping.store(true,std::memory_order_release);
+    std::unique_lock<std::shared_mutex> wlck(members_mutex);
+    for (auto& member : members) {
+        {
+            std::lock_guard<std::mutex> lck(member.second->watcher_mutex);
+        }
+        member.second->watcher_cv.notify_all();
+        if (member.second->watcher.joinable()) {
+            member.second->watcher.join();
+        }
+        member.second->watched_replies.clear();
+    }
+}
+
+inline std::shared_ptr<MemberLoads::member_t> MemberLoads::get_member(node_id_t node_id) {
+    {
+        std::shared_lock<std::shared_mutex> rlck(members_mutex);
+        auto it = members.find(node_id);
+        if (it != members.end()) {
+            return it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> wlck(members_mutex);
+    auto& member = members[node_id];
+    if (!member) {
+        member = std::make_shared<member_t>();
+    }
+    return member;
+}
+
+inline void MemberLoads::watch_replies(member_t* member) {
+    while (true) {
+        std::shared_ptr<watched_reply_t> watched;
+        {
+            std::unique_lock<std::mutex> lck(member->watcher_mutex);
+            member->watcher_cv.wait(lck,[this,member]() {
+                return stopping.load(std::memory_order_acquire) || !member->watched_replies.empty();
+            });
+            if (stopping.load(std::memory_order_acquire)) {
+                return;
+            }
+            watched = std::move(member->watched_replies.front());
+            member->watched_replies.pop_front();
+        }
+        while (!watched->watch(watch_interval)) {
+            if (stopping.load(std::memory_order_acquire)) {
+                return;
+            }
+        }
+    }
+}
+
+template <typename ReturnType>
+std::future<ReturnType> MemberLoads::track(node_id_t node_id, std::future<ReturnType>&& reply) {
+    auto member = get_member(node_id);
+    auto tracked = std::make_shared<tracked_reply_t<ReturnType>>(member,std::move(reply));
+    std::call_once(member->watcher_flag,[this,&member]() {
+        member->watcher = std::thread(&MemberLoads::watch_replies,this,member.get());
+    });
+    {
+        std::lock_guard<std::mutex> lck(member->watcher_mutex);
+        member->watched_replies.emplace_back(tracked);
+    }
+    member->watcher_cv.notify_one();
+    return std::async(std::launch::deferred,[tracked]() -> ReturnType { return tracked->get(); });
+}
+
+inline void MemberLoads::on_send(node_id_t node_id) {
+    get_member(node_id)->outstanding.fetch_add(1,std::memory_order_relaxed);
+}
+
+inline void MemberLoads::on_reply(node_id_t node_id, uint64_t latency_ns) {
+    get_member(node_id)->on_reply(latency_ns);
+}
+
+inline uint32_t MemberLoads::get_outstanding(node_id_t node_id) const {
+    std::shared_lock<std::shared_mutex> rlck(members_mutex);
+    auto it = members.find(node_id);
+    return (it == members.end()) ? 0 : it->second->outstanding.load(std::memory_order_relaxed);
+}
+
+inline uint64_t MemberLoads::get_ewma_latency_ns(node_id_t node_id) const {
+    std::shared_lock<std::shared_mutex> rlck(members_mutex);
+    auto it = members.find(node_id);
+    return (it == members.end()) ? 0 : it->second->ewma_latency_ns.load(std::memory_order_relaxed);
+}
+
+inline node_id_t MemberLoads::pick_least_outstanding(const std::vector<node_id_t>& shard_members,
+                                                     uint32_t position) const {
+    std::shared_lock<std::shared_mutex> rlck(members_mutex);
+    node_id_t node_id = shard_members[position % shard_members.size()];
+    uint32_t least_outstanding = std::numeric_limits<uint32_t>::max();
+    for (std::size_t i = 0; i < shard_members.size(); i++) {
+        node_id_t candidate = shard_members[(position + i) % shard_members.size()];
+        auto it = members.find(candidate);
+        // a member without a load has nothing outstanding.
+        uint32_t outstanding = (it == members.end()) ? 0 : it->second->outstanding.load(std::memory_order_relaxed);
+        if (outstanding < least_outstanding) {
+            least_outstanding = outstanding;
+            node_id = candidate;
+        }
+    }
+    return node_id;
+}
+
+inline node_id_t MemberLoads::pick_power_of_two_choices(const std::vector<node_id_t>& shard_members,
+                                                        std::minstd_rand& random_engine) const {
+    std::size_t first = random_engine() % shard_members.size();
+    node_id_t node_id = shard_members[first];
+    if (shard_members.size() > 1) {
+        std::size_t second = random_engine() % (shard_members.size() - 1);
+        if (second >= first) {
+            second ++;
+        }
+        std::shared_lock<std::shared_mutex> rlck(members_mutex);
+        auto cost = [this](node_id_t nid) -> uint64_t {
+            auto it = members.find(nid);
+            if (it == members.end()) {
+                return 0;
+            }
+            uint64_t ewma_latency_ns = it->second->ewma_latency_ns.load(std::memory_order_relaxed);
+            return ewma_latency_ns * (it->second->outstanding.load(std::memory_order_relaxed) + 1);
+        };
+        if (cost(shard_members[second]) < cost(node_id)) {
+            node_id = shard_members[second];
+        }
+    }
+    return node_id;
+}
+
+}  // namespace cascade
+}  // namespace derecho
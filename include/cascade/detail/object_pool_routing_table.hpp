@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cascade/config.h>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * @class ObjectPoolRoutingTable
+ * @brief An immutable path trie that resolves a key to the object pool it belongs to.
+ *
+ * A routing table is built once from the object pool pathnames and never modified afterwards. A lookup walks the
+ * components of the key in place, so it neither allocates nor locks, and any number of threads can use a table at the
+ * same time. To change the routes, build a new table and publish it in place of the old one.
+ *
+ * @tparam T            - the route entry type, interned once per object pool.
+ * @tparam separator    - the pathname separator
+ */
+template <typename T, char separator = PATH_SEPARATOR>
+class ObjectPoolRoutingTable {
+private:
+    struct node_t {
+        /** The children as (component, node index) pairs, sorted by component. */
+        std::vector<std::pair<std::string,uint32_t>> children;
+        /** The route entry if an object pool is registered at this node. */
+        std::shared_ptr<T> entry;
+    };
+    /** The trie nodes. nodes[0] is the root. */
+    std::vector<node_t> nodes;
+    /** The number of route entries. */
+    std::size_t num_routes;
+
+    /**
+     * Find the child of a node by its component.
+     *
+     * @param node_index - the index of the parent node.
+     * @param component - the component of the child.
+     *
+     * @return the index of the child node, or 0 if the child is not found.
+     */
+    inline uint32_t find_child(uint32_t node_index, const std::string_view& component) const;
+public:
+    /**
+     * Constructor
+     *
+     * @param routes - the map from object pool pathnames to their route entries.
+     */
+    ObjectPoolRoutingTable(const std::unordered_map<std::string,std::shared_ptr<T>>& routes);
+
+    /**
+     * Find the object pool a pathname belongs to, which is the object pool with the shortest pathname that is a prefix
+     * of the given pathname. Like str_tokenizer(), empty components are skipped.
+     *
+     * @param pathname - the pathname.
+     *
+     * @return a pointer to the route entry, or nullptr if the pathname does not belong to any object pool. The entry
+     *         lives as long as the routing table.
+     */
+    T* find(const std::string_view& pathname) const;
+
+    /**
+     * Find the object pool a key belongs to. The pathname of a key is the part before its last separator.
+     *
+     * @param key - the key.
+     *
+     * @return a pointer to the route entry, or nullptr if the key does not belong to any object pool.
+     */
+    T* find_by_key(const std::string_view& key) const;
+
+    /**
+     * @return the number of object pools in the routing table.
+     */
+    std::size_t size() const;
+};
+
+}
+}
+
+#include "object_pool_routing_table_impl.hpp"
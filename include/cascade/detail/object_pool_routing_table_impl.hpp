@@ -0,0 +1,97 @@
+#pragma once
+#include <algorithm>
+
+namespace derecho {
+namespace cascade {
+
+template <typename T, char separator>
+ObjectPoolRoutingTable<T,separator>::ObjectPoolRoutingTable(const std::unordered_map<std::string,std::shared_ptr<T>>& routes):
+    nodes(1), num_routes(0) {
+    for (const auto& route: routes) {
+        uint32_t node_index = 0;
+        std::string::size_type pos = 0;
+        const std::string& pathname = route.first;
+        while (pos < pathname.size()) {
+            std::string::size_type end = pathname.find(separator,pos);
+            if (end == std::string::npos) {
+                end = pathname.size();
+            }
+            // skip leading and consecutive separators.
+            if (end > pos) {
+                std::string_view component(pathname.data() + pos, end - pos);
+                auto& children = nodes[node_index].children;
+                auto it = std::lower_bound(children.begin(), children.end(), component,
+                        [](const std::pair<std::string,uint32_t>& child, const std::string_view& comp) {
+                            return std::string_view(child.first) < comp;
+                        });
+                if (it != children.end() && std::string_view(it->first) == component) {
+                    node_index = it->second;
+                } else {
+                    uint32_t child_index = static_cast<uint32_t>(nodes.size());
+                    children.emplace(it,std::string(component),child_index);
+                    // 'children' is invalidated by the following emplace_back.
+                    nodes.emplace_back();
+                    node_index = child_index;
+                }
+            }
+            pos = end + 1;
+        }
+        if (node_index != 0 && !nodes[node_index].entry) {
+            nodes[node_index].entry = route.second;
+            num_routes ++;
+        }
+    }
+}
+
+template <typename T, char separator>
+inline uint32_t ObjectPoolRoutingTable<T,separator>::find_child(uint32_t node_index, const std::string_view& component) const {
+    const auto& children = nodes[node_index].children;
+    auto it = std::lower_bound(children.cbegin(), children.cend(), component,
+            [](const std::pair<std::string,uint32_t>& child, const std::string_view& comp) {
+                return std::string_view(child.first) < comp;
+            });
+    if (it != children.cend() && std::string_view(it->first) == component) {
+        return it->second;
+    }
+    return 0;
+}
+
+template <typename T, char separator>
+T* ObjectPoolRoutingTable<T,separator>::find(const std::string_view& pathname) const {
+    uint32_t node_index = 0;
+    std::string_view::size_type pos = 0;
+    while (pos < pathname.size()) {
+        std::string_view::size_type end = pathname.find(separator,pos);
+        if (end == std::string_view::npos) {
+            end = pathname.size();
+        }
+        if (end > pos) {
+            node_index = find_child(node_index,pathname.substr(pos,end - pos));
+            if (node_index == 0) {
+                return nullptr;
+            }
+            if (nodes[node_index].entry) {
+                return nodes[node_index].entry.get();
+            }
+        }
+        pos = end + 1;
+    }
+    return nullptr;
+}
+
+template <typename T, char separator>
+T* ObjectPoolRoutingTable<T,separator>::find_by_key(const std::string_view& key) const {
+    std::string_view::size_type pos = key.rfind(separator);
+    if (pos == std::string_view::npos) {
+        return nullptr;
+    }
+    return find(key.substr(0,pos));
+}
+
+template <typename T, char separator>
+std::size_t ObjectPoolRoutingTable<T,separator>::size() const {
+    return num_routes;
+}
+
+}
+}
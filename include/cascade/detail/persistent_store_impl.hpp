@@ -4,11 +4,13 @@
 #include "cascade/config.h"
 #include "cascade/utils.hpp"
 #include "debug_util.hpp"
+#include "store_util.hpp"
 #include "delta_store_core.hpp"
 
 #include <derecho/conf/conf.hpp>
 #include <derecho/persistent/PersistentInterface.hpp>
 #include <derecho/persistent/detail/PersistLog.hpp>
+#include <algorithm>
 #include <fstream>
 #include <map>
 #include <memory>
@@ -54,6 +56,32 @@ void PersistentCascadeStore<KT, VT, IK, IV, ST>::put_and_forget(const VT& value,
     debug_leave_func();
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::put_batch(const std::vector<VT>& values, bool as_trigger) const {
+    debug_enter_func_with_args("num_objects={}", values.size());
+
+    derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_put_batch)>(values, as_trigger);
+    auto& replies = results.get();
+    version_tuple ret{CURRENT_VERSION, 0};
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+void PersistentCascadeStore<KT, VT, IK, IV, ST>::put_batch_and_forget(const std::vector<VT>& values, bool as_trigger) const {
+    debug_enter_func_with_args("num_objects={}", values.size());
+
+    derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+    subgroup_handle.template ordered_send<RPC_NAME(ordered_put_batch_and_forget)>(values, as_trigger);
+
+    debug_leave_func();
+}
+
 #ifdef ENABLE_EVALUATION
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 double PersistentCascadeStore<KT, VT, IK, IV, ST>::perf_put(const uint32_t max_payload_size, const uint64_t duration_sec) const {
@@ -129,9 +157,48 @@ const VT PersistentCascadeStore<KT, VT, IK, IV, ST>::get(const KT& key, const pe
         LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_END, group,*IV,ver);
 #endif
         return persistent_core->lockless_get(key);
+    } else if(!exact) {
+        // The latest version of the key not newer than requested_version, from the per-key version index.
+        persistent::version_t target_version = persistent_core->lockless_get_version_by_key(key, requested_version);
+        // Follow the backward chain only where the index does not reach back to requested_version.
+        while (target_version > requested_version) {
+            target_version =
+                persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(target_version,true,
+                    [&key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
+                        return delta.objects.at(key).previous_version_by_key;
+                    });
+        }
+        if (target_version == persistent::INVALID_VERSION) {
+            VT value = *IV;
+            if(may_be_reclaimed(requested_version)) {
+                // The key may be removed after requested_version, and its tombstone reclaimed with its versions.
+                persistent_core.get(requested_version, [&key, &value](const DeltaCascadeStoreCore<KT, VT, IK, IV>& pers_core) {
+                    pers_core.kv_map.read(key, [&value](const VT& v) { value = v; });
+                });
+            }
+#if __cplusplus > 201703L
+            LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_END, group,*IV,ver);
+#else
+            LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_END, group,*IV,ver);
+#endif
+            debug_leave_func_with_value("No data found for key:{} in the index before version:0x{:x}", key, requested_version);
+            return value;
+        }
+#if __cplusplus > 201703L
+        LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_END, group,*IV,ver);
+#else
+        LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_END, group,*IV,ver);
+#endif
+        debug_leave_func_with_value("key:{} is found at version:0x{:x}", key, target_version);
+        return persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(target_version,true,
+                [&key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
+                    // This return is a copy, which make sure the returned value does not rely on the data in
+                    // the delta log.
+                    return delta.objects.at(key);
+                });
     } else {
-        return persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(requested_version, exact,
-        [this, key, requested_version, exact, ver](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta) {
+        return persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(requested_version, true,
+        [this, key, requested_version, ver](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta) {
             if(delta.objects.find(key) != delta.objects.cend()) {
                 debug_leave_func_with_value("key:{} is found at version:0x{:x}", key, requested_version);
 #if __cplusplus > 201703L
@@ -142,56 +209,64 @@ const VT PersistentCascadeStore<KT, VT, IK, IV, ST>::get(const KT& key, const pe
                 // This return is a copy to make sure returned value does not rely on the data in the delta log.
                 return delta.objects.at(key);
             } else {
-                if(exact) {
-                    // return invalid object for EXACT search.
-                    debug_leave_func_with_value("No data found for key:{} at version:0x{:x}", key, requested_version);
-#if __cplusplus > 201703L
-                    LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_END, group,*IV,ver);
-#else
-                    LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_END, group,*IV,ver);
-#endif
-                    return *IV;
-                } else {
-                    // fall back to the slow path.
-                    // following the backward chain until its version is behind requested_version.
-                    // TODO: We can introduce a per-key version index to achieve a better performance
-                    //       with a 64bit per log entry memory overhead.
-                    VT o = persistent_core->lockless_get(key);
-                    persistent::version_t target_version = o.version;
-                    while (target_version > requested_version) {
-                        target_version = 
-                            persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(target_version,true,
-                                [&key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
-                                    return delta.objects.at(key).previous_version_by_key;
-                                });
-                    }
-                    if (target_version == persistent::INVALID_VERSION) {
+                // return invalid object for EXACT search.
+                debug_leave_func_with_value("No data found for key:{} at version:0x{:x}", key, requested_version);
 #if __cplusplus > 201703L
-                        LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_END, group,*IV,ver);
+                LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_END, group,*IV,ver);
 #else
-                        LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_END, group,*IV,ver);
+                LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_END, group,*IV,ver);
 #endif
-                        debug_leave_func_with_value("No data found for key:{} before version:0x{:x}", key, requested_version);
-                        return *IV;
-                    } else {
-#if __cplusplus > 201703L
-                        LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_END, group,*IV,ver);
-#else
-                        LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_END, group,*IV,ver);
-#endif
-                        return persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(target_version,true,
-                                [&key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
-                                    // This return is a copy, which make sure the returned value does not rely on the data in
-                                    // the delta log.
-                                    return delta.objects.at(key);
-                                });
-                    }
-                }
+                return *IV;
             }
         });
     }
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::vector<VT> PersistentCascadeStore<KT, VT, IK, IV, ST>::multi_key_get(const std::vector<KT>& keys, const persistent::version_t& ver, const bool stable) const {
+    debug_enter_func_with_args("num_keys={},ver=0x{:x},stable={}", keys.size(), ver, stable);
+
+    persistent::version_t requested_version = ver;
+
+    // adjust version once for all keys if stable is requested, the same way as get() does.
+    if(stable) {
+        derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+        if(requested_version == CURRENT_VERSION) {
+            requested_version = subgroup_handle.get_global_persistence_frontier();
+        } else if(!subgroup_handle.wait_for_global_persistence_frontier(requested_version) && requested_version > persistent_core.getLatestVersion()) {
+            debug_leave_func_with_value("requested version:{:x} is beyond the latest atomic broadcast version.", requested_version);
+            return std::vector<VT>(keys.size(), *IV);
+        }
+    }
+
+    if(requested_version == CURRENT_VERSION) {
+        // one lockless pass over kv_map for all keys.
+        auto values = persistent_core->lockless_multi_key_get(keys);
+        debug_leave_func();
+        return values;
+    }
+
+    // one lockless pass at the version, the same way as scan() reads a page.
+    std::vector<VT> values;
+    if(!may_be_reclaimed(requested_version)) {
+        // Every key of the state at the version is still in kv_map, with the value at the version or a newer one. Only
+        // the newer ones are resolved back to the version through the version index.
+        values = persistent_core->lockless_multi_key_get(keys);
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            for(std::size_t i = 0; i < keys.size(); i++) {
+                if(values[i].get_version() > requested_version) {
+                    // requested_version is stable already.
+                    values[i] = get(keys[i], requested_version, false, false);
+                }
+            }
+        }
+    } else {
+        values = lockless_multi_key_get(*get_scan_view(requested_version), keys, *IV);
+    }
+    debug_leave_func();
+    return values;
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 const VT PersistentCascadeStore<KT, VT, IK, IV, ST>::multi_get(const KT& key) const {
     debug_enter_func_with_args("key={}", key);
@@ -210,9 +285,70 @@ const VT PersistentCascadeStore<KT, VT, IK, IV, ST>::multi_get(const KT& key) co
     return replies.begin()->second.get();
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+persistent::version_t PersistentCascadeStore<KT, VT, IK, IV, ST>::get_version_at_time(const uint64_t& ts_us) const {
+    // The time index answers in O(log n) without touching the log, as long as the time is after the oldest version
+    // applied since the process started. Inside a time bucket with several versions, only the log between the first
+    // and the last versions of the bucket is searched. The versions with empty deltas are not indexed, but their states
+    // are the same as the indexed versions before them.
+    persistent::version_t bucket_first = persistent::INVALID_VERSION;
+    persistent::version_t bucket_last = persistent::INVALID_VERSION;
+    persistent::version_t ver = persistent_core->lockless_get_version_at_time(ts_us, bucket_first, bucket_last);
+    if(ver == persistent::INVALID_VERSION && bucket_first != persistent::INVALID_VERSION) {
+        ver = get_version_in_time_bucket(ts_us, bucket_first, bucket_last);
+    }
+    if(ver == persistent::INVALID_VERSION) {
+        ver = persistent_core.getVersionAtTime({ts_us, 0});
+    }
+    return ver;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+persistent::version_t PersistentCascadeStore<KT, VT, IK, IV, ST>::get_version_in_time_bucket(
+        const uint64_t& ts_us,
+        const persistent::version_t& bucket_first,
+        const persistent::version_t& bucket_last) const {
+    // 'low' is stamped not later than ts_us and 'high' later than it. 'found' is the latest logged version not newer
+    // than 'low', which is the answer once no version is left between the two.
+    persistent::version_t low = bucket_first;
+    persistent::version_t high = bucket_last;
+    persistent::version_t found = bucket_first;
+    while(high - low > 1) {
+        const persistent::version_t mid = low + (high - low) / 2;
+        // The delta at mid, or at the latest logged version before it. All objects in a delta share its version and
+        // timestamp.
+        auto stamp = persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(mid, false,
+            [](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta) {
+                if(delta.objects.empty()) {
+                    return std::make_pair(persistent::INVALID_VERSION, static_cast<uint64_t>(0));
+                }
+                const VT& value = delta.objects.cbegin()->second;
+                return std::make_pair(value.get_version(), value.get_timestamp());
+            });
+        if(stamp.first == persistent::INVALID_VERSION) {
+            return persistent::INVALID_VERSION;
+        }
+        if(stamp.second <= ts_us) {
+            low = mid;
+            found = std::max(found, stamp.first);
+        } else {
+            high = mid;
+        }
+    }
+    return found;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+bool PersistentCascadeStore<KT, VT, IK, IV, ST>::may_be_reclaimed(const persistent::version_t& ver) const {
+    // The tombstones reclaimed so far are not newer than the latest version minus the reclaim distance.
+    const persistent::version_t latest_version = persistent_core.getLatestVersion();
+    return latest_version >= TOMBSTONE_RECLAIM_DISTANCE && ver < latest_version - TOMBSTONE_RECLAIM_DISTANCE;
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 const VT PersistentCascadeStore<KT, VT, IK, IV, ST>::get_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const {
     debug_enter_func_with_args("key={},ts_us={},stable={}", key, ts_us, stable);
+    LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_BY_TIME_START, group, *IV);
     const HLC hlc(ts_us, 0ull);
 
     derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
@@ -229,13 +365,15 @@ const VT PersistentCascadeStore<KT, VT, IK, IV, ST>::get_by_time(const KT& key,
         return *IV;
     }
 
-    persistent::version_t ver = persistent_core.getVersionAtTime({ts_us, 0});
+    persistent::version_t ver = get_version_at_time(ts_us);
     if(ver == persistent::INVALID_VERSION) {
         return *IV;
     }
 
+    auto value = get(key, ver, stable, false);
+    LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_BY_TIME_END, group, *IV);
     debug_leave_func();
-    return get(key, ver, stable, false);
+    return value;
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
@@ -303,8 +441,52 @@ uint64_t PersistentCascadeStore<KT, VT, IK, IV, ST>::get_size(const KT& key, con
         LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
 #endif
          return rvo_val;
+    } else if(!exact) {
+        // The latest version of the key not newer than requested_version, from the per-key version index.
+        persistent::version_t target_version = persistent_core->lockless_get_version_by_key(key, requested_version);
+        // Follow the backward chain only where the index does not reach back to requested_version.
+        while (target_version > requested_version) {
+            target_version =
+                persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(target_version,true,
+                    [&key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
+                        if (delta.objects.find(key) != delta.objects.cend()) {
+                            return delta.objects.at(key).previous_version_by_key;
+                        }
+                        return persistent::INVALID_VERSION;
+                    });
+        }
+        if (target_version == persistent::INVALID_VERSION) {
+            uint64_t size = 0ull;
+            if(may_be_reclaimed(requested_version)) {
+                // The key may be removed after requested_version, and its tombstone reclaimed with its versions.
+                persistent_core.get(requested_version, [&key, &size](const DeltaCascadeStoreCore<KT, VT, IK, IV>& pers_core) {
+                    pers_core.kv_map.read(key, [&size](const VT& v) { size = mutils::bytes_size(v); });
+                });
+            }
+#if __cplusplus > 201703L
+            LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
+#else
+            LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
+#endif
+            debug_leave_func_with_value("No data found for key:{} in the index before version:0x{:x}", key, requested_version);
+            return size;
+        }
+        auto size = persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(target_version,true,
+                [&key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
+                    if (delta.objects.find(key) != delta.objects.cend()) {
+                        return static_cast<uint64_t>(mutils::bytes_size(delta.objects.at(key)));
+                    }
+                    return static_cast<uint64_t>(0ull);
+                });
+#if __cplusplus > 201703L
+        LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
+#else
+        LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
+#endif
+        debug_leave_func_with_value("key:{} is found at version:0x{:x}", key, target_version);
+        return size;
     } else {
-        return persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(requested_version, exact, [this, &key, requested_version, exact, ver](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta) -> uint64_t {
+        return persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(requested_version, true, [this, &key, requested_version, ver](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta) -> uint64_t {
             if(delta.objects.find(key)!=delta.objects.cend()) {
                 debug_leave_func_with_value("key:{} is found at version:0x{:x}", key, requested_version);
                 uint64_t size = mutils::bytes_size(delta.objects.at(key));
@@ -315,56 +497,14 @@ uint64_t PersistentCascadeStore<KT, VT, IK, IV, ST>::get_size(const KT& key, con
 #endif
                 return size;
             } else {
-                if(exact) {
-                    // return invalid object for EXACT search.
-                    debug_leave_func_with_value("No data found for key:{} at version:0x{:x}", key, requested_version);
-#if __cplusplus > 201703L
-                    LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
-#else
-                    LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
-#endif
-                    return 0ull;
-                } else {
-                    // fall back to the slow path.
-                    // following the backward chain until its version is behind requested_version.
-                    // TODO: We can introduce a per-key version index to achieve a better performance
-                    //       with a 64bit per log entry memory overhead.
-                    VT o = persistent_core->lockless_get(key);
-                    persistent::version_t target_version = o.version;
-                    while (target_version > requested_version) {
-                        target_version =
-                            persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(target_version,true,
-                                [&key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
-                                    if (delta.objects.find(key) != delta.objects.cend()) {
-                                        return delta.objects.at(key).previous_version_by_key;
-                                    }
-                                    return persistent::INVALID_VERSION;
-                                });
-                    }
-                    if (target_version == persistent::INVALID_VERSION) {
-#if __cplusplus > 201703L
-                        LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
-#else
-                        LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
-#endif
-                        debug_leave_func_with_value("No data found for key:{} before version:0x{:x}", key, requested_version);
-                        return 0ull;
-                    } else {
-                        auto size = persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(target_version,true,
-                                [&key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
-                                    if (delta.objects.find(key) != delta.objects.cend()) {
-                                        return static_cast<uint64_t>(mutils::bytes_size(delta.objects.at(key)));
-                                    }
-                                    return static_cast<uint64_t>(0ull);
-                                });
+                // return invalid object for EXACT search.
+                debug_leave_func_with_value("No data found for key:{} at version:0x{:x}", key, requested_version);
 #if __cplusplus > 201703L
-                        LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
+                LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
 #else
-                        LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
+                LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
 #endif
-                        return size;
-                    }
-                }
+                return 0ull;
             }
         });
     }
@@ -384,7 +524,7 @@ uint64_t PersistentCascadeStore<KT, VT, IK, IV, ST>::get_size_by_time(const KT&
         return 0;
     }
 
-    persistent::version_t ver = persistent_core.getVersionAtTime({ts_us, 0});
+    persistent::version_t ver = get_version_at_time(ts_us);
     if(ver == persistent::INVALID_VERSION) {
         return 0;
     }
@@ -459,11 +599,7 @@ std::vector<KT> PersistentCascadeStore<KT, VT, IK, IV, ST>::list_keys(const std:
     } else {
         std::vector<KT> keys;
         persistent_core.get(requested_version, [&keys, &prefix](const DeltaCascadeStoreCore<KT, VT, IK, IV>& pers_core) {
-            for(const auto& kv : pers_core.kv_map) {
-                if(get_pathname<KT>(kv.first).find(prefix) == 0) {
-                    keys.push_back(kv.first);
-                }
-            }
+            keys = list_keys_by_prefix(pers_core.kv_map, prefix);
         });
 #if __cplusplus > 201703L
         LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_LIST_KEYS_END, group,*IV,ver);
@@ -474,6 +610,84 @@ std::vector<KT> PersistentCascadeStore<KT, VT, IK, IV, ST>::list_keys(const std:
     }
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+scan_page_tuple<KT, VT> PersistentCascadeStore<KT, VT, IK, IV, ST>::scan(const std::string& prefix, const persistent::version_t& ver, const bool stable,
+                                                                        const KT& cursor, const uint32_t& max_items, const uint64_t& max_bytes) const {
+    debug_enter_func_with_args("prefix={},ver=0x{:x},stable={},max_items={},max_bytes={}", prefix, ver, stable, max_items, max_bytes);
+
+    persistent::version_t requested_version = ver;
+
+    // adjust version if stable is requested, the same way as list_keys() does.
+    if(stable) {
+        derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+        if(requested_version == CURRENT_VERSION) {
+            requested_version = subgroup_handle.get_global_persistence_frontier();
+            if(requested_version == persistent::INVALID_VERSION) {
+                debug_leave_func_with_value("nothing is persisted yet.");
+                return {{}, *IK, requested_version};
+            }
+        } else if(!subgroup_handle.wait_for_global_persistence_frontier(requested_version) && requested_version > persistent_core.getLatestVersion()) {
+            debug_leave_func_with_value("requested version:{:x} is beyond the latest atomic broadcast version.", requested_version);
+            return {{}, *IK, requested_version};
+        }
+    }
+
+    if(requested_version == CURRENT_VERSION) {
+        auto page = persistent_core->lockless_scan(prefix, cursor, max_items, max_bytes);
+        debug_leave_func_with_value("{} objects", std::get<0>(page).size());
+        return page;
+    }
+
+    // Every page is read at requested_version, which is returned with the page, so that the following pages of a
+    // stable scan are read at the same version instead of a later frontier.
+    scan_page_tuple<KT, VT> page;
+    if(!may_be_reclaimed(requested_version)) {
+        // Every key of the state at the version is still in kv_map, with the value at the version or a newer one,
+        // including the tombstones of the keys removed since. The newer ones are resolved back to the version through
+        // the version index, so the state is not rebuilt.
+        page = scan_by_prefix(persistent_core->kv_map, prefix, cursor, *IK, max_items, max_bytes,
+                              [this, &requested_version](const VT& value, VT& value_at_version) {
+                                  if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+                                      if(value.get_version() > requested_version) {
+                                          value_at_version = get(value.get_key_ref(), requested_version, false, false);
+                                          return true;
+                                      }
+                                  }
+                                  return false;
+                              });
+    } else {
+        page = scan_by_prefix(*get_scan_view(requested_version), prefix, cursor, *IK, max_items, max_bytes);
+    }
+    std::get<2>(page) = requested_version;
+    debug_leave_func_with_value("{} objects", std::get<0>(page).size());
+    return page;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::shared_ptr<const ConcurrentOrderedMap<KT, VT>> PersistentCascadeStore<KT, VT, IK, IV, ST>::get_scan_view(const persistent::version_t& ver) const {
+    {
+        std::lock_guard<std::mutex> lck(scan_views_mutex);
+        for(auto it = scan_views.begin(); it != scan_views.end(); it++) {
+            if(it->first == ver) {
+                // move it to the front, where the most recently used view is.
+                scan_views.splice(scan_views.begin(), scan_views, it);
+                return scan_views.front().second;
+            }
+        }
+    }
+    // rebuild the state outside of the lock, which takes time proportional to the log.
+    std::shared_ptr<const ConcurrentOrderedMap<KT, VT>> view;
+    persistent_core.get(ver, [&view](const DeltaCascadeStoreCore<KT, VT, IK, IV>& pers_core) {
+        view = std::make_shared<const ConcurrentOrderedMap<KT, VT>>(pers_core.kv_map);
+    });
+    std::lock_guard<std::mutex> lck(scan_views_mutex);
+    scan_views.emplace_front(ver, view);
+    if(scan_views.size() > SCAN_VIEW_CACHE_CAPACITY) {
+        scan_views.pop_back();
+    }
+    return view;
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 std::vector<KT> PersistentCascadeStore<KT, VT, IK, IV, ST>::list_keys_by_time(const std::string& prefix, const uint64_t& ts_us, const bool stable) const {
     debug_enter_func_with_args("ts_us={}", ts_us);
@@ -488,7 +702,7 @@ std::vector<KT> PersistentCascadeStore<KT, VT, IK, IV, ST>::list_keys_by_time(co
         return {};
     }
 
-    persistent::version_t ver = persistent_core.getVersionAtTime({ts_us, 0});
+    persistent::version_t ver = get_version_at_time(ts_us);
     if(ver == persistent::INVALID_VERSION) {
         return {};
     }
@@ -553,9 +767,133 @@ void PersistentCascadeStore<KT, VT, IK, IV, ST>::ordered_put_and_forget(const VT
     debug_leave_func();
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::ordered_put_batch(const std::vector<VT>& values, bool as_trigger) {
+    debug_enter_func_with_args("num_objects={}", values.size());
+    derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+    auto version_and_hlc = subgroup_handle.get_current_version();
+    version_tuple version_and_timestamp{persistent::INVALID_VERSION,0};
+    if(values.empty()) {
+        debug_leave_func_with_value("empty batch, version=0x{:x}", std::get<0>(version_and_hlc));
+        return version_and_timestamp;
+    }
+
+    for(const auto& value : values) {
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            value.set_version(std::get<0>(version_and_hlc));
+        }
+        if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+            value.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+        }
+    }
+
+    // all objects go to one delta, and hence one log entry, under the same version.
+    if(this->persistent_core->ordered_put_batch(values, this->persistent_core.getLatestVersion(), as_trigger) == false) {
+        debug_leave_func_with_value("rejected, version=0x{:x}", std::get<0>(version_and_hlc));
+        return version_and_timestamp;
+    }
+
+    if(cascade_watcher_ptr) {
+        // a value overwritten later in the batch is gone from kv_map, so only the last put to a key is shared.
+        std::vector<bool> last_puts;
+        if(!as_trigger) {
+            last_puts = last_puts_by_key<KT>(values);
+        }
+        for(std::size_t i = 0; i < values.size(); i++) {
+            const auto& value = values[i];
+            if(as_trigger || !last_puts[i]) {
+                (*cascade_watcher_ptr)(
+                        this->subgroup_index,
+                        subgroup_handle.get_shard_num(),
+                        group->get_rpc_caller_id(),
+                        value.get_key_ref(), value, cascade_context_ptr);
+            } else {
+                // the stored copy is shared with the watcher instead of copied again.
+                cascade_watcher_ptr->observe_shared(
+                        this->subgroup_index,
+                        subgroup_handle.get_shard_num(),
+                        group->get_rpc_caller_id(),
+                        value.get_key_ref(), value,
+                        [this,&value]() { return this->persistent_core->kv_map.read_shared(value.get_key_ref()); },
+                        cascade_context_ptr);
+            }
+        }
+    }
+    if(!as_trigger) {
+        snapshot_kv_map(std::get<0>(version_and_hlc));
+    }
+    version_and_timestamp = {std::get<0>(version_and_hlc),std::get<1>(version_and_hlc).m_rtc_us};
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_hlc),
+            std::get<1>(version_and_hlc).m_rtc_us);
+    return version_and_timestamp;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+void PersistentCascadeStore<KT, VT, IK, IV, ST>::ordered_put_batch_and_forget(const std::vector<VT>& values, bool as_trigger) {
+    debug_enter_func_with_args("num_objects={}", values.size());
+    derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+    auto version_and_hlc = subgroup_handle.get_current_version();
+    if(values.empty()) {
+        debug_leave_func_with_value("empty batch, version=0x{:x}", std::get<0>(version_and_hlc));
+        return;
+    }
+
+    for(const auto& value : values) {
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            value.set_version(std::get<0>(version_and_hlc));
+        }
+        if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+            value.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+        }
+    }
+
+    // the objects are applied in order, each on its own, but go to one delta under the same version.
+    auto applied = this->persistent_core->ordered_put_batch_in_order(values, this->persistent_core.getLatestVersion(), as_trigger);
+
+    if(cascade_watcher_ptr) {
+        // a value overwritten later in the batch is gone from kv_map, so only the last put to a key is shared.
+        std::vector<bool> last_puts;
+        if(!as_trigger) {
+            last_puts = last_puts_by_key<KT>(values);
+        }
+        for(std::size_t i = 0; i < values.size(); i++) {
+            const auto& value = values[i];
+            if(!applied[i]) {
+                continue;
+            }
+            if(as_trigger || !last_puts[i]) {
+                (*cascade_watcher_ptr)(
+                        this->subgroup_index,
+                        subgroup_handle.get_shard_num(),
+                        group->get_rpc_caller_id(),
+                        value.get_key_ref(), value, cascade_context_ptr);
+            } else {
+                // the stored copy is shared with the watcher instead of copied again.
+                cascade_watcher_ptr->observe_shared(
+                        this->subgroup_index,
+                        subgroup_handle.get_shard_num(),
+                        group->get_rpc_caller_id(),
+                        value.get_key_ref(), value,
+                        [this,&value]() { return this->persistent_core->kv_map.read_shared(value.get_key_ref()); },
+                        cascade_context_ptr);
+            }
+        }
+    }
+    if(!as_trigger && std::find(applied.begin(), applied.end(), true) != applied.end()) {
+        snapshot_kv_map(std::get<0>(version_and_hlc));
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_hlc),
+            std::get<1>(version_and_hlc).m_rtc_us);
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 bool PersistentCascadeStore<KT, VT, IK, IV, ST>::internal_ordered_put(const VT& value, bool as_trigger) {
-    auto version_and_hlc = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index).get_current_version();
+    derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+    auto version_and_hlc = subgroup_handle.get_current_version();
     if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
         value.set_version(std::get<0>(version_and_hlc));
     }
@@ -572,12 +910,26 @@ bool PersistentCascadeStore<KT, VT, IK, IV, ST>::internal_ordered_put(const VT&
     }
 
     if(cascade_watcher_ptr) {
-        (*cascade_watcher_ptr)(
-                // group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index).get_subgroup_id(), // this is subgroup id
-                this->subgroup_index,
-                group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index).get_shard_num(),
-                group->get_rpc_caller_id(),
-                value.get_key_ref(), value, cascade_context_ptr);
+        if(as_trigger) {
+            (*cascade_watcher_ptr)(
+                    // group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index).get_subgroup_id(), // this is subgroup id
+                    this->subgroup_index,
+                    subgroup_handle.get_shard_num(),
+                    group->get_rpc_caller_id(),
+                    value.get_key_ref(), value, cascade_context_ptr);
+        } else {
+            // the stored copy is shared with the watcher instead of copied again.
+            cascade_watcher_ptr->observe_shared(
+                    this->subgroup_index,
+                    subgroup_handle.get_shard_num(),
+                    group->get_rpc_caller_id(),
+                    value.get_key_ref(), value,
+                    [this,&value]() { return this->persistent_core->kv_map.read_shared(value.get_key_ref()); },
+                    cascade_context_ptr);
+        }
+    }
+    if(!as_trigger) {
+        snapshot_kv_map(std::get<0>(version_and_hlc));
     }
     return true;
 }
@@ -585,7 +937,8 @@ bool PersistentCascadeStore<KT, VT, IK, IV, ST>::internal_ordered_put(const VT&
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::ordered_remove(const KT& key) {
     debug_enter_func_with_args("key={}", key);
-    auto version_and_hlc = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index).get_current_version();
+    derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+    auto version_and_hlc = subgroup_handle.get_current_version();
 #if __cplusplus > 201703L
     LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_ORDERED_REMOVE_START, group, *IV, std::get<0>(version_and_hlc));
 #else
@@ -600,6 +953,7 @@ version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::ordered_remove(const K
         value.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
     }
     if(this->persistent_core->ordered_remove(value, this->persistent_core.getLatestVersion())) {
+        snapshot_kv_map(std::get<0>(version_and_hlc));
         if(cascade_watcher_ptr) {
             (*cascade_watcher_ptr)(
                     // group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index).get_subgroup_id(), // this is subgroup id
@@ -756,16 +1110,83 @@ std::unique_ptr<PersistentCascadeStore<KT, VT, IK, IV, ST>> PersistentCascadeSto
     return persistent_cascade_store_ptr;
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::string PersistentCascadeStore<KT, VT, IK, IV, ST>::get_kv_map_snapshot_filename(persistent::PersistentRegistry* pr, uint64_t snapshot_interval) {
+    // A snapshot is tagged with the versions of its entries.
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        if(pr != nullptr && snapshot_interval > 0) {
+            return derecho::getConfString(CONF_PERS_FILE_PATH) + "/" + pr->get_subgroup_prefix() + ".kv_map_snapshot";
+        }
+    }
+    return "";
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+void PersistentCascadeStore<KT, VT, IK, IV, ST>::snapshot_kv_map(persistent::version_t ver) {
+    if(kv_map_snapshot_context.filename.empty() || ++updates_since_kv_map_snapshot < kv_map_snapshot_interval) {
+        return;
+    }
+    // retry on the next update if the last snapshot is still being written.
+    if(kv_map_snapshot_in_progress.exchange(true)) {
+        return;
+    }
+    if(kv_map_snapshot_thread.joinable()) {
+        kv_map_snapshot_thread.join();
+    }
+    updates_since_kv_map_snapshot = 0;
+    kv_map_snapshot_thread = std::thread([this, ver]() {
+        // a snapshot holding an update lost in a view change or a restart would be loaded with it.
+        this->persistent_core->lockless_save_snapshot(this->kv_map_snapshot_context.filename, ver,
+                [this](persistent::version_t max_version) {
+                    return this->group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index)
+                            .wait_for_global_persistence_frontier(max_version);
+                });
+        this->kv_map_snapshot_in_progress.store(false);
+    });
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 PersistentCascadeStore<KT, VT, IK, IV, ST>::PersistentCascadeStore(
         persistent::PersistentRegistry* pr,
         CriticalDataPathObserver<PersistentCascadeStore<KT, VT, IK, IV>>* cw,
-        ICascadeContext* cc) : persistent_core([]() {
+        ICascadeContext* cc) : kv_map_snapshot_interval(derecho::hasCustomizedConfKey(CASCADE_KV_MAP_SNAPSHOT_INTERVAL)
+                                                                ? derecho::getConfUInt64(CASCADE_KV_MAP_SNAPSHOT_INTERVAL)
+                                                                : 0),
+                               kv_map_snapshot_context(get_kv_map_snapshot_filename(pr, kv_map_snapshot_interval)),
+                               updates_since_kv_map_snapshot(0),
+                               kv_map_snapshot_in_progress(false),
+                               persistent_core([]() {
                                    return std::make_unique<DeltaCascadeStoreCore<KT, VT, IK, IV>>();
                                },
-                                               nullptr, pr),
+                                               nullptr, pr, false,
+                                               mutils::DeserializationManager({&kv_map_snapshot_context})),
                                cascade_watcher_ptr(cw),
                                cascade_context_ptr(cc) {
+    // The log replays only the updates after the snapshot. A snapshot the log does not agree with, for example,
+    // because the log tail was lost in a crash, or truncated and appended again after a view change, cannot be
+    // completed that way; rebuild from the log instead. The newest entry of the snapshot must be in the log.
+    const persistent::version_t snapshot_max_version = persistent_core->get_snapshot_max_version();
+    bool snapshot_in_log = (snapshot_max_version == persistent::INVALID_VERSION);
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        if(!snapshot_in_log && snapshot_max_version <= persistent_core.getLatestVersion()) {
+            try {
+                snapshot_in_log = persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(snapshot_max_version, true,
+                        [this, snapshot_max_version](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta) {
+                            auto it = delta.objects.find(this->persistent_core->get_snapshot_max_version_key());
+                            return it != delta.objects.cend() && it->second.get_version() == snapshot_max_version;
+                        });
+            } catch(...) {
+                snapshot_in_log = false;
+            }
+        }
+    }
+    if(!snapshot_in_log) {
+        dbg_default_warn("{}: kv_map snapshot {} at version 0x{:x} does not match the log at version 0x{:x}, replaying the whole log.",
+                         __PRETTY_FUNCTION__, kv_map_snapshot_context.filename, snapshot_max_version, persistent_core.getLatestVersion());
+        persistent_core.get(persistent_core.getLatestVersion(), [this](const DeltaCascadeStoreCore<KT, VT, IK, IV>& replayed_core) {
+            this->persistent_core->reset_state(replayed_core.kv_map);
+        });
+    }
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
@@ -773,13 +1194,21 @@ PersistentCascadeStore<KT, VT, IK, IV, ST>::PersistentCascadeStore(
         persistent::Persistent<DeltaCascadeStoreCore<KT, VT, IK, IV>, ST>&&
                 _persistent_core,
         CriticalDataPathObserver<PersistentCascadeStore<KT, VT, IK, IV>>* cw,
-        ICascadeContext* cc) : persistent_core(std::move(_persistent_core)),
+        ICascadeContext* cc) : kv_map_snapshot_interval(0),
+                               kv_map_snapshot_context(""),
+                               updates_since_kv_map_snapshot(0),
+                               kv_map_snapshot_in_progress(false),
+                               persistent_core(std::move(_persistent_core)),
                                cascade_watcher_ptr(cw),
                                cascade_context_ptr(cc) {
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
-PersistentCascadeStore<KT, VT, IK, IV, ST>::PersistentCascadeStore() : persistent_core(
+PersistentCascadeStore<KT, VT, IK, IV, ST>::PersistentCascadeStore() : kv_map_snapshot_interval(0),
+                                                                       kv_map_snapshot_context(""),
+                                                                       updates_since_kv_map_snapshot(0),
+                                                                       kv_map_snapshot_in_progress(false),
+                                                                       persistent_core(
         []() {
             return std::make_unique<DeltaCascadeStoreCore<KT, VT, IK, IV>>();
         },
@@ -790,7 +1219,11 @@ PersistentCascadeStore<KT, VT, IK, IV, ST>::PersistentCascadeStore() : persisten
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
-PersistentCascadeStore<KT, VT, IK, IV, ST>::~PersistentCascadeStore() {}
+PersistentCascadeStore<KT, VT, IK, IV, ST>::~PersistentCascadeStore() {
+    if(kv_map_snapshot_thread.joinable()) {
+        kv_map_snapshot_thread.join();
+    }
+}
 
 }  // namespace cascade
 }  // namespace derecho
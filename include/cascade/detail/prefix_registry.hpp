@@ -91,6 +91,15 @@ public:
      */
 private:
     void traverse(TreeNode* ptn, const std::function<std::shared_ptr<T>(const std::shared_ptr<T>& value)>& modifier);
+    /**
+     * collect the values under a tree node, assuming lock has been applied.
+     *
+     * @param ptn       - pointer to the tree node
+     * @param prefix    - the prefix of the tree node
+     * @param collector - the lambda function to collect the values
+     */
+    void collect_values(const TreeNode* ptn, const std::string& prefix,
+            const std::function<void(const std::string& prefix,const std::shared_ptr<T>& value)>& collector) const;
 public:
     /**
      * Test if a prefix has already been registered or not.
@@ -118,6 +127,14 @@ public:
      */
     void collect_values_for_prefixes(const std::string& path,
             const std::function<void(const std::string& prefix,const std::shared_ptr<T>& value)>& collector) const;
+    /**
+     * Process the values of all registered prefixes but the root, in no particular order. The lock is held during the
+     * traversal, so the collector must not call back into the registry.
+     *
+     * @param collector - the lambda function to collect the values, called with each prefix in the format
+     *                    "/component1/component2/.../componentn/".
+     */
+    void collect_values(const std::function<void(const std::string& prefix,const std::shared_ptr<T>& value)>& collector) const;
 #ifdef PREFIX_REGISTRY_DEBUG
     /**
      * Dump the tree information
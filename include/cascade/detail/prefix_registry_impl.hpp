@@ -210,5 +210,24 @@ void PrefixRegistry<T, separator>::collect_values_for_prefixes(
     }
 }
 
+template <typename T, char separator>
+void PrefixRegistry<T, separator>::collect_values(
+        const std::function<void(const std::string& prefix,const std::shared_ptr<T>& value)>& collector) const {
+    std::lock_guard<std::mutex> lck(prefix_tree_mutex);
+    collect_values(&prefix_tree,std::string(1,separator),collector);
+}
+
+template <typename T, char separator>
+void PrefixRegistry<T, separator>::collect_values(const TreeNode* ptn, const std::string& prefix,
+        const std::function<void(const std::string& prefix,const std::shared_ptr<T>& value)>& collector) const {
+    for (const auto& child:ptn->children) {
+        std::string child_prefix = prefix + child.first + separator;
+        if (child.second->value) {
+            collector(child_prefix,child.second->value);
+        }
+        collect_values(child.second.get(),child_prefix,collector);
+    }
+}
+
 } // namespace cascade
 } // namespace derecho
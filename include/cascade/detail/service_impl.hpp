@@ -1,6 +1,8 @@
 #include <derecho/core/derecho_exception.hpp>
 #include <derecho/core/detail/rpc_utils.hpp>
 #include <derecho/core/notification.hpp>
+#include <algorithm>
+#include <deque>
 #include <vector>
 #include <map>
 #include <typeindex>
@@ -162,7 +164,56 @@ ServiceClient<CascadeTypes...>::ServiceClient(derecho::Group<CascadeMetadataServ
             std::make_unique<derecho::ExternalGroupClient<CascadeMetadataService<CascadeTypes...>,CascadeTypes...>>(
                     client_stub_factory<CascadeMetadataService<CascadeTypes...>>,
                     client_stub_factory<CascadeTypes>...);
+        this->template create_external_callers<CascadeMetadataService<CascadeTypes...>>();
+        (this->template create_external_callers<CascadeTypes>(),...);
     }
+    (this->template create_write_coalescer<CascadeTypes>(),...);
+}
+
+template <typename... CascadeTypes>
+ServiceClient<CascadeTypes...>::~ServiceClient() {
+    // the coalescers send with the other members, so they go first.
+    try {
+        disable_write_coalescing();
+    } catch (std::exception& ex) {
+        dbg_default_warn("Failed to flush the coalesced writes:{}", ex.what());
+    }
+    (this->write_coalescers.template get<CascadeTypes>().reset(),...);
+    delete object_pool_router.load();
+    for (auto& retired: retired_object_pool_routers) {
+        delete retired.second;
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+void ServiceClient<CascadeTypes...>::create_external_callers() {
+    uint32_t num_subgroups = external_group_ptr->template get_number_of_subgroups<SubgroupType>();
+    for (uint32_t subgroup_index = 0; subgroup_index < num_subgroups; subgroup_index ++) {
+        external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+void ServiceClient<CascadeTypes...>::create_write_coalescer() {
+    this->write_coalescers.template get<SubgroupType>() =
+        std::make_unique<WriteCoalescer<typename SubgroupType::ObjectType>>(
+            [this](uint32_t subgroup_index, uint32_t shard_index,
+                   const std::vector<typename SubgroupType::ObjectType>& objects, bool as_trigger) {
+                this->template send_coalesced_writes<SubgroupType>(subgroup_index,shard_index,objects,as_trigger);
+            },1024,1024*1024,20);
+}
+
+template <typename... CascadeTypes>
+std::mutex& ServiceClient<CascadeTypes...>::p2p_send_mutex(node_id_t node_id) const {
+    return p2p_send_contexts[node_id % num_send_contexts].mutex;
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+std::mutex& ServiceClient<CascadeTypes...>::ordered_send_mutex(uint32_t subgroup_index) const {
+    return ordered_send_contexts[(std::type_index(typeid(SubgroupType)).hash_code() + subgroup_index) % num_send_contexts].mutex;
 }
 
 template <typename... CascadeTypes>
@@ -389,9 +440,17 @@ void ServiceClient<CascadeTypes...>::set_member_selection_policy(uint32_t subgro
         ShardMemberSelectionPolicy policy, node_id_t user_specified_node_id) {
     // write lock policies
     std::unique_lock wlck(this->member_selection_policies_mutex);
+    auto key = std::make_tuple(std::type_index(typeid(SubgroupType)),subgroup_index,shard_index);
+    // count the shards with an adaptive policy
+    auto it = this->member_selection_policies.find(key);
+    if (it != this->member_selection_policies.end() && is_adaptive_member_selection_policy(std::get<0>(it->second))) {
+        this->num_adaptive_policies.fetch_sub(1,std::memory_order_relaxed);
+    }
+    if (is_adaptive_member_selection_policy(policy)) {
+        this->num_adaptive_policies.fetch_add(1,std::memory_order_relaxed);
+    }
     // update map
-    this->member_selection_policies[std::make_tuple(std::type_index(typeid(SubgroupType)),subgroup_index,shard_index)] =
-            std::make_tuple(policy,user_specified_node_id);
+    this->member_selection_policies[key] = std::make_tuple(policy,user_specified_node_id);
 }
 
 template <typename... CascadeTypes>
@@ -415,14 +474,8 @@ void ServiceClient<CascadeTypes...>::refresh_member_cache_entry(uint32_t subgrou
                                                           uint32_t shard_index) {
     auto key = std::make_tuple(std::type_index(typeid(SubgroupType)),subgroup_index,shard_index);
     auto members = get_shard_members<SubgroupType>(subgroup_index,shard_index);
-    std::shared_lock rlck(member_cache_mutex);
-    if (member_cache.find(key) == member_cache.end()) {
-        rlck.unlock();
-        std::unique_lock wlck(member_cache_mutex);
-        member_cache[key] = members;
-    } else {
-        member_cache[key].swap(members);
-    }
+    std::unique_lock wlck(member_cache_mutex);
+    member_cache[key].swap(members);
 }
 
 template <typename... CascadeTypes>
@@ -430,7 +483,20 @@ template <typename KeyType>
 std::tuple<uint32_t,uint32_t,uint32_t> ServiceClient<CascadeTypes...>::key_to_shard(
         const KeyType& key,
         bool check_object_location) {
+    if constexpr (std::is_convertible_v<KeyType,std::string>) {
+        // fast path: route with the published router.
+        EpochGuard epoch_guard;
+        const auto* router = object_pool_router.load(std::memory_order_acquire);
+        const ObjectPoolMetadataCacheEntry* entry = (router == nullptr) ? nullptr : router->routing_table.find_by_key(key);
+        if (entry != nullptr && !entry->opm.deleted) {
+            const auto& opm = entry->opm;
+            return std::tuple<uint32_t,uint32_t,uint32_t>{opm.subgroup_type_index,opm.subgroup_index,
+                opm.key_to_shard_index(key,router->to_affinity_set_view(entry,key),
+                                       get_number_of_shards(opm.subgroup_type_index,opm.subgroup_index),check_object_location)};
+        }
+    }
 
+    // slow path: the object pool is not cached yet.
     auto pair = find_object_pool_and_affinity_set_by_key(key);
 
     auto& opm = std::get<0>(pair);
@@ -445,69 +511,489 @@ std::tuple<uint32_t,uint32_t,uint32_t> ServiceClient<CascadeTypes...>::key_to_sh
 
 template <typename... CascadeTypes>
 ServiceClient<CascadeTypes...>::ObjectPoolMetadataCacheEntry::ObjectPoolMetadataCacheEntry(
-        const ObjectPoolMetadata<CascadeTypes...>& _opm): opm(_opm), database(nullptr) {
-    if (opm.affinity_set_regex.size() > 0) {
-        hs_compile_error_t* compile_err;
-        if (hs_compile(opm.affinity_set_regex.c_str(), HS_FLAG_DOTALL|HS_FLAG_SOM_LEFTMOST, HS_MODE_BLOCK, NULL, &database,
-                       &compile_err) != HS_SUCCESS) {
-            hs_free_compile_error(compile_err);
-            dbg_default_error("Compilation of affinity set regex:" + opm.affinity_set_regex + " failed with message:" +
-                    compile_err->message);
-            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) +
-                    ": compilation of affinity_set_regex:" +
-                    opm.affinity_set_regex +
-                    " failed with message:" +
-                    compile_err->message);
+        const ObjectPoolMetadata<CascadeTypes...>& _opm): opm(_opm) {}
+
+/**
+ * Collect the affinity set regexes of an object pool metadata cache for AffinitySetMatcher.
+ */
+template <typename EntryType>
+std::vector<std::pair<const EntryType*,std::string>> collect_affinity_set_regexes(
+        const std::unordered_map<std::string,std::shared_ptr<EntryType>>& cache) {
+    std::vector<std::pair<const EntryType*,std::string>> regexes;
+    for (const auto& kv: cache) {
+        if (!kv.second->opm.affinity_set_regex.empty()) {
+            regexes.emplace_back(kv.second.get(),kv.second->opm.affinity_set_regex);
         }
     }
+    return regexes;
+}
+
+template <typename... CascadeTypes>
+ServiceClient<CascadeTypes...>::ObjectPoolRouter::ObjectPoolRouter(
+        const std::unordered_map<std::string,std::shared_ptr<ObjectPoolMetadataCacheEntry>>& cache):
+    routing_table(cache),
+    affinity_set_matcher(collect_affinity_set_regexes(cache)) {}
+
+template <typename... CascadeTypes>
+inline std::string_view ServiceClient<CascadeTypes...>::ObjectPoolRouter::to_affinity_set_view(
+        const ObjectPoolMetadataCacheEntry* entry, const std::string& key_string) const {
+    if (entry->opm.affinity_set_regex.empty()) {
+        return key_string;
+    }
+    return affinity_set_matcher.match(entry,key_string);
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+bool ServiceClient<CascadeTypes...>::is_tracking_replies(uint32_t subgroup_index, uint32_t shard_index) {
+    return num_adaptive_policies.load(std::memory_order_relaxed) > 0 &&
+           is_adaptive_member_selection_policy(
+               std::get<0>(get_member_selection_policy<SubgroupType>(subgroup_index,shard_index)));
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType, typename ReturnType>
+derecho::rpc::QueryResults<ReturnType> ServiceClient<CascadeTypes...>::track_replies(
+        uint32_t subgroup_index, uint32_t shard_index, node_id_t node_id,
+        derecho::rpc::QueryResults<ReturnType>&& results) {
+    if (!is_tracking_replies<SubgroupType>(subgroup_index,shard_index)) {
+        return std::move(results);
+    }
+
+    using map_fut_t = typename derecho::rpc::QueryResults<ReturnType>::map_fut;
+    using reply_map_t = typename std::decay_t<decltype(std::declval<map_fut_t&>().get())>::element_type;
+
+    // The reply map of a p2p_send is fulfilled before p2p_send returns, so this does not block. The map future handed
+    // to the caller has to be a real one, because QueryResults waits on it with a timeout.
+    auto tracked_replies = std::make_unique<reply_map_t>();
+    for (auto& reply : results.get()) {
+        tracked_replies->emplace(reply.first,member_loads.track(reply.first,std::move(reply.second)));
+    }
+    std::promise<std::unique_ptr<reply_map_t>> tracked_replies_promise;
+    tracked_replies_promise.set_value(std::move(tracked_replies));
+    return derecho::rpc::QueryResults<ReturnType>(tracked_replies_promise.get_future());
+}
+
+template <typename... CascadeTypes>
+void ServiceClient<CascadeTypes...>::enable_read_hedging(double delay_percentile, uint64_t min_delay_us) {
+    if (delay_percentile <= 0.0 || delay_percentile >= 1.0) {
+        throw derecho::derecho_exception("Invalid read hedging delay percentile:" + std::to_string(delay_percentile));
+    }
+    read_hedging_percentile.store(delay_percentile,std::memory_order_relaxed);
+    read_hedging_min_delay_ns.store(min_delay_us*1000,std::memory_order_relaxed);
+    // until there are enough samples, hedge the reads slower than 1 ms.
+    read_hedging_delay_ns.store(std::max<uint64_t>(min_delay_us*1000,1000000),std::memory_order_relaxed);
+    read_hedging_enabled.store(true,std::memory_order_release);
+}
+
+template <typename... CascadeTypes>
+void ServiceClient<CascadeTypes...>::disable_read_hedging() {
+    read_hedging_enabled.store(false,std::memory_order_release);
+}
+
+template <typename... CascadeTypes>
+std::tuple<uint64_t,uint64_t,uint64_t,uint64_t> ServiceClient<CascadeTypes...>::get_read_hedging_stats() const {
+    return std::make_tuple(num_hedgeable_reads.load(std::memory_order_relaxed),
+                           num_hedged_reads.load(std::memory_order_relaxed),
+                           num_hedge_wins.load(std::memory_order_relaxed),
+                           read_hedging_delay_ns.load(std::memory_order_relaxed));
+}
+
+template <typename... CascadeTypes>
+void ServiceClient<CascadeTypes...>::enable_read_cache(std::size_t capacity_bytes, uint64_t max_staleness_us) {
+    if (capacity_bytes == 0) {
+        throw derecho::derecho_exception("The read cache capacity must be positive.");
+    }
+    if (max_staleness_us == 0) {
+        // the invalidations are best effort, and a shard member receives none.
+        throw derecho::derecho_exception("The read cache needs a staleness bound.");
+    }
+    std::atomic_store(&read_cache,std::make_shared<ClientReadCache<read_cache_object_t>>(capacity_bytes,max_staleness_us));
+}
+
+template <typename... CascadeTypes>
+void ServiceClient<CascadeTypes...>::disable_read_cache() {
+    std::atomic_store(&read_cache,std::shared_ptr<ClientReadCache<read_cache_object_t>>());
+}
+
+template <typename... CascadeTypes>
+typename ClientReadCache<typename ServiceClient<CascadeTypes...>::read_cache_object_t>::stats_t
+ServiceClient<CascadeTypes...>::get_read_cache_stats() const {
+    auto cache = std::atomic_load(&read_cache);
+    if (!cache) {
+        return {};
+    }
+    return cache->get_stats();
 }
 
 template <typename... CascadeTypes>
-ServiceClient<CascadeTypes...>::ObjectPoolMetadataCacheEntry::~ObjectPoolMetadataCacheEntry() {
-    if (this->database != nullptr) {
-        hs_free_database(database);
-        this->database = nullptr;
+template <typename SubgroupType>
+uint64_t ServiceClient<CascadeTypes...>::read_cache_owner(uint32_t subgroup_index) const {
+    return (static_cast<uint64_t>(std::type_index(typeid(SubgroupType)).hash_code()) << 16) ^ subgroup_index;
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+std::shared_ptr<ClientReadCache<typename ServiceClient<CascadeTypes...>::read_cache_object_t>>
+ServiceClient<CascadeTypes...>::read_cache_of(uint32_t subgroup_index, uint32_t shard_index) {
+    if constexpr (!is_read_cacheable<SubgroupType>) {
+        return nullptr;
     }
+    auto cache = std::atomic_load(&read_cache);
+    if (cache && !is_external_client() &&
+        static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+        return nullptr;
+    }
+    return cache;
 }
 
 template <typename... CascadeTypes>
-inline std::string ServiceClient<CascadeTypes...>::ObjectPoolMetadataCacheEntry::to_affinity_set(
-        const std::string& key_string) {
-    if (key_string.size() > 0 && this->opm.affinity_set_regex.size() > 0) {
-        if (scratch == nullptr) {
-            if (hs_alloc_scratch(database, &scratch) != HS_SUCCESS) {
-                hs_free_database(database);
-                dbg_default_error("failed to allocate hyperscan scratch space.");
-                throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) +
-                        " failed to allocate hyperscan scratch space.");
+template <typename SubgroupType>
+bool ServiceClient<CascadeTypes...>::subscribe_cache_invalidation(uint32_t subgroup_index, uint32_t shard_index,
+                                                                  uint64_t renewal_interval_us) {
+    auto shard = std::make_tuple(std::type_index(typeid(SubgroupType)),subgroup_index,shard_index);
+    auto is_fresh = [renewal_interval_us](const read_cache_subscription_t& subscription) {
+        return subscription.renewing || get_time_us(false) - subscription.renewed_us < renewal_interval_us;
+    };
+    {
+        std::shared_lock<std::shared_mutex> rlck(read_cache_subscriptions_mutex);
+        auto it = read_cache_subscriptions.find(shard);
+        if (it != read_cache_subscriptions.end() && is_fresh(it->second)) {
+            return true;
+        }
+    }
+    std::unique_lock<std::shared_mutex> wlck(read_cache_subscriptions_mutex);
+    auto it = read_cache_subscriptions.find(shard);
+    if (it != read_cache_subscriptions.end()) {
+        if (is_fresh(it->second)) {
+            return true;
+        }
+        // renew without holding the lock; the reads from the shard keep using the current subscription meanwhile.
+        it->second.renewing = true;
+        wlck.unlock();
+    } else {
+        // the reads from the shard wait here until the first subscription is registered.
+        std::unique_lock<std::mutex> type_registry_lock(this->notification_handler_registry_mutex);
+        auto& per_type_registry = notification_handler_registry.template get<SubgroupType>();
+        if (per_type_registry.find(subgroup_index) == per_type_registry.cend()) {
+            per_type_registry.emplace(subgroup_index,SubgroupNotificationHandler<SubgroupType>{});
+            auto& subgroup_caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
+            per_type_registry.at(subgroup_index).initialize(subgroup_caller);
+        }
+        auto& subgroup_handlers = per_type_registry.at(subgroup_index);
+        std::lock_guard<std::mutex> subgroup_handlers_lock(*subgroup_handlers.object_pool_notification_handlers_mutex);
+        if (!subgroup_handlers.cache_invalidation_handler.has_value()) {
+            subgroup_handlers.cache_invalidation_handler = [this](const std::string& key, const persistent::version_t& version) {
+                auto cache = std::atomic_load(&read_cache);
+                if (cache) {
+                    cache->invalidate(key,version);
+                }
+            };
+        }
+    }
+    // subscribe after the handler is in place, so that no invalidation is lost. Every member of the shard applies the
+    // writes and sends the invalidations of its own subscribers, so the subscription goes to all of them, and is
+    // renewed with all of them: a member that failed to reach this client has dropped it.
+    typename SubgroupType::ObjectType subscription(std::string(CACHE_INVALIDATION_SUBSCRIPTION_KEY),Blob());
+    auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
+    std::unordered_set<node_id_t> subscribed;
+    std::vector<std::pair<node_id_t,derecho::rpc::QueryResults<void>>> pending;
+    for (const auto member : this->template get_shard_members<SubgroupType>(subgroup_index,shard_index)) {
+        try {
+            std::lock_guard<std::mutex> p2p_lck(this->p2p_send_mutex(member));
+            pending.emplace_back(member,caller.template p2p_send<RPC_NAME(trigger_put)>(member,subscription));
+        } catch (derecho::derecho_exception& ex) {
+            dbg_default_warn("Failed to subscribe to the cache invalidations of {}:{}/{} on node {}:{}",
+                    typeid(SubgroupType).name(), subgroup_index, shard_index, member, ex.what());
+        }
+    }
+    for (auto& member_results : pending) {
+        try {
+            for (auto& reply : member_results.second.get()) {
+                reply.second.get();
             }
+            subscribed.emplace(member_results.first);
+        } catch (derecho::derecho_exception& ex) {
+            dbg_default_warn("Failed to subscribe to the cache invalidations of {}:{}/{} on node {}:{}",
+                    typeid(SubgroupType).name(), subgroup_index, shard_index, member_results.first, ex.what());
         }
+    }
+    if (!wlck.owns_lock()) {
+        wlck.lock();
+    }
+    if (subscribed.empty()) {
+        // the next read tries again.
+        read_cache_subscriptions.erase(shard);
+        return false;
+    }
+    // the members gone with a view change are dropped.
+    auto& subscription_state = read_cache_subscriptions[shard];
+    subscription_state.members = std::move(subscribed);
+    subscription_state.renewed_us = get_time_us(false);
+    subscription_state.renewing = false;
+    return true;
+}
 
-        struct hs_scan_ctxt {
-            unsigned long long from = 0;
-            unsigned long long to = 0;
-        } ctxt;
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClient<CascadeTypes...>::fill_read_cache(
+        const std::shared_ptr<ClientReadCache<read_cache_object_t>>& cache, uint64_t owner,
+        const std::string& key, const persistent::version_t& version, bool stable, uint64_t stamp,
+        derecho::rpc::QueryResults<const typename SubgroupType::ObjectType>&& results) {
+    using ObjectType = typename SubgroupType::ObjectType;
+    using map_fut_t = typename derecho::rpc::QueryResults<const ObjectType>::map_fut;
+    using reply_map_t = typename std::decay_t<decltype(std::declval<map_fut_t&>().get())>::element_type;
+
+    // like track_replies(), this does not block on a p2p_send or on a hedged read.
+    auto filled_replies = std::make_unique<reply_map_t>();
+    for (auto& reply : results.get()) {
+        filled_replies->emplace(reply.first,std::async(std::launch::deferred,
+            [cache,owner,key,version,stable,stamp,reply_future = std::move(reply.second)]() mutable -> const ObjectType {
+                auto object = std::make_shared<const ObjectType>(reply_future.get());
+                cache->fill(owner,key,version,stable,stamp,object,mutils::bytes_size(*object));
+                // the caller and the cache share the object data.
+                return ClientReadCache<read_cache_object_t>::share(object);
+            }));
+    }
+    std::promise<std::unique_ptr<reply_map_t>> filled_replies_promise;
+    filled_replies_promise.set_value(std::move(filled_replies));
+    return derecho::rpc::QueryResults<const ObjectType>(filled_replies_promise.get_future());
+}
+
+template <typename... CascadeTypes>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::end_cached_writes(
+        const std::shared_ptr<ClientReadCache<read_cache_object_t>>& cache, std::vector<std::string>&& keys,
+        derecho::rpc::QueryResults<version_tuple>&& results) {
+    if (!cache) {
+        return std::move(results);
+    }
+    using map_fut_t = typename derecho::rpc::QueryResults<version_tuple>::map_fut;
+    using reply_map_t = typename std::decay_t<decltype(std::declval<map_fut_t&>().get())>::element_type;
+
+    auto shared_keys = std::make_shared<std::vector<std::string>>(std::move(keys));
+    auto versioned_replies = std::make_unique<reply_map_t>();
+    for (auto& reply : results.get()) {
+        versioned_replies->emplace(reply.first,std::async(std::launch::deferred,
+            [cache,shared_keys,reply_future = std::move(reply.second)]() mutable -> version_tuple {
+                try {
+                    version_tuple version = reply_future.get();
+                    for (const auto& key : *shared_keys) {
+                        cache->end_write(key,std::get<0>(version));
+                    }
+                    return version;
+                } catch (...) {
+                    for (const auto& key : *shared_keys) {
+                        cache->end_write(key,persistent::INVALID_VERSION);
+                    }
+                    throw;
+                }
+            }));
+    }
+    std::promise<std::unique_ptr<reply_map_t>> versioned_replies_promise;
+    versioned_replies_promise.set_value(std::move(versioned_replies));
+    return derecho::rpc::QueryResults<version_tuple>(versioned_replies_promise.get_future());
+}
 
-        hs_scan(database, key_string.c_str(), key_string.size(), HS_FLAG_SOM_LEFTMOST, scratch,
-                [](unsigned int /*id*/, unsigned long long from,
-                   unsigned long long to, unsigned int /*flags*/,
-                   void* ctxt)->int {
-                    struct hs_scan_ctxt* p_hs_ctxt = static_cast<struct hs_scan_ctxt*>(ctxt);
-                    p_hs_ctxt->from = from;
-                    p_hs_ctxt->to = to;
-                    return 0; // do the longest match
-                },
-                &ctxt);
-        if (ctxt.to > ctxt.from) {
-            return key_string.substr(ctxt.from,(ctxt.to-ctxt.from));
-        }
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+void ServiceClient<CascadeTypes...>::notify_cache_invalidation(
+        const std::string& key,
+        const persistent::version_t& version,
+        const uint32_t subgroup_index,
+        const node_id_t client_id) const {
+    if (is_external_client()) {
+        throw derecho_exception(std::string(__PRETTY_FUNCTION__) +
+                "Cannot notify an external client from an external client.");
     }
 
-    return key_string;
+    auto& client_handle = group_ptr->template get_client_callback<SubgroupType>(subgroup_index);
+
+    CascadeCacheInvalidationMessage invalidation(key,version);
+    derecho::NotificationMessage derecho_notification_message(CASCADE_CACHE_INVALIDATION_MESSAGE_TYPE, mutils::bytes_size(invalidation));
+    mutils::to_bytes(invalidation,derecho_notification_message.body);
+
+    std::lock_guard<std::mutex> lck(this->p2p_send_mutex(client_id));
+    client_handle.template p2p_send<RPC_NAME(notify)>(client_id,derecho_notification_message);
 }
 
 template <typename... CascadeTypes>
-thread_local hs_scratch_t* ServiceClient<CascadeTypes...>::ObjectPoolMetadataCacheEntry::scratch = nullptr;
+void ServiceClient<CascadeTypes...>::record_read_latency(uint64_t latency_ns) {
+    // bucket b >= 4 covers [(4 + b%4) << (b/4 - 1), (5 + b%4) << (b/4 - 1)).
+    auto bucket_of = [](uint64_t v)->uint32_t {
+        if (v < 4) {
+            return static_cast<uint32_t>(v);
+        }
+        uint32_t e = 63 - __builtin_clzll(v);
+        return 4*(e-1) + static_cast<uint32_t>((v >> (e-2)) & 3);
+    };
+    read_latency_histogram[bucket_of(latency_ns)].fetch_add(1,std::memory_order_relaxed);
+    if ((num_read_latency_samples.fetch_add(1,std::memory_order_relaxed) + 1) % read_latency_samples_per_refresh != 0) {
+        return;
+    }
+    // refresh the delay, and halve the histogram.
+    std::array<uint32_t,num_read_latency_buckets> counts;
+    uint64_t total = 0;
+    for (uint32_t b = 0; b < num_read_latency_buckets; b++) {
+        counts[b] = read_latency_histogram[b].load(std::memory_order_relaxed);
+        read_latency_histogram[b].fetch_sub(counts[b]/2,std::memory_order_relaxed);
+        total += counts[b];
+    }
+    uint64_t target = static_cast<uint64_t>(total * read_hedging_percentile.load(std::memory_order_relaxed));
+    uint64_t seen = 0;
+    uint32_t b = 0;
+    for (; b < num_read_latency_buckets - 1; b++) {
+        seen += counts[b];
+        if (seen > target) {
+            break;
+        }
+    }
+    // use the upper bound of the bucket.
+    // buckets 0 to 3 hold a single value each.
+    uint64_t delay_ns = (b < 4) ? (b + 1) : (static_cast<uint64_t>(5 + b%4) << (b/4 - 1));
+    read_hedging_delay_ns.store(std::max(delay_ns,read_hedging_min_delay_ns.load(std::memory_order_relaxed)),
+                                std::memory_order_relaxed);
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType, typename KeyTypeForHashing>
+node_id_t ServiceClient<CascadeTypes...>::pick_hedge_member(uint32_t subgroup_index, uint32_t shard_index,
+                                                            const KeyTypeForHashing& key_for_hashing,
+                                                            node_id_t first_node_id) {
+    node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key_for_hashing);
+    if (node_id != first_node_id) {
+        return node_id;
+    }
+    auto key = std::make_tuple(std::type_index(typeid(SubgroupType)),subgroup_index,shard_index);
+    std::shared_lock rlck(member_cache_mutex);
+    auto it = member_cache.find(key);
+    if (it == member_cache.end() || it->second.size() < 2) {
+        return INVALID_NODE_ID;
+    }
+    const auto& members = it->second;
+    auto pos = std::find(members.begin(),members.end(),first_node_id);
+    if (pos == members.end() || ++pos == members.end()) {
+        pos = members.begin();
+    }
+    return *pos;
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType, typename ReturnType, typename KeyTypeForHashing>
+derecho::rpc::QueryResults<ReturnType> ServiceClient<CascadeTypes...>::hedge_read(
+        uint32_t subgroup_index, uint32_t shard_index, const KeyTypeForHashing& key_for_hashing,
+        node_id_t node_id, const std::function<derecho::rpc::QueryResults<ReturnType>(node_id_t)>& send) {
+    num_hedgeable_reads.fetch_add(1,std::memory_order_relaxed);
+
+    using map_fut_t = typename derecho::rpc::QueryResults<ReturnType>::map_fut;
+    using reply_map_t = typename std::decay_t<decltype(std::declval<map_fut_t&>().get())>::element_type;
+
+    // The replies are not wrapped by track_replies(), whose deferred futures cannot be polled; the loads of the
+    // members are tracked here instead.
+    const bool tracking = is_tracking_replies<SubgroupType>(subgroup_index,shard_index);
+    uint64_t send_ns = static_cast<uint64_t>(get_time());
+    std::unique_ptr<MemberLoads::load_guard_t> first_guard;
+    if (tracking) {
+        first_guard = std::make_unique<MemberLoads::load_guard_t>(member_loads,node_id);
+    }
+    auto results = send(node_id);
+    std::future<ReturnType> first_reply;
+    for (auto& reply : results.get()) {
+        first_reply = std::move(reply.second);
+    }
+
+    auto hedged_replies = std::make_unique<reply_map_t>();
+    hedged_replies->emplace(node_id,std::async(std::launch::deferred,
+        [this,subgroup_index,shard_index,key=KeyTypeForHashing(key_for_hashing),node_id,send,send_ns,tracking,
+         first_guard=std::move(first_guard),first_reply=std::move(first_reply)]() mutable -> ReturnType {
+            using namespace std::chrono_literals;
+            auto record_and_get = [this,send_ns](std::future<ReturnType>& reply,
+                                                 std::unique_ptr<MemberLoads::load_guard_t>& guard) -> ReturnType {
+                reply.wait();
+                record_read_latency(static_cast<uint64_t>(get_time()) - send_ns);
+                if (guard) {
+                    guard->on_reply();
+                }
+                return reply.get();
+            };
+            uint64_t elapsed_ns = static_cast<uint64_t>(get_time()) - send_ns;
+            uint64_t delay_ns = read_hedging_delay_ns.load(std::memory_order_relaxed);
+            if (elapsed_ns >= delay_ns ||
+                first_reply.wait_for(std::chrono::nanoseconds(delay_ns - elapsed_ns)) != std::future_status::ready) {
+                node_id_t hedge_node_id = pick_hedge_member<SubgroupType>(subgroup_index,shard_index,key,node_id);
+                if (hedge_node_id != INVALID_NODE_ID &&
+                    first_reply.wait_for(0s) != std::future_status::ready) {
+                    num_hedged_reads.fetch_add(1,std::memory_order_relaxed);
+                    std::unique_ptr<MemberLoads::load_guard_t> hedge_guard;
+                    if (tracking) {
+                        hedge_guard = std::make_unique<MemberLoads::load_guard_t>(member_loads,hedge_node_id);
+                    }
+                    uint64_t hedge_send_ns = static_cast<uint64_t>(get_time());
+                    std::future<ReturnType> hedge_reply;
+                    {
+                        auto hedge_results = send(hedge_node_id);
+                        for (auto& reply : hedge_results.get()) {
+                            hedge_reply = std::move(reply.second);
+                        }
+                    }
+                    // A std::future can not be waited on together with another one, so each reply gets a thread
+                    // waiting for it. The thread records the latency and the load of its reply when it arrives,
+                    // whether it wins or not, and hands the reply over in the order of arrival.
+                    struct hedge_race_t {
+                        std::mutex mutex;
+                        std::condition_variable arrived;
+                        std::deque<std::pair<bool,std::future<ReturnType>>> replies;
+                    };
+                    auto race = std::make_shared<hedge_race_t>();
+                    auto watch = [this,&race](bool is_hedge, std::future<ReturnType>&& reply, uint64_t reply_send_ns,
+                                              std::unique_ptr<MemberLoads::load_guard_t>&& guard) {
+                        std::thread([this,race,is_hedge,reply = std::move(reply),reply_send_ns,
+                                     guard = std::move(guard)]() mutable {
+                            reply.wait();
+                            record_read_latency(static_cast<uint64_t>(get_time()) - reply_send_ns);
+                            if (guard) {
+                                guard->on_reply();
+                            }
+                            std::lock_guard<std::mutex> lck(race->mutex);
+                            race->replies.emplace_back(is_hedge,std::move(reply));
+                            race->arrived.notify_one();
+                        }).detach();
+                    };
+                    watch(false,std::move(first_reply),send_ns,std::move(first_guard));
+                    watch(true,std::move(hedge_reply),hedge_send_ns,std::move(hedge_guard));
+                    // return the first reply from either member, or the other one if the first fails.
+                    for (uint32_t pending = 2; pending > 0; pending--) {
+                        std::pair<bool,std::future<ReturnType>> reply;
+                        {
+                            std::unique_lock<std::mutex> lck(race->mutex);
+                            race->arrived.wait(lck,[&race]{return !race->replies.empty();});
+                            reply = std::move(race->replies.front());
+                            race->replies.pop_front();
+                        }
+                        if (reply.first) {
+                            num_hedge_wins.fetch_add(1,std::memory_order_relaxed);
+                        }
+                        try {
+                            return reply.second.get();
+                        } catch (...) {
+                            if (reply.first) {
+                                num_hedge_wins.fetch_sub(1,std::memory_order_relaxed);
+                            }
+                            if (pending == 1) {
+                                throw;
+                            }
+                            dbg_default_debug("read to node:{} failed, waiting for node:{}.",
+                                              reply.first ? hedge_node_id : node_id,
+                                              reply.first ? node_id : hedge_node_id);
+                        }
+                    }
+                }
+            }
+            return record_and_get(first_reply,first_guard);
+        }));
+    std::promise<std::unique_ptr<reply_map_t>> hedged_replies_promise;
+    hedged_replies_promise.set_value(std::move(hedged_replies));
+    return derecho::rpc::QueryResults<ReturnType>(hedged_replies_promise.get_future());
+}
 
 template <typename... CascadeTypes>
 template <typename SubgroupType,typename KeyTypeForHashing>
@@ -526,7 +1012,12 @@ node_id_t ServiceClient<CascadeTypes...>::pick_member_by_policy(uint32_t subgrou
 
     auto key = std::make_tuple(std::type_index(typeid(SubgroupType)),subgroup_index,shard_index);
 
-    if (member_cache.find(key) == member_cache.end() || retry) {
+    bool cached = false;
+    if (!retry) {
+        std::shared_lock rlck(member_cache_mutex);
+        cached = (member_cache.find(key) != member_cache.end());
+    }
+    if (!cached) {
         refresh_member_cache_entry<SubgroupType>(subgroup_index,shard_index);
     }
 
@@ -551,12 +1042,27 @@ node_id_t ServiceClient<CascadeTypes...>::pick_member_by_policy(uint32_t subgrou
         break;
     case ShardMemberSelectionPolicy::RoundRobin:
         {
-            std::shared_lock rlck(member_selection_policies_mutex);
-            node_id = static_cast<uint32_t>(node_id+1)%member_cache.at(key).size();
-            auto new_policy = std::make_tuple(ShardMemberSelectionPolicy::RoundRobin,node_id);
-            member_selection_policies[key].swap(new_policy);
+            // the position starts from the member index in the policy, if there is one.
+            auto& round_robin_position = round_robin_positions[do_hash<std::tuple<std::type_index,uint32_t,uint32_t>>{}(key) % num_send_contexts];
+            uint32_t position = round_robin_position.position.fetch_add(1,std::memory_order_relaxed);
+            if (node_id != INVALID_NODE_ID) {
+                position += node_id + 1;
+            }
+            node_id = member_cache.at(key)[position % member_cache.at(key).size()];
+        }
+        break;
+    case ShardMemberSelectionPolicy::LeastOutstandingRequests:
+        {
+            auto& round_robin_position = round_robin_positions[do_hash<std::tuple<std::type_index,uint32_t,uint32_t>>{}(key) % num_send_contexts];
+            node_id = member_loads.pick_least_outstanding(member_cache.at(key),
+                round_robin_position.position.fetch_add(1,std::memory_order_relaxed));
+        }
+        break;
+    case ShardMemberSelectionPolicy::PowerOfTwoChoices:
+        {
+            static thread_local std::minstd_rand random_engine(std::random_device{}());
+            node_id = member_loads.pick_power_of_two_choices(member_cache.at(key),random_engine);
         }
-        node_id = member_cache.at(key)[node_id];
         break;
     case ShardMemberSelectionPolicy::KeyHashing:
         {
@@ -588,11 +1094,19 @@ derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::put(
         bool as_trigger) {
     LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_PUT_START,
             (std::is_base_of<IHasMessageID,typename SubgroupType::ObjectType>::value?value.get_message_id():0));
+    std::shared_ptr<ClientReadCache<read_cache_object_t>> cache;
+    std::vector<std::string> cached_keys;
+    if constexpr (is_read_cacheable<SubgroupType>) {
+        if (!as_trigger && (cache = read_cache_of<SubgroupType>(subgroup_index,shard_index))) {
+            cached_keys.emplace_back(value.get_key_ref());
+            cache->begin_write(cached_keys.back());
+        }
+    }
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
             // ordered put as a shard member
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            std::lock_guard<std::mutex> lck(this->template ordered_send_mutex<SubgroupType>(subgroup_index));
             return subgroup_handle.template ordered_send<RPC_NAME(ordered_put)>(value,as_trigger);
         } else {
             // p2p put
@@ -600,19 +1114,24 @@ derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::put(
             try {
                 // as a subgroup member
                 auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-                return subgroup_handle.template p2p_send<RPC_NAME(put)>(node_id,value,as_trigger);
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+                return end_cached_writes(cache,std::move(cached_keys),track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                        subgroup_handle.template p2p_send<RPC_NAME(put)>(node_id,value,as_trigger)));
             } catch (derecho::invalid_subgroup_exception& ex) {
                 // as an external caller
                 auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-                return subgroup_handle.template p2p_send<RPC_NAME(put)>(node_id,value,as_trigger);
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+                return end_cached_writes(cache,std::move(cached_keys),track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                        subgroup_handle.template p2p_send<RPC_NAME(put)>(node_id,value,as_trigger)));
             }
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
-        return caller.template p2p_send<RPC_NAME(put)>(node_id,value,as_trigger);
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        return end_cached_writes(cache,std::move(cached_keys),track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                caller.template p2p_send<RPC_NAME(put)>(node_id,value,as_trigger)));
     }
 }
 
@@ -673,11 +1192,22 @@ void ServiceClient<CascadeTypes...>::put_and_forget(
         bool as_trigger) {
     LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_PUT_AND_FORGET_START,
             (std::is_base_of<IHasMessageID,typename SubgroupType::ObjectType>::value?value.get_message_id():0));
+    if constexpr (is_read_cacheable<SubgroupType>) {
+        // there is no reply to learn the version from, so the write only invalidates the cached current version.
+        auto cache = as_trigger ? nullptr : read_cache_of<SubgroupType>(subgroup_index,shard_index);
+        if (cache) {
+            cache->invalidate(value.get_key_ref(),CURRENT_VERSION);
+        }
+    }
+    if (write_coalescing_enabled.load(std::memory_order_acquire)) {
+        this->write_coalescers.template get<SubgroupType>()->put(subgroup_index,shard_index,value,as_trigger);
+        return;
+    }
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
             // do ordered put as a shard member (Replicated).
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            std::lock_guard<std::mutex> lck(this->template ordered_send_mutex<SubgroupType>(subgroup_index));
             subgroup_handle.template ordered_send<RPC_NAME(ordered_put_and_forget)>(value,as_trigger);
         } else {
             node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
@@ -685,18 +1215,20 @@ void ServiceClient<CascadeTypes...>::put_and_forget(
             try{
                 // as a subgroup member
                 auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
                 subgroup_handle.template p2p_send<RPC_NAME(put_and_forget)>(node_id,value,as_trigger);
             } catch (derecho::invalid_subgroup_exception& ex) {
                 // as an external caller
                 auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
                 subgroup_handle.template p2p_send<RPC_NAME(put_and_forget)>(node_id,value,as_trigger);
             }
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
         caller.template p2p_send<RPC_NAME(put_and_forget)>(node_id,value,as_trigger);
     }
 }
@@ -747,6 +1279,201 @@ void ServiceClient<CascadeTypes...>::put_and_forget(const ObjectType& value,bool
     this->template type_recursive_put_and_forget<ObjectType,CascadeTypes...>(subgroup_type_index,value,subgroup_index,shard_index,as_trigger);
 }
 
+template <typename... CascadeTypes>
+void ServiceClient<CascadeTypes...>::enable_write_coalescing(std::size_t max_batch_objects,
+                                                             std::size_t max_batch_bytes,
+                                                             uint64_t linger_us) {
+    if (max_batch_objects == 0 || max_batch_bytes == 0) {
+        throw derecho::derecho_exception("The write coalescing thresholds must be positive.");
+    }
+    (this->write_coalescers.template get<CascadeTypes>()->configure(max_batch_objects,max_batch_bytes,linger_us),...);
+    write_coalescing_enabled.store(true,std::memory_order_release);
+}
+
+template <typename... CascadeTypes>
+void ServiceClient<CascadeTypes...>::disable_write_coalescing() {
+    write_coalescing_enabled.store(false,std::memory_order_release);
+    flush();
+}
+
+template <typename... CascadeTypes>
+void ServiceClient<CascadeTypes...>::flush() {
+    (this->write_coalescers.template get<CascadeTypes>()->flush(),...);
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+node_id_t ServiceClient<CascadeTypes...>::pick_coalescing_member(uint32_t subgroup_index, uint32_t shard_index) {
+    ShardMemberSelectionPolicy policy;
+    node_id_t user_specified_node_id;
+    std::tie(policy,user_specified_node_id) = get_member_selection_policy<SubgroupType>(subgroup_index,shard_index);
+    if (policy == ShardMemberSelectionPolicy::UserSpecified) {
+        return user_specified_node_id;
+    }
+
+    auto key = std::make_tuple(std::type_index(typeid(SubgroupType)),subgroup_index,shard_index);
+    bool cached;
+    {
+        std::shared_lock rlck(member_cache_mutex);
+        cached = (member_cache.find(key) != member_cache.end());
+    }
+    if (!cached) {
+        refresh_member_cache_entry<SubgroupType>(subgroup_index,shard_index);
+    }
+    std::shared_lock rlck(member_cache_mutex);
+    const auto& members = member_cache.at(key);
+    if (members.empty()) {
+        throw derecho::derecho_exception("No member in shard " + std::to_string(shard_index) + " of subgroup " +
+                                         std::to_string(subgroup_index) + " to send the coalesced writes to.");
+    }
+    // spread the clients over the members.
+    return members[get_my_id() % members.size()];
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+void ServiceClient<CascadeTypes...>::send_coalesced_writes(uint32_t subgroup_index, uint32_t shard_index,
+                                                           const std::vector<typename SubgroupType::ObjectType>& objects,
+                                                           bool as_trigger) {
+    if (!is_external_client()) {
+        if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+            // ordered put as a shard member
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            std::lock_guard<std::mutex> lck(this->template ordered_send_mutex<SubgroupType>(subgroup_index));
+            subgroup_handle.template ordered_send<RPC_NAME(ordered_put_batch_and_forget)>(objects,as_trigger);
+            return;
+        }
+        node_id_t node_id = pick_coalescing_member<SubgroupType>(subgroup_index,shard_index);
+        try {
+            // as a subgroup member
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            subgroup_handle.template p2p_send<RPC_NAME(put_batch_and_forget)>(node_id,objects,as_trigger);
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // as an external caller
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            subgroup_handle.template p2p_send<RPC_NAME(put_batch_and_forget)>(node_id,objects,as_trigger);
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
+        node_id_t node_id = pick_coalescing_member<SubgroupType>(subgroup_index,shard_index);
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        caller.template p2p_send<RPC_NAME(put_batch_and_forget)>(node_id,objects,as_trigger);
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::put_batch(
+        const std::vector<typename SubgroupType::ObjectType>& values,
+        uint32_t subgroup_index,
+        uint32_t shard_index,
+        bool as_trigger) {
+    if (values.empty()) {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": cannot put an empty batch.");
+    }
+    std::shared_ptr<ClientReadCache<read_cache_object_t>> cache;
+    std::vector<std::string> cached_keys;
+    if constexpr (is_read_cacheable<SubgroupType>) {
+        if (!as_trigger && (cache = read_cache_of<SubgroupType>(subgroup_index,shard_index))) {
+            for (const auto& value : values) {
+                cached_keys.emplace_back(value.get_key_ref());
+                cache->begin_write(cached_keys.back());
+            }
+        }
+    }
+    if (!is_external_client()) {
+        if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+            // ordered put as a shard member
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            std::lock_guard<std::mutex> lck(this->template ordered_send_mutex<SubgroupType>(subgroup_index));
+            return subgroup_handle.template ordered_send<RPC_NAME(ordered_put_batch)>(values,as_trigger);
+        } else {
+            // p2p put
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,values.front().get_key_ref());
+            try {
+                // as a subgroup member
+                auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+                return end_cached_writes(cache,std::move(cached_keys),track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                        subgroup_handle.template p2p_send<RPC_NAME(put_batch)>(node_id,values,as_trigger)));
+            } catch (derecho::invalid_subgroup_exception& ex) {
+                // as an external caller
+                auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+                return end_cached_writes(cache,std::move(cached_keys),track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                        subgroup_handle.template p2p_send<RPC_NAME(put_batch)>(node_id,values,as_trigger)));
+            }
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,values.front().get_key_ref());
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        return end_cached_writes(cache,std::move(cached_keys),track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                caller.template p2p_send<RPC_NAME(put_batch)>(node_id,values,as_trigger)));
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename ObjectType, typename FirstType, typename SecondType, typename... RestTypes>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_put_batch(
+        uint32_t type_index,
+        const std::vector<ObjectType>& values,
+        uint32_t subgroup_index,
+        uint32_t shard_index,
+        bool as_trigger) {
+    if (type_index == 0) {
+        return this->template put_batch<FirstType>(values,subgroup_index,shard_index,as_trigger);
+    } else {
+        return this->template type_recursive_put_batch<ObjectType, SecondType, RestTypes...>(type_index-1,values,subgroup_index,shard_index,as_trigger);
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename ObjectType, typename LastType>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_put_batch(
+        uint32_t type_index,
+        const std::vector<ObjectType>& values,
+        uint32_t subgroup_index,
+        uint32_t shard_index,
+        bool as_trigger) {
+    if (type_index == 0) {
+        return this->template put_batch<LastType>(values,subgroup_index,shard_index,as_trigger);
+    } else {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename ObjectType>
+std::vector<std::unique_ptr<derecho::rpc::QueryResults<version_tuple>>> ServiceClient<CascadeTypes...>::put_batch(
+        const std::vector<ObjectType>& values, bool as_trigger) {
+    // STEP 1 - check object type
+    if constexpr (!std::is_base_of_v<ICascadeObject<std::string,ObjectType>,ObjectType>) {
+        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports object of type ICascadeObject<std::string,ObjectType>,but we get ") + typeid(ObjectType).name());
+    }
+
+    // STEP 2 - group the objects by shard
+    std::map<std::tuple<uint32_t,uint32_t,uint32_t>,std::vector<ObjectType>> shard_batches;
+    for (const auto& value : values) {
+        shard_batches[this->template key_to_shard(value.get_key_ref())].push_back(value);
+    }
+
+    // STEP 3 - send one batch to each shard
+    std::vector<std::unique_ptr<derecho::rpc::QueryResults<version_tuple>>> results;
+    for (const auto& shard_batch : shard_batches) {
+        uint32_t subgroup_type_index,subgroup_index,shard_index;
+        std::tie(subgroup_type_index,subgroup_index,shard_index) = shard_batch.first;
+        results.emplace_back(std::make_unique<derecho::rpc::QueryResults<version_tuple>>(
+                this->template type_recursive_put_batch<ObjectType,CascadeTypes...>(
+                        subgroup_type_index,shard_batch.second,subgroup_index,shard_index,as_trigger)));
+    }
+    return results;
+}
+
 template <typename... CascadeTypes>
 template <typename SubgroupType>
 derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::trigger_put(
@@ -756,24 +1483,25 @@ derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::trigger_put(
     LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_TRIGGER_PUT_START,
             (std::is_base_of<IHasMessageID,typename SubgroupType::ObjectType>::value?value.get_message_id():0));
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index){
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
             node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
             dbg_default_trace("trigger_put to node {}",node_id);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
             return subgroup_handle.template p2p_send<RPC_NAME(trigger_put)>(node_id,value);
         } else {
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
             node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
             dbg_default_trace("trigger_put to node {}",node_id);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
             return subgroup_handle.template p2p_send<RPC_NAME(trigger_put)>(node_id,value);
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
         dbg_default_trace("trigger_put to node {}",node_id);
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
         return caller.template p2p_send<RPC_NAME(trigger_put)>(node_id,value);
     }
 }
@@ -832,24 +1560,25 @@ void ServiceClient<CascadeTypes...>::collective_trigger_put(
     LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_COLLECTIVE_TRIGGER_PUT_START,
             (std::is_base_of<IHasMessageID,typename SubgroupType::ObjectType>::value?value.get_message_id():0));
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         if (group_ptr->template get_my_shard<SubgroupType>(subgroup_index) != -1) {
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
             for (auto& kv: nodes_and_futures) {
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(kv.first));
                 nodes_and_futures[kv.first] = std::make_unique<derecho::rpc::QueryResults<void>>(
                         std::move(subgroup_handle.template p2p_send<RPC_NAME(trigger_put)>(kv.first,value)));
             }
         } else {
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
             for (auto& kv: nodes_and_futures) {
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(kv.first));
                 nodes_and_futures[kv.first] = std::make_unique<derecho::rpc::QueryResults<void>>(
                         std::move(subgroup_handle.template p2p_send<RPC_NAME(trigger_put)>(kv.first,value)));
             }
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         for (auto& kv: nodes_and_futures) {
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(kv.first));
             nodes_and_futures[kv.first] = std::make_unique<derecho::rpc::QueryResults<void>>(
                     std::move(caller.template p2p_send<RPC_NAME(trigger_put)>(kv.first,value)));
         }
@@ -863,11 +1592,19 @@ derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::remove
         uint32_t subgroup_index,
         uint32_t shard_index) {
     LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_REMOVE_START,0);
+    std::shared_ptr<ClientReadCache<read_cache_object_t>> cache;
+    std::vector<std::string> cached_keys;
+    if constexpr (is_read_cacheable<SubgroupType>) {
+        if ((cache = read_cache_of<SubgroupType>(subgroup_index,shard_index))) {
+            cached_keys.emplace_back(key);
+            cache->begin_write(cached_keys.back());
+        }
+    }
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
             // do ordered remove as a member (Replicated).
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            std::lock_guard<std::mutex> lck(this->template ordered_send_mutex<SubgroupType>(subgroup_index));
             return subgroup_handle.template ordered_send<RPC_NAME(ordered_remove)>(key);
         } else {
             // do p2p remove
@@ -875,19 +1612,24 @@ derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::remove
             try {
                 // as a subgroup member
                 auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-                return subgroup_handle.template p2p_send<RPC_NAME(remove)>(node_id,key);
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+                return end_cached_writes(cache,std::move(cached_keys),track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                        subgroup_handle.template p2p_send<RPC_NAME(remove)>(node_id,key)));
             } catch (derecho::invalid_subgroup_exception& ex) {
                 // as an external caller
                 auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-                return subgroup_handle.template p2p_send<RPC_NAME(remove)>(node_id,key);
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+                return end_cached_writes(cache,std::move(cached_keys),track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                        subgroup_handle.template p2p_send<RPC_NAME(remove)>(node_id,key)));
             }
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        return caller.template p2p_send<RPC_NAME(remove)>(node_id,key);
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        return end_cached_writes(cache,std::move(cached_keys),track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                caller.template p2p_send<RPC_NAME(remove)>(node_id,key)));
     }
 }
 
@@ -945,15 +1687,49 @@ derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClien
         uint32_t subgroup_index,
         uint32_t shard_index) {
     LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_GET_START,0);
+    if constexpr (is_read_cacheable<SubgroupType>) {
+        auto cache = read_cache_of<SubgroupType>(subgroup_index,shard_index);
+        if (cache) {
+            uint64_t owner = read_cache_owner<SubgroupType>(subgroup_index);
+            auto cached = cache->find(owner,key,version,stable);
+            if (cached) {
+                node_id_t node_id = get_my_id();
+                auto pending_results = std::make_shared<PendingResults<const typename SubgroupType::ObjectType>>();
+                pending_results->fulfill_map({node_id});
+                // the view shares the cached object data.
+                pending_results->set_value(node_id,ClientReadCache<read_cache_object_t>::share(cached));
+                auto query_results = pending_results->get_future();
+                return std::move(*query_results);
+            }
+            // a versioned object never changes, so only the current versions need the invalidations.
+            if (version != CURRENT_VERSION || !is_external_client() ||
+                subscribe_cache_invalidation<SubgroupType>(subgroup_index,shard_index,cache->get_max_staleness_us())) {
+                uint64_t stamp = cache->stamp(key);
+                return fill_read_cache<SubgroupType>(cache,owner,key,version,stable,stamp,
+                        get_from_shard<SubgroupType>(key,version,stable,subgroup_index,shard_index));
+            }
+        }
+    }
+    return get_from_shard<SubgroupType>(key,version,stable,subgroup_index,shard_index);
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClient<CascadeTypes...>::get_from_shard(
+        const typename SubgroupType::KeyType& key,
+        const persistent::version_t& version,
+        bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
         try {
             // do p2p get as a subgroup member
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
             if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
                 node_id = group_ptr->get_my_id();
-                // local get
+                // local get. The store may return a view sharing the stored object; set_value() copies the view,
+                // which shares the object data instead of copying it.
                 auto obj = subgroup_handle.get_ref().get(key,version,stable);
                 auto pending_results = std::make_shared<PendingResults<const typename SubgroupType::ObjectType>>();
                 pending_results->fulfill_map({node_id});
@@ -961,78 +1737,205 @@ derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClien
                 auto query_results = pending_results->get_future();
                 return std::move(*query_results);
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(get)>(node_id,key,version,stable,false);
+            if (version == CURRENT_VERSION && read_hedging_enabled.load(std::memory_order_relaxed)) {
+                return hedge_read<SubgroupType,const typename SubgroupType::ObjectType>(subgroup_index,shard_index,key,node_id,
+                    [this,&subgroup_handle,key,version,stable](node_id_t nid) {
+                        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(nid));
+                        return subgroup_handle.template p2p_send<RPC_NAME(get)>(nid,key,version,stable,false);
+                    });
+            }
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(get)>(node_id,key,version,stable,false));
         } catch (derecho::invalid_subgroup_exception& ex) {
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(get)>(node_id,key,version,stable,false);
+            if (version == CURRENT_VERSION && read_hedging_enabled.load(std::memory_order_relaxed)) {
+                return hedge_read<SubgroupType,const typename SubgroupType::ObjectType>(subgroup_index,shard_index,key,node_id,
+                    [this,&subgroup_handle,key,version,stable](node_id_t nid) {
+                        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(nid));
+                        return subgroup_handle.template p2p_send<RPC_NAME(get)>(nid,key,version,stable,false);
+                    });
+            }
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(get)>(node_id,key,version,stable,false));
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        return caller.template p2p_send<RPC_NAME(get)>(node_id,key,version,stable,false);
+        if (version == CURRENT_VERSION && read_hedging_enabled.load(std::memory_order_relaxed)) {
+            return hedge_read<SubgroupType,const typename SubgroupType::ObjectType>(subgroup_index,shard_index,key,node_id,
+                [this,&caller,key,version,stable](node_id_t nid) {
+                    std::lock_guard<std::mutex> lck(this->p2p_send_mutex(nid));
+                    return caller.template p2p_send<RPC_NAME(get)>(nid,key,version,stable,false);
+                });
+        }
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                caller.template p2p_send<RPC_NAME(get)>(node_id,key,version,stable,false));
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClient<CascadeTypes...>::multi_get(
+        const typename SubgroupType::KeyType& key,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_MULTI_GET_START,0);
+    if (!is_external_client()) {
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+        try {
+            // do p2p multi_get as a subgroup member.
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                node_id = group_ptr->get_my_id();
+            }
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(multi_get)>(node_id,key));
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // do p2p multi_get as an external caller.
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(multi_get)>(node_id,key));
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                caller.template p2p_send<RPC_NAME(multi_get)>(node_id,key));
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
+auto ServiceClient<CascadeTypes...>::type_recursive_get(
+        uint32_t type_index,
+        const KeyType& key,
+        const persistent::version_t& version,
+        bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        return this->template get<FirstType>(key,version,stable,subgroup_index,shard_index);
+    } else {
+        return this->template type_recursive_get<KeyType,SecondType,RestTypes...>(type_index-1,key,version,stable,subgroup_index,shard_index);
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType, typename LastType>
+auto ServiceClient<CascadeTypes...>::type_recursive_get(
+        uint32_t type_index,
+        const KeyType& key,
+        const persistent::version_t& version,
+        bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        return this->template get<LastType>(key,version,stable,subgroup_index,shard_index);
+    } else {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType>
+auto ServiceClient<CascadeTypes...>::get(
+        // const std::decay_t<typename std::result_of_t<decltype(&ObjectType::get_key_ref())>>& key,
+        const KeyType& key,
+        const persistent::version_t& version,
+        bool stable) {
+    // STEP 1 - get key
+    if constexpr (!std::is_convertible_v<KeyType,std::string>) {
+        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
     }
+
+    // STEP 2 - get shard
+    uint32_t subgroup_type_index,subgroup_index,shard_index;
+    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(key);
+
+    // STEP 3 - call recursive get
+    return this->template type_recursive_get<KeyType,CascadeTypes...>(subgroup_type_index,key,version,stable,subgroup_index,shard_index);
 }
 
 template <typename... CascadeTypes>
 template <typename SubgroupType>
-derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClient<CascadeTypes...>::multi_get(
-        const typename SubgroupType::KeyType& key,
+derecho::rpc::QueryResults<std::vector<typename SubgroupType::ObjectType>> ServiceClient<CascadeTypes...>::multi_key_get(
+        const std::vector<typename SubgroupType::KeyType>& keys,
+        const persistent::version_t& version,
+        bool stable,
         uint32_t subgroup_index,
         uint32_t shard_index) {
-    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_MULTI_GET_START,0);
+    if (keys.empty()) {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": cannot get an empty list of keys.");
+    }
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,keys.front());
         try {
-            // do p2p multi_get as a subgroup member.
+            // do p2p multi_key_get as a subgroup member
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
             if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
                 node_id = group_ptr->get_my_id();
+                // local multi_key_get
+                auto objs = subgroup_handle.get_ref().multi_key_get(keys,version,stable);
+                auto pending_results = std::make_shared<PendingResults<std::vector<typename SubgroupType::ObjectType>>>();
+                pending_results->fulfill_map({node_id});
+                pending_results->set_value(node_id,objs);
+                auto query_results = pending_results->get_future();
+                return std::move(*query_results);
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(multi_get)>(node_id,key);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(multi_key_get)>(node_id,keys,version,stable));
         } catch (derecho::invalid_subgroup_exception& ex) {
-            // do p2p multi_get as an external caller.
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(multi_get)>(node_id,key);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(multi_key_get)>(node_id,keys,version,stable));
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        return caller.template p2p_send<RPC_NAME(multi_get)>(node_id,key);
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,keys.front());
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                caller.template p2p_send<RPC_NAME(multi_key_get)>(node_id,keys,version,stable));
     }
 }
 
 template <typename... CascadeTypes>
 template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
-auto ServiceClient<CascadeTypes...>::type_recursive_get(
+auto ServiceClient<CascadeTypes...>::type_recursive_multi_key_get(
         uint32_t type_index,
-        const KeyType& key,
+        const std::vector<KeyType>& keys,
         const persistent::version_t& version,
         bool stable,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template get<FirstType>(key,version,stable,subgroup_index,shard_index);
+        return this->template multi_key_get<FirstType>(keys,version,stable,subgroup_index,shard_index);
     } else {
-        return this->template type_recursive_get<KeyType,SecondType,RestTypes...>(type_index-1,key,version,stable,subgroup_index,shard_index);
+        return this->template type_recursive_multi_key_get<KeyType,SecondType,RestTypes...>(type_index-1,keys,version,stable,subgroup_index,shard_index);
     }
 }
 
 template <typename... CascadeTypes>
 template <typename KeyType, typename LastType>
-auto ServiceClient<CascadeTypes...>::type_recursive_get(
+auto ServiceClient<CascadeTypes...>::type_recursive_multi_key_get(
         uint32_t type_index,
-        const KeyType& key,
+        const std::vector<KeyType>& keys,
         const persistent::version_t& version,
         bool stable,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template get<LastType>(key,version,stable,subgroup_index,shard_index);
+        return this->template multi_key_get<LastType>(keys,version,stable,subgroup_index,shard_index);
     } else {
         throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
     }
@@ -1040,22 +1943,54 @@ auto ServiceClient<CascadeTypes...>::type_recursive_get(
 
 template <typename... CascadeTypes>
 template <typename KeyType>
-auto ServiceClient<CascadeTypes...>::get(
-        // const std::decay_t<typename std::result_of_t<decltype(&ObjectType::get_key_ref())>>& key,
-        const KeyType& key,
+auto ServiceClient<CascadeTypes...>::multi_key_get(
+        const std::vector<KeyType>& keys,
         const persistent::version_t& version,
         bool stable) {
-    // STEP 1 - get key
+    // STEP 1 - check key type
     if constexpr (!std::is_convertible_v<KeyType,std::string>) {
         throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
     }
 
-    // STEP 2 - get shard
-    uint32_t subgroup_type_index,subgroup_index,shard_index;
-    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(key);
-
-    // STEP 3 - call recursive get
-    return this->template type_recursive_get<KeyType,CascadeTypes...>(subgroup_type_index,key,version,stable,subgroup_index,shard_index);
+    // STEP 2 - group the keys by shard, and remember where they are in the key list.
+    std::map<std::tuple<uint32_t,uint32_t,uint32_t>,std::pair<std::vector<KeyType>,std::vector<std::size_t>>> shard_keys;
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        auto& shard = shard_keys[this->template key_to_shard(keys[i])];
+        shard.first.push_back(keys[i]);
+        shard.second.push_back(i);
+    }
+
+    // STEP 3 - scatter: send one request to each shard.
+    using ResultsType = decltype(this->template type_recursive_multi_key_get<KeyType,CascadeTypes...>(0,keys,version,stable,0,0));
+    std::vector<std::unique_ptr<ResultsType>> shard_results;
+    for (const auto& shard : shard_keys) {
+        uint32_t subgroup_type_index,subgroup_index,shard_index;
+        std::tie(subgroup_type_index,subgroup_index,shard_index) = shard.first;
+        shard_results.emplace_back(std::make_unique<ResultsType>(
+                this->template type_recursive_multi_key_get<KeyType,CascadeTypes...>(
+                        subgroup_type_index,shard.second.first,version,stable,subgroup_index,shard_index)));
+    }
+
+    // STEP 4 - gather the replies in the order of the keys.
+    using ObjectListType = std::decay_t<decltype(shard_results.front()->get().begin()->second.get())>;
+    ObjectListType objects(keys.size());
+    auto shard_it = shard_keys.cbegin();
+    for (auto& shard_result : shard_results) {
+        const auto& positions = shard_it->second.second;
+        for (auto& reply_future : shard_result->get()) {
+            auto reply = reply_future.second.get();
+            if (reply.size() != positions.size()) {
+                throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": expecting " + std::to_string(positions.size())
+                        + " objects from a shard, but got " + std::to_string(reply.size()) + ".");
+            }
+            for (std::size_t i = 0; i < positions.size(); i++) {
+                objects[positions[i]] = std::move(reply[i]);
+            }
+            break;
+        }
+        shard_it++;
+    }
+    return objects;
 }
 
 template <typename... CascadeTypes>
@@ -1112,7 +2047,6 @@ derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClien
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
         try {
             // do p2p get_by_time
@@ -1121,18 +2055,23 @@ derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClien
                 // as a shard member.
                 node_id = group_ptr->get_my_id();
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(get_by_time)>(node_id,key,ts_us,stable);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(get_by_time)>(node_id,key,ts_us,stable));
         } catch (derecho::invalid_subgroup_exception& ex) {
             // do p2p get_by_time as an external caller
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(get_by_time)>(node_id,key,ts_us,stable);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(get_by_time)>(node_id,key,ts_us,stable));
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>();
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        return caller.template p2p_send<RPC_NAME(get_by_time)>(node_id,key,ts_us,stable);
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                caller.template p2p_send<RPC_NAME(get_by_time)>(node_id,key,ts_us,stable));
     }
 }
 
@@ -1197,7 +2136,6 @@ derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::get_size(
         uint32_t shard_index) {
     LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_GET_SIZE_START,0);
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
         try {
             // do p2p get_size as a subgroup_member
@@ -1206,18 +2144,45 @@ derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::get_size(
                 // as a shard member.
                 node_id = group_ptr->get_my_id();
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(get_size)>(node_id,key,version,stable,false);
+            if (version == CURRENT_VERSION && read_hedging_enabled.load(std::memory_order_relaxed) &&
+                node_id != group_ptr->get_my_id()) {
+                return hedge_read<SubgroupType,uint64_t>(subgroup_index,shard_index,key,node_id,
+                    [this,&subgroup_handle,key,version,stable](node_id_t nid) {
+                        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(nid));
+                        return subgroup_handle.template p2p_send<RPC_NAME(get_size)>(nid,key,version,stable,false);
+                    });
+            }
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(get_size)>(node_id,key,version,stable,false));
         } catch (derecho::invalid_subgroup_exception& ex) {
             // do p2p get_size as an external caller
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(get_size)>(node_id,key,version,stable,false);
+            if (version == CURRENT_VERSION && read_hedging_enabled.load(std::memory_order_relaxed)) {
+                return hedge_read<SubgroupType,uint64_t>(subgroup_index,shard_index,key,node_id,
+                    [this,&subgroup_handle,key,version,stable](node_id_t nid) {
+                        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(nid));
+                        return subgroup_handle.template p2p_send<RPC_NAME(get_size)>(nid,key,version,stable,false);
+                    });
+            }
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(get_size)>(node_id,key,version,stable,false));
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        return caller.template p2p_send<RPC_NAME(get_size)>(node_id,key,version,stable,false);
+        if (version == CURRENT_VERSION && read_hedging_enabled.load(std::memory_order_relaxed)) {
+            return hedge_read<SubgroupType,uint64_t>(subgroup_index,shard_index,key,node_id,
+                [this,&caller,key,version,stable](node_id_t nid) {
+                    std::lock_guard<std::mutex> lck(this->p2p_send_mutex(nid));
+                    return caller.template p2p_send<RPC_NAME(get_size)>(nid,key,version,stable,false);
+                });
+        }
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                caller.template p2p_send<RPC_NAME(get_size)>(node_id,key,version,stable,false));
     }
 }
 
@@ -1279,7 +2244,6 @@ derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::multi_get_s
         uint32_t subgroup_index, uint32_t shard_index) {
     LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_MULTI_GET_SIZE_START,0);
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
         try {
             // do p2p multi_get_size as a subgroup member.
@@ -1287,18 +2251,23 @@ derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::multi_get_s
             if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
                 node_id = group_ptr->get_my_id();
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(multi_get_size)>(node_id,key);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(multi_get_size)>(node_id,key));
         } catch (derecho::invalid_subgroup_exception& ex) {
             // do p2p multi_get_size as an external caller.
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(multi_get_size)>(node_id,key);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(multi_get_size)>(node_id,key));
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        return caller.template p2p_send<RPC_NAME(multi_get_size)>(node_id,key);
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                caller.template p2p_send<RPC_NAME(multi_get_size)>(node_id,key));
     }
 }
 
@@ -1355,7 +2324,6 @@ derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::get_size_by
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
         try {
             // do p2p get_size_by_time as a subgroup member.
@@ -1363,18 +2331,23 @@ derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::get_size_by
             if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
                 node_id = group_ptr->get_my_id();
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(get_size_by_time)>(node_id,key,ts_us,stable);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(get_size_by_time)>(node_id,key,ts_us,stable));
         } catch (derecho::invalid_subgroup_exception& ex) {
             // do p2p get_size_by_time as an external caller.
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(get_size_by_time)>(node_id,key,ts_us,stable);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(get_size_by_time)>(node_id,key,ts_us,stable));
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        return caller.template p2p_send<RPC_NAME(get_size_by_time)>(node_id,key,ts_us,stable);
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                caller.template p2p_send<RPC_NAME(get_size_by_time)>(node_id,key,ts_us,stable));
     }
 }
 
@@ -1438,7 +2411,6 @@ derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>> ServiceC
         uint32_t shard_index) {
     LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_LIST_KEYS_START,0);
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
         try {
             // do p2p list_keys as a subgroup member.
@@ -1446,18 +2418,45 @@ derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>> ServiceC
             if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
                 node_id = group_ptr->get_my_id();
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(node_id,"",version,stable);
+            if (version == CURRENT_VERSION && read_hedging_enabled.load(std::memory_order_relaxed) &&
+                node_id != group_ptr->get_my_id()) {
+                return hedge_read<SubgroupType,std::vector<typename SubgroupType::KeyType>>(subgroup_index,shard_index,0,node_id,
+                    [this,&subgroup_handle,version,stable](node_id_t nid) {
+                        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(nid));
+                        return subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(nid,"",version,stable);
+                    });
+            }
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(node_id,"",version,stable));
         } catch (derecho::invalid_subgroup_exception& ex) {
             // do p2p list_keys as an external client.
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(node_id,"",version,stable);
+            if (version == CURRENT_VERSION && read_hedging_enabled.load(std::memory_order_relaxed)) {
+                return hedge_read<SubgroupType,std::vector<typename SubgroupType::KeyType>>(subgroup_index,shard_index,0,node_id,
+                    [this,&subgroup_handle,version,stable](node_id_t nid) {
+                        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(nid));
+                        return subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(nid,"",version,stable);
+                    });
+            }
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(node_id,"",version,stable));
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
-        return caller.template p2p_send<RPC_NAME(list_keys)>(node_id,"",version,stable);
+        if (version == CURRENT_VERSION && read_hedging_enabled.load(std::memory_order_relaxed)) {
+            return hedge_read<SubgroupType,std::vector<typename SubgroupType::KeyType>>(subgroup_index,shard_index,0,node_id,
+                [this,&caller,version,stable](node_id_t nid) {
+                    std::lock_guard<std::mutex> lck(this->p2p_send_mutex(nid));
+                    return caller.template p2p_send<RPC_NAME(list_keys)>(nid,"",version,stable);
+                });
+        }
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                caller.template p2p_send<RPC_NAME(list_keys)>(node_id,"",version,stable));
     }
 }
 
@@ -1501,8 +2500,10 @@ std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename Subg
     }
     uint32_t subgroup_index = opm.subgroup_index;
     uint32_t shards = get_number_of_shards<SubgroupType>(subgroup_index);
+    // an object pool with the RANGE policy only needs the shards owning the prefix.
+    auto shard_range = opm.prefix_to_shard_range(object_pool_pathname,shards);
     std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> result;
-    for (uint32_t shard_index = 0; shard_index < shards; shard_index ++){
+    for (uint32_t shard_index = shard_range.first; shard_index <= shard_range.second && shard_index < shards; shard_index ++){
         if (!is_external_client()) {
             node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
             try {
@@ -1510,17 +2511,19 @@ std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename Subg
                 if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
                     node_id = group_ptr->get_my_id();
                 }
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
                 auto shard_keys = subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(node_id,object_pool_pathname,version,stable);
                 result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
             } catch (derecho::invalid_subgroup_exception& ex) {
                 auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
                 auto shard_keys= subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(node_id,object_pool_pathname,version,stable);
                 result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
             }
         } else {
-            std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
             auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
             node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
             auto shard_keys = caller.template p2p_send<RPC_NAME(list_keys)>(node_id,object_pool_pathname,version,stable);
             result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
         }
@@ -1569,7 +2572,6 @@ derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>> ServiceC
         uint32_t shard_index) {
     LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_MULTI_LIST_KEYS_START,0);
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
         try {
             // do p2p multi_list_keys as a subgroup member.
@@ -1577,19 +2579,24 @@ derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>> ServiceC
             if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
                 node_id = group_ptr->get_my_id();
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,"");
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,""));
         } catch (derecho::invalid_subgroup_exception& ex) {
             // do p2p multi_list_keys as an external client.
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
             node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
-            return subgroup_handle.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,"");
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,""));
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
-        return caller.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,"");
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                caller.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,""));
     }
 }
 
@@ -1626,8 +2633,10 @@ std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename Subg
     }
     uint32_t subgroup_index = opm.subgroup_index;
     uint32_t shards = get_number_of_shards<SubgroupType>(subgroup_index);
+    // an object pool with the RANGE policy only needs the shards owning the prefix.
+    auto shard_range = opm.prefix_to_shard_range(object_pool_pathname,shards);
     std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> result;
-    for (uint32_t shard_index = 0; shard_index < shards; shard_index ++){
+    for (uint32_t shard_index = shard_range.first; shard_index <= shard_range.second && shard_index < shards; shard_index ++){
         if (!is_external_client()) {
             node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,object_pool_pathname);
             try {
@@ -1635,17 +2644,19 @@ std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename Subg
                 if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
                     node_id = group_ptr->get_my_id();
                 }
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
                 auto shard_keys = subgroup_handle.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,object_pool_pathname);
                 result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
             } catch (derecho::invalid_subgroup_exception& ex) {
                 auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
                 auto shard_keys= subgroup_handle.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,object_pool_pathname);
                 result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
             }
         } else {
-            std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
             auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
             node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,object_pool_pathname);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
             auto shard_keys = caller.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,object_pool_pathname);
             result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
         }
@@ -1668,7 +2679,6 @@ derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>> ServiceC
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
         try {
             // do p2p list_keys_by_time as a subgroup member
@@ -1676,18 +2686,23 @@ derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>> ServiceC
             if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
                 node_id = group_ptr->get_my_id();
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,"",ts_us,stable);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,"",ts_us,stable));
         } catch (derecho::invalid_subgroup_exception& ex) {
             // do p2p list_keys_by_time as an external client.
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,"",ts_us,stable);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,"",ts_us,stable));
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
-        return caller.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,"",ts_us,stable);
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                caller.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,"",ts_us,stable));
     }
 }
 
@@ -1731,10 +2746,11 @@ std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename Subg
     }
     uint32_t subgroup_index = opm.subgroup_index;
     uint32_t shards = get_number_of_shards<SubgroupType>(subgroup_index);
+    // an object pool with the RANGE policy only needs the shards owning the prefix.
+    auto shard_range = opm.prefix_to_shard_range(object_pool_pathname,shards);
     std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> result;
-    for (uint32_t shard_index = 0; shard_index < shards; shard_index ++){
+    for (uint32_t shard_index = shard_range.first; shard_index <= shard_range.second && shard_index < shards; shard_index ++){
         if (!is_external_client()) {
-            std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
             node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,object_pool_pathname);
             try {
                 // do p2p list_keys_by_time as a subgroup member.
@@ -1742,19 +2758,21 @@ std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename Subg
                 if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
                     node_id = group_ptr->get_my_id();
                 }
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
                 auto shard_keys = subgroup_handle.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,object_pool_pathname,ts_us,stable);
                 result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
             } catch (derecho::invalid_subgroup_exception& ex) {
                 // do p2p list_keys_by_time as an external client.
                 auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+                std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
                 auto shard_keys = subgroup_handle.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,object_pool_pathname,ts_us,stable);
                 result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
             }
         } else {
-            std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
             // call as an external client (ExternalClientCaller).
             auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
             node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,object_pool_pathname);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
             auto shard_keys = caller.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,object_pool_pathname,ts_us,stable);
             result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
         }
@@ -1769,27 +2787,325 @@ auto ServiceClient<CascadeTypes...>::list_keys_by_time(const uint64_t& ts_us, co
     return this->template type_recursive_list_keys_by_time<CascadeTypes...>(subgroup_type_index,ts_us,stable,object_pool_pathname);
 }
 
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<scan_page_tuple<typename SubgroupType::KeyType,typename SubgroupType::ObjectType>> ServiceClient<CascadeTypes...>::scan(
+        const std::string& prefix,
+        const typename SubgroupType::KeyType& cursor,
+        uint32_t max_items,
+        uint64_t max_bytes,
+        const persistent::version_t& version,
+        bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (!is_external_client()) {
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        try {
+            // do p2p scan as a subgroup member.
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                node_id = group_ptr->get_my_id();
+            }
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(scan)>(node_id,prefix,version,stable,cursor,max_items,max_bytes));
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // do p2p scan as an external client.
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+            return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                    subgroup_handle.template p2p_send<RPC_NAME(scan)>(node_id,prefix,version,stable,cursor,max_items,max_bytes));
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
+        return track_replies<SubgroupType>(subgroup_index,shard_index,node_id,
+                caller.template p2p_send<RPC_NAME(scan)>(node_id,prefix,version,stable,cursor,max_items,max_bytes));
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+scan_page_tuple<typename SubgroupType::KeyType,typename SubgroupType::ObjectType> ServiceClient<CascadeTypes...>::scan_object_pool(
+        const std::string& prefix,
+        const typename SubgroupType::KeyType& cursor,
+        uint32_t max_items,
+        uint64_t max_bytes,
+        const persistent::version_t& version,
+        bool stable) {
+    if constexpr (!std::is_convertible_v<typename SubgroupType::KeyType,std::string>) {
+        throw derecho::derecho_exception(std::string("scan_object_pool requires string keys, but SubgroupType is:") + typeid(SubgroupType).name());
+    } else {
+        auto opm = find_object_pool(prefix);
+        if (!opm.is_valid() || opm.is_null() || opm.deleted) {
+            throw derecho::derecho_exception("Failed to find object_pool for prefix:" + prefix);
+        }
+        if (opm.sharding_policy != RANGE || !opm.affinity_set_regex.empty()) {
+            throw derecho::derecho_exception("scan_object_pool requires an object pool with the RANGE sharding policy and no affinity set:" + opm.pathname);
+        }
+        if (opm.subgroup_type_index != ObjectPoolMetadata<CascadeTypes...>::template get_subgroup_type_index<SubgroupType>()) {
+            throw derecho::derecho_exception(std::string("scan_object_pool failed because object pool:") + opm.pathname +
+                                             " is not of SubgroupType:" + typeid(SubgroupType).name());
+        }
+        const typename SubgroupType::KeyType& invalid_key = SubgroupType::ObjectType::IK;
+        uint32_t shards = get_number_of_shards<SubgroupType>(opm.subgroup_index);
+        auto shard_range = opm.prefix_to_shard_range(prefix,shards);
+        // start from the shard owning the cursor, and move on to the next shard only when a shard runs out of objects.
+        uint32_t shard_index = shard_range.first;
+        typename SubgroupType::KeyType shard_cursor = cursor;
+        if (cursor != invalid_key) {
+            shard_index = std::max(shard_index,opm.key_to_shard_index(cursor,cursor,shards,false));
+        }
+        std::vector<typename SubgroupType::ObjectType> objects;
+        uint64_t page_bytes = 0;
+        while (shard_index <= shard_range.second && shard_index < shards) {
+            uint32_t items_left = (max_items == 0) ? 0 : (max_items - static_cast<uint32_t>(objects.size()));
+            uint64_t bytes_left = (max_bytes == 0) ? 0 : (max_bytes - page_bytes);
+            auto result = this->template scan<SubgroupType>(prefix,shard_cursor,items_left,bytes_left,version,stable,opm.subgroup_index,shard_index);
+            for (auto& reply_future: result.get()) {
+                auto page = reply_future.second.get();
+                for (auto& object: std::get<0>(page)) {
+                    page_bytes += mutils::bytes_size(object);
+                    objects.emplace_back(std::move(object));
+                }
+                shard_cursor = std::get<1>(page);
+                break;
+            }
+            if (shard_cursor != invalid_key) {
+                // the page is full in the middle of the shard.
+                return {std::move(objects),shard_cursor,version};
+            }
+            shard_index ++;
+            if ((max_items != 0 && objects.size() >= max_items) || (max_bytes != 0 && page_bytes >= max_bytes)) {
+                // the page is full at the end of the shard: the next page resumes after the last object, from the shard
+                // owning it, which then moves on to the following shards.
+                if (shard_index <= shard_range.second && shard_index < shards && !objects.empty()) {
+                    typename SubgroupType::KeyType next_cursor = objects.back().get_key_ref();
+                    return {std::move(objects),next_cursor,version};
+                }
+                break;
+            }
+        }
+        return {std::move(objects),invalid_key,version};
+    }
+}
+
 template <typename... CascadeTypes>
 void ServiceClient<CascadeTypes...>::refresh_object_pool_metadata_cache() {
-    std::unordered_map<std::string,ObjectPoolMetadataCacheEntry> refreshed_metadata;
-    uint32_t num_shards = this->template get_number_of_shards<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX);
-    for(uint32_t shard=0;shard<num_shards;shard++) {
-        auto results = this->template multi_list_keys<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX,shard);
-        for (auto& reply : results.get()) { // only once
-            for(auto& key: reply.second.get()) { // iterate over keys
-                // we only read the stable version.
-                auto opm_result = this->template get<CascadeMetadataService<CascadeTypes...>>(key,CURRENT_VERSION,false,METADATA_SERVICE_SUBGROUP_INDEX,shard);
-                for (auto& opm_reply:opm_result.get()) { // only once
-                    refreshed_metadata.emplace(key,opm_reply.second.get());
-                    break;
+    // a refresh in progress started before this call, so we need the one after it.
+    uint64_t seq = object_pool_metadata_refresh_seq.load(std::memory_order_acquire);
+    uint64_t target = (seq % 2 == 0) ? (seq + 2) : (seq + 3);
+    std::lock_guard<std::mutex> refresh_lck(object_pool_metadata_refresh_mutex);
+    if (object_pool_metadata_refresh_seq.load(std::memory_order_acquire) >= target) {
+        // coalesced with a refresh started after this call.
+        return;
+    }
+    object_pool_metadata_refresh_seq.fetch_add(1,std::memory_order_acq_rel);
+    std::unordered_map<std::string,std::shared_ptr<ObjectPoolMetadataCacheEntry>> refreshed_metadata;
+    try {
+        if (is_external_client()) {
+            // subscribe before reading, so that no delta applied after the read is lost.
+            subscribe_object_pool_metadata(true);
+        }
+        uint32_t num_shards = this->template get_number_of_shards<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX);
+        for(uint32_t shard=0;shard<num_shards;shard++) {
+            auto results = this->template multi_list_keys<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX,shard);
+            for (auto& reply : results.get()) { // only once
+                for(auto& key: reply.second.get()) { // iterate over keys
+                    // we only read the stable version.
+                    auto opm_result = this->template get<CascadeMetadataService<CascadeTypes...>>(key,CURRENT_VERSION,false,METADATA_SERVICE_SUBGROUP_INDEX,shard);
+                    for (auto& opm_reply:opm_result.get()) { // only once
+                        refreshed_metadata.emplace(key,std::make_shared<ObjectPoolMetadataCacheEntry>(opm_reply.second.get()));
+                        break;
+                    }
                 }
+                break;
             }
-            break;
         }
+    } catch (...) {
+        // revert the start, so that the callers coalesced with this refresh do their own instead of taking it as done.
+        object_pool_metadata_refresh_seq.fetch_sub(1,std::memory_order_acq_rel);
+        throw;
     }
 
     std::unique_lock<std::shared_mutex> wlck(object_pool_metadata_cache_mutex);
+    // keep the entries updated by the deltas pushed during the refresh.
+    for (auto& refreshed: refreshed_metadata) {
+        auto it = object_pool_metadata_cache.find(refreshed.first);
+        if (it != object_pool_metadata_cache.end() &&
+            it->second->opm.get_version() != persistent::INVALID_VERSION &&
+            it->second->opm.get_version() > refreshed.second->opm.get_version()) {
+            refreshed.second = it->second;
+        }
+    }
     this->object_pool_metadata_cache = std::move(refreshed_metadata);
+    publish_object_pool_router();
+    object_pool_metadata_refresh_seq.fetch_add(1,std::memory_order_acq_rel);
+}
+
+template <typename... CascadeTypes>
+void ServiceClient<CascadeTypes...>::subscribe_object_pool_metadata(bool renew_all) {
+    auto& caller = external_group_ptr->template get_subgroup_caller<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX);
+    std::call_once(object_pool_metadata_subscription_flag,[this,&caller](){
+        caller.register_notification_handler(
+                [this](const derecho::NotificationMessage& msg){
+                    if (msg.message_type != CASCADE_NOTIFICATION_MESSAGE_TYPE) {
+                        return;
+                    }
+                    mutils::deserialize_and_run(nullptr, msg.body,
+                            [this](const CascadeNotificationMessage& cascade_message)->void {
+                                auto opm = mutils::from_bytes<ObjectPoolMetadata<CascadeTypes...>>(nullptr,cascade_message.blob.bytes);
+                                dbg_default_trace("Received object pool metadata delta: {} version=0x{:x}",
+                                        opm->pathname, opm->get_version());
+                                std::unique_lock<std::shared_mutex> wlck(object_pool_metadata_cache_mutex);
+                                if (apply_object_pool_metadata(*opm)) {
+                                    publish_object_pool_router();
+                                }
+                            });
+                });
+    });
+    // subscribe after the handler is in place, so that no delta is lost. Every member of a shard pushes the same
+    // deltas; the duplicates are ignored by their versions.
+    ObjectPoolMetadata<CascadeTypes...> subscription(METADATA_SERVICE_SUBSCRIPTION_KEY,
+            ObjectPoolMetadata<CascadeTypes...>::invalid_subgroup_type_index,0,HASH,{},"",false);
+    uint32_t num_shards = this->template get_number_of_shards<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX);
+    std::lock_guard<std::mutex> lck(object_pool_metadata_subscriptions_mutex);
+    object_pool_metadata_subscriptions.resize(num_shards);
+    for (uint32_t shard = 0; shard < num_shards; shard++) {
+        auto members = this->template get_shard_members<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX,shard);
+        std::unordered_set<node_id_t> subscribed;
+        std::vector<std::pair<node_id_t,derecho::rpc::QueryResults<void>>> pending;
+        for (const auto member : members) {
+            if (!renew_all && object_pool_metadata_subscriptions[shard].count(member) != 0) {
+                subscribed.emplace(member);
+                continue;
+            }
+            try {
+                std::lock_guard<std::mutex> p2p_lck(this->p2p_send_mutex(member));
+                pending.emplace_back(member,caller.template p2p_send<RPC_NAME(trigger_put)>(member,subscription));
+            } catch (derecho::derecho_exception& ex) {
+                dbg_default_warn("Failed to subscribe to the object pool metadata deltas of node {}:{}", member, ex.what());
+            }
+        }
+        for (auto& member_results : pending) {
+            try {
+                for (auto& reply : member_results.second.get()) {
+                    reply.second.get();
+                }
+                subscribed.emplace(member_results.first);
+            } catch (derecho::derecho_exception& ex) {
+                dbg_default_warn("Failed to subscribe to the object pool metadata deltas of node {}:{}",
+                                 member_results.first, ex.what());
+            }
+        }
+        // the members gone with a view change are dropped.
+        object_pool_metadata_subscriptions[shard] = std::move(subscribed);
+    }
+}
+
+template <typename... CascadeTypes>
+void ServiceClient<CascadeTypes...>::fetch_object_pool_metadata(const std::string& pathname) {
+    std::promise<void> fetched;
+    {
+        std::unique_lock<std::mutex> fetches_lck(object_pool_metadata_fetches_mutex);
+        auto it = object_pool_metadata_fetches.find(pathname);
+        if (it != object_pool_metadata_fetches.end()) {
+            // coalesced with the fetch in flight.
+            auto in_flight = it->second;
+            fetches_lck.unlock();
+            in_flight.get();
+            return;
+        }
+        object_pool_metadata_fetches.emplace(pathname,fetched.get_future().share());
+    }
+
+    try {
+        if (is_external_client()) {
+            // subscribe to the members that joined since the last subscription, before reading.
+            subscribe_object_pool_metadata(false);
+        }
+        // look up every prefix at once; the metadata of an object pool lives in the shard its pathname hashes to.
+        uint32_t num_shards = this->template get_number_of_shards<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX);
+        std::vector<derecho::rpc::QueryResults<const ObjectPoolMetadata<CascadeTypes...>>> results;
+        std::string prefix;
+        for (const auto& comp: str_tokenizer(pathname)) {
+            prefix = prefix + PATH_SEPARATOR + comp;
+            results.emplace_back(this->template get<CascadeMetadataService<CascadeTypes...>>(
+                    prefix,CURRENT_VERSION,false,METADATA_SERVICE_SUBGROUP_INDEX,std::hash<std::string>{}(prefix) % num_shards));
+        }
+        std::vector<ObjectPoolMetadata<CascadeTypes...>> found;
+        for (auto& result: results) {
+            for (auto& reply: result.get()) { // only once
+                auto opm = reply.second.get();
+                if (opm.is_valid() && !opm.is_null()) {
+                    found.emplace_back(std::move(opm));
+                }
+                break;
+            }
+        }
+        if (!found.empty()) {
+            std::unique_lock<std::shared_mutex> wlck(object_pool_metadata_cache_mutex);
+            bool changed = false;
+            for (const auto& opm: found) {
+                changed = apply_object_pool_metadata(opm) || changed;
+            }
+            if (changed) {
+                publish_object_pool_router();
+            }
+        }
+        fetched.set_value();
+    } catch (...) {
+        fetched.set_exception(std::current_exception());
+    }
+
+    std::unique_lock<std::mutex> fetches_lck(object_pool_metadata_fetches_mutex);
+    auto in_flight = object_pool_metadata_fetches.at(pathname);
+    object_pool_metadata_fetches.erase(pathname);
+    fetches_lck.unlock();
+    in_flight.get();
+}
+
+template <typename... CascadeTypes>
+bool ServiceClient<CascadeTypes...>::apply_object_pool_metadata(const ObjectPoolMetadata<CascadeTypes...>& opm) {
+    auto it = object_pool_metadata_cache.find(opm.pathname);
+    if (it != object_pool_metadata_cache.end() &&
+        it->second->opm.get_version() != persistent::INVALID_VERSION &&
+        it->second->opm.get_version() >= opm.get_version()) {
+        // a stale or duplicated delta.
+        return false;
+    }
+    if (opm.is_null()) {
+        if (it == object_pool_metadata_cache.end()) {
+            return false;
+        }
+        object_pool_metadata_cache.erase(it);
+    } else {
+        object_pool_metadata_cache[opm.pathname] = std::make_shared<ObjectPoolMetadataCacheEntry>(opm);
+    }
+    return true;
+}
+
+template <typename... CascadeTypes>
+void ServiceClient<CascadeTypes...>::publish_object_pool_router() {
+    auto* router = new ObjectPoolRouter(object_pool_metadata_cache);
+    auto* old_router = object_pool_router.exchange(router,std::memory_order_acq_rel);
+    if (old_router != nullptr) {
+        retired_object_pool_routers.emplace_back(EpochDomain::get().retire_epoch(),old_router);
+        EpochDomain::get().advance();
+    }
+    // reclaim the routers no reader can see anymore.
+    uint64_t oldest = EpochDomain::get().oldest_active_epoch();
+    auto keep = retired_object_pool_routers.begin();
+    for (auto it = retired_object_pool_routers.begin(); it != retired_object_pool_routers.end(); it++) {
+        if (it->first < oldest) {
+            delete it->second;
+        } else {
+            *(keep++) = *it;
+        }
+    }
+    retired_object_pool_routers.erase(keep,retired_object_pool_routers.end());
 }
 
 template <typename... CascadeTypes>
@@ -1797,13 +3113,19 @@ template <typename SubgroupType>
 derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::create_object_pool(
         const std::string& pathname, const uint32_t subgroup_index,
         const sharding_policy_t sharding_policy, const std::unordered_map<std::string,uint32_t>& object_locations,
-        const std::string& affinity_set_regex) {
+        const std::string& affinity_set_regex, const std::vector<std::string>& range_split_points) {
     uint32_t subgroup_type_index = ObjectPoolMetadata<CascadeTypes...>::template get_subgroup_type_index<SubgroupType>();
     if (subgroup_type_index == ObjectPoolMetadata<CascadeTypes...>::invalid_subgroup_type_index) {
         dbg_default_crit("Create object pool failed because of invalid SubgroupType:{}", typeid(SubgroupType).name());
         throw derecho::derecho_exception(std::string("Create object pool failed because SubgroupType is invalid:")+typeid(SubgroupType).name());
     }
-    ObjectPoolMetadata<CascadeTypes...> opm(pathname,subgroup_type_index,subgroup_index,sharding_policy,object_locations,affinity_set_regex,false);
+    ObjectPoolMetadata<CascadeTypes...> opm(pathname,subgroup_type_index,subgroup_index,sharding_policy,object_locations,affinity_set_regex,false,range_split_points);
+    if (sharding_policy != RANGE && !range_split_points.empty()) {
+        throw derecho::derecho_exception("Create object pool failed because only the RANGE sharding policy takes range split points.");
+    }
+    if (sharding_policy == RANGE && !opm.check_range_split_points()) {
+        throw derecho::derecho_exception("Create object pool failed because the range split points are not strictly increasing.");
+    }
     // clear local cache entry.
     std::shared_lock<std::shared_mutex> rlck(object_pool_metadata_cache_mutex);
     if (object_pool_metadata_cache.find(pathname)==object_pool_metadata_cache.end()) {
@@ -1812,6 +3134,7 @@ derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::create
         rlck.unlock();
         std::unique_lock<std::shared_mutex> wlck(object_pool_metadata_cache_mutex);
         object_pool_metadata_cache.erase(pathname);
+        publish_object_pool_router();
     }
     // determine the shard index by hashing
     uint32_t metadata_service_shard_index = std::hash<std::string>{}(pathname) % this->template get_number_of_shards<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX);
@@ -1837,6 +3160,7 @@ derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::remove
         rlck.unlock();
         std::unique_lock<std::shared_mutex> wlck(object_pool_metadata_cache_mutex);
         object_pool_metadata_cache.erase(pathname);
+        publish_object_pool_router();
         wlck.unlock();
     }
     if (opm.is_valid() && !opm.is_null()) {
@@ -1862,19 +3186,25 @@ ObjectPoolMetadata<CascadeTypes...> ServiceClient<CascadeTypes...>::internal_fin
     for (const auto& comp: components) {
         prefix = prefix + PATH_SEPARATOR + comp;
         if (object_pool_metadata_cache.find(prefix) != object_pool_metadata_cache.end()) {
-            return object_pool_metadata_cache.at(prefix).opm;
+            return object_pool_metadata_cache.at(prefix)->opm;
         }
     }
+    bool bootstrapped = (object_pool_metadata_refresh_seq.load(std::memory_order_acquire) >= 2);
     rlck.unlock();
 
-    // refresh and try again.
-    refresh_object_pool_metadata_cache();
+    // load the missing object pool and try again.
+    if (bootstrapped) {
+        fetch_object_pool_metadata(pathname);
+    } else {
+        // the first miss loads the whole cache, after subscribing to the metadata deltas.
+        refresh_object_pool_metadata_cache();
+    }
     prefix = "";
     rlck.lock();
     for (const auto& comp: components) {
         prefix = prefix + PATH_SEPARATOR + comp;
         if (object_pool_metadata_cache.find(prefix) != object_pool_metadata_cache.end()) {
-            return object_pool_metadata_cache.at(prefix).opm;
+            return object_pool_metadata_cache.at(prefix)->opm;
         }
     }
     return ObjectPoolMetadata<CascadeTypes...>::IV;
@@ -1900,7 +3230,9 @@ std::pair<ObjectPoolMetadata<CascadeTypes...>,std::string> ServiceClient<Cascade
 
     std::string affinity_set = "";
     if (opm.is_valid() && !opm.is_null() && !opm.deleted) {
-        affinity_set = object_pool_metadata_cache.at(opm.pathname).to_affinity_set(key);
+        // the router is published and reclaimed under the exclusive lock, so it matches the cache we are holding.
+        affinity_set = std::string(object_pool_router.load(std::memory_order_acquire)->to_affinity_set_view(
+                object_pool_metadata_cache.at(opm.pathname).get(),key));
     }
 
     return {opm,affinity_set};
@@ -1915,7 +3247,7 @@ std::vector<std::string> ServiceClient<CascadeTypes...>::list_object_pools(bool
     std::vector<std::string> ret;
     std::shared_lock rlck(this->object_pool_metadata_cache_mutex);
     for (auto& op:this->object_pool_metadata_cache) {
-        if (op.second.opm.deleted) {
+        if (op.second->opm.deleted) {
             if (include_deleted) {
                 ret.emplace_back(op.first+"(!)");
             }
@@ -2043,6 +3375,7 @@ void ServiceClient<CascadeTypes...>::notify(
     derecho::NotificationMessage derecho_notification_message(CASCADE_NOTIFICATION_MESSAGE_TYPE, mutils::bytes_size(cascade_notification_message));
     mutils::to_bytes(cascade_notification_message,derecho_notification_message.body);
 
+    std::lock_guard<std::mutex> lck(this->p2p_send_mutex(client_id));
     client_handle.template p2p_send<RPC_NAME(notify)>(client_id,derecho_notification_message);
 }
 
@@ -2095,19 +3428,20 @@ template <typename SubgroupType>
 derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::dump_timestamp(const std::string& filename, const uint32_t subgroup_index, const uint32_t shard_index) {
 
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            std::lock_guard<std::mutex> lck(this->template ordered_send_mutex<SubgroupType>(subgroup_index));
             return subgroup_handle.template ordered_send<RPC_NAME(ordered_dump_timestamp_log)>(filename);
         } else {
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
             node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,filename);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
             return subgroup_handle.template p2p_send<RPC_NAME(dump_timestamp_log)>(node_id,filename);
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,filename);
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
         return caller.template p2p_send<RPC_NAME(dump_timestamp_log)>(node_id,filename);
     }
 }
@@ -2162,17 +3496,18 @@ template <typename... CascadeTypes>
 template <typename SubgroupType>
 derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::dump_timestamp_workaround(const std::string& filename, const uint32_t subgroup_index, const uint32_t shard_index, const node_id_t node_id) {
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
             return subgroup_handle.template p2p_send<RPC_NAME(dump_timestamp_log_workaround)>(node_id, filename);
         } else {
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
             return subgroup_handle.template p2p_send<RPC_NAME(dump_timestamp_log_workaround)>(node_id,filename);
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
         return caller.template p2p_send<RPC_NAME(dump_timestamp_log_workaround)>(node_id,filename);
     }
 }
@@ -2184,9 +3519,9 @@ derecho::rpc::QueryResults<double> ServiceClient<CascadeTypes...>::perf_put(cons
         // 'perf_put' must be issued from an external client.
         throw derecho::derecho_exception{"perf_put must be issued from an external client."};
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        std::lock_guard<std::mutex> lck(this->p2p_send_mutex(node_id));
         return caller.template p2p_send<RPC_NAME(perf_put)>(node_id,message_size,duration_sec);
     }
 }
@@ -2243,8 +3578,6 @@ ServiceClient<CascadeTypes...>& ServiceClient<CascadeTypes...>::get_service_clie
 
 template <typename... CascadeTypes>
 ExecutionEngine<CascadeTypes...>::ExecutionEngine() {
-    stateless_action_queue_for_multicast.initialize();
-    stateless_action_queue_for_p2p.initialize();
     prefix_registry_ptr = std::make_shared<PrefixRegistry<prefix_entry_t,PATH_SEPARATOR>>();
 }
 
@@ -2273,7 +3606,8 @@ void ExecutionEngine<CascadeTypes...>::construct() {
                         user_defined_logic_manager->get_observer(
                             vertex.second.uuids[i],
                             vertex.second.configurations[i]),
-                        vertex.second.edges[i]);
+                        vertex.second.edges[i],
+                        vertex.second.batching[i]);
                 } else {
 #ifdef ENABLE_MPROC
                     // runs inside a different address space: with a little overhead but more secure.
@@ -2291,7 +3625,8 @@ void ExecutionEngine<CascadeTypes...>::construct() {
                         user_defined_logic_manager->get_observer(
                             "fb6458a8-60cb-11ee-b058-0242ac110003",
                             vertex.second.configurations[i]),
-                        vertex.second.edges[i]);
+                        vertex.second.edges[i],
+                        vertex.second.batching[i]);
 #else
                     throw derecho_exception("MPROC is disabled, which is required by execution environment other than PTHREAD");
 #endif
@@ -2299,6 +3634,9 @@ void ExecutionEngine<CascadeTypes...>::construct() {
             }
         }
     }
+    if (derecho::hasCustomizedConfKey(CASCADE_CONTEXT_SHARE_STORED_VALUES)) {
+        share_stored_values = derecho::getConfBoolean(CASCADE_CONTEXT_SHARE_STORED_VALUES);
+    }
     // 2 - start the working threads
     is_running.store(true);
     uint32_t num_stateless_multicast_workers = 0;
@@ -2309,6 +3647,10 @@ void ExecutionEngine<CascadeTypes...>::construct() {
     } else {
         num_stateless_multicast_workers = derecho::getConfUInt32(CASCADE_CONTEXT_NUM_STATELESS_WORKERS_MULTICAST);
     }
+    if (num_stateless_multicast_workers > 0) {
+        stateless_scheduler_for_multicast = std::make_unique<WorkStealingScheduler<Action>>(
+                num_stateless_multicast_workers,ACTION_BUFFER_SIZE);
+    }
     for (uint32_t i=0;i<num_stateless_multicast_workers;i++) {
         // off_critical_data_path_thread_pool.emplace_back(std::thread(&ExecutionEngine<CascadeTypes...>::workhorse,this,i));
         stateless_workhorses_for_multicast.emplace_back(
@@ -2326,7 +3668,8 @@ void ExecutionEngine<CascadeTypes...>::construct() {
                     }
                 }
                 // call workhorse
-                this->workhorse(i,stateless_action_queue_for_multicast);
+                stealing_action_queue aq{*stateless_scheduler_for_multicast,i};
+                this->workhorse(i,aq);
             });
     }
     // 2.2 -initialize stateless p2p workers.
@@ -2335,6 +3678,10 @@ void ExecutionEngine<CascadeTypes...>::construct() {
     } else {
         num_stateless_p2p_workers = derecho::getConfUInt32(CASCADE_CONTEXT_NUM_STATELESS_WORKERS_P2P);
     }
+    if (num_stateless_p2p_workers > 0) {
+        stateless_scheduler_for_p2p = std::make_unique<WorkStealingScheduler<Action>>(
+                num_stateless_p2p_workers,ACTION_BUFFER_SIZE);
+    }
     for (uint32_t i=0;i<num_stateless_p2p_workers;i++) {
         // off_critical_data_path_thread_pool.emplace_back(std::thread(&ExecutionEngine<CascadeTypes...>::workhorse,this,i));
         stateless_workhorses_for_p2p.emplace_back(
@@ -2352,7 +3699,8 @@ void ExecutionEngine<CascadeTypes...>::construct() {
                     }
                 }
                 // call workhorse
-                this->workhorse(i,stateless_action_queue_for_p2p);
+                stealing_action_queue aq{*stateless_scheduler_for_p2p,i};
+                this->workhorse(i,aq);
             });
     }
     uint32_t num_stateful_multicast_workers = 0;
@@ -2435,83 +3783,179 @@ void ExecutionEngine<CascadeTypes...>::construct() {
 }
 
 template <typename... CascadeTypes>
-void ExecutionEngine<CascadeTypes...>::workhorse(uint32_t worker_id, struct action_queue& aq) {
+template <typename ActionSource>
+void ExecutionEngine<CascadeTypes...>::workhorse(uint32_t worker_id, ActionSource& aq) {
     pthread_setname_np(pthread_self(), ("cs_ctxt_t" + std::to_string(worker_id)).c_str());
     dbg_default_trace("Cascade context workhorse[{}] started", worker_id);
+    // the batches being collected, for the observers registered with batching.
+    std::vector<action_batch> batches;
     while(is_running) {
-        // waiting for an action
-        Action action = aq.action_buffer_dequeue(is_running);
+        // waiting for an action, but not beyond the earliest deadline of the batches being collected.
+        bool collecting = false;
+        auto deadline = std::chrono::steady_clock::time_point::max();
+        uint32_t max_drain = 0;
+        for (const auto& batch : batches) {
+            if (!batch.actions.empty()) {
+                collecting = true;
+                deadline = std::min(deadline,batch.deadline);
+                max_drain = std::max(max_drain,batch.max_batch_size);
+            }
+        }
+        Action action = collecting ? aq.action_buffer_dequeue_until(is_running,deadline) :
+                                     aq.action_buffer_dequeue(is_running);
         // if action_buffer_dequeue return with is_running == false, value_ptr is invalid(nullptr).
-        action.fire(this,worker_id);
+        // while collecting a batch, also take the actions already queued, up to the largest batch size.
+        uint32_t drained = 0;
+        while (action) {
+            max_drain = std::max(max_drain,action.batching.max_batch_size);
+            fire_or_batch(worker_id,std::move(action),batches);
+            if (++drained >= max_drain) {
+                break;
+            }
+            action = aq.action_buffer_try_dequeue();
+        }
+        fire_batches(worker_id,batches,true);
 
         if (!is_running) {
             do {
                 action = std::move(aq.action_buffer_dequeue(is_running));
                 if (!action) break; // end of queue
-                action.fire(this,worker_id);
+                fire_or_batch(worker_id,std::move(action),batches);
             } while(true);
         }
     }
+    fire_batches(worker_id,batches,false);
     dbg_default_trace("Cascade context workhorse[{}] finished normally.", static_cast<uint64_t>(gettid()));
 }
 
+template <typename... CascadeTypes>
+void ExecutionEngine<CascadeTypes...>::fire_or_batch(uint32_t worker_id, Action&& action,
+                                                     std::vector<action_batch>& batches) {
+    if (action.batching.max_batch_size <= 1 || !action.ocdpo_ptr || !action.value_ptr) {
+        action.fire(this,worker_id);
+        return;
+    }
+    auto it = std::find_if(batches.begin(),batches.end(),
+                           [&action](const action_batch& batch){return batch.ocdpo == action.ocdpo_ptr.get();});
+    if (it == batches.end()) {
+        it = batches.emplace(batches.end());
+        it->ocdpo = action.ocdpo_ptr.get();
+    }
+    if (it->actions.empty()) {
+        it->max_batch_size = action.batching.max_batch_size;
+        it->deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(action.batching.max_wait_us);
+    }
+    it->actions.emplace_back(std::move(action));
+    if (it->actions.size() >= it->max_batch_size) {
+        fire_batch(worker_id,*it);
+    }
+}
+
+template <typename... CascadeTypes>
+void ExecutionEngine<CascadeTypes...>::fire_batch(uint32_t worker_id, action_batch& batch) {
+    for (const auto& action : batch.actions) {
+        TimestampLogger::log(TLT_ACTION_FIRE_START,
+                             0,
+                             dynamic_cast<const IHasMessageID*>(action.value_ptr.get())->get_message_id(),
+                             0);
+    }
+    dbg_default_trace("In {}: [worker_id={}] a batch of {} actions is fired.", __PRETTY_FUNCTION__, worker_id, batch.actions.size());
+    batch.ocdpo->handle_batch(batch.actions.data(),batch.actions.size(),this,worker_id);
+    // clear() keeps the capacity for the next batch.
+    batch.actions.clear();
+}
+
+template <typename... CascadeTypes>
+void ExecutionEngine<CascadeTypes...>::fire_batches(uint32_t worker_id, std::vector<action_batch>& batches,
+                                                    bool expired_only) {
+    auto now = std::chrono::steady_clock::now();
+    for (auto& batch : batches) {
+        if (!batch.actions.empty() && (!expired_only || now >= batch.deadline)) {
+            fire_batch(worker_id,batch);
+        }
+    }
+}
+
 template <typename... CascadeTypes>
 void ExecutionEngine<CascadeTypes...>::action_queue::initialize() {
-    action_buffer_head.store(0);
-    action_buffer_tail.store(0);
+    action_buffer.reset();
 }
-#define ACTION_BUFFER_IS_FULL   ((action_buffer_head) == ((action_buffer_tail+1)%ACTION_BUFFER_SIZE))
-#define ACTION_BUFFER_IS_EMPTY  ((action_buffer_head) == (action_buffer_tail))
-#define ACTION_BUFFER_DEQUEUE   ((action_buffer_head) = (action_buffer_head+1)%ACTION_BUFFER_SIZE)
-#define ACTION_BUFFER_ENQUEUE   ((action_buffer_tail) = (action_buffer_tail+1)%ACTION_BUFFER_SIZE)
-#define ACTION_BUFFER_HEAD      (action_buffer[action_buffer_head])
-#define ACTION_BUFFER_NEXT_TAIL (action_buffer[(action_buffer_tail)%ACTION_BUFFER_SIZE])
 
 /* There is only one thread that enqueues. */
 template <typename... CascadeTypes>
 void ExecutionEngine<CascadeTypes...>::action_queue::action_buffer_enqueue(Action&& action) {
-    std::unique_lock<std::mutex> lck(action_buffer_slot_mutex);
-    while (ACTION_BUFFER_IS_FULL) {
-        dbg_default_warn("In {}: Critical data path waits for 10 ms. The action buffer is full! You are sending too fast or the UDL workers are too slow. This can cause a soft deadlock.", __PRETTY_FUNCTION__);
-        action_buffer_slot_cv.wait_for(lck,10ms,[this]{return !ACTION_BUFFER_IS_EMPTY;});
+    if (!action_buffer.try_enqueue(std::move(action))) {
+        dbg_default_warn("In {}: Critical data path waits. The action buffer is full! You are sending too fast or the UDL workers are too slow. This can cause a soft deadlock.", __PRETTY_FUNCTION__);
+        action_buffer.enqueue(std::move(action));
     }
-
-    ACTION_BUFFER_NEXT_TAIL = std::move(action);
-    ACTION_BUFFER_ENQUEUE;
-    action_buffer_data_cv.notify_one();
 }
 
 /* All worker threads dequeues. */
 template <typename... CascadeTypes>
 Action ExecutionEngine<CascadeTypes...>::action_queue::action_buffer_dequeue(std::atomic<bool>& is_running) {
-    std::unique_lock<std::mutex> lck(action_buffer_data_mutex);
-    while (ACTION_BUFFER_IS_EMPTY && is_running) {
-        action_buffer_data_cv.wait_for(lck,10ms,[this,&is_running]{return (!ACTION_BUFFER_IS_EMPTY) || (!is_running);});
-    }
+    Action ret;
+    // if the queue is empty and is_running is false, ret stays empty.
+    action_buffer.dequeue(ret,is_running);
+    return ret;
+}
 
+template <typename... CascadeTypes>
+Action ExecutionEngine<CascadeTypes...>::action_queue::action_buffer_dequeue_until(
+        std::atomic<bool>& is_running, const std::chrono::steady_clock::time_point& deadline) {
     Action ret;
-    if (!ACTION_BUFFER_IS_EMPTY) {
-        ret = std::move(ACTION_BUFFER_HEAD);
-        ACTION_BUFFER_DEQUEUE;
-        action_buffer_slot_cv.notify_one();
-    }
+    // ret stays empty if nothing comes before the deadline.
+    action_buffer.dequeue_until(ret,is_running,deadline);
+    return ret;
+}
 
+template <typename... CascadeTypes>
+Action ExecutionEngine<CascadeTypes...>::action_queue::action_buffer_try_dequeue() {
+    Action ret;
+    action_buffer.try_dequeue(ret);
     return ret;
 }
 
 /* shutdown the action buffer */
 template <typename... CascadeTypes>
 void ExecutionEngine<CascadeTypes...>::action_queue::notify_all() {
-    action_buffer_data_cv.notify_all();
-    action_buffer_slot_cv.notify_all();
+    action_buffer.notify_all();
+}
+
+/* A stateless worker takes the actions in its own queue first, and steals from the others when it is empty. */
+template <typename... CascadeTypes>
+Action ExecutionEngine<CascadeTypes...>::stealing_action_queue::action_buffer_dequeue(std::atomic<bool>& is_running) {
+    Action ret;
+    // if all the queues are empty and is_running is false, ret stays empty.
+    scheduler.dequeue(worker_id,ret,is_running);
+    return ret;
+}
+
+template <typename... CascadeTypes>
+Action ExecutionEngine<CascadeTypes...>::stealing_action_queue::action_buffer_dequeue_until(
+        std::atomic<bool>& is_running, const std::chrono::steady_clock::time_point& deadline) {
+    Action ret;
+    // ret stays empty if nothing comes before the deadline.
+    scheduler.dequeue_until(worker_id,ret,is_running,deadline);
+    return ret;
+}
+
+template <typename... CascadeTypes>
+Action ExecutionEngine<CascadeTypes...>::stealing_action_queue::action_buffer_try_dequeue() {
+    Action ret;
+    scheduler.try_dequeue(worker_id,ret);
+    return ret;
 }
 
 template <typename... CascadeTypes>
 void ExecutionEngine<CascadeTypes...>::destroy() {
     dbg_default_trace("Destroying Cascade context@{:p}.",static_cast<void*>(this));
     is_running.store(false);
-    stateless_action_queue_for_multicast.notify_all();
-    stateless_action_queue_for_p2p.notify_all();
+    if (stateless_scheduler_for_multicast) {
+        stateless_scheduler_for_multicast->notify_all();
+    }
+    if (stateless_scheduler_for_p2p) {
+        stateless_scheduler_for_p2p->notify_all();
+    }
     for (auto& th:stateless_workhorses_for_multicast) {
         if (th.joinable()) {
             th.join();
@@ -2568,12 +4012,13 @@ void ExecutionEngine<CascadeTypes...>::register_prefixes(
         const std::string&                                  user_defined_logic_id,
         const std::string&                                  user_defined_logic_config,
         const std::shared_ptr<OffCriticalDataPathObserver>& ocdpo_ptr,
-        const std::unordered_map<std::string,bool>&         outputs) {
+        const std::unordered_map<std::string,bool>&         outputs,
+        const DataFlowGraph::VertexBatching&                batching) {
     for (const auto& prefix:prefixes) {
         prefix_registry_ptr->atomically_modify(prefix,
             [&dfg_uuid,&prefix,&execution_environment,&shard_dispatcher,&stateful,
              &hook,&user_defined_logic_id,&user_defined_logic_config,
-             &ocdpo_ptr,&outputs] (const std::shared_ptr<prefix_entry_t>& entry){
+             &ocdpo_ptr,&outputs,&batching] (const std::shared_ptr<prefix_entry_t>& entry){
                 std::shared_ptr<prefix_entry_t> new_entry;
                 if (entry) {
                     new_entry = std::make_shared<prefix_entry_t>(*entry);
@@ -2594,7 +4039,8 @@ void ExecutionEngine<CascadeTypes...>::register_prefixes(
                     .statefulness = stateful,
                     .hook = hook,
                     .ocdpo = ocdpo_ptr,
-                    .output_map = outputs};
+                    .output_map = std::make_shared<const std::unordered_map<std::string,bool>>(outputs),
+                    .batching = batching};
 
                 // insert it to new_entry
                 (*new_entry)[dfg_uuid].erase(ocdpo_info);
@@ -2603,17 +4049,22 @@ void ExecutionEngine<CascadeTypes...>::register_prefixes(
                 return new_entry;
             },true);
     }
+    dispatch_plans.rebuild(*prefix_registry_ptr);
 }
 
 template <typename... CascadeTypes>
 void ExecutionEngine<CascadeTypes...>::unregister_prefixes(const std::string& dfg_uuid) {
     prefix_registry_ptr->atomically_traverse(
             [&dfg_uuid](const std::shared_ptr<prefix_entry_t>& entry) {
-                if (entry->find(dfg_uuid) != entry->cend()) {
-                    entry->erase(dfg_uuid);
+                // the entry can be in use by a dispatch plan, so it is replaced instead of modified.
+                if (entry && entry->find(dfg_uuid) != entry->cend()) {
+                    auto new_entry = std::make_shared<prefix_entry_t>(*entry);
+                    new_entry->erase(dfg_uuid);
+                    return new_entry;
                 }
                 return entry;
             });
+    dispatch_plans.rebuild(*prefix_registry_ptr);
 }
 
 /* Note: On the same hardware, copying a shared_ptr spends ~7.4ns, and copying a raw pointer spends ~1.8 ns*/
@@ -2634,10 +4085,130 @@ match_results_t ExecutionEngine<CascadeTypes...>::get_prefix_handlers(const std:
     return handlers;
 }
 
+template <typename... CascadeTypes>
+std::shared_ptr<const prefix_dispatch_plan_t> ExecutionEngine<CascadeTypes...>::get_dispatch_plan(const std::string& key) {
+    return dispatch_plans.get(*prefix_registry_ptr,key);
+}
+
+template <typename... CascadeTypes>
+bool ExecutionEngine<CascadeTypes...>::is_sharing_stored_values() const {
+    return share_stored_values;
+}
+
+inline std::shared_ptr<const prefix_dispatch_plan_t> prefix_dispatch_plan_t::build(
+        const PrefixRegistry<prefix_entry_t,PATH_SEPARATOR>& registry, const std::string& path) {
+    auto plan = std::make_shared<prefix_dispatch_plan_t>();
+    plan->path = path;
+    registry.collect_values_for_prefixes(
+            path,
+            [&plan](const std::string& prefix, const std::shared_ptr<prefix_entry_t>& entry) {
+                if (!entry) {
+                    return;
+                }
+                plan->entries.emplace_back(entry);
+                for (const auto& dfg_ocdpos : *entry) {
+                    for (const auto& oi : dfg_ocdpos.second) {
+                        prefix_dispatch_target_t target{static_cast<uint32_t>(prefix.size()),&oi};
+                        if (oi.hook != DataFlowGraph::VertexHook::ORDERED_PUT) {
+                            plan->trigger_put_targets.emplace_back(target);
+                            if (oi.execution_environment != DataFlowGraph::VertexExecutionEnvironment::PTHREAD) {
+                                plan->has_mproc_udl_for_trigger_put = true;
+                            }
+                        }
+                        if (oi.hook != DataFlowGraph::VertexHook::TRIGGER_PUT) {
+                            switch (oi.shard_dispatcher) {
+                            case DataFlowGraph::VertexShardDispatcher::ONE:
+                                plan->ordered_put_targets_for_one.emplace_back(target);
+                                break;
+                            case DataFlowGraph::VertexShardDispatcher::ALL:
+                                plan->ordered_put_targets_for_all.emplace_back(target);
+                                break;
+                            default:
+                                // unknown dispatcher.
+                                break;
+                            }
+                        }
+                    }
+                }
+            });
+    return plan;
+}
+
+inline PrefixDispatchPlans::PrefixDispatchPlans():
+    table(new plan_table_t()),
+    empty_plan(std::make_shared<const prefix_dispatch_plan_t>()) {}
+
+inline PrefixDispatchPlans::~PrefixDispatchPlans() {
+    delete table.load();
+    for (auto& retired: retired_tables) {
+        delete retired.second;
+    }
+}
+
+inline std::shared_ptr<const prefix_dispatch_plan_t> PrefixDispatchPlans::get(
+        const PrefixRegistry<prefix_entry_t,PATH_SEPARATOR>& registry, const std::string& key) const {
+    std::string_view path(key);
+    auto pos = path.rfind(PATH_SEPARATOR);
+    if (pos == std::string_view::npos) {
+        return empty_plan;
+    }
+    // important: we need to keep the trailing PATH_SEPARATOR
+    path = path.substr(0,pos + 1);
+    // the registry skips empty components, but the table only has the prefixes without them.
+    if (path.front() != PATH_SEPARATOR) {
+        return prefix_dispatch_plan_t::build(registry,std::string(path));
+    }
+    for (std::size_t i = 1; i < path.size(); i++) {
+        if (path[i] == PATH_SEPARATOR && path[i - 1] == PATH_SEPARATOR) {
+            return prefix_dispatch_plan_t::build(registry,std::string(path));
+        }
+    }
+
+    EpochGuard epoch_guard;
+    const plan_table_t* plans = table.load(std::memory_order_acquire);
+    while (path.size() > 1) {
+        auto it = plans->find(path);
+        if (it != plans->end()) {
+            return it->second;
+        }
+        // drop the last component.
+        path = path.substr(0,path.rfind(PATH_SEPARATOR,path.size() - 2) + 1);
+    }
+    return empty_plan;
+}
+
+inline void PrefixDispatchPlans::rebuild(const PrefixRegistry<prefix_entry_t,PATH_SEPARATOR>& registry) {
+    std::lock_guard<std::mutex> lck(rebuild_mutex);
+    std::vector<std::string> prefixes;
+    registry.collect_values(
+            [&prefixes](const std::string& prefix, const std::shared_ptr<prefix_entry_t>& entry) {
+                if (entry) {
+                    prefixes.emplace_back(prefix);
+                }
+            });
+    auto* new_table = new plan_table_t();
+    for (const auto& prefix : prefixes) {
+        auto plan = prefix_dispatch_plan_t::build(registry,prefix);
+        new_table->emplace(std::string_view(plan->path),plan);
+    }
+    const auto* old_table = table.exchange(new_table,std::memory_order_acq_rel);
+    retired_tables.emplace_back(EpochDomain::get().retire_epoch(),old_table);
+    EpochDomain::get().advance();
+    // reclaim the tables no reader can see anymore.
+    uint64_t oldest = EpochDomain::get().oldest_active_epoch();
+    auto keep = retired_tables.begin();
+    for (auto it = retired_tables.begin(); it != retired_tables.end(); it++) {
+        if (it->first < oldest) {
+            delete it->second;
+        } else {
+            *(keep++) = *it;
+        }
+    }
+    retired_tables.erase(keep,retired_tables.end());
+}
+
 template <typename... CascadeTypes>
 bool ExecutionEngine<CascadeTypes...>::post(Action&& action, DataFlowGraph::Statefulness stateful, bool is_trigger) {
-    static uint32_t trigger_rrcnt = 0;
-    static uint32_t multicast_rrcnt = 0;
     dbg_default_trace("Posting an action to Cascade context@{:p}.", static_cast<void*>(this));
     if (is_running) {
         if (is_trigger) {
@@ -2650,8 +4221,12 @@ bool ExecutionEngine<CascadeTypes...>::post(Action&& action, DataFlowGraph::Stat
                 break;
             case DataFlowGraph::Statefulness::STATELESS:
             case DataFlowGraph::Statefulness::UNKNOWN_S: // default
-                // stateless_action_queue_for_p2p.action_buffer_enqueue(std::move(action));
-                stateful_action_queues_for_p2p[trigger_rrcnt++ % stateful_action_queues_for_p2p.size()]->action_buffer_enqueue(std::move(action));
+                if (stateless_scheduler_for_p2p) {
+                    stateless_scheduler_for_p2p->enqueue(std::move(action));
+                } else {
+                    uint32_t thread_index = stateless_rrcnt_for_p2p.fetch_add(1,std::memory_order_relaxed) % stateful_action_queues_for_p2p.size();
+                    stateful_action_queues_for_p2p[thread_index]->action_buffer_enqueue(std::move(action));
+                }
                 break;
             case DataFlowGraph::Statefulness::SINGLETHREADED:
                 single_threaded_action_queue_for_p2p.action_buffer_enqueue(std::move(action));
@@ -2667,8 +4242,12 @@ bool ExecutionEngine<CascadeTypes...>::post(Action&& action, DataFlowGraph::Stat
                 break;
             case DataFlowGraph::Statefulness::STATELESS:
             case DataFlowGraph::Statefulness::UNKNOWN_S: // default
-                // stateless_action_queue_for_multicast.action_buffer_enqueue(std::move(action));
-                stateful_action_queues_for_multicast[multicast_rrcnt++ % stateful_action_queues_for_multicast.size()]->action_buffer_enqueue(std::move(action));
+                if (stateless_scheduler_for_multicast) {
+                    stateless_scheduler_for_multicast->enqueue(std::move(action));
+                } else {
+                    uint32_t thread_index = stateless_rrcnt_for_multicast.fetch_add(1,std::memory_order_relaxed) % stateful_action_queues_for_multicast.size();
+                    stateful_action_queues_for_multicast[thread_index]->action_buffer_enqueue(std::move(action));
+                }
                 break;
             case DataFlowGraph::Statefulness::SINGLETHREADED:
                 single_threaded_action_queue_for_multicast.action_buffer_enqueue(std::move(action));
@@ -2685,12 +4264,12 @@ bool ExecutionEngine<CascadeTypes...>::post(Action&& action, DataFlowGraph::Stat
 
 template <typename... CascadeTypes>
 size_t ExecutionEngine<CascadeTypes...>::stateless_action_queue_length_p2p() {
-    return (stateless_action_queue_for_p2p.action_buffer_tail - stateless_action_queue_for_multicast.action_buffer_head + ACTION_BUFFER_SIZE)%ACTION_BUFFER_SIZE;
+    return stateless_scheduler_for_p2p ? stateless_scheduler_for_p2p->size() : 0;
 }
 
 template <typename... CascadeTypes>
 size_t ExecutionEngine<CascadeTypes...>::stateless_action_queue_length_multicast() {
-    return (stateless_action_queue_for_multicast.action_buffer_tail - stateless_action_queue_for_multicast.action_buffer_head + ACTION_BUFFER_SIZE)%ACTION_BUFFER_SIZE;
+    return stateless_scheduler_for_multicast ? stateless_scheduler_for_multicast->size() : 0;
 }
 
 template <typename... CascadeTypes>
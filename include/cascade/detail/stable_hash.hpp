@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * Stable hash functions for object placement.
+ *
+ * Unlike std::hash, whose values depend on the standard library implementation, these functions are fully specified,
+ * so a key is placed on the same shard by any client, in any language, on any platform.
+ */
+
+namespace xxhash64_detail {
+constexpr uint64_t prime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t prime3 = 0x165667B19E3779F9ull;
+constexpr uint64_t prime4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t prime5 = 0x27D4EB2F165667C5ull;
+
+inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+/** Read little-endian integers regardless of the host byte order. */
+inline uint64_t read64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+inline uint32_t read32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * prime2;
+    acc = rotl(acc, 31);
+    return acc * prime1;
+}
+
+inline uint64_t merge_round(uint64_t acc, uint64_t val) {
+    acc ^= round(0, val);
+    return acc * prime1 + prime4;
+}
+}  // namespace xxhash64_detail
+
+/**
+ * @brief The 64-bit xxHash (XXH64) of a byte string, as specified at https://github.com/Cyan4973/xxHash.
+ *
+ * @param[in]   data    The bytes to hash.
+ * @param[in]   len     The number of bytes.
+ * @param[in]   seed    The seed.
+ *
+ * @return The hash value.
+ */
+inline uint64_t xxhash64(const void* data, std::size_t len, uint64_t seed = 0) {
+    using namespace xxhash64_detail;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* const end = p + len;
+    uint64_t h64;
+
+    if (len >= 32) {
+        const uint8_t* const limit = end - 32;
+        uint64_t v1 = seed + prime1 + prime2;
+        uint64_t v2 = seed + prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - prime1;
+        do {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h64 = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h64 = merge_round(h64, v1);
+        h64 = merge_round(h64, v2);
+        h64 = merge_round(h64, v3);
+        h64 = merge_round(h64, v4);
+    } else {
+        h64 = seed + prime5;
+    }
+
+    h64 += static_cast<uint64_t>(len);
+
+    while (p + 8 <= end) {
+        h64 ^= round(0, read64(p));
+        h64 = rotl(h64, 27) * prime1 + prime4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h64 ^= static_cast<uint64_t>(read32(p)) * prime1;
+        h64 = rotl(h64, 23) * prime2 + prime3;
+        p += 4;
+    }
+    while (p < end) {
+        h64 ^= static_cast<uint64_t>(*p) * prime5;
+        h64 = rotl(h64, 11) * prime1;
+        p++;
+    }
+
+    h64 ^= h64 >> 33;
+    h64 *= prime2;
+    h64 ^= h64 >> 29;
+    h64 *= prime3;
+    h64 ^= h64 >> 32;
+    return h64;
+}
+
+/**
+ * @brief The 64-bit xxHash (XXH64) of a string with seed 0.
+ */
+inline uint64_t xxhash64(const std::string_view& str) {
+    return xxhash64(str.data(), str.size(), 0);
+}
+
+/**
+ * @brief Jump consistent hash, from "A Fast, Minimal Memory, Consistent Hash Algorithm" by Lamping and Veach.
+ * When the number of buckets grows from n to n+1, only about 1/(n+1) of the keys move, all to the new bucket.
+ *
+ * @param[in]   key         The 64-bit hash of the key.
+ * @param[in]   num_buckets The number of buckets, which must be positive.
+ *
+ * @return The bucket in [0, num_buckets).
+ */
+inline uint32_t jump_consistent_hash(uint64_t key, uint32_t num_buckets) {
+    int64_t b = -1;
+    int64_t j = 0;
+    while (j < static_cast<int64_t>(num_buckets)) {
+        b = j;
+        key = key * 2862933555777941757ull + 1;
+        j = static_cast<int64_t>(static_cast<double>(b + 1) *
+                                 (static_cast<double>(1ll << 31) / static_cast<double>((key >> 33) + 1)));
+    }
+    return static_cast<uint32_t>(b);
+}
+
+}  // namespace cascade
+}  // namespace derecho
@@ -0,0 +1,105 @@
+#pragma once
+#include "cascade/config.h"
+#include "cascade/cascade_interface.hpp"
+#include "concurrent_ordered_map.hpp"
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * list_keys_by_prefix(): list the keys in a kv_map whose pathname starts with a prefix, i.e. the keys for which
+ * get_pathname(key).find(prefix) == 0 holds.
+ * kv_map is ordered by key, and every such key starts with the prefix. Therefore, only the range of keys starting with
+ * the prefix is visited instead of the whole map, and no pathname string is allocated for the visited keys. The
+ * visit is lockless, so it is safe to call from threads other than the predicate thread.
+ *
+ * @tparam KT     - Type of the Key
+ * @tparam VT     - Type of the Value
+ * @param  kv_map - the kv_map
+ * @param  prefix - the prefix
+ *
+ * @return the matching keys in key order.
+ */
+template <typename KT, typename VT>
+inline std::vector<KT> list_keys_by_prefix(const ConcurrentOrderedMap<KT, VT>& kv_map, const std::string& prefix);
+
+/**
+ * scan_by_prefix(): get a page of the objects in a kv_map whose keys match a prefix as in list_keys_by_prefix(),
+ * in key order, starting after a cursor. Null objects are skipped. The visit is lockless.
+ *
+ * @tparam KT          - Type of the Key
+ * @tparam VT          - Type of the Value
+ * @tparam ResolveFunc - bool(const VT& value, VT& resolved): replace a visited value by 'resolved' if it returns true,
+ *                       for example, by the value of the key at an older version.
+ * @param  kv_map      - the kv_map
+ * @param  prefix      - the prefix
+ * @param  cursor      - the last key of the previous page, or invalid_key for the first page
+ * @param  invalid_key - the invalid key
+ * @param  max_items   - the maximum number of objects in the page, or 0 for no limit
+ * @param  max_bytes   - the maximum serialized size of the page, or 0 for no limit
+ * @param  resolve     - the resolver of the visited values
+ *
+ * @return the page, with the cursor to the next page, or invalid_key if there are no more objects.
+ */
+template <typename KT, typename VT, typename ResolveFunc>
+inline scan_page_tuple<KT, VT> scan_by_prefix(const ConcurrentOrderedMap<KT, VT>& kv_map, const std::string& prefix,
+                                              const KT& cursor, const KT& invalid_key, uint32_t max_items, uint64_t max_bytes,
+                                              ResolveFunc&& resolve);
+template <typename KT, typename VT>
+inline scan_page_tuple<KT, VT> scan_by_prefix(const ConcurrentOrderedMap<KT, VT>& kv_map, const std::string& prefix,
+                                              const KT& cursor, const KT& invalid_key, uint32_t max_items, uint64_t max_bytes);
+
+/**
+ * lockless_get_view(): get the value of a key from a kv_map locklessly, without copying the object data if possible.
+ * If VT implements ISharedView, the returned value is a view sharing the stored object, whose data is copied only when
+ * the view is serialized. Otherwise, the stored object is copied once.
+ *
+ * @tparam KT            - Type of the Key
+ * @tparam VT            - Type of the Value
+ * @param  kv_map        - the kv_map
+ * @param  key           - the key
+ * @param  invalid_value - the value returned if the key is not in kv_map
+ *
+ * @return the value of the key.
+ */
+template <typename KT, typename VT>
+inline VT lockless_get_view(const ConcurrentOrderedMap<KT, VT>& kv_map, const KT& key, const VT& invalid_value);
+
+/**
+ * lockless_multi_key_get(): get the values of a list of keys in one lockless pass over a kv_map.
+ * All lookups run inside one epoch-protected critical section, so that the whole batch pays for entering it once. Like
+ * ConcurrentOrderedMap::for_each, the result is not an atomic snapshot: each value is the one the key had when it was
+ * looked up.
+ *
+ * @tparam KT            - Type of the Key
+ * @tparam VT            - Type of the Value
+ * @param  kv_map        - the kv_map
+ * @param  keys          - the keys
+ * @param  invalid_value - the value returned for the keys not in kv_map
+ *
+ * @return the values, in the order of the keys.
+ */
+template <typename KT, typename VT>
+inline std::vector<VT> lockless_multi_key_get(const ConcurrentOrderedMap<KT, VT>& kv_map, const std::vector<KT>& keys, const VT& invalid_value);
+
+/**
+ * last_puts_by_key(): find the values of a batch that are the last put to their key.
+ * Only those values are still in kv_map after the batch is applied, and hence can be shared with the watcher.
+ *
+ * @tparam KT            - Type of the Key
+ * @tparam VT            - Type of the Value
+ * @param  values        - the batch
+ *
+ * @return a flag for each value in the batch, true if no later value in the batch has the same key.
+ */
+template <typename KT, typename VT>
+inline std::vector<bool> last_puts_by_key(const std::vector<VT>& values);
+
+}  // namespace cascade
+}  // namespace derecho
+
+#include "store_util_impl.hpp"
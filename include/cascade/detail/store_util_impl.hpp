@@ -0,0 +1,126 @@
+#pragma once
+#include <unordered_set>
+
+namespace derecho {
+namespace cascade {
+
+template <typename KT, typename VT>
+std::vector<KT> list_keys_by_prefix(const ConcurrentOrderedMap<KT, VT>& kv_map, const std::string& prefix) {
+    std::vector<KT> key_list;
+    if constexpr(std::is_convertible<KT, std::string>::value) {
+        kv_map.for_each_from(KT(prefix), [&key_list, &prefix](const KT& key, const VT&) {
+            const std::string& key_str = key;
+            if(key_str.compare(0, prefix.size(), prefix) != 0) {
+                // out of the range of the keys starting with prefix.
+                return false;
+            }
+            // the pathname is the part before the last separator, it has to cover the whole prefix.
+            size_t pos = key_str.rfind(PATH_SEPARATOR);
+            if(prefix.empty() || (pos != std::string::npos && pos >= prefix.size())) {
+                key_list.push_back(key);
+            }
+            return true;
+        });
+    } else if(prefix.empty()) {
+        // get_pathname() returns an empty pathname for other key types, which only matches an empty prefix.
+        kv_map.for_each([&key_list](const KT& key, const VT&) {
+            key_list.push_back(key);
+        });
+    }
+    return key_list;
+}
+
+template <typename KT, typename VT, typename ResolveFunc>
+scan_page_tuple<KT, VT> scan_by_prefix(const ConcurrentOrderedMap<KT, VT>& kv_map, const std::string& prefix,
+                                       const KT& cursor, const KT& invalid_key, uint32_t max_items, uint64_t max_bytes,
+                                       ResolveFunc&& resolve) {
+    std::vector<VT> values;
+    KT next_cursor = invalid_key;
+    uint64_t page_bytes = 0;
+    const bool resuming = (cursor != invalid_key);
+    // add a value to the page, or stop the scan at it if the page is full.
+    auto add_to_page = [&](const KT& key, const VT& stored_value) {
+        if(resuming && key == cursor) {
+            return true;
+        }
+        VT resolved_value;
+        const VT& value = resolve(stored_value, resolved_value) ? resolved_value : stored_value;
+        if(value.is_null()) {
+            return true;
+        }
+        uint64_t value_bytes = mutils::bytes_size(value);
+        if((max_items != 0 && values.size() >= max_items) ||
+           (max_bytes != 0 && !values.empty() && page_bytes + value_bytes > max_bytes)) {
+            // the cursor is the last key in the page, so that the scan resumes right after it.
+            next_cursor = values.back().get_key_ref();
+            return false;
+        }
+        values.emplace_back(value);
+        page_bytes += value_bytes;
+        return true;
+    };
+    if constexpr(std::is_convertible<KT, std::string>::value) {
+        const std::string& cursor_str = cursor;
+        KT start = (resuming && cursor_str > prefix) ? cursor : KT(prefix);
+        kv_map.for_each_from(start, [&add_to_page, &prefix](const KT& key, const VT& value) {
+            const std::string& key_str = key;
+            if(key_str.compare(0, prefix.size(), prefix) != 0) {
+                // out of the range of the keys starting with prefix.
+                return false;
+            }
+            // the same matching rule as list_keys_by_prefix().
+            size_t pos = key_str.rfind(PATH_SEPARATOR);
+            if(prefix.empty() || (pos != std::string::npos && pos >= prefix.size())) {
+                return add_to_page(key, value);
+            }
+            return true;
+        });
+    } else if(prefix.empty()) {
+        kv_map.for_each_from(resuming ? cursor : KT{}, add_to_page);
+    }
+    return {std::move(values), next_cursor, CURRENT_VERSION};
+}
+
+template <typename KT, typename VT>
+scan_page_tuple<KT, VT> scan_by_prefix(const ConcurrentOrderedMap<KT, VT>& kv_map, const std::string& prefix,
+                                       const KT& cursor, const KT& invalid_key, uint32_t max_items, uint64_t max_bytes) {
+    return scan_by_prefix(kv_map, prefix, cursor, invalid_key, max_items, max_bytes,
+                          [](const VT&, VT&) { return false; });
+}
+
+template <typename KT, typename VT>
+VT lockless_get_view(const ConcurrentOrderedMap<KT, VT>& kv_map, const KT& key, const VT& invalid_value) {
+    auto shared = kv_map.read_shared(key);
+    if(!shared) {
+        return invalid_value;
+    }
+    if constexpr(std::is_base_of<ISharedView<VT>, VT>::value) {
+        return shared->create_shared_view(shared);
+    } else {
+        return *shared;
+    }
+}
+
+template <typename KT, typename VT>
+std::vector<VT> lockless_multi_key_get(const ConcurrentOrderedMap<KT, VT>& kv_map, const std::vector<KT>& keys, const VT& invalid_value) {
+    std::vector<VT> values;
+    values.reserve(keys.size());
+    EpochGuard guard;
+    for(const auto& key : keys) {
+        values.emplace_back(lockless_get_view(kv_map, key, invalid_value));
+    }
+    return values;
+}
+
+template <typename KT, typename VT>
+std::vector<bool> last_puts_by_key(const std::vector<VT>& values) {
+    std::vector<bool> last_puts(values.size(), false);
+    std::unordered_set<KT> later_keys;
+    for(std::size_t i = values.size(); i-- > 0;) {
+        last_puts[i] = later_keys.insert(values[i].get_key_ref()).second;
+    }
+    return last_puts;
+}
+
+}  // namespace cascade
+}  // namespace derecho
@@ -28,6 +28,17 @@ void TriggerCascadeNoStore<KT, VT, IK, IV>::put_and_forget(const VT& value, bool
     dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple TriggerCascadeNoStore<KT, VT, IK, IV>::put_batch(const std::vector<VT>& values, bool as_trigger) const {
+    dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
+    return {persistent::INVALID_VERSION, 0};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void TriggerCascadeNoStore<KT, VT, IK, IV>::put_batch_and_forget(const std::vector<VT>& values, bool as_trigger) const {
+    dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
+}
+
 #ifdef ENABLE_EVALUATION
 template <typename KT, typename VT, KT* IK, VT* IV>
 double TriggerCascadeNoStore<KT, VT, IK, IV>::perf_put(const uint32_t max_payload_size, const uint64_t duration_sec) const {
@@ -48,6 +59,13 @@ const VT TriggerCascadeNoStore<KT, VT, IK, IV>::get(const KT& key, const persist
     return *IV;
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<VT> TriggerCascadeNoStore<KT, VT, IK, IV>::multi_key_get(const std::vector<KT>& keys, const persistent::version_t& ver, const bool stable) const {
+    dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
+    // one invalid object per key, like get().
+    return std::vector<VT>(keys.size(), *IV);
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 const VT TriggerCascadeNoStore<KT, VT, IK, IV>::multi_get(const KT& key) const {
     dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
@@ -78,6 +96,13 @@ std::vector<KT> TriggerCascadeNoStore<KT, VT, IK, IV>::list_keys_by_time(const s
     return {};
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+scan_page_tuple<KT, VT> TriggerCascadeNoStore<KT, VT, IK, IV>::scan(const std::string& prefix, const persistent::version_t& ver, const bool stable,
+                                                                   const KT& cursor, const uint32_t& max_items, const uint64_t& max_bytes) const {
+    dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
+    return {{}, *IK, CURRENT_VERSION};
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 uint64_t TriggerCascadeNoStore<KT, VT, IK, IV>::multi_get_size(const KT& key) const {
     dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
@@ -113,6 +138,17 @@ void TriggerCascadeNoStore<KT, VT, IK, IV>::ordered_put_and_forget(const VT& val
     dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple TriggerCascadeNoStore<KT, VT, IK, IV>::ordered_put_batch(const std::vector<VT>& values, bool as_trigger) {
+    dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
+    return {persistent::INVALID_VERSION, 0};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void TriggerCascadeNoStore<KT, VT, IK, IV>::ordered_put_batch_and_forget(const std::vector<VT>& values, bool as_trigger) {
+    dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 version_tuple TriggerCascadeNoStore<KT, VT, IK, IV>::ordered_remove(const KT& key) {
     dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
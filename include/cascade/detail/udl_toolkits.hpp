@@ -5,6 +5,18 @@
  * The UDL toolkit
  */
 
+/**
+ * @brief An object of a batch handed to DefaultOffCriticalDataPathObserver::ocdpo_batch_handler(), with the same
+ * meaning as the arguments of DefaultOffCriticalDataPathObserver::ocdpo_handler().
+ */
+struct ocdpo_batch_entry_t {
+    node_id_t                   sender;
+    std::string                 object_pool_pathname;
+    std::string                 key_string;
+    const ObjectWithStringKey*  object;
+    emit_func_t                 emit;
+};
+
 /**
  * @brief DefaultOffCriticalDataPathObserver
  * A wrapper around OffCrticalDataPathObserver with application friendly parameters.
@@ -21,6 +33,12 @@ public:
             ICascadeContext* ctxt,
             uint32_t worker_id) override;
 
+    virtual void handle_batch(
+            const Action* actions,
+            const std::size_t num_actions,
+            ICascadeContext* ctxt,
+            uint32_t worker_id) override;
+
     /**
      * @brief offcritical data path handler
      * 
@@ -40,4 +58,20 @@ public:
             const emit_func_t&              emit,
             DefaultCascadeContextType*      typed_ctxt,
             uint32_t                        worker_id) = 0;
+
+    /**
+     * @brief offcritical data path batch handler
+     * It is called instead of ocdpo_handler() when the UDL is registered with a "max_batch_size" larger than 1 in
+     * the "user_defined_logic_batch_list" of dfgs.json. The objects are in the order they were posted. Override it to
+     * process the objects together, for example, to run one model inference over a batch of frames. The default
+     * implementation calls ocdpo_handler() on each object.
+     *
+     * @param[in]   batch                   The objects
+     * @param[in]   typed_ctxt              Typed Cascade Context
+     * @param[in]   worker_id               Worker thread id.
+     */
+    virtual void ocdpo_batch_handler (
+            const std::vector<ocdpo_batch_entry_t>& batch,
+            DefaultCascadeContextType*      typed_ctxt,
+            uint32_t                        worker_id);
 };
@@ -4,6 +4,7 @@
 #include "cascade/config.h"
 #include "cascade/utils.hpp"
 #include "debug_util.hpp"
+#include "store_util.hpp"
 
 #include <derecho/conf/conf.hpp>
 #include <derecho/persistent/PersistentInterface.hpp>
@@ -12,6 +13,7 @@
 #include <memory>
 #include <string>
 #include <type_traits>
+#include <unordered_set>
 
 namespace derecho {
 namespace cascade {
@@ -47,6 +49,32 @@ void VolatileCascadeStore<KT, VT, IK, IV>::put_and_forget(const VT& value, bool
     debug_leave_func();
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCascadeStore<KT, VT, IK, IV>::put_batch(const std::vector<VT>& values, bool as_trigger) const {
+    debug_enter_func_with_args("num_objects={}", values.size());
+
+    derecho::Replicated<VolatileCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_put_batch)>(values,as_trigger);
+    auto& replies = results.get();
+    version_tuple ret{CURRENT_VERSION, 0};
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::put_batch_and_forget(const std::vector<VT>& values, bool as_trigger) const {
+    debug_enter_func_with_args("num_objects={}", values.size());
+
+    derecho::Replicated<VolatileCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index);
+    subgroup_handle.template ordered_send<RPC_NAME(ordered_put_batch_and_forget)>(values,as_trigger);
+
+    debug_leave_func();
+}
+
 #ifdef ENABLE_EVALUATION
 
 template <typename CascadeType>
@@ -123,53 +151,23 @@ const VT VolatileCascadeStore<KT, VT, IK, IV>::get(const KT& key, const persiste
     }
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_GET_START, group, *IV);
 
-    // copy data out
-    persistent::version_t v1, v2;
-    static thread_local VT copied_out;
-    do {
-        // This only for TSO memory reordering.
-        v2 = this->lockless_v2.load(std::memory_order_relaxed);
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        /* 
-         * An out_of_range exception can be thrown even if 'key' exists in
-         * kv_map. Since std::map is not thread-safe, and there is another
-         * thread modifying kv_map concurrently, the internal data structure can
-         * be changed while this thread is inside kv_map.at(key). Therefore, we
-         * keep trying until it is possible to copy either the object we are
-         * looking for, or the invalid object.
-         */
-        while(true) {
-            try {
-                if(this->kv_map.find(key) != this->kv_map.end()) {
-                    copied_out.copy_from(this->kv_map.at(key));
-                } else {
-                    copied_out.copy_from(*IV);
-                }
-
-                break;
-            } catch (const std::out_of_range&) {
-                dbg_default_debug("{}: out_of_range exception thrown while trying to get key {}", __PRETTY_FUNCTION__, key);
-            }
-        }
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        v1 = this->lockless_v1.load(std::memory_order_relaxed);
-        // busy sleep
-        std::this_thread::yield();
-    } while(v1 != v2);
+    // The object data is copied only when the value is serialized into the reply.
+    VT value = lockless_get_view(this->kv_map, key, *IV);
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_GET_END, group, *IV);
-    return copied_out;
+    return value;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<VT> VolatileCascadeStore<KT, VT, IK, IV>::multi_key_get(const std::vector<KT>& keys, const persistent::version_t& ver, const bool) const {
+    debug_enter_func_with_args("num_keys={},ver=0x{:x}", keys.size(), ver);
+    if(ver != CURRENT_VERSION) {
+        debug_leave_func_with_value("Cannot support versioned get, ver=0x{:x}", ver);
+        return std::vector<VT>(keys.size(), *IV);
+    }
+
+    auto values = lockless_multi_key_get(this->kv_map, keys, *IV);
+    debug_leave_func();
+    return values;
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
@@ -226,35 +224,7 @@ std::vector<KT> VolatileCascadeStore<KT, VT, IK, IV>::list_keys(const std::strin
 
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_LIST_KEYS_START, group, *IV);
     // copy key list out
-    std::vector<KT> key_list;
-    persistent::version_t v1, v2;
-    static thread_local VT copied_out;
-    do {
-        // This only for TSO memory reordering.
-        v2 = this->lockless_v2.load(std::memory_order_relaxed);
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        for(auto kv : this->kv_map) {
-            if(get_pathname<KT>(kv.first).find(prefix) == 0) {
-                key_list.push_back(kv.first);
-            }
-        }
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        v1 = this->lockless_v1.load(std::memory_order_relaxed);
-        // busy sleep
-        std::this_thread::yield();
-    } while(v1 != v2);
+    std::vector<KT> key_list = list_keys_by_prefix(this->kv_map, prefix);
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_LIST_KEYS_END, group, *IV);
 
     return key_list;
@@ -268,6 +238,20 @@ std::vector<KT> VolatileCascadeStore<KT, VT, IK, IV>::list_keys_by_time(const st
     return {};
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+scan_page_tuple<KT, VT> VolatileCascadeStore<KT, VT, IK, IV>::scan(const std::string& prefix, const persistent::version_t& ver, const bool,
+                                                                  const KT& cursor, const uint32_t& max_items, const uint64_t& max_bytes) const {
+    debug_enter_func_with_args("prefix={},ver=0x{:x},max_items={},max_bytes={}", prefix, ver, max_items, max_bytes);
+    if(ver != CURRENT_VERSION) {
+        debug_leave_func_with_value("Cannot support versioned scan, ver=0x{:x}", ver);
+        return {{}, *IK, CURRENT_VERSION};
+    }
+
+    auto page = scan_by_prefix(this->kv_map, prefix, cursor, *IK, max_items, max_bytes);
+    debug_leave_func_with_value("{} objects", std::get<0>(page).size());
+    return page;
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 uint64_t VolatileCascadeStore<KT, VT, IK, IV>::multi_get_size(const KT& key) const {
     debug_enter_func_with_args("key={}", key);
@@ -298,32 +282,8 @@ uint64_t VolatileCascadeStore<KT, VT, IK, IV>::get_size(const KT& key, const per
 
     // copy data out
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_GET_SIZE_START, group, *IV);
-    persistent::version_t v1, v2;
     uint64_t size = 0ull;
-    do {
-        // This only for TSO memory reordering.
-        v2 = this->lockless_v2.load(std::memory_order_relaxed);
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        if(this->kv_map.find(key) != this->kv_map.end()) {
-            size = mutils::bytes_size(this->kv_map.at(key));
-        }
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        v1 = this->lockless_v1.load(std::memory_order_relaxed);
-        // busy sleep
-        std::this_thread::yield();
-    } while(v1 != v2);
+    this->kv_map.read(key, [&size](const VT& value) { size = mutils::bytes_size(value); });
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_GET_SIZE_END, group, *IV);
     return size;
 }
@@ -350,12 +310,7 @@ std::vector<KT> VolatileCascadeStore<KT, VT, IK, IV>::ordered_list_keys(const st
 #else
     LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_VOLATILE_ORDERED_LIST_KEYS_START,group,*IV,std::get<0>(version_and_hlc));
 #endif
-    std::vector<KT> key_list;
-    for(auto kv : this->kv_map) {
-        if(get_pathname<KT>(kv.first).find(prefix) == 0) {
-            key_list.push_back(kv.first);
-        }
-    }
+    std::vector<KT> key_list = list_keys_by_prefix(this->kv_map, prefix);
 #if __cplusplus > 201703L
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_ORDERED_LIST_KEYS_END,group,*IV,std::get<0>(version_and_hlc));
 #else
@@ -417,6 +372,110 @@ void VolatileCascadeStore<KT, VT, IK, IV>::ordered_put_and_forget(const VT& valu
     debug_leave_func();
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCascadeStore<KT, VT, IK, IV>::ordered_put_batch(const std::vector<VT>& values, bool as_trigger) {
+    debug_enter_func_with_args("num_objects={}", values.size());
+
+    auto version_and_hlc = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_current_version();
+    version_tuple version_and_timestamp{persistent::INVALID_VERSION, 0};
+    if(values.empty()) {
+        debug_leave_func_with_value("empty batch, version=0x{:x}", std::get<0>(version_and_hlc));
+        return version_and_timestamp;
+    }
+
+    // Validate and verify every object against the state before the batch, and validate it against the objects before
+    // it in the batch as well. The batch is rejected as a whole if any of them fails, so that a batch is either applied
+    // entirely or not at all.
+    std::unordered_set<KT> batch_keys;
+    ConcurrentOrderedMap<KT, VT> validated_values;
+    for(const auto& value : values) {
+        if(!batch_keys.insert(value.get_key_ref()).second) {
+            dbg_default_warn("{}: reject the batch because key:{} appears more than once.", __PRETTY_FUNCTION__, value.get_key_ref());
+            debug_leave_func_with_value("rejected, version=0x{:x}", std::get<0>(version_and_hlc));
+            return version_and_timestamp;
+        }
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            value.set_version(std::get<0>(version_and_hlc));
+        }
+        if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+            value.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+        }
+        if constexpr(std::is_base_of<IValidator<KT, VT>, VT>::value) {
+            if(!value.validate(this->kv_map) || !value.validate(validated_values)) {
+                debug_leave_func_with_value("rejected, version=0x{:x}", std::get<0>(version_and_hlc));
+                return version_and_timestamp;
+            }
+            validated_values.insert_or_assign(value.get_key_ref(), value);
+        }
+        if constexpr(std::is_base_of<IVerifyPreviousVersion, VT>::value) {
+            auto it = this->kv_map.find(value.get_key_ref());
+            if(!value.verify_previous_version(this->update_version,
+                        (it != this->kv_map.end()) ? it->second.get_version() : persistent::INVALID_VERSION)) {
+                debug_leave_func_with_value("rejected, version=0x{:x}", std::get<0>(version_and_hlc));
+                return version_and_timestamp;
+            }
+        }
+    }
+
+    // Apply the batch under one version.
+    for(const auto& value : values) {
+        if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+            auto it = this->kv_map.find(value.get_key_ref());
+            value.set_previous_version(this->update_version,
+                    (it != this->kv_map.end()) ? it->second.get_version() : persistent::INVALID_VERSION);
+        }
+        if(!as_trigger) {
+            this->kv_map.insert_or_assign(value.get_key_ref(), value);
+        }
+    }
+    if(!as_trigger) {
+        this->update_version = std::get<0>(version_and_hlc);
+    }
+
+    if(cascade_watcher_ptr) {
+        // a value overwritten later in the batch is gone from kv_map, so only the last put to a key is shared.
+        std::vector<bool> last_puts;
+        if(!as_trigger) {
+            last_puts = last_puts_by_key<KT>(values);
+        }
+        for(std::size_t i = 0; i < values.size(); i++) {
+            const auto& value = values[i];
+            if(as_trigger || !last_puts[i]) {
+                (*cascade_watcher_ptr)(
+                        this->subgroup_index,
+                        group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_shard_num(),
+                        group->get_rpc_caller_id(),
+                        value.get_key_ref(), value, cascade_context_ptr);
+            } else {
+                // the stored copy is shared with the watcher instead of copied again.
+                cascade_watcher_ptr->observe_shared(
+                        this->subgroup_index,
+                        group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_shard_num(),
+                        group->get_rpc_caller_id(),
+                        value.get_key_ref(), value,
+                        [this,&value]() { return this->kv_map.read_shared(value.get_key_ref()); },
+                        cascade_context_ptr);
+            }
+        }
+    }
+    version_and_timestamp = {std::get<0>(version_and_hlc),std::get<1>(version_and_hlc).m_rtc_us};
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_hlc),
+            std::get<1>(version_and_hlc).m_rtc_us);
+    return version_and_timestamp;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::ordered_put_batch_and_forget(const std::vector<VT>& values, bool as_trigger) {
+    debug_enter_func_with_args("num_objects={}", values.size());
+    // the objects are applied in order, each on its own, as a sequence of ordered_put_and_forget sharing one version.
+    for(const auto& value : values) {
+        internal_ordered_put(value,as_trigger);
+    }
+    debug_leave_func();
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 bool VolatileCascadeStore<KT, VT, IK, IV>::internal_ordered_put(const VT& value, bool as_trigger) {
     auto version_and_hlc = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_current_version();
@@ -457,38 +516,28 @@ bool VolatileCascadeStore<KT, VT, IK, IV>::internal_ordered_put(const VT& value,
     }
 
     if (!as_trigger) {
-    // for lockless check
-    this->lockless_v1.store(std::get<0>(version_and_hlc), std::memory_order_relaxed);
-    // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                         : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-
-        this->kv_map.erase(value.get_key_ref());           // remove
-        this->kv_map.emplace(value.get_key_ref(), value);  // copy constructor
+        this->kv_map.insert_or_assign(value.get_key_ref(), value);
         this->update_version = std::get<0>(version_and_hlc);
-
-        // for lockless check
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                         : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        this->lockless_v2.store(std::get<0>(version_and_hlc), std::memory_order_relaxed);
     }
 
     if(cascade_watcher_ptr) {
-        (*cascade_watcher_ptr)(
-                // group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_subgroup_id(), // this is subgroup id
-                this->subgroup_index,  // this is subgroup index
-                group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_shard_num(),
-                group->get_rpc_caller_id(),
-                value.get_key_ref(), value, cascade_context_ptr);
+        if(as_trigger) {
+            (*cascade_watcher_ptr)(
+                    // group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_subgroup_id(), // this is subgroup id
+                    this->subgroup_index,  // this is subgroup index
+                    group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_shard_num(),
+                    group->get_rpc_caller_id(),
+                    value.get_key_ref(), value, cascade_context_ptr);
+        } else {
+            // the stored copy is shared with the watcher instead of copied again.
+            cascade_watcher_ptr->observe_shared(
+                    this->subgroup_index,  // this is subgroup index
+                    group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_shard_num(),
+                    group->get_rpc_caller_id(),
+                    value.get_key_ref(), value,
+                    [this,&value]() { return this->kv_map.read_shared(value.get_key_ref()); },
+                    cascade_context_ptr);
+        }
     }
 
     return true;
@@ -530,30 +579,9 @@ version_tuple VolatileCascadeStore<KT, VT, IK, IV>::ordered_remove(const KT& key
         }
     }
 
-    // for lockless check
-    this->lockless_v1.store(std::get<0>(version_and_hlc), std::memory_order_relaxed);
-    // compiler reordering barrier
-#ifdef __GNUC__
-    asm volatile("" ::
-                         : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-
-    this->kv_map.erase(key);  // remove
-    this->kv_map.emplace(key, value);
+    this->kv_map.insert_or_assign(key, value);
     this->update_version = std::get<0>(version_and_hlc);
 
-    // for lockless check
-    // compiler reordering barrier
-#ifdef __GNUC__
-    asm volatile("" ::
-                         : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-    this->lockless_v2.store(std::get<0>(version_and_hlc), std::memory_order_relaxed);
-
     if(cascade_watcher_ptr) {
         (*cascade_watcher_ptr)(
                 // group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_subgroup_id(), // this is subgroup id
@@ -693,7 +721,7 @@ template <typename KT, typename VT, KT* IK, VT* IV>
 std::unique_ptr<VolatileCascadeStore<KT, VT, IK, IV>> VolatileCascadeStore<KT, VT, IK, IV>::from_bytes(
         mutils::DeserializationManager* dsm,
         uint8_t const* buf) {
-    auto kv_map_ptr = mutils::from_bytes<std::map<KT, VT>>(dsm, buf);
+    auto kv_map_ptr = mutils::from_bytes<ConcurrentOrderedMap<KT, VT>>(dsm, buf);
     auto update_version_ptr = mutils::from_bytes<persistent::version_t>(dsm, buf + mutils::bytes_size(*kv_map_ptr));
     auto volatile_cascade_store_ptr = std::make_unique<VolatileCascadeStore>(std::move(*kv_map_ptr),
                                                                              *update_version_ptr,
@@ -705,9 +733,7 @@ std::unique_ptr<VolatileCascadeStore<KT, VT, IK, IV>> VolatileCascadeStore<KT, V
 template <typename KT, typename VT, KT* IK, VT* IV>
 VolatileCascadeStore<KT, VT, IK, IV>::VolatileCascadeStore(
         CriticalDataPathObserver<VolatileCascadeStore<KT, VT, IK, IV>>* cw,
-        ICascadeContext* cc) : lockless_v1(persistent::INVALID_VERSION),
-                               lockless_v2(persistent::INVALID_VERSION),
-                               update_version(persistent::INVALID_VERSION),
+        ICascadeContext* cc) : update_version(persistent::INVALID_VERSION),
                                cascade_watcher_ptr(cw),
                                cascade_context_ptr(cc) {
     debug_enter_func();
@@ -716,12 +742,10 @@ VolatileCascadeStore<KT, VT, IK, IV>::VolatileCascadeStore(
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 VolatileCascadeStore<KT, VT, IK, IV>::VolatileCascadeStore(
-        const std::map<KT, VT>& _kvm,
+        const ConcurrentOrderedMap<KT, VT>& _kvm,
         persistent::version_t _uv,
         CriticalDataPathObserver<VolatileCascadeStore<KT, VT, IK, IV>>* cw,
-        ICascadeContext* cc) : lockless_v1(_uv),
-                               lockless_v2(_uv),
-                               kv_map(_kvm),
+        ICascadeContext* cc) : kv_map(_kvm),
                                update_version(_uv),
                                cascade_watcher_ptr(cw),
                                cascade_context_ptr(cc) {
@@ -731,12 +755,10 @@ VolatileCascadeStore<KT, VT, IK, IV>::VolatileCascadeStore(
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 VolatileCascadeStore<KT, VT, IK, IV>::VolatileCascadeStore(
-        std::map<KT, VT>&& _kvm,
+        ConcurrentOrderedMap<KT, VT>&& _kvm,
         persistent::version_t _uv,
         CriticalDataPathObserver<VolatileCascadeStore<KT, VT, IK, IV>>* cw,
-        ICascadeContext* cc) : lockless_v1(_uv),
-                               lockless_v2(_uv),
-                               kv_map(std::move(_kvm)),
+        ICascadeContext* cc) : kv_map(std::move(_kvm)),
                                update_version(_uv),
                                cascade_watcher_ptr(cw),
                                cascade_context_ptr(cc) {
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "action_queue.hpp"
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * @class WorkStealingScheduler
+ * @brief A scheduler of actions to a pool of workers, where an idle worker steals the actions queued for the others.
+ *
+ * Every worker has its own lock-free ActionQueue. Actions are posted to the queues in a round-robin manner, and a
+ * worker takes the actions from its own queue first. A worker finding its own queue empty steals the oldest action
+ * from the queue of another worker, so that an action posted behind a slow one does not wait for it as long as some
+ * worker is idle. The actions of a worker are therefore not processed in the order they are posted; the scheduler is
+ * meant for stateless actions only.
+ *
+ * A worker finding all the queues empty spins for a while, then yields, then parks on a condition variable shared by
+ * all the workers; the producer only touches the condition variable if some worker is parked.
+ *
+ * @tparam T    - the element type, which must be default constructible and move assignable.
+ */
+template <typename T>
+class WorkStealingScheduler {
+private:
+    static constexpr std::size_t cache_line_size = 64;
+    /** The spins before yielding, and the yields before parking. */
+    static constexpr uint32_t max_spins = 1024;
+    static constexpr uint32_t max_yields = 16;
+
+    /** The queues of the workers. */
+    std::vector<std::unique_ptr<ActionQueue<T>>> queues;
+    /** The queue for the next posted action. */
+    alignas(cache_line_size) std::atomic<uint32_t> next_queue;
+    /** The number of actions taken from the queue of another worker. */
+    alignas(cache_line_size) std::atomic<uint64_t> num_steals;
+
+    /** The parked workers, and what they park on. */
+    alignas(cache_line_size) std::atomic<uint32_t> parked_workers;
+    std::mutex park_mutex;
+    std::condition_variable data_cv;
+
+    /** Wake up a parked worker, if any. */
+    inline void wake_worker();
+    /** Test if all the queues are empty. */
+    inline bool is_empty() const;
+    /** Dequeue an element for a worker, waiting for one while is_running is true, until the deadline if there is one. */
+    bool dequeue_impl(uint32_t worker_id, T& value, const std::atomic<bool>& is_running,
+                      const std::chrono::steady_clock::time_point* deadline);
+
+public:
+    /**
+     * Constructor
+     *
+     * @param[in] num_workers           - the number of workers, which must be positive.
+     * @param[in] capacity_per_worker   - the number of slots in the queue of each worker.
+     */
+    WorkStealingScheduler(uint32_t num_workers, std::size_t capacity_per_worker);
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    /**
+     * @return the number of workers.
+     */
+    uint32_t get_num_workers() const;
+
+    /**
+     * Enqueue an element to the queue of the next worker, or of any worker if that queue is full, waiting for a free
+     * slot if all the queues are full.
+     *
+     * @param[in] value     - the element.
+     */
+    void enqueue(T&& value);
+
+    /**
+     * Dequeue an element for a worker without waiting, from the worker's own queue if it is not empty, otherwise from
+     * the queue of another worker.
+     *
+     * @param[in]  worker_id    - the worker, from 0 to get_num_workers()-1.
+     * @param[out] value        - the element.
+     *
+     * @return false if all the queues are empty.
+     */
+    bool try_dequeue(uint32_t worker_id, T& value);
+
+    /**
+     * Dequeue an element for a worker, waiting for one while is_running is true.
+     *
+     * @param[in]  worker_id    - the worker, from 0 to get_num_workers()-1.
+     * @param[out] value        - the element.
+     * @param[in]  is_running   - the flag to stop waiting. Call notify_all() after clearing it.
+     *
+     * @return false if all the queues are empty and is_running is false.
+     */
+    bool dequeue(uint32_t worker_id, T& value, const std::atomic<bool>& is_running);
+
+    /**
+     * Dequeue an element for a worker, waiting for one while is_running is true, but no later than a deadline.
+     *
+     * @param[in]  worker_id    - the worker, from 0 to get_num_workers()-1.
+     * @param[out] value        - the element.
+     * @param[in]  is_running   - the flag to stop waiting. Call notify_all() after clearing it.
+     * @param[in]  deadline     - the deadline.
+     *
+     * @return false if all the queues are still empty at the deadline, or empty and is_running is false.
+     */
+    bool dequeue_until(uint32_t worker_id, T& value, const std::atomic<bool>& is_running,
+                       const std::chrono::steady_clock::time_point& deadline);
+
+    /**
+     * @return the number of elements in all the queues, which can be stale by the time it returns.
+     */
+    std::size_t size() const;
+
+    /**
+     * @return the number of elements a worker has taken from the queue of another worker.
+     */
+    uint64_t get_num_steals() const;
+
+    /**
+     * Wake up all parked workers and producers, for shutdown.
+     */
+    void notify_all();
+};
+
+}
+}
+
+#include "work_stealing_scheduler_impl.hpp"
@@ -0,0 +1,149 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace derecho {
+namespace cascade {
+
+template <typename T>
+WorkStealingScheduler<T>::WorkStealingScheduler(uint32_t num_workers, std::size_t capacity_per_worker):
+    next_queue(0),
+    num_steals(0),
+    parked_workers(0) {
+    for (uint32_t i = 0; i < std::max(num_workers,1u); i++) {
+        queues.emplace_back(std::make_unique<ActionQueue<T>>(capacity_per_worker));
+    }
+}
+
+template <typename T>
+uint32_t WorkStealingScheduler<T>::get_num_workers() const {
+    return static_cast<uint32_t>(queues.size());
+}
+
+template <typename T>
+inline void WorkStealingScheduler<T>::wake_worker() {
+    // pairs with the fence in dequeue_impl(): either the worker sees the new element, or we see it parked.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked_workers.load(std::memory_order_relaxed) > 0) {
+        // taking the mutex makes sure a worker that is about to park is waiting before it is notified.
+        { std::lock_guard<std::mutex> lck(park_mutex); }
+        data_cv.notify_one();
+    }
+}
+
+template <typename T>
+inline bool WorkStealingScheduler<T>::is_empty() const {
+    for (const auto& queue : queues) {
+        if (queue->size() > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+void WorkStealingScheduler<T>::enqueue(T&& value) {
+    const uint32_t num_queues = static_cast<uint32_t>(queues.size());
+    const uint32_t first = next_queue.fetch_add(1,std::memory_order_relaxed) % num_queues;
+    for (uint32_t i = 0; i < num_queues; i++) {
+        if (queues[(first + i) % num_queues]->try_enqueue(std::move(value))) {
+            wake_worker();
+            return;
+        }
+    }
+    queues[first]->enqueue(std::move(value));
+    wake_worker();
+}
+
+template <typename T>
+bool WorkStealingScheduler<T>::try_dequeue(uint32_t worker_id, T& value) {
+    const uint32_t num_queues = static_cast<uint32_t>(queues.size());
+    const uint32_t own = worker_id % num_queues;
+    if (queues[own]->try_dequeue(value)) {
+        return true;
+    }
+    for (uint32_t i = 1; i < num_queues; i++) {
+        if (queues[(own + i) % num_queues]->try_dequeue(value)) {
+            num_steals.fetch_add(1,std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T>
+bool WorkStealingScheduler<T>::dequeue_impl(uint32_t worker_id, T& value, const std::atomic<bool>& is_running,
+                                            const std::chrono::steady_clock::time_point* deadline) {
+    uint32_t rounds = 0;
+    while (!try_dequeue(worker_id,value)) {
+        if (!is_running.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (rounds < max_spins) {
+            action_queue_detail::cpu_relax();
+        } else if (rounds < max_spins + max_yields) {
+            std::this_thread::yield();
+        } else {
+            // the timeout only guards against a missed shutdown; new elements always notify.
+            auto wake_up_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+            if (deadline != nullptr) {
+                if (std::chrono::steady_clock::now() >= *deadline) {
+                    return false;
+                }
+                wake_up_time = std::min(wake_up_time,*deadline);
+            }
+            std::unique_lock<std::mutex> lck(park_mutex);
+            parked_workers.fetch_add(1,std::memory_order_relaxed);
+            // pairs with the fence in wake_worker().
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (is_empty() && is_running.load(std::memory_order_relaxed)) {
+                data_cv.wait_until(lck,wake_up_time);
+            }
+            parked_workers.fetch_sub(1,std::memory_order_relaxed);
+            continue;
+        }
+        rounds++;
+        if (deadline != nullptr && (rounds & 0xff) == 0 && std::chrono::steady_clock::now() >= *deadline) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+bool WorkStealingScheduler<T>::dequeue(uint32_t worker_id, T& value, const std::atomic<bool>& is_running) {
+    return dequeue_impl(worker_id,value,is_running,nullptr);
+}
+
+template <typename T>
+bool WorkStealingScheduler<T>::dequeue_until(uint32_t worker_id, T& value, const std::atomic<bool>& is_running,
+                                             const std::chrono::steady_clock::time_point& deadline) {
+    return dequeue_impl(worker_id,value,is_running,&deadline);
+}
+
+template <typename T>
+std::size_t WorkStealingScheduler<T>::size() const {
+    std::size_t ret = 0;
+    for (const auto& queue : queues) {
+        ret += queue->size();
+    }
+    return ret;
+}
+
+template <typename T>
+uint64_t WorkStealingScheduler<T>::get_num_steals() const {
+    return num_steals.load(std::memory_order_relaxed);
+}
+
+template <typename T>
+void WorkStealingScheduler<T>::notify_all() {
+    { std::lock_guard<std::mutex> lck(park_mutex); }
+    data_cv.notify_all();
+    for (auto& queue : queues) {
+        queue->notify_all();
+    }
+}
+
+}
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * @class WriteCoalescer
+ * @brief Accumulates the fire-and-forget writes of a client per destination shard, and hands them to a sender in
+ * batches.
+ *
+ * The buffer of a shard is flushed when it reaches the object count or the byte size threshold, in the writing thread,
+ * or when its oldest object has lingered for the linger timeout, in the linger thread. A flush sends the buffered
+ * objects in the order they were written, and the flushes of a shard are serialized, so that the writes to a key are
+ * sent in order. Consecutive objects with the same trigger flag go in one batch.
+ *
+ * The linger thread is started with the first write.
+ *
+ * @tparam ObjectType   - the object type, which must be serializable with mutils.
+ */
+template <typename ObjectType>
+class WriteCoalescer {
+public:
+    /**
+     * The sender of a batch, called with the subgroup index, the shard index, the objects, and the trigger flag.
+     */
+    using sender_t = std::function<void(uint32_t,uint32_t,const std::vector<ObjectType>&,bool)>;
+
+private:
+    struct shard_buffer_t {
+        const uint32_t subgroup_index;
+        const uint32_t shard_index;
+        /** Serializes the flushes of the shard. */
+        std::mutex flush_mutex;
+        /** Guards the buffer. */
+        std::mutex mutex;
+        std::vector<ObjectType> objects;
+        std::vector<bool> as_triggers;
+        std::size_t bytes = 0;
+        /** Counts the batches, so that the linger timeout of a batch flushed early is ignored. */
+        uint64_t generation = 0;
+
+        shard_buffer_t(uint32_t _subgroup_index, uint32_t _shard_index):
+            subgroup_index(_subgroup_index), shard_index(_shard_index) {}
+    };
+
+    struct shard_hash {
+        std::size_t operator()(const std::pair<uint32_t,uint32_t>& shard) const {
+            return (static_cast<std::size_t>(shard.first) << 32) | shard.second;
+        }
+    };
+
+    const sender_t sender;
+
+    std::atomic<std::size_t> max_batch_objects;
+    std::atomic<std::size_t> max_batch_bytes;
+    std::atomic<uint64_t> linger_ns;
+
+    mutable std::shared_mutex buffers_mutex;
+    std::unordered_map<std::pair<uint32_t,uint32_t>,std::unique_ptr<shard_buffer_t>,shard_hash> buffers;
+
+    /** The linger deadlines in the order of the batches, which is also the order of their deadlines. */
+    std::mutex linger_mutex;
+    std::condition_variable linger_cv;
+    std::deque<std::tuple<uint64_t,shard_buffer_t*,uint64_t>> linger_queue;
+    bool stopping;
+    std::once_flag linger_thread_flag;
+    std::thread linger_thread;
+
+    /** Get the buffer of a shard, creating it on first use. */
+    shard_buffer_t& buffer_of(uint32_t subgroup_index, uint32_t shard_index);
+    /**
+     * Flush the buffer of a shard.
+     *
+     * @param[in] buffer        - the buffer.
+     * @param[in] generation    - the batch to flush, or 0 for whatever is buffered.
+     */
+    void flush_buffer(shard_buffer_t& buffer, uint64_t generation);
+    /** The linger thread. */
+    void linger();
+
+public:
+    /**
+     * Constructor
+     *
+     * @param[in] sender            - the sender of the batches.
+     * @param[in] max_batch_objects - the object count threshold.
+     * @param[in] max_batch_bytes   - the byte size threshold.
+     * @param[in] linger_us         - the linger timeout in microseconds.
+     */
+    WriteCoalescer(const sender_t& sender, std::size_t max_batch_objects, std::size_t max_batch_bytes,
+                   uint64_t linger_us);
+
+    WriteCoalescer(const WriteCoalescer&) = delete;
+    WriteCoalescer& operator=(const WriteCoalescer&) = delete;
+
+    /**
+     * Destructor
+     * Stops the linger thread. The objects still buffered are dropped; call flush() before.
+     */
+    virtual ~WriteCoalescer();
+
+    /**
+     * Change the thresholds. They apply to the following writes.
+     *
+     * @param[in] max_batch_objects - the object count threshold.
+     * @param[in] max_batch_bytes   - the byte size threshold.
+     * @param[in] linger_us         - the linger timeout in microseconds.
+     */
+    void configure(std::size_t max_batch_objects, std::size_t max_batch_bytes, uint64_t linger_us);
+
+    /**
+     * Buffer a write, and flush the buffer of the shard if it reaches a threshold.
+     *
+     * @param[in] subgroup_index
+     * @param[in] shard_index
+     * @param[in] object
+     * @param[in] as_trigger
+     *
+     * @throws the exceptions of the sender, if the buffer is flushed.
+     */
+    void put(uint32_t subgroup_index, uint32_t shard_index, const ObjectType& object, bool as_trigger);
+
+    /**
+     * Flush the buffers of all shards.
+     *
+     * @throws the exceptions of the sender.
+     */
+    void flush();
+};
+
+}
+}
+
+#include "write_coalescer_impl.hpp"
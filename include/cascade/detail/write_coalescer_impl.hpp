@@ -0,0 +1,188 @@
+#pragma once
+#include <chrono>
+#include <cascade/utils.hpp>
+#include <exception>
+#include <derecho/core/derecho_exception.hpp>
+#include <derecho/utils/logger.hpp>
+#include <mutils-serialization/SerializationSupport.hpp>
+
+namespace derecho {
+namespace cascade {
+
+template <typename ObjectType>
+WriteCoalescer<ObjectType>::WriteCoalescer(const sender_t& _sender, std::size_t _max_batch_objects,
+                                           std::size_t _max_batch_bytes, uint64_t _linger_us):
+    sender(_sender),
+    max_batch_objects(_max_batch_objects),
+    max_batch_bytes(_max_batch_bytes),
+    linger_ns(_linger_us*1000),
+    stopping(false) {}
+
+template <typename ObjectType>
+WriteCoalescer<ObjectType>::~WriteCoalescer() {
+    {
+        std::lock_guard<std::mutex> lck(linger_mutex);
+        stopping = true;
+    }
+    linger_cv.notify_one();
+    if (linger_thread.joinable()) {
+        linger_thread.join();
+    }
+}
+
+template <typename ObjectType>
+void WriteCoalescer<ObjectType>::configure(std::size_t _max_batch_objects, std::size_t _max_batch_bytes,
+                                           uint64_t _linger_us) {
+    max_batch_objects.store(_max_batch_objects,std::memory_order_relaxed);
+    max_batch_bytes.store(_max_batch_bytes,std::memory_order_relaxed);
+    linger_ns.store(_linger_us*1000,std::memory_order_relaxed);
+}
+
+template <typename ObjectType>
+typename WriteCoalescer<ObjectType>::shard_buffer_t& WriteCoalescer<ObjectType>::buffer_of(uint32_t subgroup_index,
+                                                                                           uint32_t shard_index) {
+    auto shard = std::make_pair(subgroup_index,shard_index);
+    {
+        std::shared_lock<std::shared_mutex> rlck(buffers_mutex);
+        auto it = buffers.find(shard);
+        if (it != buffers.end()) {
+            return *it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> wlck(buffers_mutex);
+    auto& buffer = buffers[shard];
+    if (!buffer) {
+        buffer = std::make_unique<shard_buffer_t>(subgroup_index,shard_index);
+    }
+    return *buffer;
+}
+
+template <typename ObjectType>
+void WriteCoalescer<ObjectType>::put(uint32_t subgroup_index, uint32_t shard_index, const ObjectType& object,
+                                     bool as_trigger) {
+    std::call_once(linger_thread_flag,[this](){
+        linger_thread = std::thread(&WriteCoalescer<ObjectType>::linger,this);
+    });
+    auto& buffer = buffer_of(subgroup_index,shard_index);
+    bool full;
+    uint64_t new_generation = 0;
+    {
+        std::lock_guard<std::mutex> lck(buffer.mutex);
+        if (buffer.objects.empty()) {
+            new_generation = ++buffer.generation;
+        }
+        buffer.objects.emplace_back(object);
+        buffer.as_triggers.emplace_back(as_trigger);
+        buffer.bytes += mutils::bytes_size(object);
+        full = (buffer.objects.size() >= max_batch_objects.load(std::memory_order_relaxed) ||
+                buffer.bytes >= max_batch_bytes.load(std::memory_order_relaxed));
+    }
+    if (full) {
+        flush_buffer(buffer,0);
+    } else if (new_generation != 0) {
+        bool was_empty;
+        {
+            std::lock_guard<std::mutex> lck(linger_mutex);
+            was_empty = linger_queue.empty();
+            linger_queue.emplace_back(get_time_ns(false) + linger_ns.load(std::memory_order_relaxed),
+                                      &buffer,new_generation);
+        }
+        // a later deadline never comes first, so the linger thread only needs waking up for the first one.
+        if (was_empty) {
+            linger_cv.notify_one();
+        }
+    }
+}
+
+template <typename ObjectType>
+void WriteCoalescer<ObjectType>::flush_buffer(shard_buffer_t& buffer, uint64_t generation) {
+    std::lock_guard<std::mutex> flush_lck(buffer.flush_mutex);
+    std::vector<ObjectType> objects;
+    std::vector<bool> as_triggers;
+    {
+        std::lock_guard<std::mutex> lck(buffer.mutex);
+        if (generation != 0 && generation != buffer.generation) {
+            // flushed already.
+            return;
+        }
+        objects.swap(buffer.objects);
+        as_triggers.swap(buffer.as_triggers);
+        buffer.bytes = 0;
+    }
+    if (objects.empty()) {
+        return;
+    }
+    // send the runs of objects with the same trigger flag in order.
+    std::size_t begin = 0;
+    try {
+        while (begin < objects.size()) {
+            std::size_t end = begin + 1;
+            while (end < objects.size() && as_triggers[end] == as_triggers[begin]) {
+                end++;
+            }
+            if (begin == 0 && end == objects.size()) {
+                sender(buffer.subgroup_index,buffer.shard_index,objects,as_triggers[begin]);
+            } else {
+                std::vector<ObjectType> run(std::make_move_iterator(objects.begin() + begin),
+                                            std::make_move_iterator(objects.begin() + end));
+                sender(buffer.subgroup_index,buffer.shard_index,run,as_triggers[begin]);
+            }
+            begin = end;
+        }
+    } catch (...) {
+        // the objects are out of the buffer already, so the failed run and the ones after it are lost.
+        dbg_default_warn("Dropped {} of {} coalesced writes to shard {}/{}.",
+                objects.size() - begin, objects.size(), buffer.subgroup_index, buffer.shard_index);
+        throw;
+    }
+}
+
+template <typename ObjectType>
+void WriteCoalescer<ObjectType>::flush() {
+    std::vector<shard_buffer_t*> all_buffers;
+    {
+        std::shared_lock<std::shared_mutex> rlck(buffers_mutex);
+        for (auto& buffer : buffers) {
+            all_buffers.emplace_back(buffer.second.get());
+        }
+    }
+    for (auto* buffer : all_buffers) {
+        flush_buffer(*buffer,0);
+    }
+}
+
+template <typename ObjectType>
+void WriteCoalescer<ObjectType>::linger() {
+    pthread_setname_np(pthread_self(),"cs_coalescer");
+    std::unique_lock<std::mutex> lck(linger_mutex);
+    while (!stopping) {
+        if (linger_queue.empty()) {
+            linger_cv.wait(lck);
+            continue;
+        }
+        uint64_t deadline_ns = std::get<0>(linger_queue.front());
+        uint64_t now_ns = get_time_ns(false);
+        if (now_ns < deadline_ns) {
+            linger_cv.wait_for(lck,std::chrono::nanoseconds(deadline_ns - now_ns));
+            continue;
+        }
+        shard_buffer_t* buffer = std::get<1>(linger_queue.front());
+        uint64_t generation = std::get<2>(linger_queue.front());
+        linger_queue.pop_front();
+        lck.unlock();
+        try {
+            flush_buffer(*buffer,generation);
+        } catch (std::exception& ex) {
+            // derecho_exception included; nothing may escape the linger thread.
+            dbg_default_warn("Failed to flush the coalesced writes to shard {}/{}:{}",
+                    buffer->subgroup_index, buffer->shard_index, ex.what());
+        } catch (...) {
+            dbg_default_warn("Failed to flush the coalesced writes to shard {}/{} with an unknown exception.",
+                    buffer->subgroup_index, buffer->shard_index);
+        }
+        lck.lock();
+    }
+}
+
+}
+}
@@ -27,6 +27,7 @@ enum object_memory_mode_t {
     DEFAULT,
     EMPLACED,
     BLOB_GENERATOR,
+    SHARED,
 };
 
 using blob_generator_func_t = std::function<std::size_t(uint8_t*,const std::size_t)>;
@@ -40,6 +41,9 @@ public:
     // for BLOB_GENERATOR mode only
     blob_generator_func_t blob_generator;
 
+    // for SHARED mode only: the owner of the data, which lives as long as the blob.
+    std::shared_ptr<const void> shared_owner;
+
     object_memory_mode_t   memory_mode;
 
 
@@ -51,7 +55,10 @@ public:
     // generator constructor - data to be generated on serialization
     Blob(const blob_generator_func_t& generator, const decltype(size) s);
 
-    // copy constructor - copy to own the data
+    // shared constructor - refer to the data of an owner, and keep the owner alive
+    Blob(const uint8_t* b, const decltype(size) s, const std::shared_ptr<const void>& owner);
+
+    // copy constructor - copy to own the data, or share the data of a SHARED blob
     Blob(const Blob& other);
 
     // move constructor - accept the memory from another object
@@ -94,7 +101,8 @@ public:
 class ObjectWithUInt64Key : public mutils::ByteRepresentable,
                             public ICascadeObject<uint64_t,ObjectWithUInt64Key>,
                             public IKeepTimestamp,
-                            public IVerifyPreviousVersion
+                            public IVerifyPreviousVersion,
+                            public ISharedView<ObjectWithUInt64Key>
 #ifdef ENABLE_EVALUATION
                             , public IHasMessageID
 #endif
@@ -185,6 +193,7 @@ public:
     virtual uint64_t get_timestamp() const override;
     virtual void set_previous_version(persistent::version_t prev_ver, persistent::version_t prev_ver_by_key) const override;
     virtual bool verify_previous_version(persistent::version_t prev_ver, persistent::version_t prev_ver_by_key) const override;
+    virtual ObjectWithUInt64Key create_shared_view(const std::shared_ptr<const ObjectWithUInt64Key>& self) const override;
 #ifdef ENABLE_EVALUATION
     virtual void set_message_id(uint64_t id) const override;
     virtual uint64_t get_message_id() const override;
@@ -211,7 +220,9 @@ public:
 
 inline std::ostream& operator<<(std::ostream& out, const Blob& b) {
     out << "[size:" << b.size << ", data:" << std::hex;
-    if(b.size > 0) {
+    if(b.size > 0 && b.memory_mode == object_memory_mode_t::BLOB_GENERATOR) {
+        out << " <generated>";
+    } else if(b.size > 0) {
         uint32_t i = 0;
         for(i = 0; i < 8 && i < b.size; i++) {
             out << " " << b.bytes[i];
@@ -237,7 +248,8 @@ inline std::ostream& operator<<(std::ostream& out, const ObjectWithUInt64Key& o)
 class ObjectWithStringKey : public mutils::ByteRepresentable,
                             public ICascadeObject<std::string,ObjectWithStringKey>,
                             public IKeepTimestamp,
-                            public IVerifyPreviousVersion
+                            public IVerifyPreviousVersion,
+                            public ISharedView<ObjectWithStringKey>
 #ifdef ENABLE_EVALUATION
                             ,public IHasMessageID
 #endif
@@ -328,6 +340,7 @@ public:
     virtual uint64_t get_timestamp() const override;
     virtual void set_previous_version(persistent::version_t prev_ver, persistent::version_t perv_ver_by_key) const override;
     virtual bool verify_previous_version(persistent::version_t prev_ver, persistent::version_t perv_ver_by_key) const override;
+    virtual ObjectWithStringKey create_shared_view(const std::shared_ptr<const ObjectWithStringKey>& self) const override;
 #ifdef ENABLE_EVALUATION
     virtual void set_message_id(uint64_t id) const override;
     virtual uint64_t get_message_id() const override;
@@ -1,14 +1,20 @@
 #pragma once
 #include <hs/hs.h>
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <vector>
 #include "object.hpp"
 #include "utils.hpp"
+#include "detail/stable_hash.hpp"
 
 namespace derecho {
 namespace cascade {
 
 using sharding_policy_t = enum sharding_policy_type {
     HASH,
-    RANGE
+    RANGE,
+    JUMP_HASH
 };
 
 /**
@@ -27,6 +33,24 @@ using sharding_policy_t = enum sharding_policy_type {
  * The affinity set is a mechanism that groups objects together. When we put/get an object, we use affinity set regex
  * to match a string, which we called the 'affinity set' string; then we use this string as input of sharding policy.
  * If no matching string is found, the original object key is used as the input of sharding policy.
+ *
+ * Important: Sharding Policies
+ * - HASH: an object goes to shard hash(input) % num_shards.
+ * - JUMP_HASH: an object goes to shard jump_consistent_hash(xxhash64(input), num_shards). Both functions are specified
+ *   independently of the standard library, so the placement is the same for all clients, and changing the number of
+ *   shards from n to n+1 only moves about 1/(n+1) of the objects.
+ * - RANGE: the shards partition the ordered input space at the sorted 'range_split_points': shard 0 owns the inputs
+ *   less than range_split_points[0], shard i owns the inputs in [range_split_points[i-1],range_split_points[i]), and
+ *   the last shard owns the rest. The split points are compared with the whole key, so they normally start with the
+ *   object pool pathname, e.g. {"/pool/g","/pool/n","/pool/t"} for a pool of four shards. The keys with a common
+ *   prefix live in a contiguous run of shards, which prefix_to_shard_range() returns.
+ *
+ * Important: Serialization Compatibility
+ * 'range_split_points' is serialized after all the other members, and the serialized format has no version number.
+ * Metadata serialized by a release without 'range_split_points' can not be read by this one, and vice versa: the
+ * clients and the servers of a deployment must be upgraded together, and the persisted log of the metadata service
+ * (the object pool metadata subgroup) must be removed before the upgraded servers start, after which the object pools
+ * have to be created again.
  */
 template<typename... CascadeTypes>
 class ObjectPoolMetadata : public mutils::ByteRepresentable
@@ -53,6 +77,7 @@ public:
     std::unordered_map<std::string,uint32_t>    object_locations; // the list of shards where a corresponding key is stored.
     std::string                                 affinity_set_regex; // the regex to extract the affinity set string
     bool                                        deleted; // is deleted
+    std::vector<std::string>                    range_split_points; // the sorted split points of the RANGE policy
 
     // serialization support
     DEFAULT_SERIALIZATION_SUPPORT(ObjectPoolMetadata<CascadeTypes...>,
@@ -69,7 +94,8 @@ public:
                                   sharding_policy,
                                   object_locations,
                                   affinity_set_regex,
-                                  deleted);
+                                  deleted,
+                                  range_split_points);
 
     // constructor 0: default
     ObjectPoolMetadata():
@@ -86,7 +112,8 @@ public:
         sharding_policy(HASH),
         object_locations(),
         affinity_set_regex(""),
-        deleted(false) {}
+        deleted(false),
+        range_split_points() {}
 
     // constructor 1:
     ObjectPoolMetadata(
@@ -103,7 +130,8 @@ public:
                        sharding_policy_t _sharding_policy,
                        const std::unordered_map<std::string,uint32_t>& _object_locations,
                        const std::string& _affinity_set_regex,
-                       bool _deleted):
+                       bool _deleted,
+                       const std::vector<std::string>& _range_split_points):
 #ifdef ENABLE_EVALUATION
         message_id(_message_id),
 #endif
@@ -117,7 +145,8 @@ public:
         sharding_policy(_sharding_policy),
         object_locations(_object_locations),
         affinity_set_regex(_affinity_set_regex),
-        deleted(_deleted) {
+        deleted(_deleted),
+        range_split_points(_range_split_points) {
             if (!check_pathname_format(_pathname)) {
                 throw derecho::derecho_exception("Invalid object pool pathname:" + _pathname);
             }
@@ -129,7 +158,8 @@ public:
                        sharding_policy_t _sharding_policy,
                        const std::unordered_map<std::string,uint32_t>& _object_locations,
                        const std::string& _affinity_set_regex,
-                       bool _deleted):
+                       bool _deleted,
+                       const std::vector<std::string>& _range_split_points = {}):
 #ifdef ENABLE_EVALUATION
         message_id(0),
 #endif
@@ -143,7 +173,8 @@ public:
         sharding_policy(_sharding_policy),
         object_locations(_object_locations),
         affinity_set_regex(_affinity_set_regex),
-        deleted(_deleted) {
+        deleted(_deleted),
+        range_split_points(_range_split_points) {
             if (!check_pathname_format(_pathname)) {
                 throw derecho::derecho_exception("Invalid object pool pathname:" + _pathname);
             }
@@ -164,7 +195,8 @@ public:
         sharding_policy(other.sharding_policy),
         object_locations(other.object_locations),
         affinity_set_regex(other.affinity_set_regex),
-        deleted(other.deleted) {}
+        deleted(other.deleted),
+        range_split_points(other.range_split_points) {}
 
     // constructor 3: move constructor
     ObjectPoolMetadata(ObjectPoolMetadata&& other):
@@ -181,7 +213,8 @@ public:
         sharding_policy(other.sharding_policy),
         object_locations(std::move(other.object_locations)),
         affinity_set_regex(other.affinity_set_regex),
-        deleted(other.deleted) {}
+        deleted(other.deleted),
+        range_split_points(std::move(other.range_split_points)) {}
 
     void operator = (const ObjectPoolMetadata& other) {
 #ifdef ENABLE_EVALUATION
@@ -198,6 +231,7 @@ public:
         this->object_locations = other.object_locations;
         this->affinity_set_regex = other.affinity_set_regex;
         this->deleted = other.deleted;
+        this->range_split_points = other.range_split_points;
     }
 
 #ifdef ENABLE_EVALUATION
@@ -252,17 +286,20 @@ public:
                ((this->previous_version_by_key == persistent::INVALID_VERSION)?true:(this->previous_version_by_key >= prev_ver_by_key));
     }
 
-    virtual bool validate(const std::map<std::string,ObjectPoolMetadata<CascadeTypes...>>& kv_map) const override {
+    virtual bool validate(const ConcurrentOrderedMap<std::string,ObjectPoolMetadata<CascadeTypes...>>& kv_map) const override {
         auto components = str_tokenizer(pathname,true,PATH_SEPARATOR); // only check prefixes. It is valid to overwrite an existing one.
         std::string prefix;
         for (const auto& comp:components) {
             prefix = prefix + PATH_SEPARATOR + comp;
-            if (kv_map.find(prefix) != kv_map.end()) {
+            auto it = kv_map.find(prefix);
+            // removed entries do not count: their tombstones may or may not be reclaimed yet.
+            if (it != kv_map.end() && !it->second.is_null()) {
                 return false;
             }
         }
         for (const auto& oppn:kv_map) {
-            if (oppn.first.size() > pathname.size() && (oppn.first.compare(0,pathname.size(),pathname) == 0)) {
+            if (oppn.first.size() > pathname.size() && (oppn.first.compare(0,pathname.size(),pathname) == 0) &&
+                !oppn.second.is_null()) {
                 return false;
             }
         }
@@ -273,6 +310,7 @@ public:
      * Find the shard for an object: key_to_shard_index
      *
      * @tparam KeyType type of the key.
+     * @tparam AffinitySetType type of the affinity set, which is either KeyType or std::string_view.
      * @param  key
      * @param  affinity_set
      * @param  num_shards
@@ -280,8 +318,8 @@ public:
      *                                  process by disabling it by setting it to false.
      * @return shard index.
      */
-    template<typename KeyType>
-    inline uint32_t key_to_shard_index(const KeyType& key, const KeyType& affinity_set, uint32_t num_shards, bool check_object_locations = true) const {
+    template<typename KeyType, typename AffinitySetType = KeyType>
+    inline uint32_t key_to_shard_index(const KeyType& key, const AffinitySetType& affinity_set, uint32_t num_shards, bool check_object_locations = true) const {
         if constexpr (std::is_convertible_v<KeyType,std::string>) {
             if (check_object_locations) {
                 if (this->object_locations.find(key) != object_locations.end()) {
@@ -291,12 +329,27 @@ public:
             uint32_t shard_index = 0;
             switch (sharding_policy) {
             case HASH:
-                if (static_cast<std::string>(affinity_set).length() > 0) {
-                    shard_index = std::hash<std::string>{}(affinity_set) % num_shards;
+                // std::hash<std::string_view> agrees with std::hash<std::string> on the same characters.
+                if (std::string_view(affinity_set).length() > 0) {
+                    shard_index = std::hash<std::string_view>{}(std::string_view(affinity_set)) % num_shards;
                 } else {
                     shard_index = std::hash<std::string>{}(key) % num_shards;
                 }
                 break;
+            case JUMP_HASH:
+                if (std::string_view(affinity_set).length() > 0) {
+                    shard_index = jump_consistent_hash(xxhash64(std::string_view(affinity_set)),num_shards);
+                } else {
+                    shard_index = jump_consistent_hash(xxhash64(std::string_view(key)),num_shards);
+                }
+                break;
+            case RANGE:
+                if (std::string_view(affinity_set).length() > 0) {
+                    shard_index = range_owner(std::string_view(affinity_set),num_shards);
+                } else {
+                    shard_index = range_owner(std::string_view(key),num_shards);
+                }
+                break;
             default:
                 throw derecho::derecho_exception(std::string("Unknown sharding_policy:") + std::to_string(sharding_policy));
             }
@@ -306,6 +359,47 @@ public:
         }
     }
 
+    /**
+     * Find the shards that may hold the keys starting with a prefix: prefix_to_shard_range
+     * Under the RANGE policy, they are a contiguous run of shards. Under the HASH policy, they are all the shards.
+     * Please note that the affinity set is not considered: if the pool has an affinity set regex, the keys are placed
+     * by their affinity set strings, which may not share the prefix.
+     *
+     * @param  prefix
+     * @param  num_shards
+     * @return the first and the last shard index, both inclusive.
+     */
+    inline std::pair<uint32_t,uint32_t> prefix_to_shard_range(const std::string& prefix, uint32_t num_shards) const {
+        if (sharding_policy != RANGE || !affinity_set_regex.empty() || num_shards == 0) {
+            return {0,(num_shards == 0)?0:(num_shards - 1)};
+        }
+        // the keys with the prefix are in [prefix, successor), where successor is the smallest string greater than all
+        // strings with the prefix, or unbounded if the prefix is all 0xff.
+        uint32_t first = range_owner(prefix,num_shards);
+        std::string successor = prefix;
+        while (!successor.empty() && static_cast<uint8_t>(successor.back()) == 0xff) {
+            successor.pop_back();
+        }
+        if (successor.empty()) {
+            return {first,num_shards - 1};
+        }
+        successor.back() = static_cast<char>(static_cast<uint8_t>(successor.back()) + 1);
+        // the last shard owns the largest key less than successor.
+        auto it = std::lower_bound(range_split_points.cbegin(),range_split_points.cend(),successor);
+        uint32_t last = std::min(static_cast<uint32_t>(it - range_split_points.cbegin()),num_shards - 1);
+        return {first,std::max(first,last)};
+    }
+
+    /**
+     * Check if the split points are valid for the RANGE policy: check_range_split_points
+     *
+     * @return true if the split points are strictly increasing, otherwise false.
+     */
+    inline bool check_range_split_points() const {
+        return std::adjacent_find(range_split_points.cbegin(),range_split_points.cend(),
+                                  std::greater_equal<std::string>()) == range_split_points.cend();
+    }
+
     static std::string IK;
     static ObjectPoolMetadata<CascadeTypes...> IV;
 
@@ -331,6 +425,18 @@ public:
      * @return true for a valid format false for an invalid format.
      */
     static inline bool check_pathname_format(const std::string& pathname);
+
+private:
+    /**
+     * The RANGE policy: the shard owning an input is the number of split points not greater than it.
+     */
+    inline uint32_t range_owner(const std::string_view& input, uint32_t num_shards) const {
+        auto it = std::upper_bound(range_split_points.cbegin(),range_split_points.cend(),input,
+                                   [](const std::string_view& lhs, const std::string& rhs) {
+                                       return lhs < std::string_view(rhs);
+                                   });
+        return std::min(static_cast<uint32_t>(it - range_split_points.cbegin()),num_shards - 1);
+    }
 };
 
 template<typename... CascadeTypes>
@@ -351,7 +457,8 @@ ObjectPoolMetadata<CascadeTypes...> ObjectPoolMetadata<CascadeTypes...>::IV(
         HASH,                        // HASH
         {},                          // object_locations
         "",                          // affinity set regex
-        false);                      // deleted
+        false,                       // deleted
+        {});                         // range split points
 
 template<typename... CascadeTypes>
 const std::vector<std::type_index> ObjectPoolMetadata<CascadeTypes...>::subgroup_type_order{std::type_index(typeid(CascadeTypes))...};
@@ -397,6 +504,7 @@ inline std::ostream& operator<<(std::ostream& out, const ObjectPoolMetadata<Casc
             "\tsharding_policy:" << std::to_string(opm.sharding_policy) <<"\n" <<
             "\tobject_locations:[hidden]" << "\n" <<
             "\taffinity_set_regex:" << opm.affinity_set_regex << "\n" <<
+            "\trange_split_points:" << std::to_string(opm.range_split_points.size()) << " split points\n" <<
             "\tis_deleted:" << std::to_string(opm.deleted) <<
             std::endl;
     }
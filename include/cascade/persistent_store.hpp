@@ -8,14 +8,23 @@
 
 #include <atomic>
 #include <cstdint>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
 
 namespace derecho {
 namespace cascade {
 
+/** The number of updates between two kv_map snapshots of a persistent store. 0, the default, disables snapshots. */
+#define CASCADE_KV_MAP_SNAPSHOT_INTERVAL    "CASCADE/kv_map_snapshot_interval"
+/** The number of states rebuilt from the log that a persistent store keeps for the scans at old versions. */
+#define SCAN_VIEW_CACHE_CAPACITY            (2)
+
 /**
  * template for persistent cascade stores.
  *
@@ -30,7 +39,66 @@ class PersistentCascadeStore : public ICascadeStore<KT, VT, IK, IV>,
                                public derecho::GroupReference,
                                public derecho::NotificationSupport {
 private:
+    /** The number of updates between two kv_map snapshots, or 0 if snapshots are disabled. */
+    const uint64_t kv_map_snapshot_interval;
+    /** The kv_map snapshot file, given to the recovery of persistent_core. */
+    KVMapSnapshotContext kv_map_snapshot_context;
+    /** The number of updates since the last kv_map snapshot. Touched by the predicate thread only. */
+    uint64_t updates_since_kv_map_snapshot;
+    std::atomic<bool> kv_map_snapshot_in_progress;
+    std::thread kv_map_snapshot_thread;
+    /**
+     * Get the kv_map snapshot file of the store, or an empty string if snapshots are disabled.
+     */
+    static std::string get_kv_map_snapshot_filename(persistent::PersistentRegistry* pr, uint64_t snapshot_interval);
+    /**
+     * Count an update applied on the predicate thread, and start writing a kv_map snapshot in the background when
+     * the snapshot interval is reached and the last snapshot is done.
+     *
+     * @param[in]   ver     The version of the update.
+     */
+    void snapshot_kv_map(persistent::version_t ver);
     bool internal_ordered_put(const VT& value, bool as_trigger);
+    /**
+     * Find the latest version not later than a given time, from the in-memory time index if it covers the time, or
+     * from the log otherwise.
+     */
+    persistent::version_t get_version_at_time(const uint64_t& ts_us) const;
+    /**
+     * Binary-search the log between the first and the last versions of a time bucket for the latest version stamped
+     * not later than a given time. The first version must be stamped not later than the time, and the last version
+     * later than it.
+     *
+     * @param[in]   ts_us           The time in microseconds.
+     * @param[in]   bucket_first    The first version of the bucket.
+     * @param[in]   bucket_last     The last version of the bucket.
+     *
+     * @return The version, or INVALID_VERSION if the log holds a delta without objects in the range, whose timestamp
+     *         can not be told from the delta.
+     */
+    persistent::version_t get_version_in_time_bucket(const uint64_t& ts_us,
+                                                     const persistent::version_t& bucket_first,
+                                                     const persistent::version_t& bucket_last) const;
+    /**
+     * Test if a key missing from the version index at a version may have been removed after it, with the tombstone
+     * and the versions of the key reclaimed since. The caller has to look the key up in the state at the version then.
+     *
+     * @param[in]   ver     The version
+     */
+    bool may_be_reclaimed(const persistent::version_t& ver) const;
+    /**
+     * The states at the versions of the latest scans older than the reclaim distance, rebuilt from the log, with the
+     * most recently used first. The following pages of such a scan are read from the same state instead of rebuilding
+     * it for every page.
+     */
+    mutable std::list<std::pair<persistent::version_t, std::shared_ptr<const ConcurrentOrderedMap<KT, VT>>>> scan_views;
+    mutable std::mutex scan_views_mutex;
+    /**
+     * Get the state at a version for a scan or a stable multi_key_get, from scan_views, or rebuilt from the log.
+     *
+     * @param[in]   ver     The version
+     */
+    std::shared_ptr<const ConcurrentOrderedMap<KT, VT>> get_scan_view(const persistent::version_t& ver) const;
 
 public:
     using derecho::GroupReference::group;
@@ -43,16 +111,20 @@ public:
                                              P2P_TARGETS(
                                                      put,
                                                      put_and_forget,
+                                                     put_batch,
+                                                     put_batch_and_forget,
 #ifdef ENABLE_EVALUATION
                                                      perf_put,
 #endif  // ENABLE_EVALUATION
                                                      remove,
                                                      get,
+                                                     multi_key_get,
                                                      multi_get,
                                                      get_by_time,
                                                      multi_list_keys,
                                                      list_keys,
                                                      list_keys_by_time,
+                                                     scan,
                                                      multi_get_size,
                                                      get_size,
                                                      get_size_by_time,
@@ -69,6 +141,8 @@ public:
                                              ORDERED_TARGETS(
                                                      ordered_put,
                                                      ordered_put_and_forget,
+                                                     ordered_put_batch,
+                                                     ordered_put_batch_and_forget,
                                                      ordered_remove,
                                                      ordered_get,
                                                      ordered_list_keys,
@@ -87,21 +161,28 @@ public:
     virtual void trigger_put(const VT& value) const override;
     virtual version_tuple put(const VT& value, bool as_trigger) const override;
     virtual void put_and_forget(const VT& value, bool as_trigger) const override;
+    virtual version_tuple put_batch(const std::vector<VT>& values, bool as_trigger) const override;
+    virtual void put_batch_and_forget(const std::vector<VT>& values, bool as_trigger) const override;
 #ifdef ENABLE_EVALUATION
     virtual double perf_put(const uint32_t max_payload_size, const uint64_t duration_sec) const override;
 #endif  // ENABLE_EVALUATION
     virtual version_tuple remove(const KT& key) const override;
     virtual const VT get(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const override;
+    virtual std::vector<VT> multi_key_get(const std::vector<KT>& keys, const persistent::version_t& ver, const bool stable) const override;
     virtual const VT multi_get(const KT& key) const override;
     virtual const VT get_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const override;
     virtual std::vector<KT> multi_list_keys(const std::string& prefix) const override;
     virtual std::vector<KT> list_keys(const std::string& prefix, const persistent::version_t& ver, const bool stable) const override;
     virtual std::vector<KT> list_keys_by_time(const std::string& prefix, const uint64_t& ts_us, const bool stable) const override;
+    virtual scan_page_tuple<KT, VT> scan(const std::string& prefix, const persistent::version_t& ver, const bool stable,
+                                         const KT& cursor, const uint32_t& max_items, const uint64_t& max_bytes) const override;
     virtual uint64_t multi_get_size(const KT& key) const override;
     virtual uint64_t get_size(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const override;
     virtual uint64_t get_size_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const override;
     virtual version_tuple ordered_put(const VT& value, bool as_trigger) override;
     virtual void ordered_put_and_forget(const VT& value, bool as_trigger) override;
+    virtual version_tuple ordered_put_batch(const std::vector<VT>& values, bool as_trigger) override;
+    virtual void ordered_put_batch_and_forget(const std::vector<VT>& values, bool as_trigger) override;
     virtual version_tuple ordered_remove(const KT& key) override;
     virtual const VT ordered_get(const KT& key) override;
     virtual std::vector<KT> ordered_list_keys(const std::string& prefix) override;
@@ -19,9 +19,13 @@
 #include <derecho/core/notification.hpp>
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
 #include <derecho/persistent/PersistentInterface.hpp>
+#include <array>
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <random>
 #include <shared_mutex>
+#include <string_view>
 #include <typeinfo>
 #include <tuple>
 #include <derecho/utils/time.h>
@@ -29,6 +33,7 @@
 #include <condition_variable>
 #include <thread>
 #include <functional>
+#include <future>
 #include <iostream>
 #include <unordered_map>
 #include <unordered_set>
@@ -40,6 +45,13 @@
 #include "user_defined_logic_manager.hpp"
 #include "data_flow_graph.hpp"
 #include "detail/prefix_registry.hpp"
+#include "detail/object_pool_routing_table.hpp"
+#include "detail/affinity_set_matcher.hpp"
+#include "detail/client_read_cache.hpp"
+#include "detail/member_loads.hpp"
+#include "detail/write_coalescer.hpp"
+#include "detail/action_queue.hpp"
+#include "detail/work_stealing_scheduler.hpp"
 
 namespace derecho {
 namespace cascade {
@@ -79,6 +91,8 @@ namespace cascade {
         &ObjectPoolMetadata<CascadeTypes...>::IV,
         ST_FILE>;
 #define METADATA_SERVICE_SUBGROUP_INDEX (0)
+/* An external client subscribes to the object pool metadata deltas by a trigger_put of this key to the metadata service */
+#define METADATA_SERVICE_SUBSCRIPTION_KEY "/.cascade_metadata_subscription"
 
 
     /* The cascade context to be defined later */
@@ -115,6 +129,19 @@ namespace cascade {
                                  const std::unordered_map<std::string,bool>& outputs,
                                  ICascadeContext* ctxt,
                                  uint32_t worker_id) = 0;
+        /**
+         * The batch entry point, called with the actions a worker has collected for an observer registered with
+         * batching in the DFG. The actions are in the order they were posted. It has to be re-entrant/thread-safe.
+         * The default implementation calls operator() on each of them.
+         * @param[in] actions           The actions
+         * @param[in] num_actions       The number of actions
+         * @param[in] ctxt              The CascadeContext
+         * @param[in] worker_id         The off critical data path worker id.
+         */
+        virtual void handle_batch(const Action* actions,
+                                  const std::size_t num_actions,
+                                  ICascadeContext* ctxt,
+                                  uint32_t worker_id);
     };
     /**
      * Action is an command passed from the on critical data path logic (cascade watcher) to the off critical data path
@@ -123,23 +150,17 @@ namespace cascade {
      * !!! IMPORTANT NOTES ON "ACTION" DESIGN !!!
      * Action carries the key string, version, prefix handler (ocdpo_raw_ptr), and the object value so that the prefix
      * handler has all the information to process in the worker thread. It is important to avoid unnecessary copies
-     * because the object value is big sometime (for example, a high resolution video clip). Currently, we copied the
-     * value data into a new allocated memory buffer pointed by a unique pointer in the critical data path because the
-     * value in critical data path is in Derecho's managed RDMA buffer, which will not last beyond the lifetime of the
-     * critical data path. However, even this copy can be avoided using a lock-less design.
+     * because the object value is big sometime (for example, a high resolution video clip).
      *
-     * For example, we can pass the raw pointer to the value in VolatileCascadeStore or PersistentCascadeStore instead of
-     * allocating new memory and copying data. But the critical data path keeps updating the value (actually, the old
-     * value is removed from the map, and a new value is inserted). Dereferencing the raw pointer might crash with a
-     * segmentation fault if the pointed value is reclaimed. Moreover, using lock is not efficient at all because the
-     * off critical data path lock will block the critical data path, slowing down the whole system. An optimal solution
-     * to this issue is to
-     * 1) keep a short history of all the versions in VolatileCascadeStore or PersistentCascadeStore in std::vector<>;
-     * 2) enable concurrent access to the value. For example, we can allocate a lock for each of the slot of the history
-     * and pass it to the critical data path so that the worker thread can lock the corresponding slot when it is
-     * working on that. The number of slots in history should match the size of action buffer.
+     * The value in critical data path is in Derecho's managed RDMA buffer, which will not last beyond the lifetime of
+     * the critical data path. But VolatileCascadeStore and PersistentCascadeStore keep each value of their kv_map in a
+     * reference-counted box, so for an ordered put, the action shares the copy already held by the store (see
+     * CriticalDataPathObserver::observe_shared()). The critical data path keeps updating the value (actually, the old
+     * value is removed from the map, and a new value is inserted), but the shared handle keeps the old value alive until
+     * the last action holding it is done, without any lock between the critical data path and the workers. The value is
+     * immutable from then on, so the handle is to a const value.
      *
-     * This is a TODO work to be done later. So far, we stick to the extra copy for convenience.
+     * A trigger put has no store copy to share, so its value is still copied into a new allocated memory buffer.
      *
      */
 #define ACTION_BUFFER_ENTRY_SIZE    (256)
@@ -151,20 +172,23 @@ namespace cascade {
         uint32_t                        prefix_length;
         persistent::version_t           version;
         std::shared_ptr<OffCriticalDataPathObserver>   ocdpo_ptr;
-        std::shared_ptr<mutils::ByteRepresentable>     value_ptr;
-        std::unordered_map<std::string,bool>           outputs;
+        std::shared_ptr<const mutils::ByteRepresentable>   value_ptr;
+        /** the outputs, shared with the prefix registry instead of copied for every action */
+        std::shared_ptr<const std::unordered_map<std::string,bool>>   outputs;
+        DataFlowGraph::VertexBatching                  batching;
         /**
          * Move constructor
          * @param[in] other     The input Action object
          */
         Action(Action&& other):
             sender(other.sender),
-            key_string(other.key_string),
+            key_string(std::move(other.key_string)),
             prefix_length(other.prefix_length),
             version(other.version),
             ocdpo_ptr(std::move(other.ocdpo_ptr)),
             value_ptr(std::move(other.value_ptr)),
-            outputs(std::move(other.outputs)) {}
+            outputs(std::move(other.outputs)),
+            batching(other.batching) {}
         /**
          * Constructor
          * @param[in]   _sender
@@ -174,27 +198,38 @@ namespace cascade {
          * @param[in]   _ocdpo_ptr const reference rvalue
          * @param[in]   _value_ptr
          * @param[in]   _outputs
+         * @param[in]   _batching
          */
         Action(const node_id_t              _sender = INVALID_NODE_ID,
                const std::string&           _key_string = "",
                const uint32_t               _prefix_length = 0,
                const persistent::version_t& _version = CURRENT_VERSION,
                const std::shared_ptr<OffCriticalDataPathObserver>&  _ocdpo_ptr = nullptr,
-               const std::shared_ptr<mutils::ByteRepresentable>&    _value_ptr = nullptr,
-               const std::unordered_map<std::string,bool>           _outputs = {}):
+               const std::shared_ptr<const mutils::ByteRepresentable>&  _value_ptr = nullptr,
+               const std::shared_ptr<const std::unordered_map<std::string,bool>>&   _outputs = nullptr,
+               const DataFlowGraph::VertexBatching&                 _batching = {}):
             sender(_sender),
             key_string(_key_string),
             prefix_length(_prefix_length),
             version(_version),
             ocdpo_ptr(_ocdpo_ptr),
             value_ptr(_value_ptr),
-            outputs(_outputs) {}
+            outputs(_outputs),
+            batching(_batching) {}
         Action(const Action&) = delete; // disable copy constructor
         /**
          * Assignment operators
          */
         Action& operator = (Action&&) = default;
         Action& operator = (const Action&) = delete;
+        /**
+         * Get the outputs.
+         * @return the outputs, or an empty map if there is none.
+         */
+        inline const std::unordered_map<std::string,bool>& get_outputs() const {
+            static const std::unordered_map<std::string,bool> no_outputs;
+            return outputs ? *outputs : no_outputs;
+        }
         /**
          *  fire the action.
          *  @param[in] ctxt
@@ -207,7 +242,7 @@ namespace cascade {
                                      dynamic_cast<const IHasMessageID*>(value_ptr.get())->get_message_id(),
                                      0);
                 dbg_default_trace("In {}: [worker_id={}] action is fired.", __PRETTY_FUNCTION__, worker_id);
-                (*ocdpo_ptr)(sender,key_string,prefix_length,version,value_ptr.get(),outputs,ctxt,worker_id);
+                (*ocdpo_ptr)(sender,key_string,prefix_length,version,value_ptr.get(),get_outputs(),ctxt,worker_id);
             }
         }
         inline explicit operator bool() const {
@@ -215,6 +250,16 @@ namespace cascade {
         }
     };
 
+    inline void OffCriticalDataPathObserver::handle_batch(const Action* actions,
+                                                          const std::size_t num_actions,
+                                                          ICascadeContext* ctxt,
+                                                          uint32_t worker_id) {
+        for (std::size_t i = 0; i < num_actions; i++) {
+            (*this)(actions[i].sender,actions[i].key_string,actions[i].prefix_length,actions[i].version,
+                    actions[i].value_ptr.get(),actions[i].get_outputs(),ctxt,worker_id);
+        }
+    }
+
     inline std::ostream& operator << (std::ostream& out, const Action& action) {
         out << "Action:\n"
             << "\tsender = " << action.sender << "\n"
@@ -224,7 +269,7 @@ namespace cascade {
             << "\tocdpo_ptr = " << action.ocdpo_ptr.get() << "\n"
             << "\tvalue_ptr = " << action.value_ptr.get() << "\n"
             << "\toutput = ";
-        for (auto& output:action.outputs) {
+        for (auto& output:action.get_outputs()) {
             out << output.first << (output.second? "[*]":"") << ";";
         }
         out << std::endl;
@@ -333,10 +378,21 @@ namespace cascade {
         RoundRobin,     // use a member in round-robin order.
         KeyHashing,     // use the key's hashing
         UserSpecified,  // user specify which member to contact.
+        LeastOutstandingRequests,   // use the member with the fewest RPCs in flight from this client.
+        PowerOfTwoChoices,          // sample two members and use the one with the lower EWMA reply latency,
+                                    // weighted by its RPCs in flight from this client.
         InvalidPolicy = -1
     };
     #define DEFAULT_SHARD_MEMBER_SELECTION_POLICY (ShardMemberSelectionPolicy::RoundRobin)
 
+    /**
+     * @return true if the policy picks members by the load tracked by the client.
+     */
+    inline bool is_adaptive_member_selection_policy(ShardMemberSelectionPolicy policy) {
+        return policy == ShardMemberSelectionPolicy::LeastOutstandingRequests ||
+               policy == ShardMemberSelectionPolicy::PowerOfTwoChoices;
+    }
+
     std::ostream& operator<<(std::ostream& stream, const ShardMemberSelectionPolicy& policy);
 
     template <typename T> struct do_hash {};
@@ -378,6 +434,33 @@ namespace cascade {
             blob(_blob) {}
     };
 
+    /** The CascadeCacheInvalidationMessage type */
+#define CASCADE_CACHE_INVALIDATION_MESSAGE_TYPE   (0x100000001ull)
+    /**
+     * The key the clients trigger_put to a shard to subscribe to the invalidations of the objects in the shard, which
+     * the shard member receiving the subscription sends for every update or removal it applies.
+     */
+#define CACHE_INVALIDATION_SUBSCRIPTION_KEY "/.cascade_cache_subscription"
+    struct CascadeCacheInvalidationMessage: public mutils::ByteRepresentable {
+        /** The key updated or removed */
+        std::string key;
+        /** The new version of the key */
+        persistent::version_t version;
+
+        DEFAULT_SERIALIZATION_SUPPORT(CascadeCacheInvalidationMessage,key,version);
+
+        /** constructors */
+        CascadeCacheInvalidationMessage():
+            key(),
+            version(persistent::INVALID_VERSION) {}
+        CascadeCacheInvalidationMessage(const std::string& _key, const persistent::version_t& _version):
+            key(_key),
+            version(_version) {}
+    };
+
+    /** The cache invalidation handler type, called with the key and the new version */
+    using cascade_cache_invalidation_handler_t = std::function<void(const std::string&,const persistent::version_t&)>;
+
     /**
      * This is the structure for the server side notification handlers
      */
@@ -388,6 +471,8 @@ namespace cascade {
         // The handler for "" key is the default handler, which will always be triggered.
         std::unordered_map<std::string, std::optional<cascade_notification_handler_t>> object_pool_notification_handlers;
         mutable std::unique_ptr<std::mutex> object_pool_notification_handlers_mutex;
+        // The handler of the cache invalidation messages, set by the client read cache.
+        std::optional<cascade_cache_invalidation_handler_t> cache_invalidation_handler;
 
         SubgroupNotificationHandler():
             object_pool_notification_handlers_mutex(std::make_unique<std::mutex>()) {}
@@ -407,6 +492,16 @@ namespace cascade {
         inline void operator ()(const derecho::NotificationMessage& msg) {
             dbg_default_trace("SubgroupNotificationHandler(this={:x}) is triggered with message_type={:x}, size={} bytes",
                     reinterpret_cast<uint64_t>(this),msg.message_type, msg.size);
+            if (msg.message_type == CASCADE_CACHE_INVALIDATION_MESSAGE_TYPE) {
+                mutils::deserialize_and_run(nullptr, msg.body,
+                        [this](const CascadeCacheInvalidationMessage& invalidation)->void {
+                            std::lock_guard<std::mutex> lck(*object_pool_notification_handlers_mutex);
+                            if (cache_invalidation_handler.has_value()) {
+                                (*cache_invalidation_handler)(invalidation.key,invalidation.version);
+                            }
+                        });
+                return;
+            }
             if (msg.message_type != CASCADE_NOTIFICATION_MESSAGE_TYPE) {
                 return;
             }
@@ -437,6 +532,9 @@ namespace cascade {
     template <typename SubgroupType>
     using per_type_notification_handler_registry_t =
         std::unordered_map<uint32_t,SubgroupNotificationHandler<SubgroupType>>;
+
+    template <typename SubgroupType>
+    using per_type_write_coalescer_t = std::unique_ptr<WriteCoalescer<typename SubgroupType::ObjectType>>;
     /**
      * The ServiceClient template class contains all APIs needed to read/write data. The four core APIs are put, remove,
      * get, and get_by_time. We also provide a set of helper APIs for the client to get the group topology. The core APIs
@@ -449,10 +547,263 @@ namespace cascade {
     private:
         // default caller as an external client.
         std::unique_ptr<derecho::ExternalGroupClient<CascadeMetadataService<CascadeTypes...>,CascadeTypes...>> external_group_ptr;
-        mutable std::mutex external_group_ptr_mutex;
         // caller as a group member.
         derecho::Group<CascadeMetadataService<CascadeTypes...>, CascadeTypes...>* group_ptr;
-        mutable std::mutex group_ptr_mutex;
+        /**
+         * A send context serializes the threads building RPC messages into the same send buffer. There is no lock for
+         * all senders: a P2P send takes the context of its destination node, and an ordered send takes the context of
+         * its subgroup, so that the threads sending to different nodes or subgroups do not wait for each other. The
+         * contexts are striped over fixed arrays, which are never resized and hence need no lock to look up.
+         */
+        struct alignas(64) send_context_t {
+            std::mutex mutex;
+        };
+        static constexpr uint32_t num_send_contexts = 64;
+        mutable std::array<send_context_t,num_send_contexts> p2p_send_contexts;
+        mutable std::array<send_context_t,num_send_contexts> ordered_send_contexts;
+        /**
+         * Get the send context lock of a destination node for P2P sends.
+         * @param[in] node_id
+         */
+        std::mutex& p2p_send_mutex(node_id_t node_id) const;
+        /**
+         * Get the send context lock of a subgroup for ordered sends.
+         * @param[in] subgroup_index
+         */
+        template <typename SubgroupType>
+        std::mutex& ordered_send_mutex(uint32_t subgroup_index) const;
+        /**
+         * The positions of the RoundRobin member selection policy, striped by shard like the send contexts, so that
+         * picking a member does not update the shared policy map.
+         */
+        struct alignas(64) round_robin_position_t {
+            std::atomic<uint32_t> position{0};
+        };
+        mutable std::array<round_robin_position_t,num_send_contexts> round_robin_positions;
+        /**
+         * The loads of the shard members as seen by this client, which drive the adaptive member selection policies
+         * (LeastOutstandingRequests and PowerOfTwoChoices).
+         */
+        mutable MemberLoads member_loads;
+        /** The number of shards with an adaptive member selection policy, to skip tracking when there is none. */
+        std::atomic<uint32_t> num_adaptive_policies{0};
+        /**
+         * Test if the replies from a shard are tracked, which is the case if its member selection policy is adaptive.
+         *
+         * @tparam SubgroupType
+         * @param[in] subgroup_index
+         * @param[in] shard_index
+         */
+        template <typename SubgroupType>
+        bool is_tracking_replies(uint32_t subgroup_index, uint32_t shard_index);
+        /**
+         * Track the replies of an RPC sent to a shard member with an adaptive member selection policy with
+         * MemberLoads::track(): count the RPC as outstanding until its reply arrives, and feed the reply latency to the
+         * moving average then, whether or not the caller has consumed the reply yet. Other policies get the results back
+         * untouched.
+         *
+         * @tparam SubgroupType
+         * @tparam ReturnType           The return type of the RPC.
+         * @param[in] subgroup_index
+         * @param[in] shard_index
+         * @param[in] node_id           The member the RPC is sent to.
+         * @param[in] results           The results of the RPC.
+         *
+         * @return the results to hand to the caller.
+         */
+        template <typename SubgroupType, typename ReturnType>
+        derecho::rpc::QueryResults<ReturnType> track_replies(uint32_t subgroup_index, uint32_t shard_index,
+                                                             node_id_t node_id,
+                                                             derecho::rpc::QueryResults<ReturnType>&& results);
+        /**
+         * Read hedging: a current-version get, get_size, or list_keys sent to a remote shard member is duplicated to a
+         * second member if its reply takes longer than 'read_hedging_delay_ns', and the first reply wins. The delay
+         * follows a percentile of the recent read latencies, which are counted in a log-scale histogram with four
+         * buckets per octave; the histogram is halved every time the delay is refreshed, so old samples fade out.
+         */
+        static constexpr uint32_t num_read_latency_buckets = 256;
+        static constexpr uint32_t read_latency_samples_per_refresh = 256;
+        std::atomic<bool> read_hedging_enabled{false};
+        std::atomic<double> read_hedging_percentile{0.95};
+        std::atomic<uint64_t> read_hedging_min_delay_ns{0};
+        std::atomic<uint64_t> read_hedging_delay_ns{0};
+        mutable std::array<std::atomic<uint32_t>,num_read_latency_buckets> read_latency_histogram{};
+        std::atomic<uint32_t> num_read_latency_samples{0};
+        std::atomic<uint64_t> num_hedgeable_reads{0};
+        std::atomic<uint64_t> num_hedged_reads{0};
+        std::atomic<uint64_t> num_hedge_wins{0};
+        /**
+         * Record the latency of a hedgeable read, and refresh the hedging delay every
+         * 'read_latency_samples_per_refresh' samples.
+         * @param[in] latency_ns
+         */
+        void record_read_latency(uint64_t latency_ns);
+        /**
+         * Pick the member for the duplicate of a hedged read with pick_member_by_policy, or the member next to the
+         * first one if the policy picks the same member again.
+         *
+         * @tparam SubgroupType
+         * @tparam KeyTypeForHashing
+         * @param[in] subgroup_index
+         * @param[in] shard_index
+         * @param[in] key_for_hashing
+         * @param[in] first_node_id     The member the read was sent to first.
+         *
+         * @return the member, or INVALID_NODE_ID if the shard has no other member.
+         */
+        template <typename SubgroupType, typename KeyTypeForHashing>
+        node_id_t pick_hedge_member(uint32_t subgroup_index, uint32_t shard_index,
+                                    const KeyTypeForHashing& key_for_hashing, node_id_t first_node_id);
+        /**
+         * Send a read to a shard member, and hedge it. The reply is handed to the caller through
+         * a deferred future, which waits for the first reply up to the hedging delay, sends the duplicate, and then
+         * returns whichever reply comes first. If one of them fails, the other one is used. The hedging happens in the
+         * thread waiting for the reply, so a caller that waits late hedges late. Once a read is hedged, a thread waits
+         * for each of the two replies, so that the losing reply is accounted for when it arrives, too: like
+         * track_replies(), both the read and its duplicate count towards the loads of their members, and the latencies
+         * of both replies are recorded for the hedging delay.
+         *
+         * @tparam SubgroupType
+         * @tparam ReturnType           The return type of the RPC.
+         * @tparam KeyTypeForHashing
+         * @param[in] subgroup_index
+         * @param[in] shard_index
+         * @param[in] key_for_hashing   The key to pick the second member.
+         * @param[in] node_id           The member to send the read to first.
+         * @param[in] send              Sends the read to a given member under the p2p send mutex of that member.
+         *
+         * @return the results of the read.
+         */
+        template <typename SubgroupType, typename ReturnType, typename KeyTypeForHashing>
+        derecho::rpc::QueryResults<ReturnType> hedge_read(
+                uint32_t subgroup_index, uint32_t shard_index, const KeyTypeForHashing& key_for_hashing,
+                node_id_t node_id, const std::function<derecho::rpc::QueryResults<ReturnType>(node_id_t)>& send);
+        /**
+         * The client read cache, or nullptr if it is disabled. It is swapped with std::atomic_load/std::atomic_store, so
+         * that a read keeps the cache it started with.
+         */
+        using read_cache_object_t = typename std::tuple_element_t<0,std::tuple<CascadeTypes...>>::ObjectType;
+        std::shared_ptr<ClientReadCache<read_cache_object_t>> read_cache;
+        /** The subscription of this client to the cache invalidations of a shard. */
+        struct read_cache_subscription_t {
+            /** The shard members subscribed to. */
+            std::unordered_set<node_id_t> members;
+            /** When the subscription was last renewed, in microseconds. */
+            uint64_t renewed_us = 0;
+            /** True while a read renews the subscription. */
+            bool renewing = false;
+        };
+        /** The shards this client has subscribed to the cache invalidations of. */
+        std::unordered_map<std::tuple<std::type_index,uint32_t,uint32_t>,read_cache_subscription_t,
+            do_hash<std::tuple<std::type_index,uint32_t,uint32_t>>> read_cache_subscriptions;
+        std::shared_mutex read_cache_subscriptions_mutex;
+        /** Only the subgroups of the cached object type with string keys are cached. */
+        template <typename SubgroupType>
+        static constexpr bool is_read_cacheable =
+            std::is_same_v<typename SubgroupType::ObjectType,read_cache_object_t> &&
+            std::is_convertible_v<typename SubgroupType::KeyType,std::string>;
+        /**
+         * @return the owner tag of the objects of a subgroup in the read cache.
+         */
+        template <typename SubgroupType>
+        uint64_t read_cache_owner(uint32_t subgroup_index) const;
+        /**
+         * Get the read cache serving the reads from a shard, and tracking the writes of this client to it. The reads
+         * of a shard member from its own shard are local, so they bypass the cache.
+         *
+         * @param[in] subgroup_index
+         * @param[in] shard_index
+         *
+         * @return the read cache, or nullptr if the shard is not cached.
+         */
+        template <typename SubgroupType>
+        std::shared_ptr<ClientReadCache<read_cache_object_t>> read_cache_of(uint32_t subgroup_index, uint32_t shard_index);
+        /**
+         * Subscribe to the cache invalidations of a shard with all of its members. The first call waits for the
+         * members to register the subscription, so that the invalidations of the writes after a read are not missed.
+         * The subscription is renewed with the current members once it is older than the renewal interval, so that
+         * the members that joined since, and the members that dropped this client after failing to reach it, send
+         * the invalidations again. A renewal does not hold up the other reads.
+         *
+         * @param[in] subgroup_index
+         * @param[in] shard_index
+         * @param[in] renewal_interval_us   The renewal interval in microseconds, which is the staleness bound of the
+         *                                  read cache, so that a lost subscription costs no more than the bound.
+         *
+         * @return true if this client is subscribed, false if the subscription failed.
+         */
+        template <typename SubgroupType>
+        bool subscribe_cache_invalidation(uint32_t subgroup_index, uint32_t shard_index, uint64_t renewal_interval_us);
+        /**
+         * Fill the reply of a get into the read cache when the caller consumes it.
+         *
+         * @param[in] cache     The read cache.
+         * @param[in] owner     The owner tag of the subgroup.
+         * @param[in] key       The key.
+         * @param[in] version   The version requested.
+         * @param[in] stable    If the read is stable.
+         * @param[in] stamp     The invalidation stamp of the key taken before the get is sent.
+         * @param[in] results   The results of the get.
+         *
+         * @return the results to hand to the caller.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> fill_read_cache(
+                const std::shared_ptr<ClientReadCache<read_cache_object_t>>& cache, uint64_t owner,
+                const std::string& key, const persistent::version_t& version, bool stable, uint64_t stamp,
+                derecho::rpc::QueryResults<const typename SubgroupType::ObjectType>&& results);
+        /**
+         * Tell the read cache the versions of this client's writes when the caller consumes their replies. The writes
+         * must have been started with ClientReadCache::begin_write().
+         *
+         * @param[in] cache     The read cache.
+         * @param[in] keys      The keys written.
+         * @param[in] results   The results of the write.
+         *
+         * @return the results to hand to the caller.
+         */
+        derecho::rpc::QueryResults<version_tuple> end_cached_writes(
+                const std::shared_ptr<ClientReadCache<read_cache_object_t>>& cache, std::vector<std::string>&& keys,
+                derecho::rpc::QueryResults<version_tuple>&& results);
+        /**
+         * The write coalescers of put_and_forget, one per subgroup type, used while 'write_coalescing_enabled' is set.
+         */
+        mutils::KindMap<per_type_write_coalescer_t,CascadeTypes...> write_coalescers;
+        std::atomic<bool> write_coalescing_enabled{false};
+        /**
+         * Create the write coalescer of a subgroup type.
+         */
+        template <typename SubgroupType>
+        void create_write_coalescer();
+        /**
+         * Pick the shard member the coalesced writes of this client to a shard are sent to. The member is fixed for a
+         * given membership, so that the batches reach the shard in order; a user specified member is respected.
+         *
+         * @param[in] subgroup_index
+         * @param[in] shard_index
+         *
+         * @return the node id of the member.
+         */
+        template <typename SubgroupType>
+        node_id_t pick_coalescing_member(uint32_t subgroup_index, uint32_t shard_index);
+        /**
+         * Send a batch of coalesced writes to a shard with put_batch_and_forget, which applies the objects in order,
+         * repeated keys included, and sends no reply.
+         *
+         * @param[in] subgroup_index
+         * @param[in] shard_index
+         * @param[in] objects
+         * @param[in] as_trigger
+         */
+        template <typename SubgroupType>
+        void send_coalesced_writes(uint32_t subgroup_index, uint32_t shard_index,
+                                   const std::vector<typename SubgroupType::ObjectType>& objects, bool as_trigger);
+        /**
+         * Create the callers of all subgroups of a type, since ExternalGroupClient creates them on first use, which
+         * is not safe for concurrent senders.
+         */
+        template <typename SubgroupType>
+        void create_external_callers();
         // cascade server side notification handler registry.
         mutable mutils::KindMap<per_type_notification_handler_registry_t,CascadeTypes...> notification_handler_registry;
         mutable std::mutex notification_handler_registry_mutex;
@@ -485,7 +836,7 @@ namespace cascade {
          * object access process. If an object pool does not exists, it will be loaded from metadata service.
          *
          * Each entry of the object_pool_info_cache is an object of type ObjectPoolMetadataCacheEntry. Such an object
-         * caches an object pool metadata object (opm) along with the affinity set regex processing data structures.
+         * interns an object pool metadata object (opm), which the routing structures point to.
          */
         class ObjectPoolMetadataCacheEntry {
         public:
@@ -495,30 +846,104 @@ namespace cascade {
              * @param[in] _opm object pool metadata
              */
             ObjectPoolMetadataCacheEntry(const ObjectPoolMetadata<CascadeTypes...>& _opm);
+        };
+
+        std::unordered_map<
+            std::string,
+            std::shared_ptr<ObjectPoolMetadataCacheEntry>> object_pool_metadata_cache;
+        mutable std::shared_mutex object_pool_metadata_cache_mutex;
 
+        /**
+         * 'ObjectPoolRouter' is an immutable snapshot of object_pool_metadata_cache for routing keys: a trie resolving
+         * a key to its object pool, and the affinity set regexes of all the object pools compiled into one Hyperscan
+         * database.
+         */
+        class ObjectPoolRouter {
+        public:
+            ObjectPoolRoutingTable<ObjectPoolMetadataCacheEntry> routing_table;
+            AffinitySetMatcher<ObjectPoolMetadataCacheEntry> affinity_set_matcher;
             /**
-             * The destructor
+             * The constructor
+             * @param[in] cache     the object pool metadata cache to snapshot.
              */
-            virtual ~ObjectPoolMetadataCacheEntry();
+            ObjectPoolRouter(const std::unordered_map<std::string,std::shared_ptr<ObjectPoolMetadataCacheEntry>>& cache);
 
             /**
-             * Convert a key string to corresponding affinity set string.
+             * Convert a key string to corresponding affinity set string without copying it.
+             * @param[in] entry         the object pool of the key, which must be in this snapshot.
              * @param[in] key_string
              *
-             * @return affinity set string
+             * @return a view of the affinity set inside key_string
              */
-            inline std::string to_affinity_set(const std::string& key_string);
-        private:
-            /* the database storing compiled regex */
-            hs_database_t*                      database;
-            /* the scratch for the regex */
-            thread_local static hs_scratch_t*   scratch;
+            inline std::string_view to_affinity_set_view(const ObjectPoolMetadataCacheEntry* entry, const std::string& key_string) const;
         };
 
-        std::unordered_map<
-            std::string,
-            ObjectPoolMetadataCacheEntry> object_pool_metadata_cache;
-        mutable std::shared_mutex object_pool_metadata_cache_mutex;
+        /**
+         * 'object_pool_router' is built from object_pool_metadata_cache, which key_to_shard() uses to route a key
+         * without allocation or locking. Every change to object_pool_metadata_cache publishes a new router. Readers
+         * access the router inside an EpochGuard; the replaced routers wait in 'retired_object_pool_routers' until no
+         * reader can see them. Both the publication and the reclamation happen with object_pool_metadata_cache_mutex
+         * held exclusively, so a reader holding the shared lock sees the router of the current cache.
+         */
+        std::atomic<ObjectPoolRouter*> object_pool_router{nullptr};
+        std::vector<std::pair<uint64_t,ObjectPoolRouter*>> retired_object_pool_routers;
+
+        /**
+         * Build a router from object_pool_metadata_cache and publish it. The caller must hold
+         * object_pool_metadata_cache_mutex exclusively.
+         */
+        void publish_object_pool_router();
+
+        /**
+         * Cache misses are coalesced ('single-flight') so that a burst of lookups for a missing object pool costs one
+         * round trip to the metadata service:
+         * - 'object_pool_metadata_refresh_seq' is incremented when a full refresh starts and when it ends, both under
+         *   'object_pool_metadata_refresh_mutex'. A caller is served by any refresh starting after its call.
+         * - 'object_pool_metadata_fetches' maps a missing pathname to the fetch in flight for it.
+         * Only the first miss does a full refresh. A failed refresh reverts its start, so that the callers waiting for
+         * it refresh again instead of returning with nothing loaded. An external client subscribes to the metadata
+         * deltas pushed by the metadata service before every refresh and fetch, and later misses fetch only the object
+         * pools on the missing path.
+         */
+        std::mutex object_pool_metadata_refresh_mutex;
+        std::atomic<uint64_t> object_pool_metadata_refresh_seq{0};
+        std::mutex object_pool_metadata_fetches_mutex;
+        std::unordered_map<std::string,std::shared_future<void>> object_pool_metadata_fetches;
+        std::once_flag object_pool_metadata_subscription_flag;
+        /** The metadata service members this client is subscribed to, by shard. */
+        std::vector<std::unordered_set<node_id_t>> object_pool_metadata_subscriptions;
+        std::mutex object_pool_metadata_subscriptions_mutex;
+
+        /**
+         * Register the metadata delta handler once, and subscribe to the metadata deltas with every member of each
+         * metadata service shard this client is not subscribed to. A member only pushes the deltas applied while the
+         * client is subscribed to it, and it unsubscribes a client it fails to reach, so the subscriptions are renewed
+         * before every metadata refresh and fetch: the members that joined after a view change are subscribed, and
+         * with 'renew_all', the others are subscribed again, too. A member that cannot be subscribed to is tried again
+         * the next time. For external clients only.
+         *
+         * @param[in] renew_all         Subscribe again to the members this client is subscribed to already.
+         */
+        void subscribe_object_pool_metadata(bool renew_all);
+
+        /**
+         * Fetch the object pools on the path of a pathname from the metadata service and apply them to the cache.
+         * Concurrent fetches of the same pathname are coalesced.
+         *
+         * @param[in] pathname          The missing object pool pathname.
+         */
+        void fetch_object_pool_metadata(const std::string& pathname);
+
+        /**
+         * Apply a versioned object pool metadata delta to object_pool_metadata_cache. A null metadata object removes
+         * the object pool. A delta not newer than the cached entry is ignored. The caller must hold
+         * object_pool_metadata_cache_mutex exclusively, and publish the router afterwards.
+         *
+         * @param[in] opm               The object pool metadata.
+         *
+         * @return true if the cache is changed.
+         */
+        bool apply_object_pool_metadata(const ObjectPoolMetadata<CascadeTypes...>& opm);
 
         /**
          * Pick a member by a given a policy.
@@ -558,6 +983,11 @@ namespace cascade {
         ServiceClient(derecho::Group<CascadeMetadataService<CascadeTypes...>, CascadeTypes...>* _group_ptr=nullptr);
 
     public:
+        /**
+         * The destructor
+         */
+        ~ServiceClient();
+
         /**
          * ServiceClient can be an external client or a cascade server. is_external_client() test this condition.
          * The external client implementation is based on ExternalGroupClient<> while the cascade node implementation is
@@ -684,6 +1114,86 @@ namespace cascade {
         std::tuple<ShardMemberSelectionPolicy,node_id_t> get_member_selection_policy(
                 uint32_t subgroup_index, uint32_t shard_index) const;
 
+        /**
+         * Enable hedged reads. A current-version get, get_size, or list_keys to a remote shard member is duplicated to
+         * a second member of the shard when its reply is slower than the given percentile of the recent read latencies,
+         * and the first reply is returned. Both the read and its duplicate count towards the loads of their members in
+         * the adaptive member selection policies, and the latencies of both replies feed the hedging delay.
+         *
+         * @param[in] delay_percentile  The percentile of the read latency to wait before hedging, in (0,1).
+         * @param[in] min_delay_us      The lower bound of the hedging delay in microseconds.
+         */
+        void enable_read_hedging(double delay_percentile = 0.95, uint64_t min_delay_us = 100);
+
+        /**
+         * Disable hedged reads.
+         */
+        void disable_read_hedging();
+
+        /**
+         * Reads the hedged read counters.
+         *
+         * @return a 4-tuple of the number of hedgeable reads, the number of hedged reads, the number of reads won by
+         *         the duplicate, and the current hedging delay in nanoseconds.
+         */
+        std::tuple<uint64_t,uint64_t,uint64_t,uint64_t> get_read_hedging_stats() const;
+
+        /**
+         * Enable write coalescing for put_and_forget. The objects written to a shard are buffered, and sent as one
+         * put_batch_and_forget when the buffer reaches 'max_batch_objects' objects or 'max_batch_bytes' bytes, or when
+         * its oldest object has waited for 'linger_us' microseconds. The shard applies the objects of a batch in order,
+         * each on its own like put_and_forget, so the put_and_forget writes of this client to a key reach the shard in
+         * order, and a rejected write does not drop the others. The ordering only covers the coalesced put_and_forget
+         * writes: put, trigger_put, remove, and put_batch bypass the buffers, so they can reach the shard before the
+         * coalesced writes issued before them, and not even flush() orders the buffered writes before a later write,
+         * since a batch is not acknowledged; disable write coalescing while mixing the two. If the thresholds are
+         * changed, they apply to the following writes.
+         *
+         * @param[in] max_batch_objects The object count threshold.
+         * @param[in] max_batch_bytes   The byte size threshold.
+         * @param[in] linger_us         The linger timeout in microseconds.
+         */
+        void enable_write_coalescing(std::size_t max_batch_objects = 1024,
+                                     std::size_t max_batch_bytes = 1024*1024,
+                                     uint64_t linger_us = 20);
+
+        /**
+         * Disable write coalescing for put_and_forget, and flush the buffered objects.
+         */
+        void disable_write_coalescing();
+
+        /**
+         * Send the objects buffered by write coalescing right away.
+         */
+        void flush();
+
+        /**
+         * Enable the client read cache, replacing the current one if any. Objects read at a given version are cached
+         * until evicted. Objects read at CURRENT_VERSION are served to later current-version reads until they are
+         * invalidated by this client's writes, by the invalidations an external client subscribes to from the shards it
+         * reads, or by the staleness bound. The invalidations are best effort: a client subscribes to one member of a
+         * shard, once, and the member unsubscribes a client it fails to reach, so after a view change or a failed send
+         * the staleness bound is what keeps the cache fresh. Shard members do not receive invalidations at all.
+         *
+         * @param[in] capacity_bytes    The byte budget of the cached objects.
+         * @param[in] max_staleness_us  How long a cached current version is served, which must be positive.
+         *
+         * @throws derecho::derecho_exception if the capacity or the staleness bound is 0.
+         */
+        void enable_read_cache(std::size_t capacity_bytes, uint64_t max_staleness_us);
+
+        /**
+         * Disable the client read cache and drop the cached objects.
+         */
+        void disable_read_cache();
+
+        /**
+         * Reads the read cache counters.
+         *
+         * @return the counters, which are all zero if the cache is disabled.
+         */
+        typename ClientReadCache<read_cache_object_t>::stats_t get_read_cache_stats() const;
+
         /**
          * "put" writes an object to a given subgroup/shard.
          *
@@ -766,6 +1276,9 @@ namespace cascade {
          * @param[in] shard_index       the shard index.
          * @param[in] as_trigger        If true, the object will NOT apply to the K/V store. The object will only be
          *                              used to update the state.
+         *
+         * With write coalescing enabled, the object is buffered, and is not ordered with the other writes of this
+         * client to the shard; see enable_write_coalescing().
          */
         template <typename SubgroupType>
         void put_and_forget(const typename SubgroupType::ObjectType& object,
@@ -808,6 +1321,67 @@ namespace cascade {
         template <typename ObjectType>
         void put_and_forget(const ObjectType& object, bool as_trigger = false);
 
+        /**
+         * "put_batch" writes a batch of objects to a given subgroup/shard atomically. The shard applies all objects
+         * under one version, in one delta, or rejects the whole batch if any object fails the validation or the
+         * previous version verification. The keys in a batch must be distinct.
+         *
+         * @param[in] objects           the objects to write, all of which must belong to the given shard. Each of them
+         *                              carries its own previous versions for verification, like in "put".
+         * @param[in] subgroup_index    the subgroup index of CascadeType
+         * @param[in] shard_index       the shard index.
+         * @param[in] as_trigger        If true, the objects will NOT apply to the K/V store.
+         *
+         * @return a future to the version and timestamp shared by all objects in the batch. The version is
+         *         INVALID_VERSION if the batch is rejected.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<version_tuple> put_batch(const std::vector<typename SubgroupType::ObjectType>& objects,
+                uint32_t subgroup_index, uint32_t shard_index, bool as_trigger = false);
+
+    protected:
+        /**
+         * "type_recursive_put_batch" is a helper function for internal use only.
+         * @param[in]   type_index  the index of the subgroup type in the CascadeTypes... list. And the FirstType,
+         *                          SecondType, ..., RestTypes should be in the same order.
+         * @param[in]   objects     the objects to write
+         * @param[in]   subgroup_index
+         *                          the subgroup index in the subgroup type designated by type_index
+         * @param[in]   shard_index the shard index
+         * @param[in]   as_trigger  If true, the objects will NOT apply to the K/V store.
+         *
+         * @return a future to the version and timestamp of the batch.
+         */
+        template <typename ObjectType, typename FirstType, typename SecondType, typename... RestTypes>
+        derecho::rpc::QueryResults<version_tuple> type_recursive_put_batch(
+                uint32_t type_index,
+                const std::vector<ObjectType>& objects,
+                uint32_t subgroup_index,
+                uint32_t shard_index,
+                bool as_trigger = false);
+
+        template <typename ObjectType, typename LastType>
+        derecho::rpc::QueryResults<version_tuple> type_recursive_put_batch(
+                uint32_t type_index,
+                const std::vector<ObjectType>& objects,
+                uint32_t subgroup_index,
+                uint32_t shard_index,
+                bool as_trigger = false);
+    public:
+        /**
+         * object pool version of "put_batch"
+         * The objects are grouped by the shards their keys map to, and each group is sent to its shard as one batch.
+         * A batch spanning several shards is atomic in each shard, but not across the shards.
+         *
+         * @param[in] objects       the objects to write, the object pools are extracted from the object keys.
+         * @param[in] as_trigger    If true, the objects will NOT apply to the K/V store.
+         *
+         * @return a vector of futures, one for each shard the objects are written to.
+         */
+        template <typename ObjectType>
+        std::vector<std::unique_ptr<derecho::rpc::QueryResults<version_tuple>>> put_batch(
+                const std::vector<ObjectType>& objects, bool as_trigger = false);
+
         /**
          * "trigger_put" writes an object to a given subgroup/shard.
          *
@@ -932,7 +1506,8 @@ namespace cascade {
          * @param[in] subgroup_index    the subgroup index of CascadeType
          * @param[in] shard_index       the shard index.
          *
-         * @return a future to the retrieved object.
+         * @return a future to the retrieved object. If the client read cache is enabled, a remote read may be answered
+         *         from the cache, by this node.
          * TODO: check if the user application is responsible for reclaim the future by reading it sometime.
          */
         template <typename SubgroupType>
@@ -943,6 +1518,17 @@ namespace cascade {
                 uint32_t subgroup_index = 0,
                 uint32_t shard_index = 0);
     protected:
+        /**
+         * "get_from_shard" reads the object of a given key from the shard, bypassing the client read cache. The
+         * arguments are the same as "get".
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> get_from_shard(
+                const typename SubgroupType::KeyType& key,
+                const persistent::version_t& version,
+                bool stable,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
         /**
          * "type_recursive_get" is a helper function for internal use only.
          * @param[in] type_index        the index of the subgroup type in the CascadeTypes... list. and the FirstType,
@@ -993,6 +1579,74 @@ namespace cascade {
                 const persistent::version_t& version = CURRENT_VERSION,
                 bool stable = true);
 
+        /**
+         * "multi_key_get" retrieves the objects of a list of keys in a shard with one request.
+         *
+         * @param[in] keys              the object keys, which must belong to the shard.
+         * @param[in] version           the version of the objects to read, see "get".
+         * @param[in] stable            see "get".
+         * @param[in] subgroup_index    the subgroup index of CascadeType
+         * @param[in] shard_index       the shard index.
+         *
+         * @return a future to the retrieved objects, in the order of the keys. An invalid object is returned for a
+         *         key that is not found.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<std::vector<typename SubgroupType::ObjectType>> multi_key_get(
+                const std::vector<typename SubgroupType::KeyType>& keys,
+                const persistent::version_t& version = CURRENT_VERSION,
+                bool stable = true,
+                uint32_t subgroup_index = 0,
+                uint32_t shard_index = 0);
+    protected:
+        /**
+         * "type_recursive_multi_key_get" is a helper function for internal use only.
+         * @param[in] type_index        the index of the subgroup type in the CascadeTypes... list. and the FirstType,
+         *                          SecondType, .../ RestTypes should be in the same order.
+         * @param[in] keys              the keys
+         * @param[in] version           the version
+         * @param[in] stable            stable or not?
+         * @param[in] subgroup_index    the subgroup index in the subgroup type designated by type_index
+         * @param[in] shard_index       the shard index
+         *
+         * @return a future for the objects.
+         */
+        template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
+        auto type_recursive_multi_key_get(
+                uint32_t type_index,
+                const std::vector<KeyType>& keys,
+                const persistent::version_t& version,
+                bool stable,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+
+        template <typename KeyType, typename LastType>
+        auto type_recursive_multi_key_get(
+                uint32_t type_index,
+                const std::vector<KeyType>& keys,
+                const persistent::version_t& version,
+                bool stable,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+    public:
+        /**
+         * object pool version of "multi_key_get"
+         * The keys are grouped by the shards they map to, one request is sent to each of the shards concurrently, and
+         * the replies are merged.
+         *
+         * @param[in] keys              the object keys; the object pools are extracted from the keys.
+         * @param[in] version           the version of the objects to read, see "get".
+         * @param[in] stable            see "get".
+         *
+         * @return the retrieved objects, in the order of the keys. An invalid object is returned for a key that is
+         *         not found.
+         */
+        template <typename KeyType>
+        auto multi_key_get(
+                const std::vector<KeyType>& keys,
+                const persistent::version_t& version = CURRENT_VERSION,
+                bool stable = true);
+
         /**
          * "multi_get" retrieves the latest version of the object for a given key using an atomic broadcast.
          * This ensures that the get request is mutually exclusive and linearizable with any concurrent put
@@ -1352,6 +2006,8 @@ namespace cascade {
          * @param[in] object_pool_pathname  the object pathname
          *
          * @return a vector of futures for key lists, with one key list for each shard in the object pool.
+         * If the object pool uses the RANGE sharding policy, object_pool_pathname can also be a longer key prefix
+         * in the pool, and only the shards owning that prefix are listed.
          * The return value's type will look like vector<unique_ptr<QueryResults<vector<KeyType>>>>, where KeyType is either string or uint64_t
          */
         auto list_keys(const persistent::version_t& version, const bool stable, const std::string& object_pool_pathname);
@@ -1401,6 +2057,8 @@ namespace cascade {
          * @param[in] object_pool_pathname  the object pathname
          *
          * @return a vector of futures for key lists, with one key list for each shard in the object pool.
+         * If the object pool uses the RANGE sharding policy, object_pool_pathname can also be a longer key prefix
+         * in the pool, and only the shards owning that prefix are listed.
          * The return value's type will look like vector<unique_ptr<QueryResults<vector<KeyType>>>>, where KeyType is either string or uint64_t
          */
         auto multi_list_keys(const std::string& object_pool_pathname);
@@ -1447,13 +2105,72 @@ namespace cascade {
         * @param[in] object_pool_pathname   the object pathname
         *
         * @return a vector of futures for key lists, with one key list for each shard in the object pool.
+        * If the object pool uses the RANGE sharding policy, object_pool_pathname can also be a longer key prefix
+        * in the pool, and only the shards owning that prefix are listed.
         * The return value's type will look like vector<unique_ptr<QueryResults<vector<KeyType>>>>, where KeyType is either string or uint64_t
         */
         auto list_keys_by_time(const uint64_t& ts_us, const bool stable, const std::string& object_pool_pathname);
 
+        /**
+         * "scan" retrieves a page of the objects in a shard, in key order. Repeat it with the returned cursor to
+         * stream through the shard without holding all of its keys or objects at once.
+         *
+         * @param[in] prefix            only the objects in this object pool pathname are returned; empty for all.
+         * @param[in] cursor            the cursor returned with the previous page, or the invalid key to start.
+         * @param[in] max_items         the maximum number of objects in a page, 0 for no limit.
+         * @param[in] max_bytes         the maximum serialized size of the objects in a page, 0 for no limit.
+         * @param[in] version           the version of the objects to read, see "list_keys".
+         * @param[in] stable            see "list_keys".
+         * @param[in] subgroup_index    the subgroup index of CascadeType
+         * @param[in] shard_index       the shard index.
+         *
+         * @return a future for the page, which is a tuple of the objects, the cursor of the next page, and the version
+         *         the page is read at. The cursor is the invalid key when there are no more objects. Pass the version
+         *         to get the next page, so that a stable scan reads the same version throughout.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<scan_page_tuple<typename SubgroupType::KeyType,typename SubgroupType::ObjectType>> scan(
+                const std::string& prefix,
+                const typename SubgroupType::KeyType& cursor,
+                uint32_t max_items,
+                uint64_t max_bytes,
+                const persistent::version_t& version = CURRENT_VERSION,
+                bool stable = true,
+                uint32_t subgroup_index = 0,
+                uint32_t shard_index = 0);
+
+        /**
+         * "scan_object_pool" retrieves a page of the objects with a prefix from an object pool with the RANGE sharding
+         * policy, in key order. Since the shards own contiguous key ranges, the page is read from the shard owning the
+         * cursor, and continues to the following shards in the prefix range only when that shard runs out of objects.
+         * Repeat it with the returned cursor to stream through the prefix.
+         *
+         * @param[in] prefix            the key prefix, which starts with the object pool pathname.
+         * @param[in] cursor            the cursor returned with the previous page, or the invalid key to start.
+         * @param[in] max_items         the maximum number of objects in a page, 0 for no limit.
+         * @param[in] max_bytes         the maximum serialized size of the objects in a page, 0 for no limit.
+         * @param[in] version           the version of the objects to read, see "list_keys".
+         * @param[in] stable            see "list_keys".
+         *
+         * @return the page, which is a tuple of the objects, the cursor of the next page, and the version argument,
+         *         since the shards do not share versions. The cursor is the invalid key when there are no more objects.
+         *         An exception is thrown if the object pool does not use the RANGE policy, or it is not of SubgroupType.
+         */
+        template <typename SubgroupType>
+        scan_page_tuple<typename SubgroupType::KeyType,typename SubgroupType::ObjectType> scan_object_pool(
+                const std::string& prefix,
+                const typename SubgroupType::KeyType& cursor,
+                uint32_t max_items,
+                uint64_t max_bytes,
+                const persistent::version_t& version = CURRENT_VERSION,
+                bool stable = true);
+
         /**
          * Object Pool Management API: refresh object pool cache
-         * We load 'unstable' (committed but maybe not persisted) metadata here.
+         * We load 'unstable' (committed but maybe not persisted) metadata here. Concurrent calls share one refresh
+         * that starts after they are called. If that refresh fails, the calls waiting for it refresh again.
+         *
+         * @throws the exception that fails the refresh.
          */
         void refresh_object_pool_metadata_cache();
 
@@ -1467,6 +2184,9 @@ namespace cascade {
          * @param[in]  object_locations The set of special object locations.
          * @param[in]  affinity_set_regex
          *                          The affinity set regex.
+         * @param[in]  range_split_points
+         *                          The strictly increasing split points for the RANGE sharding policy. Please see
+         *                          ObjectPoolMetadata for how the split points partition the keys.
          *
          * @return a future to the version and timestamp of the put operation.
          */
@@ -1475,7 +2195,8 @@ namespace cascade {
                 const std::string& pathname, const uint32_t subgroup_index,
                 const sharding_policy_t sharding_policy = HASH,
                 const std::unordered_map<std::string,uint32_t>& object_locations = {},
-                const std::string& affinity_set_regex = "");
+                const std::string& affinity_set_regex = "",
+                const std::vector<std::string>& range_split_points = {});
 
         /**
          * ObjectPoolManagement API: remove object pool
@@ -1588,6 +2309,21 @@ namespace cascade {
         void notify(const Blob& msg,
                 const uint32_t subgroup_index,
                 const node_id_t client_id) const;
+
+        /**
+         * Send a cache invalidation to an external client subscribed to a shard of this node.
+         *
+         * @tparam SubgroupType     The Subgroup Type
+         * @param[in] key               The key updated or removed
+         * @param[in] version           The new version of the key
+         * @param[in] subgroup_index    The subgroup index
+         * @param[in] client_id         The node id of the external client to be notified
+         */
+        template <typename SubgroupType>
+        void notify_cache_invalidation(const std::string& key,
+                const persistent::version_t& version,
+                const uint32_t subgroup_index,
+                const node_id_t client_id) const;
     protected:
         template <typename SubgroupType>
         void notify(const Blob& msg,
@@ -1729,6 +2465,7 @@ namespace cascade {
     static constexpr const char* CASCADE_CONTEXT_CPU_CORES                       = "CASCADE/cpu_cores";
     static constexpr const char* CASCADE_CONTEXT_GPUS                            = "CASCADE/gpus";
     static constexpr const char* CASCADE_CONTEXT_WORKER_CPU_AFFINITY             = "CASCADE/worker_cpu_affinity";
+    static constexpr const char* CASCADE_CONTEXT_SHARE_STORED_VALUES             = "CASCADE/share_stored_values";
 
     /**
      * A class describing the resources available in the Cascade context.
@@ -1763,7 +2500,8 @@ namespace cascade {
         DataFlowGraph::Statefulness                     statefulness;
         DataFlowGraph::VertexHook                       hook;
         std::shared_ptr<OffCriticalDataPathObserver>    ocdpo;
-        std::unordered_map<std::string,bool>            output_map;
+        std::shared_ptr<const std::unordered_map<std::string,bool>>    output_map;
+        DataFlowGraph::VertexBatching                   batching;
     };
 
     struct PrefixOCDPOInfoHash {
@@ -1808,29 +2546,132 @@ namespace cascade {
                            >;
     using match_results_t = std::unordered_map<std::string,prefix_entry_t>;
 
+    /**
+     * @struct prefix_dispatch_target_t
+     * @brief   An ocdpo to post an action to, and the length of the prefix it is registered to.
+     */
+    struct prefix_dispatch_target_t {
+        uint32_t                    prefix_length;
+        const prefix_ocdpo_info_t*  info;
+    };
+
+    /**
+     * @struct prefix_dispatch_plan_t
+     * @brief   The ocdpos matching the keys in a path, filtered by hook and shard dispatcher.
+     *
+     * A plan is immutable once published. It holds the prefix entries it was built from, so that the targets, which
+     * point into the entries, stay valid as long as the plan is in use, even if the prefixes are registered again or
+     * unregistered meanwhile.
+     */
+    struct prefix_dispatch_plan_t {
+        /** the registered prefix the plan is built for, including the trailing separator */
+        std::string                                         path;
+        /** the prefix entries matching the path */
+        std::vector<std::shared_ptr<const prefix_entry_t>>  entries;
+        /** the ocdpos hooked to ordered put, to be posted by all the shard members */
+        std::vector<prefix_dispatch_target_t>               ordered_put_targets_for_all;
+        /** the ocdpos hooked to ordered put, to be posted by the shard member a key is hashed to */
+        std::vector<prefix_dispatch_target_t>               ordered_put_targets_for_one;
+        /** the ocdpos hooked to trigger put */
+        std::vector<prefix_dispatch_target_t>               trigger_put_targets;
+        /** if any of the trigger put targets runs out of process */
+        bool                                                has_mproc_udl_for_trigger_put = false;
+
+        /**
+         * Build the plan for a path.
+         *
+         * @param[in] registry  The prefix registry
+         * @param[in] path      The path
+         *
+         * @return the plan.
+         */
+        static std::shared_ptr<const prefix_dispatch_plan_t> build(
+                const PrefixRegistry<prefix_entry_t,PATH_SEPARATOR>& registry, const std::string& path);
+    };
+
+    /**
+     * @class PrefixDispatchPlans
+     * @brief   The dispatch plans of all the registered prefixes, built when the prefixes are registered.
+     *
+     * The prefixes matching the path of a key are exactly those matching the longest registered prefix of the path, so
+     * the plan of a key is the plan of that prefix. A lookup hashes the path, and then its shorter prefixes until one is
+     * found, inside an EpochGuard: it neither locks nor allocates. Changing the prefix registry must be followed by
+     * rebuild(), which publishes a new table of plans; the replaced tables wait in 'retired_tables' until no reader can
+     * see them.
+     */
+    class PrefixDispatchPlans {
+        /** the keys are views of prefix_dispatch_plan_t::path of the values */
+        using plan_table_t = std::unordered_map<std::string_view,std::shared_ptr<const prefix_dispatch_plan_t>>;
+        std::atomic<const plan_table_t*> table;
+        /** serializes rebuild(), so that the last table published is built from the latest registry */
+        std::mutex rebuild_mutex;
+        std::vector<std::pair<uint64_t,const plan_table_t*>> retired_tables;
+        /** the plan of the keys under no registered prefix */
+        const std::shared_ptr<const prefix_dispatch_plan_t> empty_plan;
+    public:
+        PrefixDispatchPlans();
+        virtual ~PrefixDispatchPlans();
+        PrefixDispatchPlans(const PrefixDispatchPlans&) = delete;
+        PrefixDispatchPlans& operator=(const PrefixDispatchPlans&) = delete;
+        /**
+         * Get the plan for a key.
+         *
+         * @param[in] registry  The prefix registry, to build the plan from if the path of the key has empty components,
+         *                      which the table does not cover.
+         * @param[in] key       The key
+         *
+         * @return the plan of the path of the key.
+         */
+        std::shared_ptr<const prefix_dispatch_plan_t> get(
+                const PrefixRegistry<prefix_entry_t,PATH_SEPARATOR>& registry, const std::string& key) const;
+        /**
+         * Build the plans of all the prefixes in the registry, and publish them.
+         *
+         * @param[in] registry  The prefix registry
+         */
+        void rebuild(const PrefixRegistry<prefix_entry_t,PATH_SEPARATOR>& registry);
+    };
+
     template <typename... CascadeTypes>
     class ExecutionEngine: public CascadeContext<CascadeTypes...> {
     private:
         struct action_queue {
-            struct Action           action_buffer[ACTION_BUFFER_SIZE];
-            std::atomic<size_t>     action_buffer_head;
-            std::atomic<size_t>     action_buffer_tail;
-            mutable std::mutex      action_buffer_slot_mutex;
-            mutable std::mutex      action_buffer_data_mutex;
-            mutable std::condition_variable action_buffer_slot_cv;
-            mutable std::condition_variable action_buffer_data_cv;
+            ActionQueue<Action>     action_buffer{ACTION_BUFFER_SIZE};
             inline void initialize();
             inline void action_buffer_enqueue(Action&&);
             inline Action action_buffer_dequeue(std::atomic<bool>& is_running);
+            inline Action action_buffer_dequeue_until(std::atomic<bool>& is_running,
+                                                      const std::chrono::steady_clock::time_point& deadline);
+            inline Action action_buffer_try_dequeue();
             inline void notify_all();
         };
+        /** the view of a worker on a work stealing scheduler, with the dequeue calls of action_queue */
+        struct stealing_action_queue {
+            WorkStealingScheduler<Action>&  scheduler;
+            const uint32_t                  worker_id;
+            inline Action action_buffer_dequeue(std::atomic<bool>& is_running);
+            inline Action action_buffer_dequeue_until(std::atomic<bool>& is_running,
+                                                      const std::chrono::steady_clock::time_point& deadline);
+            inline Action action_buffer_try_dequeue();
+        };
+        /** the actions a worker is collecting for an observer registered with batching */
+        struct action_batch {
+            OffCriticalDataPathObserver*            ocdpo;
+            uint32_t                                max_batch_size;
+            std::chrono::steady_clock::time_point   deadline;
+            std::vector<Action>                     actions;
+        };
         /** action (ring) buffer control */
         std::vector<std::unique_ptr<struct action_queue>> stateful_action_queues_for_multicast;
         std::vector<std::unique_ptr<struct action_queue>> stateful_action_queues_for_p2p;
         struct action_queue single_threaded_action_queue_for_multicast;
         struct action_queue single_threaded_action_queue_for_p2p;
-        struct action_queue stateless_action_queue_for_multicast;
-        struct action_queue stateless_action_queue_for_p2p;
+        /** the stateless actions are scheduled to the stateless workers, which steal from each other when idle */
+        std::unique_ptr<WorkStealingScheduler<Action>> stateless_scheduler_for_multicast;
+        std::unique_ptr<WorkStealingScheduler<Action>> stateless_scheduler_for_p2p;
+        /** the round-robin counters for the stateless actions, when there is no stateless worker */
+        std::atomic<uint32_t> stateless_rrcnt_for_multicast{0};
+        std::atomic<uint32_t> stateless_rrcnt_for_p2p{0};
 
         /** thread pool control */
         std::atomic<bool>       is_running;
@@ -1838,6 +2679,13 @@ namespace cascade {
          * prefix->{udl_id->{ocdpo,{prefix->trigger_put/put}}
          */
         std::shared_ptr<PrefixRegistry<prefix_entry_t,PATH_SEPARATOR>> prefix_registry_ptr;
+        /** the dispatch plans built from prefix_registry_ptr */
+        PrefixDispatchPlans dispatch_plans;
+        /**
+         * if false, the actions of an ordered put get a copy of the value instead of sharing the one held by the store,
+         * loaded from CASCADE_CONTEXT_SHARE_STORED_VALUES, which defaults to true. It is meant for measuring the copy.
+         */
+        bool share_stored_values = true;
         /** the data path logic loader */
         std::unique_ptr<UserDefinedLogicManager<CascadeTypes...>> user_defined_logic_manager;
         /** the off-critical data path worker thread pools */
@@ -1853,10 +2701,32 @@ namespace cascade {
         void destroy();
         /**
          * off critical data path workhorse
+         * @tparam    ActionSource  action_queue or stealing_action_queue
          * @param[in] _1 The task id, started from 0 to (OFF_CRITICAL_DATA_PATH_THREAD_POOL_SIZE-1)
          * @param[in] _2 The action queue
          */
-        void workhorse(uint32_t,struct action_queue&);
+        template <typename ActionSource>
+        void workhorse(uint32_t,ActionSource&);
+        /**
+         * Fire an action, or add it to the batch of its observer if the observer is registered with batching.
+         * @param[in] worker_id     The worker id
+         * @param[in] action        The action
+         * @param[in,out] batches   The batches of the worker
+         */
+        void fire_or_batch(uint32_t worker_id, Action&& action, std::vector<action_batch>& batches);
+        /**
+         * Fire a batch, and empty it.
+         * @param[in] worker_id     The worker id
+         * @param[in,out] batch     The batch
+         */
+        void fire_batch(uint32_t worker_id, action_batch& batch);
+        /**
+         * Fire the batches of a worker.
+         * @param[in] worker_id     The worker id
+         * @param[in,out] batches   The batches of the worker
+         * @param[in] expired_only  If true, only the batches past their deadline are fired.
+         */
+        void fire_batches(uint32_t worker_id, std::vector<action_batch>& batches, bool expired_only);
 
     public:
         /** Resources **/
@@ -1929,6 +2799,7 @@ namespace cascade {
          * @param[in] ocdpo_ptr             - the data path observer
          * @param[in] outputs               - the outputs are a map from another prefix to put type (true for trigger put,
          *                                false for put).
+         * @param[in] batching              - how the actions of the ocdpo are batched.
          */
         virtual void register_prefixes(const std::string& dfg_uuid,
                                        const std::unordered_set<std::string>& prefixes,
@@ -1940,7 +2811,8 @@ namespace cascade {
                                        const std::string& user_defined_logic_id,
                                        const std::string& user_defined_logic_config,
                                        const std::shared_ptr<OffCriticalDataPathObserver>& ocdpo_ptr,
-                                       const std::unordered_map<std::string,bool>& outputs);
+                                       const std::unordered_map<std::string,bool>& outputs,
+                                       const DataFlowGraph::VertexBatching& batching = {});
         /**
          * Unregister all prefixes of an application
          *
@@ -1955,9 +2827,26 @@ namespace cascade {
          * @return the unordered map of observers registered to this prefix.
          */
         virtual match_results_t get_prefix_handlers(const std::string& prefix);
+        /**
+         * Get the dispatch plan for a key, which lists the observers to post an action to when the key is updated.
+         *
+         * @param[in] key                   - the key
+         *
+         * @return the dispatch plan of the path of the key.
+         */
+        virtual std::shared_ptr<const prefix_dispatch_plan_t> get_dispatch_plan(const std::string& key);
+        /**
+         * Test if the actions of an ordered put share the value held by the store.
+         *
+         * @return false if CASCADE_CONTEXT_SHARE_STORED_VALUES is set to false, which makes them copy it.
+         */
+        virtual bool is_sharing_stored_values() const;
 
         /**
          * post an action to the Context for processing.
+         * A stateful action goes to the worker its key is hashed to, so that the actions on a key are processed in the
+         * order they are posted. A stateless action goes to the work stealing scheduler of the stateless workers, or
+         * round-robin to the stateful workers if there is no stateless worker.
          *
          * @param[in] action        The action
          * @param[in] stateful      If the action is stateful|stateless|singlethreaded
@@ -4,6 +4,9 @@
 
 #ifdef HAS_BOOLINQ
 #include <boolinq/boolinq.h>
+#include <algorithm>
+#include <deque>
+#include <iterator>
 #endif
 
 namespace derecho {
@@ -18,8 +21,38 @@ using ServiceClientAPI = ServiceClient<VolatileCascadeStoreWithStringKey, Persis
  */
 #ifdef HAS_BOOLINQ
 
+/**
+ * The storage of a shard Linq. boolinq copies the storage with the Linq, for example, in where() or select(), so every
+ * copy iterates on its own.
+ */
 template <typename CascadeType>
-using CascadeShardLinqStorageType = std::pair<typename std::vector<typename CascadeType::KeyType>::iterator, typename std::vector<typename CascadeType::KeyType>::iterator>;
+struct CascadeShardLinqStorageType {
+    /** The next key and the end of the key list, for the Linqs iterating the keys listed up front. */
+    typename std::vector<typename CascadeType::KeyType>::iterator first;
+    typename std::vector<typename CascadeType::KeyType>::iterator second;
+    /** The objects fetched but not consumed yet. */
+    std::deque<typename CascadeType::ObjectType> fetched;
+    /** The cursor of the next scan page, and the version to read it at. */
+    typename CascadeType::KeyType cursor = CascadeType::ObjectType::IK;
+    persistent::version_t version = CURRENT_VERSION;
+    /** True when the last page is fetched. */
+    bool done = false;
+
+    CascadeShardLinqStorageType() = default;
+    CascadeShardLinqStorageType(std::vector<typename CascadeType::KeyType>& key_list) :
+        first(key_list.begin()), second(key_list.end()) {}
+};
+
+/**
+ * The number of keys the shard and objectpool Linqs fetch with one multi_key_get call.
+ */
+constexpr std::size_t linq_multi_key_get_batch_size = 256;
+
+/**
+ * The maximum number of objects and bytes in a page the shard Linq fetches with one scan call.
+ */
+constexpr uint32_t linq_scan_page_items = 256;
+constexpr uint64_t linq_scan_page_bytes = 1ull << 20;
 
 /**
  * The shard linq iterate the keys in a shard.
@@ -38,9 +71,9 @@ public:
                      uint32_t sgidx,
                      uint32_t shidx,
                      persistent::version_t ver,
-                     std::vector<typename CascadeType::KeyType>& key_list,
+                     const CascadeShardLinqStorageType<CascadeType>& storage,
                      std::function<typename CascadeType::ObjectType(CascadeShardLinqStorageType<CascadeType>&)> nextFunc) :
-        boolinq::Linq<CascadeShardLinqStorageType<CascadeType>,typename CascadeType::ObjectType>(std::make_pair(key_list.begin(),key_list.end()), nextFunc),
+        boolinq::Linq<CascadeShardLinqStorageType<CascadeType>,typename CascadeType::ObjectType>(storage, nextFunc),
         client_api(capi),
         subgroup_index(sgidx),
         shard_index(shidx),
@@ -49,8 +82,8 @@ public:
 
 /**
  * Creat a Linq iterating the objects in a shard.
- * @param key_list  This is an output argument to keep the generated key_list. Please keep it alive throughout the life
- *                  time of the Link object.
+ * The objects are streamed with scan in pages of linq_scan_page_items objects or linq_scan_page_bytes bytes, so the
+ * keys in the shard are not listed up front. All the pages are read at the version resolved for the first page.
  * @param capi      The cascade client.
  * @param subgroup_index
  * @param shard_index
@@ -59,32 +92,35 @@ public:
  */
 template <typename CascadeType, typename ServiceClientType>
 CascadeShardLinq<CascadeType,ServiceClientType> from_shard(
-        std::vector<typename CascadeType::KeyType>& key_list,
-        ServiceClientType& capi, uint32_t subgroup_index, 
+        ServiceClientType& capi, uint32_t subgroup_index,
         uint32_t shard_index, persistent::version_t version) {
-    /* load keys. */
-    auto result = capi.template list_keys<CascadeType>(version, true, subgroup_index, shard_index);
-    for(auto& reply_future:result.get()) {
-        key_list = reply_future.second.get();
-    }
+    CascadeShardLinqStorageType<CascadeType> storage;
+    storage.version = version;
     /* set up storage and nextFunc*/
-    return CascadeShardLinq<CascadeType,ServiceClientType>(capi,subgroup_index,shard_index,version,key_list,
-        [&capi,subgroup_index,shard_index,version](CascadeShardLinqStorageType<CascadeType>& _storage) {
-            if (_storage.first == _storage.second) {
-                throw boolinq::LinqEndException();
-            }
-
-            /* get object */
-            auto result = capi.template get<CascadeType>(*_storage.first,version,true/*always use stable*/,subgroup_index,shard_index);
-
-            _storage.first++;
-
-            for (auto& reply_future:result.get()) {
-                auto object = reply_future.second.get();
-                return object;
+    return CascadeShardLinq<CascadeType,ServiceClientType>(capi,subgroup_index,shard_index,version,storage,
+        [&capi,subgroup_index,shard_index](CascadeShardLinqStorageType<CascadeType>& _storage) {
+            while (_storage.fetched.empty()) {
+                if (_storage.done) {
+                    throw boolinq::LinqEndException();
+                }
+                /* get the next page of objects */
+                auto result = capi.template scan<CascadeType>("",_storage.cursor,linq_scan_page_items,linq_scan_page_bytes,
+                                                              _storage.version,true/*always use stable*/,subgroup_index,shard_index);
+                _storage.done = true;
+                for (auto& reply_future:result.get()) {
+                    auto page = reply_future.second.get();
+                    auto& objects = std::get<0>(page);
+                    std::move(objects.begin(),objects.end(),std::back_inserter(_storage.fetched));
+                    _storage.cursor = std::get<1>(page);
+                    _storage.version = std::get<2>(page);
+                    _storage.done = (_storage.cursor == CascadeType::ObjectType::IK);
+                    break;
+                }
             }
 
-            throw boolinq::LinqEndException();
+            auto object = std::move(_storage.fetched.front());
+            _storage.fetched.pop_front();
+            return object;
         });
 }
 
@@ -109,7 +145,8 @@ CascadeShardLinq<CascadeType,ServiceClientType> from_shard_by_time (
         key_list = reply_future.second.get();
     }
  /* set up storage and nextFunc*/
-    return CascadeShardLinq<CascadeType,ServiceClientType>(capi,subgroup_index,shard_index,CURRENT_VERSION,key_list,
+    return CascadeShardLinq<CascadeType,ServiceClientType>(capi,subgroup_index,shard_index,CURRENT_VERSION,
+        CascadeShardLinqStorageType<CascadeType>(key_list),
         [&capi,subgroup_index,shard_index,ts_us](CascadeShardLinqStorageType<CascadeType>& _storage) {
             if (_storage.first == _storage.second) {
                 throw boolinq::LinqEndException();
@@ -219,9 +256,6 @@ public:
 
 /**
  * Create a Linq iterating the objects in a subgroup.
- * @param shardidx_to_keys      The map that contains mappings between shard index and the corresponding 
- *                              key lists. The key lists are used to store the generated key_list in [from_shard] 
- *                              function call. Please keep it alive throughout the life time of the Link object.
  * @param shard_linq_list       This is an output argument to keep the generated ShardLinq for each shard in the 
  *                              in the subgroup. Please keep it alive throughout the life time of the Link object.
  * @param capi                  The cascade client.
@@ -231,15 +265,13 @@ public:
  */
 template <typename CascadeType, typename ServiceClientType>
 CascadeSubgroupLinq<CascadeType,ServiceClientType> from_subgroup(
-    std::unordered_map<uint32_t, std::vector<typename CascadeType::KeyType>>& shardidx_to_keys, 
  std::vector<CascadeShardLinq<CascadeType,ServiceClientType>>& shard_linq_list,
  ServiceClientType& capi, uint32_t sgidx, persistent::version_t ver) {
  
     uint32_t num_shards = capi.template get_number_of_shards<CascadeType>(sgidx);
     std::cout << "num_shards=" << num_shards << std::endl;
     for (uint32_t shidx=0;shidx<num_shards;shidx++) {
-        shardidx_to_keys.emplace(shidx,std::vector<typename CascadeType::KeyType>());
-        shard_linq_list.emplace_back(from_shard<CascadeType, ServiceClientType>(shardidx_to_keys[shidx],capi,sgidx,shidx,ver));
+        shard_linq_list.emplace_back(from_shard<CascadeType, ServiceClientType>(capi,sgidx,shidx,ver));
     }
     std::cout << "done prepare shard iterators." << std::endl;
  
@@ -283,7 +315,7 @@ public:
                      const std::string& pathname,
                      std::vector<typename CascadeType::KeyType>& key_list,
                      std::function<typename CascadeType::ObjectType(CascadeObjectpoolLinqStorageType<CascadeType>&)> nextFunc) :
-        boolinq::Linq<CascadeObjectpoolLinqStorageType<CascadeType>,typename CascadeType::ObjectType>(std::make_pair(key_list.begin(),key_list.end()), nextFunc),
+        boolinq::Linq<CascadeObjectpoolLinqStorageType<CascadeType>,typename CascadeType::ObjectType>(CascadeObjectpoolLinqStorageType<CascadeType>(key_list), nextFunc),
         client_api(capi),
         version(ver),
         objpool_pathname(pathname) {}
@@ -310,17 +342,22 @@ CascadeObjpoolLinq<CascadeType,ServiceClientType> from_objectpool(
     /* set up storage and nextFunc*/
     return CascadeObjpoolLinq<CascadeType,ServiceClientType>(capi,version,objpool_path,key_list,
         [&capi,version,objpool_path](CascadeObjectpoolLinqStorageType<CascadeType>& _storage) {
-            if (_storage.first == _storage.second) {
-                throw boolinq::LinqEndException();
-            }
-            /* get object */
-            auto result = capi.template get<CascadeType>(*_storage.first,version);
-            _storage.first++;
-            for (auto& reply_future:result.get()) {
-                auto object = reply_future.second.get();
-                return object;
+            if (_storage.fetched.empty()) {
+                if (_storage.first == _storage.second) {
+                    throw boolinq::LinqEndException();
+                }
+                /* get the next batch of objects, scattered to the shards holding them */
+                auto batch_end = _storage.first + std::min(linq_multi_key_get_batch_size,
+                        static_cast<std::size_t>(_storage.second - _storage.first));
+                std::vector<typename CascadeType::KeyType> keys(_storage.first,batch_end);
+                _storage.first = batch_end;
+                auto objects = capi.multi_key_get(keys,version);
+                std::move(objects.begin(),objects.end(),std::back_inserter(_storage.fetched));
             }
-            throw boolinq::LinqEndException();
+
+            auto object = std::move(_storage.fetched.front());
+            _storage.fetched.pop_front();
+            return object;
         });
 }
 
@@ -334,6 +334,9 @@ public:
  *      TLT_PERSISTENT_ORDERED_GET_SIZE_START
  *      TLT_PERSISTENT_ORDERED_GET_SIZE_END
  *      TLT_PERSISTENT_MULTI_GET_SIZE_END
+ *
+ *      TLT_PERSISTENT_GET_BY_TIME_START            # followed by TLT_PERSISTENT_GET_START once the version is found
+ *      TLT_PERSISTENT_GET_BY_TIME_END
  */
 #define TLT_PERSISTENT_PUT_START                    (3001)
 #define TLT_PERSISTENT_ORDERED_PUT_START            (3002)
@@ -377,6 +380,9 @@ public:
 #define TLT_PERSISTENT_ORDERED_GET_SIZE_END         (3093)
 #define TLT_PERSISTENT_MULTI_GET_SIZE_END           (3094)
 
+#define TLT_PERSISTENT_GET_BY_TIME_START            (3101)
+#define TLT_PERSISTENT_GET_BY_TIME_END              (3102)
+
 /* For TriggerCascadeNoStore:
  * ::trigger_put():
  *      TLT_TRIGGER_PUT_START
@@ -2,6 +2,7 @@
 
 #include "cascade/config.h"
 #include "cascade_interface.hpp"
+#include "detail/concurrent_ordered_map.hpp"
 
 #include <derecho/core/derecho.hpp>
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
@@ -26,17 +27,11 @@ class VolatileCascadeStore : public ICascadeStore<KT, VT, IK, IV>,
                              public derecho::NotificationSupport {
 private:
     bool internal_ordered_put(const VT& value, bool as_trigger);
-#if defined(__i386__) || defined(__x86_64__) || defined(_M_AMD64) || defined(_M_IX86)
-    mutable std::atomic<persistent::version_t> lockless_v1;
-    mutable std::atomic<persistent::version_t> lockless_v2;
-#else
-#error The lockless reader/writer works only with TSO memory reordering. Please check https://en.wikipedia.org/wiki/Memory_ordering
-#endif
 public:
     /* group reference */
     using derecho::GroupReference::group;
-    /* volatile cascade store in memory */
-    std::map<KT, VT> kv_map;
+    /* volatile cascade store in memory, updated by the predicate thread and read locklessly by the others */
+    ConcurrentOrderedMap<KT, VT> kv_map;
     /* record the version of latest update */
     persistent::version_t update_version;
     /* watcher */
@@ -48,16 +43,20 @@ public:
                                              P2P_TARGETS(
                                                      put,
                                                      put_and_forget,
+                                                     put_batch,
+                                                     put_batch_and_forget,
 #ifdef ENABLE_EVALUATION
                                                      perf_put,
 #endif
                                                      remove,
                                                      get,
+                                                     multi_key_get,
                                                      multi_get,
                                                      get_by_time,
                                                      multi_list_keys,
                                                      list_keys,
                                                      list_keys_by_time,
+                                                     scan,
                                                      multi_get_size,
                                                      get_size,
                                                      get_size_by_time,
@@ -74,6 +73,8 @@ public:
                                              ORDERED_TARGETS(
                                                      ordered_put,
                                                      ordered_put_and_forget,
+                                                     ordered_put_batch,
+                                                     ordered_put_batch_and_forget,
                                                      ordered_remove,
                                                      ordered_get,
                                                      ordered_list_keys,
@@ -95,18 +96,25 @@ public:
     virtual double perf_put(const uint32_t max_payload_size, const uint64_t duration_sec) const override;
 #endif  // ENABLE_EVALUATION
     virtual void put_and_forget(const VT& value, bool as_trigger) const override;
+    virtual version_tuple put_batch(const std::vector<VT>& values, bool as_trigger) const override;
+    virtual void put_batch_and_forget(const std::vector<VT>& values, bool as_trigger) const override;
     virtual version_tuple remove(const KT& key) const override;
     virtual const VT get(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const override;
+    virtual std::vector<VT> multi_key_get(const std::vector<KT>& keys, const persistent::version_t& ver, const bool stable) const override;
     virtual const VT multi_get(const KT& key) const override;
     virtual const VT get_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const override;
     virtual std::vector<KT> multi_list_keys(const std::string& prefix) const override;
     virtual std::vector<KT> list_keys(const std::string& prefix, const persistent::version_t& ver, const bool stable) const override;
     virtual std::vector<KT> list_keys_by_time(const std::string& prefix, const uint64_t& ts_us, const bool stable) const override;
+    virtual scan_page_tuple<KT, VT> scan(const std::string& prefix, const persistent::version_t& ver, const bool stable,
+                                         const KT& cursor, const uint32_t& max_items, const uint64_t& max_bytes) const override;
     virtual uint64_t multi_get_size(const KT& key) const override;
     virtual uint64_t get_size(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const override;
     virtual uint64_t get_size_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const override;
     virtual version_tuple ordered_put(const VT& value, bool as_trigger) override;
     virtual void ordered_put_and_forget(const VT& value, bool as_trigger) override;
+    virtual version_tuple ordered_put_batch(const std::vector<VT>& values, bool as_trigger) override;
+    virtual void ordered_put_batch_and_forget(const std::vector<VT>& values, bool as_trigger) override;
     virtual version_tuple ordered_remove(const KT& key) override;
     virtual const VT ordered_get(const KT& key) override;
     virtual std::vector<KT> ordered_list_keys(const std::string& prefix) override;
@@ -127,11 +135,11 @@ public:
     /* constructors */
     VolatileCascadeStore(CriticalDataPathObserver<VolatileCascadeStore<KT, VT, IK, IV>>* cw = nullptr,
                          ICascadeContext* cc = nullptr);
-    VolatileCascadeStore(const std::map<KT, VT>& _kvm,
+    VolatileCascadeStore(const ConcurrentOrderedMap<KT, VT>& _kvm,
                          persistent::version_t _uv,
                          CriticalDataPathObserver<VolatileCascadeStore<KT, VT, IK, IV>>* cw = nullptr,
                          ICascadeContext* cc = nullptr);  // copy kv_map
-    VolatileCascadeStore(std::map<KT, VT>&& _kvm,
+    VolatileCascadeStore(ConcurrentOrderedMap<KT, VT>&& _kvm,
                          persistent::version_t _uv,
                          CriticalDataPathObserver<VolatileCascadeStore<KT, VT, IK, IV>>* cw = nullptr,
                          ICascadeContext* cc = nullptr);  // move kv_map
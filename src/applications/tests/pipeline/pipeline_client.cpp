@@ -107,6 +107,8 @@ int main(int argc, char** argv) {
     uint64_t now_ns = get_walltime();
     uint64_t next_ns = 0;
     uint64_t end_ns = now_ns + duration_sec*1e9;
+    uint64_t start_ns = now_ns;
+    uint64_t num_sent = 0;
 #ifdef ENABLE_EVALUATION
     derecho::node_id_t my_node_id = capi.get_my_id();
     uint64_t msg_id = 0;
@@ -125,6 +127,7 @@ int main(int argc, char** argv) {
             } else {
                 capi.put_and_forget(objects.at(now_ns%NUMBER_OF_DISTINCT_OBJECTS));
             }
+            num_sent ++;
 #ifdef ENABLE_EVALUATION
             TimestampLogger::log(TLT_EC_SENT,my_node_id,msg_id,get_walltime());
             msg_id ++;
@@ -134,6 +137,10 @@ int main(int argc, char** argv) {
         }
         now_ns = get_walltime();
     }
+    double send_duration_sec = static_cast<double>(now_ns - start_ns) / 1e9;
+    std::cout << "sent " << num_sent << " objects of " << payload_size << " bytes in " << send_duration_sec << " seconds: "
+              << num_sent / send_duration_sec << " ops/s, "
+              << num_sent * payload_size / send_duration_sec / 1048576 << " MB/s" << std::endl;
 
 #ifdef ENABLE_EVALUATION
     // wait for 2 seconds so that all messages has been processed.
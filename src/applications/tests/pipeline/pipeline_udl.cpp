@@ -1,6 +1,8 @@
 #include <cascade/user_defined_logic_interface.hpp>
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
 #include <cascade/utils.hpp>
+#include <derecho/utils/time.h>
+#include <atomic>
 #include <mutex>
 #include <nlohmann/json.hpp>
 #include <iostream>
@@ -34,6 +36,9 @@ class PipelineOCDPO: public OffCriticalDataPathObserver {
         //TODO: implementing the pipeline logics.
         auto* typed_ctxt = dynamic_cast<DefaultCascadeContextType*>(ctxt);
         const auto* const value = dynamic_cast<const ObjectWithStringKey* const>(value_ptr);
+        if (report_interval_sec > 0) {
+            report_throughput(value->blob.size);
+        }
 #ifdef ENABLE_EVALUATION
         TimestampLogger::log(TLT_PIPELINE(stage),
             typed_ctxt->get_service_client_ref().get_my_id(),
@@ -58,7 +63,31 @@ class PipelineOCDPO: public OffCriticalDataPathObserver {
         }
     }
 
+    /**
+     * Count an object, and print the throughput of this stage once every report_interval_sec seconds.
+     */
+    void report_throughput(uint64_t object_size) {
+        num_objects.fetch_add(1,std::memory_order_relaxed);
+        num_bytes.fetch_add(object_size,std::memory_order_relaxed);
+        uint64_t now_ns = get_walltime();
+        uint64_t last_ns = last_report_ns.load(std::memory_order_relaxed);
+        if (now_ns - last_ns < report_interval_sec * 1000000000ull ||
+            !last_report_ns.compare_exchange_strong(last_ns,now_ns)) {
+            return;
+        }
+        uint64_t objects = num_objects.exchange(0);
+        uint64_t bytes = num_bytes.exchange(0);
+        double duration_sec = static_cast<double>(now_ns - last_ns) / 1e9;
+        std::cout << "stage " << stage << " throughput: " << objects / duration_sec << " ops/s, "
+                  << bytes / duration_sec / 1048576 << " MB/s" << std::endl;
+    }
+
     uint32_t stage;
+    /** The interval between two throughput reports, or 0 to disable them. */
+    uint32_t report_interval_sec = 0;
+    std::atomic<uint64_t> num_objects{0};
+    std::atomic<uint64_t> num_bytes{0};
+    std::atomic<uint64_t> last_report_ns{0};
 
     static std::map<json,std::shared_ptr<OffCriticalDataPathObserver>> ocdpo_map;
     static std::mutex ocdpo_map_mutex;
@@ -66,17 +95,22 @@ public:
     /**
      * The constructor should receive a json configuration object like the following
      *  {
-     *      "stage":1
+     *      "stage":1,
+     *      "report_interval_sec":5
      *  }
-     *  where the stage represents which tier the node is in the whole pipeline.
+     *  where the stage represents which tier the node is in the whole pipeline, and the OPTIONAL report_interval_sec
+     *  asks this stage to print its throughput every that many seconds.
      */
-    PipelineOCDPO(const json& config) {
+    PipelineOCDPO(const json& config) : last_report_ns(get_walltime()) {
         try{
             if (config.find("stage") != config.end()) {
                 stage = config["stage"].get<uint32_t>();
             } else {
                 stage = 0;
             }
+            if (config.find("report_interval_sec") != config.end()) {
+                report_interval_sec = config["report_interval_sec"].get<uint32_t>();
+            }
         } catch (json::exception& jsone) {
             dbg_default_error("Failed to parse pipeline configuration:{}, exception:{}",
                 config.get<std::string>(), jsone.what());
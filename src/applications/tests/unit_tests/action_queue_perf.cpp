@@ -0,0 +1,278 @@
+#include <getopt.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cascade/detail/action_queue.hpp>
+#include <cascade/utils.hpp>
+
+/**
+ * @file action_queue_perf.cpp
+ *
+ * Action Queue Tester
+ *
+ * This tester posts actions from one thread, which stands for the critical data path, to a number of worker threads
+ * through an action queue. It reports the latency of posting an action, the latency from posting an action to a worker
+ * dequeuing it, and the dequeue throughput of the workers. The lock-free ActionQueue used by the ExecutionEngine is
+ * compared with the mutex and condition variable ring it replaced.
+ */
+
+using namespace derecho::cascade;
+
+/**
+ * @brief Help string.
+ */
+const char* help_string =
+    "Action Queue Tester\n"
+    "-------------------\n"
+    "Options:\n"
+    "\t--(q)ueue <lockfree|mutex>                   the queue to test, default: lockfree\n"
+    "\t--(w)orkers <num_workers>                    number of worker threads, default: 4\n"
+    "\t--(n)um_actions <num_actions>                number of actions to post, default: 1000000\n"
+    "\t--(r)ate <actions_per_second>                the posting rate, or 0 for as fast as possible, default: 0\n"
+    "\t--(c)ost <cost_ns>                           the cost of an action in nanoseconds, default: 0\n"
+    "\t--(h)elp                                     help information\n"
+    ;
+
+/**
+ * @brief The action posted by the tester.
+ */
+struct test_action_t {
+    uint64_t post_ns = 0;
+    std::shared_ptr<uint64_t> value_ptr;
+};
+
+#define TEST_QUEUE_SIZE (8192)
+
+/**
+ * @brief The ring guarded by two mutexes and two condition variables, as the ExecutionEngine used to have.
+ */
+class MutexActionQueue {
+    test_action_t action_buffer[TEST_QUEUE_SIZE];
+    std::atomic<size_t> action_buffer_head{0};
+    std::atomic<size_t> action_buffer_tail{0};
+    std::mutex action_buffer_slot_mutex;
+    std::mutex action_buffer_data_mutex;
+    std::condition_variable action_buffer_slot_cv;
+    std::condition_variable action_buffer_data_cv;
+
+    bool is_full() const {
+        return action_buffer_head == (action_buffer_tail + 1) % TEST_QUEUE_SIZE;
+    }
+    bool is_empty() const {
+        return action_buffer_head == action_buffer_tail;
+    }
+
+public:
+    void enqueue(test_action_t&& action) {
+        std::unique_lock<std::mutex> lck(action_buffer_slot_mutex);
+        while (is_full()) {
+            action_buffer_slot_cv.wait_for(lck,std::chrono::milliseconds(10),[this]{return !is_empty();});
+        }
+        action_buffer[action_buffer_tail] = std::move(action);
+        action_buffer_tail = (action_buffer_tail + 1) % TEST_QUEUE_SIZE;
+        action_buffer_data_cv.notify_one();
+    }
+
+    bool dequeue(test_action_t& action, const std::atomic<bool>& is_running) {
+        std::unique_lock<std::mutex> lck(action_buffer_data_mutex);
+        while (is_empty() && is_running) {
+            action_buffer_data_cv.wait_for(lck,std::chrono::milliseconds(10),
+                                           [this,&is_running]{return !is_empty() || !is_running;});
+        }
+        if (is_empty()) {
+            return false;
+        }
+        action = std::move(action_buffer[action_buffer_head]);
+        action_buffer_head = (action_buffer_head + 1) % TEST_QUEUE_SIZE;
+        action_buffer_slot_cv.notify_one();
+        return true;
+    }
+
+    void notify_all() {
+        action_buffer_data_cv.notify_all();
+        action_buffer_slot_cv.notify_all();
+    }
+};
+
+/**
+ * @brief Print the percentiles of a set of latencies.
+ */
+void print_percentiles(const std::string& name, std::vector<uint64_t>& latencies_ns) {
+    if (latencies_ns.empty()) {
+        return;
+    }
+    std::sort(latencies_ns.begin(),latencies_ns.end());
+    auto at = [&latencies_ns](double p) {
+        return latencies_ns[std::min(latencies_ns.size() - 1,static_cast<std::size_t>(p * latencies_ns.size()))];
+    };
+    std::cout << name << " latency(ns): p50=" << at(0.5) << ", p99=" << at(0.99) << ", p99.9=" << at(0.999)
+              << ", max=" << latencies_ns.back() << std::endl;
+}
+
+/**
+ * @brief Run the test.
+ *
+ * @tparam      QueueType           The queue type, with enqueue(), dequeue(), and notify_all().
+ * @param[in]   queue               The queue.
+ * @param[in]   num_workers         The number of worker threads.
+ * @param[in]   num_actions         The number of actions to post.
+ * @param[in]   rate                The posting rate, or 0 for as fast as possible.
+ * @param[in]   cost_ns             The cost of an action.
+ *
+ * @return true if every action is dequeued exactly once.
+ */
+template <typename QueueType>
+bool evaluate(QueueType& queue, uint32_t num_workers, uint64_t num_actions, uint64_t rate, uint64_t cost_ns) {
+    std::atomic<bool> is_running{true};
+    std::vector<std::vector<uint64_t>> delivery_latencies_ns(num_workers);
+    std::vector<uint64_t> sums(num_workers,0);
+    std::atomic<uint64_t> num_dequeued{0};
+    uint64_t last_dequeue_ns = 0;
+    std::mutex last_dequeue_mutex;
+
+    std::vector<std::thread> workers;
+    for (uint32_t w = 0; w < num_workers; w++) {
+        workers.emplace_back([&,w]() {
+            delivery_latencies_ns[w].reserve(num_actions / num_workers + 1);
+            test_action_t action;
+            uint64_t local_last_ns = 0;
+            while (queue.dequeue(action,is_running)) {
+                uint64_t dequeue_ns = get_time_ns(false);
+                delivery_latencies_ns[w].emplace_back(dequeue_ns - action.post_ns);
+                sums[w] += *action.value_ptr;
+                action.value_ptr.reset();
+                local_last_ns = dequeue_ns;
+                num_dequeued.fetch_add(1,std::memory_order_relaxed);
+                if (cost_ns > 0) {
+                    uint64_t deadline_ns = get_time_ns(false) + cost_ns;
+                    while (get_time_ns(false) < deadline_ns);
+                }
+            }
+            std::lock_guard<std::mutex> lck(last_dequeue_mutex);
+            last_dequeue_ns = std::max(last_dequeue_ns,local_last_ns);
+        });
+    }
+
+    std::vector<uint64_t> post_latencies_ns;
+    post_latencies_ns.reserve(num_actions);
+    uint64_t interval_ns = (rate == 0) ? 0 : (1000000000ull / rate);
+    uint64_t start_ns = get_time_ns(false);
+    for (uint64_t i = 1; i <= num_actions; i++) {
+        if (interval_ns > 0) {
+            uint64_t target_ns = start_ns + i * interval_ns;
+            while (get_time_ns(false) < target_ns);
+        }
+        test_action_t action;
+        action.value_ptr = std::make_shared<uint64_t>(i);
+        uint64_t post_ns = get_time_ns(false);
+        action.post_ns = post_ns;
+        queue.enqueue(std::move(action));
+        post_latencies_ns.emplace_back(get_time_ns(false) - post_ns);
+    }
+    while (num_dequeued.load() < num_actions) {
+        std::this_thread::yield();
+    }
+    is_running.store(false);
+    queue.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    uint64_t sum = 0;
+    std::vector<uint64_t> all_delivery_latencies_ns;
+    for (uint32_t w = 0; w < num_workers; w++) {
+        sum += sums[w];
+        all_delivery_latencies_ns.insert(all_delivery_latencies_ns.end(),
+                                         delivery_latencies_ns[w].begin(),delivery_latencies_ns[w].end());
+    }
+    std::cout << "actions:" << num_actions << ", workers:" << num_workers << std::endl;
+    print_percentiles("post",post_latencies_ns);
+    print_percentiles("post-to-dequeue",all_delivery_latencies_ns);
+    std::cout << "dequeue throughput:" << static_cast<double>(num_actions) * 1e3 / (last_dequeue_ns - start_ns)
+              << " M actions/s" << std::endl;
+    if (num_dequeued.load() != num_actions || sum != num_actions * (num_actions + 1) / 2) {
+        std::cerr << "FAILED: the actions are lost or duplicated." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief The main entry.
+ */
+int main(int argc, char** argv) {
+    static struct option long_options[] = {
+        {"queue",       required_argument,  0,  'q'},
+        {"workers",     required_argument,  0,  'w'},
+        {"num_actions", required_argument,  0,  'n'},
+        {"rate",        required_argument,  0,  'r'},
+        {"cost",        required_argument,  0,  'c'},
+        {"help",        no_argument,        0,  'h'},
+        {0,0,0,0}
+    };
+
+    int c;
+    std::string queue_type = "lockfree";
+    uint32_t    num_workers = 4;
+    uint64_t    num_actions = 1000000;
+    uint64_t    rate = 0;
+    uint64_t    cost_ns = 0;
+
+    while (true) {
+        int option_index = 0;
+        c = getopt_long(argc,argv,"q:w:n:r:c:h",long_options,&option_index);
+
+        if (c == -1) {
+            break;
+        }
+
+        switch(c) {
+        case 'q':
+            queue_type = optarg;
+            break;
+        case 'w':
+            num_workers = std::stoul(optarg);
+            break;
+        case 'n':
+            num_actions = std::stoull(optarg);
+            break;
+        case 'r':
+            rate = std::stoull(optarg);
+            break;
+        case 'c':
+            cost_ns = std::stoull(optarg);
+            break;
+        case 'h':
+            std::cout << help_string << std::endl;
+            return 0;
+        case '?':
+        default:
+            std::cout << "unknown options." << std::endl;
+            std::cout << help_string << std::endl;
+            return -1;
+        }
+    }
+
+    if (num_workers == 0 || num_actions == 0) {
+        std::cerr << "num_workers and num_actions must be positive." << std::endl;
+        return -1;
+    }
+    std::cout << "queue=" << queue_type << std::endl;
+    if (queue_type == "lockfree") {
+        ActionQueue<test_action_t> queue(TEST_QUEUE_SIZE);
+        return evaluate(queue, num_workers, num_actions, rate, cost_ns) ? 0 : -1;
+    } else if (queue_type == "mutex") {
+        auto queue = std::make_unique<MutexActionQueue>();
+        return evaluate(*queue, num_workers, num_actions, rate, cost_ns) ? 0 : -1;
+    }
+    std::cerr << "unknown queue:" << queue_type << std::endl;
+    return -1;
+}
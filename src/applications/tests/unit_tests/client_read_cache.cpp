@@ -0,0 +1,190 @@
+#include <cascade/object.hpp>
+#include <cascade/detail/client_read_cache.hpp>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace derecho::cascade;
+
+/**
+ * @file client_read_cache.cpp
+ *
+ * ClientReadCache Tester
+ *
+ * It checks the hits and misses of the client read cache against its invalidations, the version floors of the
+ * client's own writes, the staleness bound, and the byte budget, and that the objects handed out share the cached
+ * object data.
+ */
+
+static uint32_t num_failures = 0;
+
+#define CHECK(cond) \
+    if (!(cond)) { \
+        std::cout << "FAILED: " << __func__ << ":" << __LINE__ << ": " #cond << std::endl; \
+        num_failures++; \
+    }
+
+using cache_t = ClientReadCache<ObjectWithStringKey>;
+
+static constexpr uint64_t owner = 1;
+
+std::shared_ptr<const ObjectWithStringKey> make_object(const std::string& key, persistent::version_t version,
+                                                       std::size_t size) {
+    std::vector<uint8_t> data(size,static_cast<uint8_t>(version));
+    auto object = std::make_shared<ObjectWithStringKey>(key,data.data(),data.size());
+    object->set_version(version);
+    return object;
+}
+
+void fill(cache_t& cache, const std::shared_ptr<const ObjectWithStringKey>& object,
+          const persistent::version_t& version = CURRENT_VERSION) {
+    uint64_t stamp = cache.stamp(object->get_key_ref());
+    cache.fill(owner,object->get_key_ref(),version,false,stamp,object,object->blob.size);
+}
+
+void test_hits_and_sharing() {
+    cache_t cache(1<<20,1000000);
+    auto object = make_object("/pool/a",10,128);
+    fill(cache,object);
+
+    auto cached = cache.find(owner,"/pool/a",CURRENT_VERSION,false);
+    CHECK(cached != nullptr);
+    CHECK(cache.find(owner,"/pool/a",10,false) != nullptr);
+    CHECK(cache.find(owner + 1,"/pool/a",CURRENT_VERSION,false) == nullptr);
+    CHECK(cache.find(owner,"/pool/a",CURRENT_VERSION,true) == nullptr);
+    CHECK(cache.find(owner,"/pool/b",CURRENT_VERSION,false) == nullptr);
+
+    // the object handed out, and its copies, share the cached object data.
+    if (cached) {
+        auto shared = cache_t::share(cached);
+        CHECK(shared.blob.bytes == object->blob.bytes);
+        CHECK(shared.blob.size == object->blob.size);
+        CHECK(shared.get_version() == 10);
+        ObjectWithStringKey copied(shared);
+        CHECK(copied.blob.bytes == object->blob.bytes);
+    }
+
+    // invalid objects, returned for the missing keys, are not cached.
+    uint64_t stamp = cache.stamp("/pool/c");
+    cache.fill(owner,"/pool/c",CURRENT_VERSION,false,stamp,std::make_shared<const ObjectWithStringKey>(),0);
+
+    auto stats = cache.get_stats();
+    CHECK(stats.hits == 2);
+    CHECK(stats.misses == 3);
+    CHECK(stats.fills == 1);
+    CHECK(stats.entries == 1);
+    CHECK(stats.bytes == 128);
+}
+
+void test_invalidations() {
+    cache_t cache(1<<20,1000000);
+    fill(cache,make_object("/pool/a",10,16));
+
+    // an invalidation of an older version keeps the latest version.
+    cache.invalidate("/pool/a",5);
+    CHECK(cache.find(owner,"/pool/a",CURRENT_VERSION,false) != nullptr);
+    // a newer version drops the latest version, but the version itself never changes.
+    cache.invalidate("/pool/a",20);
+    CHECK(cache.find(owner,"/pool/a",CURRENT_VERSION,false) == nullptr);
+    CHECK(cache.find(owner,"/pool/a",10,false) != nullptr);
+
+    // a reply racing an invalidation does not become the latest version.
+    uint64_t stamp = cache.stamp("/pool/a");
+    cache.invalidate("/pool/a",30);
+    auto racing = make_object("/pool/a",20,16);
+    cache.fill(owner,"/pool/a",CURRENT_VERSION,false,stamp,racing,16);
+    CHECK(cache.find(owner,"/pool/a",CURRENT_VERSION,false) == nullptr);
+    CHECK(cache.find(owner,"/pool/a",20,false) != nullptr);
+
+    // a versioned read does not become the latest version.
+    fill(cache,make_object("/pool/a",30,16),30);
+    CHECK(cache.find(owner,"/pool/a",CURRENT_VERSION,false) == nullptr);
+    CHECK(cache.get_stats().invalidations == 3);
+}
+
+void test_write_floors() {
+    cache_t cache(1<<20,1000000);
+    // no fill until the version of the write is known.
+    cache.begin_write("/pool/a");
+    fill(cache,make_object("/pool/a",10,16));
+    CHECK(cache.find(owner,"/pool/a",CURRENT_VERSION,false) == nullptr);
+    // then only the versions at least as new as the write.
+    cache.end_write("/pool/a",20);
+    fill(cache,make_object("/pool/a",10,16));
+    CHECK(cache.find(owner,"/pool/a",CURRENT_VERSION,false) == nullptr);
+    fill(cache,make_object("/pool/a",20,16));
+    CHECK(cache.find(owner,"/pool/a",CURRENT_VERSION,false) != nullptr);
+    // a write drops the latest version.
+    cache.begin_write("/pool/a");
+    CHECK(cache.find(owner,"/pool/a",CURRENT_VERSION,false) == nullptr);
+
+    // a rejected write leaves nothing to wait for.
+    cache.begin_write("/pool/b");
+    cache.end_write("/pool/b",persistent::INVALID_VERSION);
+    fill(cache,make_object("/pool/b",5,16));
+    CHECK(cache.find(owner,"/pool/b",CURRENT_VERSION,false) != nullptr);
+}
+
+void test_staleness() {
+    const uint64_t max_staleness_us = 50000;
+    cache_t cache(1<<20,max_staleness_us);
+    CHECK(cache.get_max_staleness_us() == max_staleness_us);
+
+    // the latest version is served up to the staleness bound.
+    fill(cache,make_object("/pool/a",10,16));
+    CHECK(cache.find(owner,"/pool/a",CURRENT_VERSION,false) != nullptr);
+    std::this_thread::sleep_for(std::chrono::microseconds(2*max_staleness_us));
+    CHECK(cache.find(owner,"/pool/a",CURRENT_VERSION,false) == nullptr);
+    CHECK(cache.find(owner,"/pool/a",10,false) != nullptr);
+
+    // the floor of a write whose reply is never consumed does not block the fills beyond the staleness bound.
+    cache.begin_write("/pool/b");
+    fill(cache,make_object("/pool/b",10,16));
+    CHECK(cache.find(owner,"/pool/b",CURRENT_VERSION,false) == nullptr);
+    std::this_thread::sleep_for(std::chrono::microseconds(2*max_staleness_us));
+    fill(cache,make_object("/pool/b",10,16));
+    CHECK(cache.find(owner,"/pool/b",CURRENT_VERSION,false) != nullptr);
+}
+
+void test_eviction() {
+    const std::size_t capacity_bytes = 1000;
+    cache_t cache(capacity_bytes,1000000);
+    auto first = make_object("/pool/k0",1,200);
+    fill(cache,first);
+    auto view = cache_t::share(cache.find(owner,"/pool/k0",CURRENT_VERSION,false));
+    first.reset();
+
+    for (uint32_t i = 1; i < 20; i++) {
+        fill(cache,make_object("/pool/k" + std::to_string(i),i + 1,200));
+        auto stats = cache.get_stats();
+        CHECK(stats.bytes <= capacity_bytes);
+        CHECK(stats.bytes == stats.entries * 200);
+    }
+    CHECK(cache.get_stats().evictions >= 15);
+    CHECK(cache.find(owner,"/pool/k0",CURRENT_VERSION,false) == nullptr);
+    // a handed out object outlives its eviction.
+    std::vector<uint8_t> expected(200,1);
+    CHECK(view.blob.size == 200 && std::memcmp(view.blob.bytes,expected.data(),200) == 0);
+
+    // an object over the budget is not cached.
+    fill(cache,make_object("/pool/large",1,capacity_bytes + 1));
+    CHECK(cache.find(owner,"/pool/large",CURRENT_VERSION,false) == nullptr);
+}
+
+int main(int argc, char** argv) {
+    test_hits_and_sharing();
+    test_invalidations();
+    test_write_floors();
+    test_staleness();
+    test_eviction();
+    if (num_failures > 0) {
+        std::cout << num_failures << " checks failed." << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <cascade/object.hpp>
+#include <cascade/detail/delta_store_core.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace derecho::cascade;
+
+/**
+ * @file delta_store_core.cpp
+ *
+ * DeltaCascadeStoreCore Tester
+ *
+ * It checks that the tombstones left by removals are reclaimed exactly TOMBSTONE_RECLAIM_DISTANCE versions later,
+ * unless their keys are put again, and that lockless_scan pages through the objects of a prefix in key order, skipping
+ * the tombstones and honouring the item and byte limits of a page.
+ */
+
+static uint32_t num_failures = 0;
+
+#define CHECK(cond) \
+    if (!(cond)) { \
+        std::cout << "FAILED: " << __func__ << ":" << __LINE__ << ": " #cond << std::endl; \
+        num_failures++; \
+    }
+
+using StoreCore = DeltaCascadeStoreCore<std::string, ObjectWithStringKey, &ObjectWithStringKey::IK, &ObjectWithStringKey::IV>;
+
+static const std::vector<uint8_t> value_data(64,'v');
+
+bool put_key(StoreCore& core, const std::string& key, persistent::version_t version) {
+    ObjectWithStringKey value(key,value_data.data(),value_data.size());
+    value.set_version(version);
+    value.set_timestamp(version);
+    bool ret = core.ordered_put(value,version - 1,false);
+    core.delta.clear();
+    return ret;
+}
+
+bool remove_key(StoreCore& core, const std::string& key, persistent::version_t version) {
+    ObjectWithStringKey tombstone(key,nullptr,0);
+    tombstone.set_version(version);
+    tombstone.set_timestamp(version);
+    bool ret = core.ordered_remove(tombstone,version - 1);
+    core.delta.clear();
+    return ret;
+}
+
+bool in_kv_map(const StoreCore& core, const std::string& key) {
+    return core.kv_map.find(key) != core.kv_map.end();
+}
+
+void test_tombstones() {
+    StoreCore core;
+    CHECK(put_key(core,"/pool/a",1));
+    CHECK(put_key(core,"/pool/b",2));
+    CHECK(remove_key(core,"/pool/a",3));
+    // a missing or removed key is not removed again.
+    CHECK(!remove_key(core,"/pool/a",4));
+    CHECK(!remove_key(core,"/pool/c",4));
+    // the tombstone stays as a null object, so the next put of the key still points back at the removal.
+    CHECK(in_kv_map(core,"/pool/a"));
+    CHECK(core.lockless_get("/pool/a").is_null());
+
+    // a removed key put again keeps its new value.
+    CHECK(remove_key(core,"/pool/b",4));
+    CHECK(put_key(core,"/pool/b",5));
+
+    CHECK(put_key(core,"/pool/c",3 + TOMBSTONE_RECLAIM_DISTANCE - 1));
+    CHECK(in_kv_map(core,"/pool/a"));
+    CHECK(core.get_num_reclaimed_tombstones() == 0);
+
+    CHECK(put_key(core,"/pool/c",4 + TOMBSTONE_RECLAIM_DISTANCE));
+    CHECK(!in_kv_map(core,"/pool/a"));
+    CHECK(in_kv_map(core,"/pool/b"));
+    CHECK(!core.lockless_get("/pool/b").is_null());
+    CHECK(core.get_num_reclaimed_tombstones() == 1);
+    CHECK(core.get_reclaimed_tombstone_bytes() > 0);
+
+    // a key put after its tombstone is reclaimed starts over.
+    persistent::version_t version = 5 + TOMBSTONE_RECLAIM_DISTANCE;
+    ObjectWithStringKey value("/pool/a",value_data.data(),value_data.size());
+    value.set_version(version);
+    value.set_timestamp(version);
+    CHECK(core.ordered_put(value,version - 1,false));
+    core.delta.clear();
+    CHECK(value.previous_version_by_key == persistent::INVALID_VERSION);
+}
+
+/** scan all pages of a prefix, returning the keys in scan order and the number of pages. */
+std::vector<std::string> scan_all(const StoreCore& core, const std::string& prefix, uint32_t max_items,
+                                  uint64_t max_bytes, uint32_t& num_pages, std::size_t& max_page_items) {
+    std::vector<std::string> keys;
+    std::string cursor = ObjectWithStringKey::IK;
+    num_pages = 0;
+    max_page_items = 0;
+    do {
+        auto page = core.lockless_scan(prefix,cursor,max_items,max_bytes);
+        for (const auto& value : std::get<0>(page)) {
+            keys.push_back(value.get_key_ref());
+        }
+        max_page_items = std::max(max_page_items,std::get<0>(page).size());
+        cursor = std::get<1>(page);
+        num_pages++;
+    } while (cursor != ObjectWithStringKey::IK && num_pages < 1000);
+    return keys;
+}
+
+void test_scan() {
+    StoreCore core;
+    persistent::version_t version = 1;
+    std::vector<std::string> expected;
+    for (uint32_t i = 0; i < 10; i++) {
+        std::string key = "/pool/k" + std::to_string(i);
+        CHECK(put_key(core,key,version++));
+        if (i != 4) {
+            expected.push_back(key);
+        }
+    }
+    CHECK(put_key(core,"/other/k0",version++));
+    CHECK(remove_key(core,"/pool/k4",version++));
+
+    uint32_t num_pages = 0;
+    std::size_t max_page_items = 0;
+    // one page without limits.
+    CHECK(scan_all(core,"/pool",0,0,num_pages,max_page_items) == expected);
+    CHECK(num_pages == 1);
+
+    // pages of 3 items.
+    CHECK(scan_all(core,"/pool",3,0,num_pages,max_page_items) == expected);
+    CHECK(num_pages == 3);
+    CHECK(max_page_items == 3);
+
+    // pages of 2 objects by size.
+    ObjectWithStringKey sample("/pool/k0",value_data.data(),value_data.size());
+    uint64_t value_bytes = mutils::bytes_size(sample);
+    CHECK(scan_all(core,"/pool",0,2 * value_bytes + 1,num_pages,max_page_items) == expected);
+    CHECK(num_pages == 5);
+    CHECK(max_page_items == 2);
+
+    // a page always holds an object, even over the byte limit.
+    CHECK(scan_all(core,"/pool",0,1,num_pages,max_page_items) == expected);
+    CHECK(num_pages == expected.size());
+
+    // resuming after the last key returns an empty last page.
+    auto page = core.lockless_scan("/pool",expected.back(),0,0);
+    CHECK(std::get<0>(page).empty());
+    CHECK(std::get<1>(page) == ObjectWithStringKey::IK);
+}
+
+int main(int argc, char** argv) {
+    test_tombstones();
+    test_scan();
+    if (num_failures > 0) {
+        std::cout << num_failures << " checks failed." << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed." << std::endl;
+    return 0;
+}
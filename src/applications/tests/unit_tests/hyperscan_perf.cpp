@@ -1,11 +1,17 @@
 #include <getopt.h>
+#include <atomic>
 #include <cinttypes>
 #include <cstring>
+#include <memory>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <iostream>
 #include <cstdlib>
 #include <cascade/utils.hpp>
+#include <cascade/detail/affinity_set_matcher.hpp>
+#include <cascade/detail/object_pool_routing_table.hpp>
 #include <cstdio>
 #include <cerrno>
 #include <fcntl.h>
@@ -17,6 +23,10 @@
  * @file hyperscan_perf.cpp
  *
  * Hyperscan Performance Tester
+ *
+ * Besides scanning test cases with one pattern, this tester measures the routing throughput of keys over hundreds of
+ * object pools, each with its own affinity set regex. It compares one Hyperscan database per object pool, scanned
+ * after the object pool is found, against one multi-pattern AffinitySetMatcher for all object pools.
  */
 
 /**
@@ -42,6 +52,9 @@ const char* help_string =
     "\t                                             timestamp_tag_enabler = " xstr(TLT_HYPERSCAN_START) "\n"
     "\t                                             ///////////////////////////////\n"
     "\t--(p)attern <regex>                          pattern for evaluation\n"
+    "\t--(r)oute <num_pools>                         evaluate routing throughput over object pools with affinity set regexes\n"
+    "\t--(k)eys <num_keys>                           number of keys to route, default: 100000\n"
+    "\t--(t)hreads <num_threads>                     the largest number of routing threads, starting from 1 and doubling, default: 8\n"
     "\t--(h)elp                                     help information\n"
     ;
 
@@ -178,6 +191,168 @@ error_group_0:
     return;
 }
 
+/**
+ * @brief An object pool with its own affinity set database, as the client cached them before AffinitySetMatcher.
+ */
+struct Pool {
+    std::string     pathname;
+    std::string     affinity_set_regex;
+    hs_database_t*  database = nullptr;
+    ~Pool() {
+        if (database != nullptr) {
+            hs_free_database(database);
+        }
+    }
+};
+
+/**
+ * @brief extract the affinity set with the database of the object pool.
+ *
+ * @param[in]   pool        The object pool.
+ * @param[in]   scratch     The scratch of the calling thread, allocated for the databases of all the pools.
+ * @param[in]   key         The key.
+ *
+ * @return a view of the affinity set inside the key.
+ */
+std::string_view per_pool_affinity_set(const Pool* pool, hs_scratch_t* scratch, const std::string& key) {
+    struct hs_scan_ctxt {
+        unsigned long long from = 0;
+        unsigned long long to = 0;
+    } ctxt;
+    hs_scan(pool->database, key.c_str(), key.size(), 0, scratch,
+            [](unsigned int, unsigned long long from, unsigned long long to, unsigned int, void* ctxt)->int {
+                static_cast<struct hs_scan_ctxt*>(ctxt)->from = from;
+                static_cast<struct hs_scan_ctxt*>(ctxt)->to = to;
+                return 0;
+            },
+            &ctxt);
+    if (ctxt.to > ctxt.from) {
+        return std::string_view(key).substr(ctxt.from,ctxt.to-ctxt.from);
+    }
+    return key;
+}
+
+/**
+ * @brief Run a routing function in a number of threads.
+ *
+ * @tparam RouteFunc    uint64_t(hs_scratch_t*, const std::string&), returning the affinity set length.
+ * @param[in]   route           The routing function.
+ * @param[in]   pools           The pools, whose databases each thread allocates its scratch for.
+ * @param[in]   keys            The keys to route.
+ * @param[in]   num_threads     The number of threads.
+ *
+ * @return The throughput in keys per second.
+ */
+template <typename RouteFunc>
+double evaluate_route(const RouteFunc& route, const std::vector<std::shared_ptr<Pool>>& pools,
+                      const std::vector<std::string>& keys, uint32_t num_threads) {
+    std::atomic<uint64_t> checksum{0};
+    std::vector<std::thread> threads;
+    uint64_t start_ns = get_time_ns(false);
+    for (uint32_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&]() {
+            hs_scratch_t* scratch = nullptr;
+            for (const auto& pool: pools) {
+                if (pool->database != nullptr && hs_alloc_scratch(pool->database, &scratch) != HS_SUCCESS) {
+                    std::cerr << "Failed to allocate scratch space." << std::endl;
+                    return;
+                }
+            }
+            uint64_t sum = 0;
+            for (const auto& key: keys) {
+                sum += route(scratch, key);
+            }
+            checksum += sum;
+            hs_free_scratch(scratch);
+        });
+    }
+    for (auto& th: threads) {
+        th.join();
+    }
+    uint64_t elapsed_ns = get_time_ns(false) - start_ns;
+    if (checksum.load() == 0) {
+        std::cerr << "WARNING: no affinity set is extracted." << std::endl;
+    }
+    return static_cast<double>(keys.size()) * num_threads * 1e9 / elapsed_ns;
+}
+
+/**
+ * @brief evaluate the routing throughput over object pools with affinity set regexes.
+ *
+ * @param[in]   num_pools       The number of object pools.
+ * @param[in]   num_keys        The number of keys to route.
+ * @param[in]   max_threads     The largest number of threads.
+ */
+void evaluate_routing(uint32_t num_pools, uint32_t num_keys, uint32_t max_threads) {
+    using namespace derecho::cascade;
+    std::unordered_map<std::string,std::shared_ptr<Pool>> routes;
+    std::vector<std::shared_ptr<Pool>> pools;
+    std::vector<std::pair<const Pool*,std::string>> regexes;
+    for (uint32_t p = 0; p < num_pools; p++) {
+        auto pool = std::make_shared<Pool>();
+        pool->pathname = "/collision/tracking/pool_" + std::to_string(p);
+        // every object pool groups the objects of the same agent.
+        pool->affinity_set_regex = pool->pathname + "/agent_[0-9]+_";
+        hs_compile_error_t* compile_err;
+        if (hs_compile(pool->affinity_set_regex.c_str(), HS_FLAG_DOTALL|HS_FLAG_SOM_LEFTMOST, HS_MODE_BLOCK, NULL,
+                       &pool->database, &compile_err) != HS_SUCCESS) {
+            std::cerr << "ERROR: Unabled to compile pattern \"" << pool->affinity_set_regex << "\":"
+                      << compile_err->message << std::endl;
+            hs_free_compile_error(compile_err);
+            return;
+        }
+        routes.emplace(pool->pathname,pool);
+        regexes.emplace_back(pool.get(),pool->affinity_set_regex);
+        pools.emplace_back(pool);
+    }
+    ObjectPoolRoutingTable<Pool> routing_table(routes);
+    uint64_t compile_start_ns = get_time_ns(false);
+    AffinitySetMatcher<Pool> matcher(regexes);
+    uint64_t compile_ns = get_time_ns(false) - compile_start_ns;
+
+    std::srand(0);
+    std::vector<std::string> keys;
+    for (uint32_t k = 0; k < num_keys; k++) {
+        keys.emplace_back(pools[std::rand() % num_pools]->pathname + "/agent_" + std::to_string(std::rand() % 1000) +
+                          "_frame_" + std::to_string(k));
+    }
+
+    auto per_pool_route = [&](hs_scratch_t* scratch, const std::string& key)->uint64_t {
+        const Pool* pool = routing_table.find_by_key(key);
+        return per_pool_affinity_set(pool,scratch,key).size();
+    };
+    auto matcher_route = [&](hs_scratch_t*, const std::string& key)->uint64_t {
+        const Pool* pool = routing_table.find_by_key(key);
+        return matcher.match(pool,key).size();
+    };
+
+    // both paths must extract the same affinity sets.
+    {
+        hs_scratch_t* scratch = nullptr;
+        for (const auto& pool: pools) {
+            hs_alloc_scratch(pool->database, &scratch);
+        }
+        for (const auto& key: keys) {
+            const Pool* pool = routing_table.find_by_key(key);
+            if (per_pool_affinity_set(pool,scratch,key) != matcher.match(pool,key)) {
+                std::cerr << "ERROR: the affinity sets of " << key << " are different." << std::endl;
+                hs_free_scratch(scratch);
+                return;
+            }
+        }
+        hs_free_scratch(scratch);
+    }
+
+    std::cout << "pools=" << num_pools << ", keys=" << num_keys << ", patterns=" << matcher.size()
+              << ", multi-pattern compile time=" << compile_ns / 1e6 << "ms" << std::endl;
+    std::cout << "threads\t\tper-pool(keys/s)\tmulti-pattern(keys/s)" << std::endl;
+    for (uint32_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        double per_pool_tput = evaluate_route(per_pool_route, pools, keys, num_threads);
+        double matcher_tput = evaluate_route(matcher_route, pools, keys, num_threads);
+        std::cout << num_threads << "\t\t" << per_pool_tput << "\t\t" << matcher_tput << std::endl;
+    }
+}
+
 /**
  * @brief The main entry.
  */
@@ -188,6 +363,9 @@ int main(int argc, char** argv) {
         {"generate-test-cases",     required_argument,  0,  'g'},
         {"evaluate",                required_argument,  0,  'e'},
         {"pattern",                 required_argument,  0,  'p'},
+        {"route",                   required_argument,  0,  'r'},
+        {"keys",                    required_argument,  0,  'k'},
+        {"threads",                 required_argument,  0,  't'},
         {"help",                    no_argument,        0,  'h'},
         {0,0,0,0}
     };
@@ -196,14 +374,18 @@ int main(int argc, char** argv) {
     enum {
         OP_NONE,
         OP_GEN,
-        OP_EVAL}    op = OP_NONE;
+        OP_EVAL,
+        OP_ROUTE}   op = OP_NONE;
     uint32_t        num_test_cases;
     std::string     testcase_file;
     std::string     pattern;
+    uint32_t        num_pools;
+    uint32_t        num_keys = 100000;
+    uint32_t        max_threads = 8;
 
     while (true) {
         int option_index = 0;
-        c = getopt_long(argc,argv,"g:e:p:h",long_options,&option_index);
+        c = getopt_long(argc,argv,"g:e:p:r:k:t:h",long_options,&option_index);
 
         if (c == -1) {
             break;
@@ -221,6 +403,16 @@ int main(int argc, char** argv) {
         case 'p':
             pattern = optarg;
             break;
+        case 'r':
+            op = OP_ROUTE;
+            num_pools = std::stoul(optarg);
+            break;
+        case 'k':
+            num_keys = std::stoul(optarg);
+            break;
+        case 't':
+            max_threads = std::stoul(optarg);
+            break;
         case 'h':
             std::cout << help_string << std::endl;
             return 0;
@@ -240,6 +432,13 @@ int main(int argc, char** argv) {
     case OP_EVAL:
         evaluate_test_cases(pattern, testcase_file);
         break;
+    case OP_ROUTE:
+        if (num_pools == 0 || num_keys == 0) {
+            std::cerr << "num_pools and num_keys must be positive." << std::endl;
+            return -1;
+        }
+        evaluate_routing(num_pools, num_keys, max_threads);
+        break;
     case OP_NONE:
     default:
         std::cout << help_string << std::endl;
@@ -0,0 +1,154 @@
+#include <getopt.h>
+#include <cinttypes>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cascade/service_types.hpp>
+#include <cascade/utils.hpp>
+
+/**
+ * @file jump_hash_perf.cpp
+ *
+ * HASH vs JUMP_HASH Sharding Tester
+ *
+ * This tester places a set of keys with the HASH and the JUMP_HASH sharding policies, and grows the number of shards
+ * one at a time. For each step it reports the fraction of the keys that move to a different shard, which is about
+ * 1/(n+1) for JUMP_HASH and close to 1 for HASH, and the cost of routing a key under each policy.
+ */
+
+using namespace derecho::cascade;
+
+using OPM = ObjectPoolMetadata<VolatileCascadeStoreWithStringKey, PersistentCascadeStoreWithStringKey, TriggerCascadeNoStoreWithStringKey>;
+
+/**
+ * @brief Help string.
+ */
+const char* help_string =
+    "HASH vs JUMP_HASH Sharding Tester\n"
+    "---------------------------------\n"
+    "Options:\n"
+    "\t--(k)eys <num_keys>                          number of keys, default: 1000000\n"
+    "\t--(m)in-shards <num_shards>                  the initial number of shards, default: 1\n"
+    "\t--ma(x)-shards <num_shards>                  the final number of shards, default: 16\n"
+    "\t--(h)elp                                     help information\n"
+    ;
+
+/**
+ * @brief Place the keys on the shards.
+ *
+ * @param[in]   opm         The object pool metadata with the sharding policy.
+ * @param[in]   keys        The keys.
+ * @param[in]   num_shards  The number of shards.
+ * @param[out]  placement   The shard index of each key.
+ *
+ * @return The average routing latency per key, in nanoseconds.
+ */
+double place(const OPM& opm, const std::vector<std::string>& keys, uint32_t num_shards, std::vector<uint32_t>& placement) {
+    placement.resize(keys.size());
+    uint64_t start_ns = get_time_ns(false);
+    for(std::size_t i = 0; i < keys.size(); i++) {
+        placement[i] = opm.key_to_shard_index(keys[i], std::string_view{}, num_shards, false);
+    }
+    return static_cast<double>(get_time_ns(false) - start_ns) / keys.size();
+}
+
+/**
+ * @brief Count the keys placed on different shards.
+ */
+std::size_t count_moved(const std::vector<uint32_t>& before, const std::vector<uint32_t>& after) {
+    std::size_t moved = 0;
+    for(std::size_t i = 0; i < before.size(); i++) {
+        if(before[i] != after[i]) {
+            moved++;
+        }
+    }
+    return moved;
+}
+
+/**
+ * @brief Evaluate both policies as the number of shards grows.
+ *
+ * @param[in]   num_keys    The number of keys.
+ * @param[in]   min_shards  The initial number of shards.
+ * @param[in]   max_shards  The final number of shards.
+ */
+void evaluate(uint32_t num_keys, uint32_t min_shards, uint32_t max_shards) {
+    std::vector<std::string> keys;
+    keys.reserve(num_keys);
+    for(uint32_t k = 0; k < num_keys; k++) {
+        keys.emplace_back("/pool/key_" + std::to_string(k));
+    }
+    OPM hash_opm("/pool", 0, 0, HASH, {}, "", false);
+    OPM jump_hash_opm("/pool", 0, 0, JUMP_HASH, {}, "", false);
+
+    std::vector<uint32_t> hash_before, hash_after, jump_before, jump_after;
+    place(hash_opm, keys, min_shards, hash_before);
+    place(jump_hash_opm, keys, min_shards, jump_before);
+    std::cout << "shards\t\tideal moved\tHASH moved\tJUMP_HASH moved\tHASH(ns/key)\tJUMP_HASH(ns/key)" << std::endl;
+    for(uint32_t num_shards = min_shards + 1; num_shards <= max_shards; num_shards++) {
+        double hash_ns = place(hash_opm, keys, num_shards, hash_after);
+        double jump_ns = place(jump_hash_opm, keys, num_shards, jump_after);
+        std::cout << (num_shards - 1) << "->" << num_shards << "\t\t"
+                  << 1.0 / num_shards << "\t"
+                  << static_cast<double>(count_moved(hash_before, hash_after)) / num_keys << "\t"
+                  << static_cast<double>(count_moved(jump_before, jump_after)) / num_keys << "\t"
+                  << hash_ns << "\t\t" << jump_ns << std::endl;
+        hash_before.swap(hash_after);
+        jump_before.swap(jump_after);
+    }
+}
+
+/**
+ * @brief The main entry.
+ */
+int main(int argc, char** argv) {
+    static struct option long_options[] = {
+        {"keys",        required_argument,  0,  'k'},
+        {"min-shards",  required_argument,  0,  'm'},
+        {"max-shards",  required_argument,  0,  'x'},
+        {"help",        no_argument,        0,  'h'},
+        {0,0,0,0}
+    };
+
+    int c;
+    uint32_t    num_keys = 1000000;
+    uint32_t    min_shards = 1;
+    uint32_t    max_shards = 16;
+
+    while (true) {
+        int option_index = 0;
+        c = getopt_long(argc,argv,"k:m:x:h",long_options,&option_index);
+
+        if (c == -1) {
+            break;
+        }
+
+        switch(c) {
+        case 'k':
+            num_keys = std::stoul(optarg);
+            break;
+        case 'm':
+            min_shards = std::stoul(optarg);
+            break;
+        case 'x':
+            max_shards = std::stoul(optarg);
+            break;
+        case 'h':
+            std::cout << help_string << std::endl;
+            return 0;
+        case '?':
+        default:
+            std::cout << "unknown options." << std::endl;
+            std::cout << help_string << std::endl;
+            return -1;
+        }
+    }
+
+    if (num_keys == 0 || min_shards == 0 || max_shards <= min_shards) {
+        std::cerr << "num_keys and min_shards must be positive, and max_shards must be greater than min_shards." << std::endl;
+        return -1;
+    }
+    evaluate(num_keys, min_shards, max_shards);
+    return 0;
+}
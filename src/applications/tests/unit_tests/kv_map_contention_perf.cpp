@@ -0,0 +1,265 @@
+#include <getopt.h>
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cascade/detail/concurrent_ordered_map.hpp>
+#include <cascade/utils.hpp>
+
+/**
+ * @file kv_map_contention_perf.cpp
+ *
+ * kv_map Reader/Writer Contention Tester
+ *
+ * One writer thread keeps updating random keys, like the predicate thread does under a write-heavy workload, while a
+ * number of reader threads keep getting random keys. It compares the seqlock-protected std::map previously used by the
+ * cascade stores against ConcurrentOrderedMap, and reports the read latency percentiles and the read/write throughput.
+ */
+
+using namespace derecho::cascade;
+
+/**
+ * @brief Help string.
+ */
+const char* help_string =
+    "kv_map Reader/Writer Contention Tester\n"
+    "--------------------------------------\n"
+    "Options:\n"
+    "\t--(m)ap <seqlock|concurrent|both>            the map to evaluate, default: both\n"
+    "\t--(r)eaders <num_readers>                    number of reader threads, default: 4\n"
+    "\t--(k)eys <num_keys>                          number of keys, default: 10000\n"
+    "\t--(s)ize <value_size>                        value size in bytes, default: 1024\n"
+    "\t--(d)uration <seconds>                       duration of each evaluation, default: 5\n"
+    "\t--(h)elp                                     help information\n"
+    ;
+
+/** The maximum number of latency samples a reader keeps. */
+#define MAX_SAMPLES_PER_READER  (1ul << 22)
+
+/**
+ * @brief The std::map with the lockless_v1/lockless_v2 seqlock, as used by the cascade stores before
+ * ConcurrentOrderedMap. Note that the readers traverse the std::map while it is being modified.
+ */
+class SeqlockMap {
+    std::atomic<uint64_t> lockless_v1{0};
+    std::atomic<uint64_t> lockless_v2{0};
+    std::map<std::string, std::string> kv_map;
+
+public:
+    std::atomic<uint64_t> retries{0};
+
+    void put(const std::string& key, const std::string& value, uint64_t ver) {
+        lockless_v1.store(ver, std::memory_order_relaxed);
+        asm volatile("" ::: "memory");
+        kv_map.erase(key);
+        kv_map.emplace(key, value);
+        asm volatile("" ::: "memory");
+        lockless_v2.store(ver, std::memory_order_relaxed);
+    }
+
+    bool get(const std::string& key, std::string& copied_out) {
+        uint64_t v1, v2;
+        bool found = false;
+        uint64_t local_retries = 0;
+        do {
+            v2 = lockless_v2.load(std::memory_order_relaxed);
+            asm volatile("" ::: "memory");
+            while(true) {
+                try {
+                    found = (kv_map.find(key) != kv_map.end());
+                    if(found) {
+                        copied_out.assign(kv_map.at(key));
+                    }
+                    break;
+                } catch(const std::out_of_range&) {
+                    local_retries++;
+                }
+            }
+            asm volatile("" ::: "memory");
+            v1 = lockless_v1.load(std::memory_order_relaxed);
+            std::this_thread::yield();
+            local_retries++;
+        } while(v1 != v2);
+        retries.fetch_add(local_retries - 1, std::memory_order_relaxed);
+        return found;
+    }
+};
+
+/**
+ * @brief ConcurrentOrderedMap with the same interface as SeqlockMap.
+ */
+class ConcurrentMap {
+    ConcurrentOrderedMap<std::string, std::string> kv_map;
+
+public:
+    std::atomic<uint64_t> retries{0};
+
+    void put(const std::string& key, const std::string& value, uint64_t) {
+        kv_map.insert_or_assign(key, value);
+    }
+
+    bool get(const std::string& key, std::string& copied_out) {
+        return kv_map.read(key, [&copied_out](const std::string& value) { copied_out.assign(value); });
+    }
+};
+
+/**
+ * @brief Run one evaluation and print the result.
+ *
+ * @tparam MapType          SeqlockMap or ConcurrentMap
+ * @param[in]   name        The name of the map, used for printing.
+ * @param[in]   num_readers The number of reader threads.
+ * @param[in]   num_keys    The number of keys.
+ * @param[in]   value_size  The value size in bytes.
+ * @param[in]   duration_s  The duration in seconds.
+ */
+template <typename MapType>
+void evaluate(const std::string& name, uint32_t num_readers, uint32_t num_keys, uint32_t value_size, uint32_t duration_s) {
+    MapType map;
+    std::vector<std::string> keys;
+    for(uint32_t i = 0; i < num_keys; i++) {
+        keys.emplace_back("/pool/key_" + std::to_string(i));
+    }
+    std::string value(value_size, 'v');
+    uint64_t version = 0;
+    for(const auto& key : keys) {
+        map.put(key, value, ++version);
+    }
+
+    std::atomic<bool> started{false};
+    std::atomic<bool> stopped{false};
+    std::vector<std::vector<uint64_t>> latencies(num_readers);
+    std::vector<std::thread> readers;
+    for(uint32_t r = 0; r < num_readers; r++) {
+        readers.emplace_back([&, r]() {
+            std::mt19937_64 rng(r + 1);
+            std::uniform_int_distribution<uint32_t> dist(0, num_keys - 1);
+            std::string copied_out;
+            auto& samples = latencies[r];
+            samples.reserve(MAX_SAMPLES_PER_READER);
+            while(!started.load(std::memory_order_acquire)) {
+            }
+            while(!stopped.load(std::memory_order_relaxed)) {
+                const auto& key = keys[dist(rng)];
+                uint64_t start_ns = get_time_ns(false);
+                map.get(key, copied_out);
+                uint64_t end_ns = get_time_ns(false);
+                if(samples.size() < MAX_SAMPLES_PER_READER) {
+                    samples.push_back(end_ns - start_ns);
+                }
+            }
+        });
+    }
+
+    std::mt19937_64 rng(0);
+    std::uniform_int_distribution<uint32_t> dist(0, num_keys - 1);
+    uint64_t num_writes = 0;
+    started.store(true, std::memory_order_release);
+    uint64_t start_ns = get_time_ns(false);
+    uint64_t end_ns = start_ns + static_cast<uint64_t>(duration_s) * 1000000000ull;
+    while(get_time_ns(false) < end_ns) {
+        value[0] = static_cast<char>('a' + (num_writes % 26));
+        map.put(keys[dist(rng)], value, ++version);
+        num_writes++;
+    }
+    stopped.store(true);
+    for(auto& reader : readers) {
+        reader.join();
+    }
+    double elapsed_s = static_cast<double>(get_time_ns(false) - start_ns) / 1e9;
+
+    std::vector<uint64_t> all;
+    for(auto& samples : latencies) {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p) -> uint64_t {
+        if(all.empty()) {
+            return 0;
+        }
+        return all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))];
+    };
+    std::cout << name << ": readers=" << num_readers << ", keys=" << num_keys << ", value_size=" << value_size << std::endl;
+    std::cout << "\tread ops/s:\t" << static_cast<double>(all.size()) / elapsed_s << std::endl;
+    std::cout << "\twrite ops/s:\t" << static_cast<double>(num_writes) / elapsed_s << std::endl;
+    std::cout << "\tread latency (ns) p50/p99/p999/max:\t"
+              << percentile(0.5) << "/" << percentile(0.99) << "/" << percentile(0.999) << "/"
+              << (all.empty() ? 0 : all.back()) << std::endl;
+    std::cout << "\treader retries:\t" << map.retries.load() << std::endl;
+}
+
+/**
+ * @brief The main entry.
+ */
+int main(int argc, char** argv) {
+    static struct option long_options[] = {
+        {"map",         required_argument,  0,  'm'},
+        {"readers",     required_argument,  0,  'r'},
+        {"keys",        required_argument,  0,  'k'},
+        {"size",        required_argument,  0,  's'},
+        {"duration",    required_argument,  0,  'd'},
+        {"help",        no_argument,        0,  'h'},
+        {0,0,0,0}
+    };
+
+    int c;
+    std::string map_type = "both";
+    uint32_t    num_readers = 4;
+    uint32_t    num_keys = 10000;
+    uint32_t    value_size = 1024;
+    uint32_t    duration_s = 5;
+
+    while (true) {
+        int option_index = 0;
+        c = getopt_long(argc,argv,"m:r:k:s:d:h",long_options,&option_index);
+
+        if (c == -1) {
+            break;
+        }
+
+        switch(c) {
+        case 'm':
+            map_type = optarg;
+            break;
+        case 'r':
+            num_readers = std::stoul(optarg);
+            break;
+        case 'k':
+            num_keys = std::stoul(optarg);
+            break;
+        case 's':
+            value_size = std::stoul(optarg);
+            break;
+        case 'd':
+            duration_s = std::stoul(optarg);
+            break;
+        case 'h':
+            std::cout << help_string << std::endl;
+            return 0;
+        case '?':
+        default:
+            std::cout << "unknown options." << std::endl;
+            std::cout << help_string << std::endl;
+            return -1;
+        }
+    }
+
+    if (num_keys == 0) {
+        std::cerr << "num_keys must be positive." << std::endl;
+        return -1;
+    }
+    if (map_type == "seqlock" || map_type == "both") {
+        evaluate<SeqlockMap>("seqlock std::map", num_readers, num_keys, value_size, duration_s);
+    }
+    if (map_type == "concurrent" || map_type == "both") {
+        evaluate<ConcurrentMap>("ConcurrentOrderedMap", num_readers, num_keys, value_size, duration_s);
+    }
+    return 0;
+}
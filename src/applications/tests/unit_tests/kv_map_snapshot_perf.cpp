@@ -0,0 +1,186 @@
+#include <getopt.h>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <cascade/object.hpp>
+#include <cascade/utils.hpp>
+#include <cascade/detail/delta_store_core.hpp>
+
+/**
+ * @file kv_map_snapshot_perf.cpp
+ *
+ * kv_map Snapshot Startup Time Tester
+ *
+ * This tester generates a log of deltas by putting random keys, and writes a kv_map snapshot a given number of updates
+ * before the end of the log. It then measures the time to rebuild the state the way a PersistentCascadeStore restarts:
+ * by applying every delta in the log, and by loading the snapshot and applying the log, where the deltas covered by the
+ * snapshot are skipped.
+ */
+
+using namespace derecho::cascade;
+
+using StoreCore = DeltaCascadeStoreCore<std::string, ObjectWithStringKey, &ObjectWithStringKey::IK, &ObjectWithStringKey::IV>;
+
+/**
+ * @brief Help string.
+ */
+const char* help_string =
+    "kv_map Snapshot Startup Time Tester\n"
+    "-----------------------------------\n"
+    "Options:\n"
+    "\t--(k)eys <num_keys>                          number of keys, default: 100000\n"
+    "\t--(u)pdates <num_updates>                    number of deltas in the log, default: 1000000\n"
+    "\t--(s)ize <value_size>                        value size in bytes, default: 256\n"
+    "\t--su(f)fix <num_updates>                     number of deltas after the snapshot, default: 10000\n"
+    "\t--(o)utput <filename>                        the snapshot file, default: kv_map_snapshot_perf.snapshot\n"
+    "\t--(h)elp                                     help information\n"
+    ;
+
+/**
+ * @brief Evaluate the startup time with and without a snapshot.
+ *
+ * @param[in]   num_keys        The number of keys.
+ * @param[in]   num_updates     The number of deltas in the log.
+ * @param[in]   value_size      The value size in bytes.
+ * @param[in]   num_suffix      The number of deltas after the snapshot.
+ * @param[in]   filename        The snapshot file.
+ *
+ * @return true if the state restored from the snapshot matches the state replayed from the log, otherwise false.
+ */
+bool evaluate(uint32_t num_keys, uint64_t num_updates, uint32_t value_size, uint64_t num_suffix, const std::string& filename) {
+    // generate the log and the snapshot.
+    std::vector<std::vector<uint8_t>> log;
+    log.reserve(num_updates);
+    uint64_t snapshot_ns = 0;
+    {
+        StoreCore writer_core;
+        std::mt19937_64 rng(0);
+        std::uniform_int_distribution<uint32_t> dist(0, num_keys - 1);
+        std::vector<uint8_t> data(value_size, 'v');
+        for(uint64_t ver = 1; ver <= num_updates; ver++) {
+            ObjectWithStringKey value("/pool/key_" + std::to_string(dist(rng)), data.data(), value_size);
+            value.set_version(static_cast<persistent::version_t>(ver));
+            value.set_timestamp(ver);
+            writer_core.ordered_put(value, static_cast<persistent::version_t>(ver - 1), false);
+            std::vector<uint8_t> delta(writer_core.currentDeltaSize());
+            writer_core.currentDeltaToBytes(delta.data(), delta.size());
+            log.emplace_back(std::move(delta));
+            if(ver == num_updates - num_suffix) {
+                uint64_t start_ns = get_time_ns(false);
+                if(!writer_core.lockless_save_snapshot(filename, static_cast<persistent::version_t>(ver))) {
+                    std::cerr << "ERROR: failed to write the snapshot to " << filename << "." << std::endl;
+                    return false;
+                }
+                snapshot_ns = get_time_ns(false) - start_ns;
+            }
+        }
+    }
+
+    // restart by applying the whole log.
+    uint64_t start_ns = get_time_ns(false);
+    auto full_core = StoreCore::create(nullptr);
+    for(const auto& delta : log) {
+        full_core->applyDelta(delta.data());
+    }
+    uint64_t full_replay_ns = get_time_ns(false) - start_ns;
+
+    // restart from the snapshot.
+    KVMapSnapshotContext snapshot_context(filename);
+    mutils::DeserializationManager dsm({&snapshot_context});
+    start_ns = get_time_ns(false);
+    auto snapshot_core = StoreCore::create(&dsm);
+    uint64_t load_ns = get_time_ns(false) - start_ns;
+    for(const auto& delta : log) {
+        snapshot_core->applyDelta(delta.data());
+    }
+    uint64_t snapshot_replay_ns = get_time_ns(false) - start_ns;
+
+    bool ok = true;
+    if(snapshot_core->get_snapshot_max_version() == persistent::INVALID_VERSION) {
+        std::cerr << "ERROR: the snapshot is not loaded." << std::endl;
+        ok = false;
+    }
+    if(full_core->kv_map.size() != snapshot_core->kv_map.size()
+       || full_core->kv_map.bytes_size() != snapshot_core->kv_map.bytes_size()) {
+        std::cerr << "ERROR: the state restored from the snapshot differs from the state replayed from the log." << std::endl;
+        ok = false;
+    }
+    std::remove(filename.c_str());
+
+    std::cout << "keys=" << full_core->kv_map.size() << ", log_entries=" << num_updates << ", value_size=" << value_size
+              << ", suffix=" << num_suffix << std::endl;
+    std::cout << "\tsnapshot write(ms):\t" << static_cast<double>(snapshot_ns) / 1e6 << std::endl;
+    std::cout << "\tfull replay(ms):\t" << static_cast<double>(full_replay_ns) / 1e6 << std::endl;
+    std::cout << "\tsnapshot load(ms):\t" << static_cast<double>(load_ns) / 1e6 << std::endl;
+    std::cout << "\tsnapshot + suffix(ms):\t" << static_cast<double>(snapshot_replay_ns) / 1e6 << std::endl;
+    std::cout << "\tspeedup:\t\t" << static_cast<double>(full_replay_ns) / snapshot_replay_ns << std::endl;
+    return ok;
+}
+
+/**
+ * @brief The main entry.
+ */
+int main(int argc, char** argv) {
+    static struct option long_options[] = {
+        {"keys",        required_argument,  0,  'k'},
+        {"updates",     required_argument,  0,  'u'},
+        {"size",        required_argument,  0,  's'},
+        {"suffix",      required_argument,  0,  'f'},
+        {"output",      required_argument,  0,  'o'},
+        {"help",        no_argument,        0,  'h'},
+        {0,0,0,0}
+    };
+
+    int c;
+    uint32_t    num_keys = 100000;
+    uint64_t    num_updates = 1000000;
+    uint32_t    value_size = 256;
+    uint64_t    num_suffix = 10000;
+    std::string filename = "kv_map_snapshot_perf.snapshot";
+
+    while (true) {
+        int option_index = 0;
+        c = getopt_long(argc,argv,"k:u:s:f:o:h",long_options,&option_index);
+
+        if (c == -1) {
+            break;
+        }
+
+        switch(c) {
+        case 'k':
+            num_keys = std::stoul(optarg);
+            break;
+        case 'u':
+            num_updates = std::stoull(optarg);
+            break;
+        case 's':
+            value_size = std::stoul(optarg);
+            break;
+        case 'f':
+            num_suffix = std::stoull(optarg);
+            break;
+        case 'o':
+            filename = optarg;
+            break;
+        case 'h':
+            std::cout << help_string << std::endl;
+            return 0;
+        case '?':
+        default:
+            std::cout << "unknown options." << std::endl;
+            std::cout << help_string << std::endl;
+            return -1;
+        }
+    }
+
+    if (num_keys == 0 || num_suffix >= num_updates) {
+        std::cerr << "num_keys must be positive, and the suffix must be shorter than the log." << std::endl;
+        return -1;
+    }
+    return evaluate(num_keys, num_updates, value_size, num_suffix, filename) ? 0 : -1;
+}
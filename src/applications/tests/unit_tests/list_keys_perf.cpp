@@ -0,0 +1,156 @@
+#include <getopt.h>
+#include <cinttypes>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cascade/detail/debug_util.hpp>
+#include <cascade/utils.hpp>
+#include <cascade/detail/store_util.hpp>
+
+/**
+ * @file list_keys_perf.cpp
+ *
+ * list_keys Performance Tester
+ *
+ * A shard holds a growing number of keys spread over many object pools, plus a small object pool with a fixed number
+ * of keys. For each shard size, this tester lists the small object pool with a full kv_map scan, which is how
+ * list_keys was implemented before, and with the prefix range scan in list_keys_by_prefix().
+ */
+
+using namespace derecho::cascade;
+
+/**
+ * @brief Help string.
+ */
+const char* help_string =
+    "list_keys Performance Tester\n"
+    "----------------------------\n"
+    "Options:\n"
+    "\t--(m)ax-keys <num_keys>                      the largest shard size, starting from 1000 and growing by 10x, default: 1000000\n"
+    "\t--(p)ools <num_pools>                        number of object pools holding the shard keys, default: 100\n"
+    "\t--(l)isted-keys <num_keys>                   number of keys in the listed object pool, default: 100\n"
+    "\t--(i)terations <num_iterations>              number of listings per shard size, default: 100\n"
+    "\t--(h)elp                                     help information\n"
+    ;
+
+/**
+ * @brief list the keys with a full scan, the way list_keys was implemented before list_keys_by_prefix().
+ */
+std::vector<std::string> full_scan_list_keys(const ConcurrentOrderedMap<std::string, std::string>& kv_map, const std::string& prefix) {
+    std::vector<std::string> key_list;
+    kv_map.for_each([&key_list, &prefix](const std::string& key, const std::string&) {
+        if(get_pathname<std::string>(key).find(prefix) == 0) {
+            key_list.push_back(key);
+        }
+    });
+    return key_list;
+}
+
+/**
+ * @brief Evaluate the listing cost as the shard grows.
+ *
+ * @param[in]   max_keys        The largest shard size.
+ * @param[in]   num_pools       The number of object pools holding the shard keys.
+ * @param[in]   num_listed_keys The number of keys in the listed object pool.
+ * @param[in]   num_iterations  The number of listings per shard size.
+ */
+void evaluate(uint64_t max_keys, uint32_t num_pools, uint32_t num_listed_keys, uint32_t num_iterations) {
+    ConcurrentOrderedMap<std::string, std::string> kv_map;
+    const std::string listed_prefix = "/pool_listed";
+    for(uint32_t i = 0; i < num_listed_keys; i++) {
+        std::string key = listed_prefix + "/key_" + std::to_string(i);
+        kv_map.insert_or_assign(key, key);
+    }
+
+    std::cout << "shard_keys\tlisted_keys\tfull_scan(us)\tprefix_scan(us)" << std::endl;
+    uint64_t num_keys = 0;
+    for(uint64_t shard_size = 1000; shard_size <= max_keys; shard_size *= 10) {
+        while(num_keys < shard_size) {
+            std::string key = "/pool_" + std::to_string(num_keys % num_pools) + "/key_" + std::to_string(num_keys);
+            kv_map.insert_or_assign(key, key);
+            num_keys++;
+        }
+
+        size_t full_scan_count = 0;
+        uint64_t start_ns = get_time_ns(false);
+        for(uint32_t i = 0; i < num_iterations; i++) {
+            full_scan_count = full_scan_list_keys(kv_map, listed_prefix).size();
+        }
+        uint64_t full_scan_ns = get_time_ns(false) - start_ns;
+
+        size_t prefix_scan_count = 0;
+        start_ns = get_time_ns(false);
+        for(uint32_t i = 0; i < num_iterations; i++) {
+            prefix_scan_count = list_keys_by_prefix(kv_map, listed_prefix).size();
+        }
+        uint64_t prefix_scan_ns = get_time_ns(false) - start_ns;
+
+        if(full_scan_count != prefix_scan_count) {
+            std::cerr << "ERROR: full scan listed " << full_scan_count << " keys, but prefix scan listed "
+                      << prefix_scan_count << " keys." << std::endl;
+        }
+        std::cout << shard_size << "\t\t" << prefix_scan_count << "\t\t"
+                  << static_cast<double>(full_scan_ns) / num_iterations / 1e3 << "\t\t"
+                  << static_cast<double>(prefix_scan_ns) / num_iterations / 1e3 << std::endl;
+    }
+}
+
+/**
+ * @brief The main entry.
+ */
+int main(int argc, char** argv) {
+    static struct option long_options[] = {
+        {"max-keys",        required_argument,  0,  'm'},
+        {"pools",           required_argument,  0,  'p'},
+        {"listed-keys",     required_argument,  0,  'l'},
+        {"iterations",      required_argument,  0,  'i'},
+        {"help",            no_argument,        0,  'h'},
+        {0,0,0,0}
+    };
+
+    int c;
+    uint64_t    max_keys = 1000000;
+    uint32_t    num_pools = 100;
+    uint32_t    num_listed_keys = 100;
+    uint32_t    num_iterations = 100;
+
+    while (true) {
+        int option_index = 0;
+        c = getopt_long(argc,argv,"m:p:l:i:h",long_options,&option_index);
+
+        if (c == -1) {
+            break;
+        }
+
+        switch(c) {
+        case 'm':
+            max_keys = std::stoull(optarg);
+            break;
+        case 'p':
+            num_pools = std::stoul(optarg);
+            break;
+        case 'l':
+            num_listed_keys = std::stoul(optarg);
+            break;
+        case 'i':
+            num_iterations = std::stoul(optarg);
+            break;
+        case 'h':
+            std::cout << help_string << std::endl;
+            return 0;
+        case '?':
+        default:
+            std::cout << "unknown options." << std::endl;
+            std::cout << help_string << std::endl;
+            return -1;
+        }
+    }
+
+    if (num_pools == 0 || num_iterations == 0) {
+        std::cerr << "num_pools and num_iterations must be positive." << std::endl;
+        return -1;
+    }
+    evaluate(max_keys, num_pools, num_listed_keys, num_iterations);
+    return 0;
+}
@@ -0,0 +1,385 @@
+#include <getopt.h>
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cascade/service.hpp>
+#include <cascade/utils.hpp>
+
+/**
+ * @file member_selection_perf.cpp
+ *
+ * Shard Member Selection Policy Stress Tester
+ *
+ * This tester drives the member selection of ServiceClient against the members of one shard, one of which is
+ * artificially slowed. The LeastOutstandingRequests and PowerOfTwoChoices policies are picked, and the replies
+ * accounted for, by the MemberLoads that ServiceClient::pick_member_by_policy() and ServiceClient::track_replies()
+ * use; RoundRobin and Random follow the same rules as pick_member_by_policy(). The members have node ids 256 apart.
+ *
+ * Two modes are run for each policy:
+ * 1) A discrete-event simulation, where each member serves its requests one at a time in FIFO order with exponentially
+ *    distributed service times, and the requests arrive as a Poisson process. It reports the reply latency percentiles
+ *    and the share of the requests sent to the slow member. The results are repeatable.
+ * 2) A stress run, where client threads send requests to server threads, one per member, in a closed loop, and track
+ *    the replies with MemberLoads::track(), which accounts for them in the reply watcher threads. It reports the time
+ *    to pick a member, the reply latency, and the share of the requests sent to the slow member.
+ *
+ * No cluster is needed.
+ */
+
+using namespace derecho::cascade;
+
+/**
+ * @brief Help string.
+ */
+const char* help_string =
+    "Shard Member Selection Policy Stress Tester\n"
+    "-------------------------------------------\n"
+    "Options:\n"
+    "\t--(m)embers <num_members>                    number of shard members, default: 3\n"
+    "\t--(s)ervice <service_time_us>                mean service time of a member in microseconds, default: 100\n"
+    "\t--s(l)owdown <factor>                        the slow member's service time multiplier, default: 10\n"
+    "\t--(u)tilization <utilization>                offered load over the capacity of the shard, default: 0.6\n"
+    "\t--(r)equests <num_requests>                  number of requests to simulate, default: 1000000\n"
+    "\t--(t)hreads <num_threads>                    number of client threads in the stress run, default: 8\n"
+    "\t--(o)ps <ops_per_thread>                     number of requests per client thread in the stress run, default: 2000\n"
+    "\t--(h)elp                                     help information\n"
+    ;
+
+/**
+ * @brief The node id of a member. The ids are 256 apart, so that members never look alike by their low bits.
+ */
+inline derecho::node_id_t node_id_of(uint32_t member_index) {
+    return member_index * 256 + 1;
+}
+
+/**
+ * @brief Pick a member by policy, with MemberLoads for the adaptive policies and the same rules as
+ * ServiceClient::pick_member_by_policy() for the others.
+ */
+derecho::node_id_t pick_member(ShardMemberSelectionPolicy policy, const std::vector<derecho::node_id_t>& node_ids,
+                      const MemberLoads& loads, std::atomic<uint32_t>& position, std::minstd_rand& rng) {
+    switch(policy) {
+    case ShardMemberSelectionPolicy::RoundRobin:
+        return node_ids[position.fetch_add(1, std::memory_order_relaxed) % node_ids.size()];
+    case ShardMemberSelectionPolicy::Random:
+        return node_ids[rng() % node_ids.size()];
+    case ShardMemberSelectionPolicy::LeastOutstandingRequests:
+        return loads.pick_least_outstanding(node_ids, position.fetch_add(1, std::memory_order_relaxed));
+    case ShardMemberSelectionPolicy::PowerOfTwoChoices:
+        return loads.pick_power_of_two_choices(node_ids, rng);
+    default:
+        return node_ids.front();
+    }
+}
+
+/**
+ * @brief Simulate one policy.
+ *
+ * @param[in]   policy          The member selection policy.
+ * @param[in]   num_members     The number of shard members.
+ * @param[in]   service_us      The mean service time of a normal member.
+ * @param[in]   slowdown        The service time multiplier of the slow member.
+ * @param[in]   utilization     The offered load over the capacity of the shard.
+ * @param[in]   num_requests    The number of requests.
+ */
+void simulate_policy(ShardMemberSelectionPolicy policy, uint32_t num_members, double service_us, double slowdown,
+                     double utilization, uint32_t num_requests) {
+    std::vector<derecho::node_id_t> node_ids(num_members);
+    std::vector<double> mean_service_us(num_members);
+    std::vector<double> busy_until_us(num_members, 0);
+    double capacity_per_us = 0;
+    for(uint32_t m = 0; m < num_members; m++) {
+        node_ids[m] = node_id_of(m);
+        // the last member is the slow one.
+        mean_service_us[m] = (m + 1 == num_members) ? service_us * slowdown : service_us;
+        capacity_per_us += 1.0 / mean_service_us[m];
+    }
+    const double arrival_rate_per_us = capacity_per_us * utilization;
+
+    MemberLoads loads;
+    std::minstd_rand rng(0);
+    std::exponential_distribution<double> inter_arrival(arrival_rate_per_us);
+    std::exponential_distribution<double> service(1.0);
+    std::atomic<uint32_t> position{0};
+
+    // completion events: (completion time, member, send time)
+    using event_t = std::tuple<double, uint32_t, double>;
+    std::priority_queue<event_t, std::vector<event_t>, std::greater<event_t>> completions;
+    std::vector<double> latencies;
+    latencies.reserve(num_requests);
+    uint64_t sent_to_slow_member = 0;
+
+    auto complete = [&](const event_t& event) {
+        double latency_us = std::get<0>(event) - std::get<2>(event);
+        // the simulated time stands in for the clock of the replies.
+        loads.on_reply(node_ids[std::get<1>(event)], static_cast<uint64_t>(latency_us * 1000));
+        latencies.emplace_back(latency_us);
+    };
+
+    double now_us = 0;
+    for(uint32_t r = 0; r < num_requests; r++) {
+        now_us += inter_arrival(rng);
+        while(!completions.empty() && std::get<0>(completions.top()) <= now_us) {
+            complete(completions.top());
+            completions.pop();
+        }
+        derecho::node_id_t node_id = pick_member(policy, node_ids, loads, position, rng);
+        uint32_t m = (node_id - 1) / 256;
+        busy_until_us[m] = std::max(busy_until_us[m], now_us) + service(rng) * mean_service_us[m];
+        loads.on_send(node_id);
+        completions.emplace(busy_until_us[m], m, now_us);
+        if(m + 1 == num_members) {
+            sent_to_slow_member++;
+        }
+    }
+    while(!completions.empty()) {
+        complete(completions.top());
+        completions.pop();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(p * latencies.size()))];
+    };
+    double sum = 0;
+    for(const auto l : latencies) {
+        sum += l;
+    }
+    std::cout << policy << "\t" << sum / latencies.size() << "\t" << percentile(0.5) << "\t" << percentile(0.99)
+              << "\t" << percentile(0.999) << "\t" << static_cast<double>(sent_to_slow_member) / num_requests
+              << std::endl;
+}
+
+/**
+ * @brief A member serving its requests one at a time in FIFO order, in its own thread.
+ */
+class member_server_t {
+    const double mean_service_us;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::promise<uint64_t>> requests;
+    bool stopping = false;
+    std::thread server;
+
+public:
+    member_server_t(double _mean_service_us, uint32_t seed) : mean_service_us(_mean_service_us) {
+        server = std::thread([this, seed]() {
+            std::minstd_rand rng(seed);
+            std::exponential_distribution<double> service(1.0);
+            while(true) {
+                std::promise<uint64_t> request;
+                {
+                    std::unique_lock<std::mutex> lck(mutex);
+                    cv.wait(lck, [this]() { return stopping || !requests.empty(); });
+                    if(requests.empty()) {
+                        return;
+                    }
+                    request = std::move(requests.front());
+                    requests.pop_front();
+                }
+                std::this_thread::sleep_for(std::chrono::nanoseconds(
+                        static_cast<uint64_t>(service(rng) * mean_service_us * 1000)));
+                request.set_value(get_time_ns(false));
+            }
+        });
+    }
+
+    std::future<uint64_t> send() {
+        std::promise<uint64_t> request;
+        auto reply = request.get_future();
+        {
+            std::lock_guard<std::mutex> lck(mutex);
+            requests.emplace_back(std::move(request));
+        }
+        cv.notify_one();
+        return reply;
+    }
+
+    ~member_server_t() {
+        {
+            std::lock_guard<std::mutex> lck(mutex);
+            stopping = true;
+        }
+        cv.notify_one();
+        server.join();
+    }
+};
+
+/**
+ * @brief Stress one policy with concurrent clients.
+ *
+ * @param[in]   policy          The member selection policy.
+ * @param[in]   num_members     The number of shard members.
+ * @param[in]   service_us      The mean service time of a normal member.
+ * @param[in]   slowdown        The service time multiplier of the slow member.
+ * @param[in]   num_threads     The number of client threads.
+ * @param[in]   ops_per_thread  The number of requests per client thread.
+ */
+void stress_policy(ShardMemberSelectionPolicy policy, uint32_t num_members, double service_us, double slowdown,
+                   uint32_t num_threads, uint32_t ops_per_thread) {
+    std::vector<derecho::node_id_t> node_ids(num_members);
+    std::vector<std::unique_ptr<member_server_t>> servers;
+    for(uint32_t m = 0; m < num_members; m++) {
+        node_ids[m] = node_id_of(m);
+        servers.emplace_back(std::make_unique<member_server_t>((m + 1 == num_members) ? service_us * slowdown : service_us,
+                                                               m));
+    }
+    MemberLoads loads;
+    std::atomic<uint32_t> position{0};
+    std::vector<std::vector<uint64_t>> latencies(num_threads);
+    std::vector<uint64_t> pick_ns(num_threads, 0);
+    std::vector<uint64_t> sent_to_slow_member(num_threads, 0);
+
+    std::vector<std::thread> clients;
+    for(uint32_t t = 0; t < num_threads; t++) {
+        clients.emplace_back([&, t]() {
+            std::minstd_rand rng(t);
+            latencies[t].reserve(ops_per_thread);
+            for(uint32_t op = 0; op < ops_per_thread; op++) {
+                uint64_t start_ns = get_time_ns(false);
+                derecho::node_id_t node_id = pick_member(policy, node_ids, loads, position, rng);
+                pick_ns[t] += get_time_ns(false) - start_ns;
+                uint32_t m = (node_id - 1) / 256;
+                auto reply = loads.track(node_id, servers[m]->send());
+                reply.get();
+                latencies[t].emplace_back(get_time_ns(false) - start_ns);
+                if(m + 1 == num_members) {
+                    sent_to_slow_member[t]++;
+                }
+            }
+        });
+    }
+    for(auto& client : clients) {
+        client.join();
+    }
+
+    std::vector<uint64_t> all_latencies;
+    uint64_t total_pick_ns = 0;
+    uint64_t total_sent_to_slow_member = 0;
+    for(uint32_t t = 0; t < num_threads; t++) {
+        all_latencies.insert(all_latencies.end(), latencies[t].begin(), latencies[t].end());
+        total_pick_ns += pick_ns[t];
+        total_sent_to_slow_member += sent_to_slow_member[t];
+    }
+    std::sort(all_latencies.begin(), all_latencies.end());
+    auto percentile_us = [&all_latencies](double p) {
+        return all_latencies[std::min(all_latencies.size() - 1, static_cast<std::size_t>(p * all_latencies.size()))]
+               / 1000.0;
+    };
+    const uint64_t num_requests = all_latencies.size();
+    std::cout << policy << "\t" << static_cast<double>(total_pick_ns) / num_requests << "\t" << percentile_us(0.5)
+              << "\t" << percentile_us(0.99) << "\t" << static_cast<double>(total_sent_to_slow_member) / num_requests
+              << std::endl;
+}
+
+/**
+ * @brief Evaluate all policies.
+ */
+void evaluate(uint32_t num_members, double service_us, double slowdown, double utilization, uint32_t num_requests,
+              uint32_t num_threads, uint32_t ops_per_thread) {
+    const auto policies = {ShardMemberSelectionPolicy::RoundRobin,
+                           ShardMemberSelectionPolicy::Random,
+                           ShardMemberSelectionPolicy::LeastOutstandingRequests,
+                           ShardMemberSelectionPolicy::PowerOfTwoChoices};
+    std::cout << "simulation: members=" << num_members << ", service_time=" << service_us << "us, slowdown="
+              << slowdown << ", utilization=" << utilization << ", requests=" << num_requests << std::endl;
+    std::cout << "policy\tmean(us)\tp50(us)\tp99(us)\tp999(us)\tslow member share" << std::endl;
+    for(auto policy : policies) {
+        simulate_policy(policy, num_members, service_us, slowdown, utilization, num_requests);
+    }
+    std::cout << "stress: members=" << num_members << ", service_time=" << service_us << "us, slowdown=" << slowdown
+              << ", threads=" << num_threads << ", ops_per_thread=" << ops_per_thread << std::endl;
+    std::cout << "policy\tpick(ns)\tp50(us)\tp99(us)\tslow member share" << std::endl;
+    for(auto policy : policies) {
+        stress_policy(policy, num_members, service_us, slowdown, num_threads, ops_per_thread);
+    }
+}
+
+/**
+ * @brief The main entry.
+ */
+int main(int argc, char** argv) {
+    static struct option long_options[] = {
+        {"members",     required_argument,  0,  'm'},
+        {"service",     required_argument,  0,  's'},
+        {"slowdown",    required_argument,  0,  'l'},
+        {"utilization", required_argument,  0,  'u'},
+        {"requests",    required_argument,  0,  'r'},
+        {"threads",     required_argument,  0,  't'},
+        {"ops",         required_argument,  0,  'o'},
+        {"help",        no_argument,        0,  'h'},
+        {0,0,0,0}
+    };
+
+    int c;
+    uint32_t    num_members = 3;
+    double      service_us = 100;
+    double      slowdown = 10;
+    double      utilization = 0.6;
+    uint32_t    num_requests = 1000000;
+    uint32_t    num_threads = 8;
+    uint32_t    ops_per_thread = 2000;
+
+    while (true) {
+        int option_index = 0;
+        c = getopt_long(argc,argv,"m:s:l:u:r:t:o:h",long_options,&option_index);
+
+        if (c == -1) {
+            break;
+        }
+
+        switch(c) {
+        case 'm':
+            num_members = std::stoul(optarg);
+            break;
+        case 's':
+            service_us = std::stod(optarg);
+            break;
+        case 'l':
+            slowdown = std::stod(optarg);
+            break;
+        case 'u':
+            utilization = std::stod(optarg);
+            break;
+        case 'r':
+            num_requests = std::stoul(optarg);
+            break;
+        case 't':
+            num_threads = std::stoul(optarg);
+            break;
+        case 'o':
+            ops_per_thread = std::stoul(optarg);
+            break;
+        case 'h':
+            std::cout << help_string << std::endl;
+            return 0;
+        case '?':
+        default:
+            std::cout << "unknown options." << std::endl;
+            std::cout << help_string << std::endl;
+            return -1;
+        }
+    }
+
+    if (num_members == 0 || service_us <= 0 || slowdown < 1 || utilization <= 0 || utilization >= 1 || num_requests == 0 ||
+        num_threads == 0 || ops_per_thread == 0) {
+        std::cerr << "num_members, service_time, num_requests, num_threads, and ops_per_thread must be positive, "
+                  << "slowdown must be at least 1, and utilization must be in (0,1)." << std::endl;
+        return -1;
+    }
+    evaluate(num_members, service_us, slowdown, utilization, num_requests, num_threads, ops_per_thread);
+    return 0;
+}
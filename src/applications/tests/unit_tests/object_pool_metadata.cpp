@@ -1,7 +1,80 @@
 #include <cascade/service_types.hpp>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 using namespace derecho::cascade;
 
+static uint32_t num_failures = 0;
+
+/**
+ * @brief Report a failed check.
+ */
+template <typename T>
+void check(const std::string& what, const T& actual, const T& expected) {
+    if (actual != expected) {
+        std::cout << "FAILED: " << what << std::endl;
+        num_failures++;
+    }
+}
+
+/**
+ * @brief Test the RANGE sharding policy: the serialization of the split points, key_to_shard_index,
+ * prefix_to_shard_range, and check_range_split_points.
+ */
+void test_range_sharding() {
+    const std::vector<std::string> split_points{"/pool/g","/pool/n","/pool/t"};
+    DefaultObjectPoolMetadataType opm("/pool",1,0,RANGE,{},"",false,split_points);
+
+    // serialization
+    std::vector<uint8_t> bytes(mutils::bytes_size(opm));
+    opm.to_bytes(bytes.data());
+    auto deserialized = mutils::from_bytes<DefaultObjectPoolMetadataType>(nullptr,bytes.data());
+    check("the sharding policy survives serialization",deserialized->sharding_policy,opm.sharding_policy);
+    check("the split points survive serialization",deserialized->range_split_points,split_points);
+
+    // key_to_shard_index: shard i owns [split_points[i-1],split_points[i]).
+    const std::vector<std::pair<std::string,uint32_t>> owners{
+        {"/pool",0},{"/pool/a",0},{"/pool/f\xff",0},{"/pool/g",1},{"/pool/m",1},
+        {"/pool/n",2},{"/pool/s",2},{"/pool/t",3},{"/pool/z",3}};
+    for (const auto& owner : owners) {
+        check("key_to_shard_index(" + owner.first + ")",opm.key_to_shard_index(owner.first,owner.first,4),owner.second);
+    }
+    check("the affinity set is used in place of the key",
+          opm.key_to_shard_index(std::string("/pool/a"),std::string_view("/pool/t"),4),3u);
+    check("the key is used if the affinity set is empty",
+          opm.key_to_shard_index(std::string("/pool/t"),std::string_view(""),4),3u);
+    check("the shards beyond num_shards own nothing",
+          opm.key_to_shard_index(std::string("/pool/z"),std::string("/pool/z"),2),1u);
+
+    // prefix_to_shard_range
+    using range_t = std::pair<uint32_t,uint32_t>;
+    check("prefix_to_shard_range(/pool/)",opm.prefix_to_shard_range("/pool/",4),range_t{0,3});
+    check("prefix_to_shard_range(/pool/g)",opm.prefix_to_shard_range("/pool/g",4),range_t{1,1});
+    check("prefix_to_shard_range(/pool/m)",opm.prefix_to_shard_range("/pool/m",4),range_t{1,1});
+    check("prefix_to_shard_range(/pool/s)",opm.prefix_to_shard_range("/pool/s",4),range_t{2,2});
+    check("prefix_to_shard_range(/pool/t)",opm.prefix_to_shard_range("/pool/t",4),range_t{3,3});
+    check("prefix_to_shard_range of an empty prefix",opm.prefix_to_shard_range("",4),range_t{0,3});
+    check("prefix_to_shard_range of an all 0xff prefix",opm.prefix_to_shard_range("\xff\xff",4),range_t{3,3});
+    check("prefix_to_shard_range with fewer shards",opm.prefix_to_shard_range("/pool/",2),range_t{0,1});
+    check("prefix_to_shard_range without shards",opm.prefix_to_shard_range("/pool/",0),range_t{0,0});
+    DefaultObjectPoolMetadataType affinity_opm("/pool",1,0,RANGE,{},"/[a-z]+$",false,split_points);
+    check("prefix_to_shard_range with an affinity set regex",affinity_opm.prefix_to_shard_range("/pool/m",4),
+          range_t{0,3});
+    DefaultObjectPoolMetadataType hash_opm("/pool",1,0,HASH,{},"",false);
+    check("prefix_to_shard_range under HASH",hash_opm.prefix_to_shard_range("/pool/m",4),range_t{0,3});
+
+    // check_range_split_points
+    check("increasing split points are valid",opm.check_range_split_points(),true);
+    check("no split points are valid",hash_opm.check_range_split_points(),true);
+    DefaultObjectPoolMetadataType unsorted_opm("/pool",1,0,RANGE,{},"",false,{"/pool/n","/pool/g"});
+    check("decreasing split points are invalid",unsorted_opm.check_range_split_points(),false);
+    DefaultObjectPoolMetadataType repeated_opm("/pool",1,0,RANGE,{},"",false,{"/pool/g","/pool/g"});
+    check("repeated split points are invalid",repeated_opm.check_range_split_points(),false);
+}
+
 int main(int argc, char** argv) {
     uint8_t buf[4096];
     DefaultObjectPoolMetadataType opm;
@@ -15,5 +88,12 @@ int main(int argc, char** argv) {
     std::cout << "PersistentCascadeStoreWithStringKey index is " << DefaultObjectPoolMetadataType::get_subgroup_type_index<PersistentCascadeStoreWithStringKey>() << std::endl;
     std::cout << "TriggerCascadeNoStoreWithStringKey index is " << DefaultObjectPoolMetadataType::get_subgroup_type_index<TriggerCascadeNoStoreWithStringKey>() << std::endl;
     std::cout << "int index is " << DefaultObjectPoolMetadataType::get_subgroup_type_index<int>() << std::endl;
+
+    test_range_sharding();
+    if (num_failures > 0) {
+        std::cout << num_failures << " RANGE sharding checks failed." << std::endl;
+        return 1;
+    }
+    std::cout << "All RANGE sharding checks passed." << std::endl;
     return 0;
 }
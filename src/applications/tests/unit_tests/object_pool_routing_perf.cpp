@@ -0,0 +1,238 @@
+#include <getopt.h>
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cascade/service_types.hpp>
+#include <cascade/utils.hpp>
+#include <cascade/detail/object_pool_routing_table.hpp>
+
+/**
+ * @file object_pool_routing_perf.cpp
+ *
+ * Object Pool Routing Performance Tester
+ *
+ * This tester measures the cost of routing a key to its shard on the client side with a growing number of threads. It
+ * compares the lookup used by key_to_shard before, which tokenizes the pathname, looks up every prefix in the object
+ * pool metadata cache under a shared lock, and copies the object pool metadata out, against the lookup in an
+ * ObjectPoolRoutingTable inside an EpochGuard.
+ */
+
+using namespace derecho::cascade;
+
+using OPM = ObjectPoolMetadata<VolatileCascadeStoreWithStringKey, PersistentCascadeStoreWithStringKey, TriggerCascadeNoStoreWithStringKey>;
+
+/**
+ * @brief Help string.
+ */
+const char* help_string =
+    "Object Pool Routing Performance Tester\n"
+    "--------------------------------------\n"
+    "Options:\n"
+    "\t--(p)ools <num_pools>                        number of object pools, default: 100\n"
+    "\t--(d)epth <depth>                            number of components in an object pool pathname, default: 3\n"
+    "\t--(l)ocations <num_locations>                number of object locations of each object pool, default: 16\n"
+    "\t--(k)eys <num_keys>                          number of keys to route, default: 100000\n"
+    "\t--(i)terations <num_iterations>              number of times each thread routes the keys, default: 10\n"
+    "\t--(t)hreads <num_threads>                    the largest number of threads, starting from 1 and doubling, default: 8\n"
+    "\t--(h)elp                                     help information\n"
+    ;
+
+/**
+ * @brief route a key the way key_to_shard did before ObjectPoolRoutingTable.
+ */
+uint32_t legacy_route(const std::unordered_map<std::string,OPM>& cache, std::shared_mutex& cache_mutex,
+                      const std::string& key, uint32_t num_shards) {
+    std::string pathname = get_pathname<std::string>(key);
+    OPM opm = OPM::IV;
+    {
+        std::shared_lock<std::shared_mutex> rlck(cache_mutex);
+        auto components = str_tokenizer(pathname);
+        std::string prefix;
+        for (const auto& comp: components) {
+            prefix = prefix + PATH_SEPARATOR + comp;
+            if (cache.find(prefix) != cache.end()) {
+                opm = cache.at(prefix);
+                break;
+            }
+        }
+    }
+    std::string affinity_set = key;
+    return opm.key_to_shard_index(key,affinity_set,num_shards,false);
+}
+
+/**
+ * @brief route a key with an ObjectPoolRoutingTable.
+ */
+uint32_t table_route(const std::atomic<ObjectPoolRoutingTable<OPM>*>& routing_table, const std::string& key, uint32_t num_shards) {
+    EpochGuard epoch_guard;
+    const OPM* opm = routing_table.load(std::memory_order_acquire)->find_by_key(key);
+    return opm->key_to_shard_index(key,std::string_view(key),num_shards,false);
+}
+
+/**
+ * @brief Run a routing function in a number of threads.
+ *
+ * @tparam RouteFunc    uint32_t(const std::string&)
+ * @param[in]   route           The routing function.
+ * @param[in]   keys            The keys to route.
+ * @param[in]   num_iterations  The number of times each thread routes the keys.
+ * @param[in]   num_threads     The number of threads.
+ *
+ * @return The average routing latency per key, in nanoseconds.
+ */
+template <typename RouteFunc>
+double evaluate_route(const RouteFunc& route, const std::vector<std::string>& keys, uint32_t num_iterations, uint32_t num_threads) {
+    std::atomic<uint64_t> checksum{0};
+    std::vector<std::thread> threads;
+    uint64_t start_ns = get_time_ns(false);
+    for (uint32_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&]() {
+            uint64_t sum = 0;
+            for (uint32_t i = 0; i < num_iterations; i++) {
+                for (const auto& key: keys) {
+                    sum += route(key);
+                }
+            }
+            checksum += sum;
+        });
+    }
+    for (auto& th: threads) {
+        th.join();
+    }
+    uint64_t elapsed_ns = get_time_ns(false) - start_ns;
+    if (checksum.load() == 0) {
+        std::cerr << "WARNING: all keys are routed to shard 0." << std::endl;
+    }
+    return static_cast<double>(elapsed_ns) / (static_cast<double>(keys.size()) * num_iterations);
+}
+
+/**
+ * @brief Evaluate both routing paths.
+ *
+ * @param[in]   num_pools       The number of object pools.
+ * @param[in]   depth           The number of components in an object pool pathname.
+ * @param[in]   num_locations   The number of object locations of each object pool.
+ * @param[in]   num_keys        The number of keys to route.
+ * @param[in]   num_iterations  The number of times each thread routes the keys.
+ * @param[in]   max_threads     The largest number of threads.
+ */
+void evaluate(uint32_t num_pools, uint32_t depth, uint32_t num_locations, uint32_t num_keys, uint32_t num_iterations, uint32_t max_threads) {
+    const uint32_t num_shards = 16;
+    std::unordered_map<std::string,OPM> cache;
+    std::shared_mutex cache_mutex;
+    std::unordered_map<std::string,std::shared_ptr<OPM>> routes;
+    std::vector<std::string> pathnames;
+    for (uint32_t p = 0; p < num_pools; p++) {
+        std::string pathname;
+        for (uint32_t d = 1; d < depth; d++) {
+            pathname += "/level" + std::to_string(d) + "_" + std::to_string(p % (d * 8));
+        }
+        pathname += "/pool_" + std::to_string(p);
+        std::unordered_map<std::string,uint32_t> object_locations;
+        for (uint32_t l = 0; l < num_locations; l++) {
+            object_locations.emplace(pathname + "/location_" + std::to_string(l), l % num_shards);
+        }
+        OPM opm(pathname,0,0,HASH,object_locations,"",false);
+        cache.emplace(pathname,opm);
+        routes.emplace(pathname,std::make_shared<OPM>(opm));
+        pathnames.emplace_back(pathname);
+    }
+    std::atomic<ObjectPoolRoutingTable<OPM>*> routing_table{new ObjectPoolRoutingTable<OPM>(routes)};
+
+    std::vector<std::string> keys;
+    for (uint32_t k = 0; k < num_keys; k++) {
+        keys.emplace_back(pathnames[k % num_pools] + "/key_" + std::to_string(k));
+    }
+    for (const auto& key: keys) {
+        if (legacy_route(cache,cache_mutex,key,num_shards) != table_route(routing_table,key,num_shards)) {
+            std::cerr << "ERROR: the routing table routes " << key << " to a different shard." << std::endl;
+            return;
+        }
+    }
+
+    std::cout << "threads\t\tlegacy(ns/key)\ttable(ns/key)\tspeedup" << std::endl;
+    for (uint32_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        double legacy_ns = evaluate_route([&](const std::string& key) { return legacy_route(cache,cache_mutex,key,num_shards); },
+                                          keys, num_iterations, num_threads);
+        double table_ns = evaluate_route([&](const std::string& key) { return table_route(routing_table,key,num_shards); },
+                                         keys, num_iterations, num_threads);
+        std::cout << num_threads << "\t\t" << legacy_ns << "\t\t" << table_ns << "\t\t" << legacy_ns / table_ns << std::endl;
+    }
+    delete routing_table.load();
+}
+
+/**
+ * @brief The main entry.
+ */
+int main(int argc, char** argv) {
+    static struct option long_options[] = {
+        {"pools",       required_argument,  0,  'p'},
+        {"depth",       required_argument,  0,  'd'},
+        {"locations",   required_argument,  0,  'l'},
+        {"keys",        required_argument,  0,  'k'},
+        {"iterations",  required_argument,  0,  'i'},
+        {"threads",     required_argument,  0,  't'},
+        {"help",        no_argument,        0,  'h'},
+        {0,0,0,0}
+    };
+
+    int c;
+    uint32_t    num_pools = 100;
+    uint32_t    depth = 3;
+    uint32_t    num_locations = 16;
+    uint32_t    num_keys = 100000;
+    uint32_t    num_iterations = 10;
+    uint32_t    max_threads = 8;
+
+    while (true) {
+        int option_index = 0;
+        c = getopt_long(argc,argv,"p:d:l:k:i:t:h",long_options,&option_index);
+
+        if (c == -1) {
+            break;
+        }
+
+        switch(c) {
+        case 'p':
+            num_pools = std::stoul(optarg);
+            break;
+        case 'd':
+            depth = std::stoul(optarg);
+            break;
+        case 'l':
+            num_locations = std::stoul(optarg);
+            break;
+        case 'k':
+            num_keys = std::stoul(optarg);
+            break;
+        case 'i':
+            num_iterations = std::stoul(optarg);
+            break;
+        case 't':
+            max_threads = std::stoul(optarg);
+            break;
+        case 'h':
+            std::cout << help_string << std::endl;
+            return 0;
+        case '?':
+        default:
+            std::cout << "unknown options." << std::endl;
+            std::cout << help_string << std::endl;
+            return -1;
+        }
+    }
+
+    if (num_pools == 0 || depth == 0 || num_keys == 0 || num_iterations == 0) {
+        std::cerr << "num_pools, depth, num_keys, and num_iterations must be positive." << std::endl;
+        return -1;
+    }
+    evaluate(num_pools, depth, num_locations, num_keys, num_iterations, max_threads);
+    return 0;
+}
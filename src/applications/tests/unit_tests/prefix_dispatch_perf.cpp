@@ -0,0 +1,316 @@
+#include <getopt.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include <cascade/object.hpp>
+#include <cascade/utils.hpp>
+#include <cascade/service.hpp>
+
+/**
+ * @file prefix_dispatch_perf.cpp
+ *
+ * Prefix Dispatch Performance Tester
+ *
+ * This tester registers UDLs to every level of a set of paths, with the hooks alternating between ordered put,
+ * trigger put, and both, and then dispatches updates to keys in those paths the way CascadeServiceCDPO does on every
+ * put: it looks up the UDLs, constructs an Action for each of them, and posts it to an ActionQueue. It compares copying
+ * the prefix entries matched by PrefixRegistry::collect_values_for_prefixes, erasing the UDLs of the other hook, and
+ * copying the outputs into every action, as CascadeServiceCDPO did before, against the dispatch plans built at
+ * registration, whose actions share the outputs. It reports the time and the heap allocations per dispatch. Every
+ * action still copies the key, which allocates once per action in both modes unless the key fits in the small string
+ * buffer.
+ */
+
+using namespace derecho::cascade;
+
+/**
+ * @brief The number of heap allocations, counted by the replaced operator new.
+ */
+static std::atomic<uint64_t> num_allocations{0};
+
+void* operator new(std::size_t size) {
+    num_allocations.fetch_add(1,std::memory_order_relaxed);
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+/**
+ * @brief Help string.
+ */
+const char* help_string =
+    "Prefix Dispatch Performance Tester\n"
+    "----------------------------------\n"
+    "Options:\n"
+    "\t--(m)ode <copy|plan>                         the dispatch to test, default: plan\n"
+    "\t--(p)aths <num_paths>                        number of distinct paths, default: 64\n"
+    "\t--(d)epth <depth>                            number of components in a path, default: 4\n"
+    "\t--(u)dls <num_udls>                          number of UDLs registered to each prefix, default: 3\n"
+    "\t--(n)um_lookups <num_lookups>                number of dispatches, default: 1000000\n"
+    "\t--(t)rigger                                  look up for trigger put instead of ordered put\n"
+    "\t--(h)elp                                     help information\n"
+    ;
+
+/**
+ * @brief Register a UDL to a prefix the way ExecutionEngine::register_prefixes() does.
+ */
+void register_udl(PrefixRegistry<prefix_entry_t,PATH_SEPARATOR>& registry, const std::string& prefix,
+                  const std::string& udl_id, DataFlowGraph::VertexHook hook) {
+    registry.atomically_modify(prefix,
+        [&udl_id,hook](const std::shared_ptr<prefix_entry_t>& entry) {
+            auto new_entry = entry ? std::make_shared<prefix_entry_t>(*entry) : std::make_shared<prefix_entry_t>();
+            prefix_ocdpo_info_t ocdpo_info = {
+                .udl_id = udl_id,
+                .config_string = "{}",
+                .execution_environment = DataFlowGraph::VertexExecutionEnvironment::PTHREAD,
+                .shard_dispatcher = DataFlowGraph::VertexShardDispatcher::ALL,
+                .statefulness = DataFlowGraph::Statefulness::STATEFUL,
+                .hook = hook,
+                .ocdpo = nullptr,
+                .output_map = std::make_shared<const std::unordered_map<std::string,bool>>(
+                        std::unordered_map<std::string,bool>{{"/output/",false}}),
+                .batching = {}};
+            (*new_entry)["perf-dfg"].emplace(ocdpo_info);
+            return new_entry;
+        },true);
+}
+
+/**
+ * @brief Post the actions, and drain them right away so that the queue never fills up.
+ *
+ * @return the sum of the prefix lengths and output counts of the actions posted.
+ */
+uint64_t post_actions(ActionQueue<Action>& queue, std::vector<Action>& actions) {
+    uint64_t sum = 0;
+    for (auto& action : actions) {
+        sum += action.prefix_length + action.get_outputs().size();
+        queue.try_enqueue(std::move(action));
+    }
+    actions.clear();
+    Action drained;
+    while (queue.try_dequeue(drained)) {}
+    return sum;
+}
+
+/**
+ * @brief Dispatch an update the way CascadeServiceCDPO did before dispatch plans.
+ *
+ * @return the sum of the prefix lengths and output counts of the actions posted.
+ */
+uint64_t copy_and_filter(const PrefixRegistry<prefix_entry_t,PATH_SEPARATOR>& registry, const std::string& key,
+                         const std::shared_ptr<const ObjectWithStringKey>& value, bool is_trigger,
+                         ActionQueue<Action>& queue, std::vector<Action>& actions) {
+    size_t pos = key.rfind(PATH_SEPARATOR);
+    std::string prefix;
+    if (pos != std::string::npos) {
+        prefix = key.substr(0, pos + 1);
+    }
+    match_results_t handlers;
+    registry.collect_values_for_prefixes(
+            prefix,
+            [&handlers](const std::string& matched_prefix, const std::shared_ptr<prefix_entry_t>& entry) {
+                if (entry) {
+                    handlers.emplace(matched_prefix,*entry);
+                }
+            });
+    for (auto& per_prefix : handlers) {
+        for (auto& dfg_ocdpos : per_prefix.second) {
+            for (auto oiit = dfg_ocdpos.second.begin(); oiit != dfg_ocdpos.second.end();) {
+                if ((oiit->hook != DataFlowGraph::VertexHook::BOTH) && (
+                    (oiit->hook == DataFlowGraph::VertexHook::ORDERED_PUT && is_trigger) ||
+                    (oiit->hook == DataFlowGraph::VertexHook::TRIGGER_PUT && !is_trigger))) {
+                    oiit = dfg_ocdpos.second.erase(oiit);
+                } else {
+                    oiit++;
+                }
+            }
+        }
+    }
+    for (const auto& per_prefix : handlers) {
+        for (const auto& dfg_ocdpos : per_prefix.second) {
+            for (const auto& oi : dfg_ocdpos.second) {
+                // the action used to hold its own copy of the outputs.
+                actions.emplace_back(0,key,static_cast<uint32_t>(per_prefix.first.size()),value->get_version(),
+                                     oi.ocdpo,value,
+                                     std::make_shared<const std::unordered_map<std::string,bool>>(*oi.output_map),
+                                     oi.batching);
+            }
+        }
+    }
+    return post_actions(queue,actions);
+}
+
+/**
+ * @brief Dispatch an update with the dispatch plans.
+ *
+ * @return the sum of the prefix lengths and output counts of the actions posted.
+ */
+uint64_t dispatch_with_plan(const PrefixDispatchPlans& plans, const PrefixRegistry<prefix_entry_t,PATH_SEPARATOR>& registry,
+                            const std::string& key, const std::shared_ptr<const ObjectWithStringKey>& value,
+                            bool is_trigger, ActionQueue<Action>& queue, std::vector<Action>& actions) {
+    auto plan = plans.get(registry,key);
+    const auto& targets = is_trigger ? plan->trigger_put_targets : plan->ordered_put_targets_for_all;
+    for (const auto& target : targets) {
+        const auto& oi = *target.info;
+        actions.emplace_back(0,key,target.prefix_length,value->get_version(),oi.ocdpo,value,oi.output_map,oi.batching);
+    }
+    return post_actions(queue,actions);
+}
+
+/**
+ * @brief Run the test.
+ *
+ * @param[in]   mode            copy or plan.
+ * @param[in]   num_paths       The number of distinct paths.
+ * @param[in]   depth           The number of components in a path.
+ * @param[in]   num_udls        The number of UDLs registered to each prefix.
+ * @param[in]   num_lookups     The number of dispatches.
+ * @param[in]   is_trigger      Look up for trigger put instead of ordered put.
+ *
+ * @return true if both dispatches post the same actions.
+ */
+bool evaluate(const std::string& mode, uint32_t num_paths, uint32_t depth, uint32_t num_udls, uint64_t num_lookups,
+              bool is_trigger) {
+    const DataFlowGraph::VertexHook hooks[] = {DataFlowGraph::VertexHook::ORDERED_PUT,
+                                               DataFlowGraph::VertexHook::TRIGGER_PUT,
+                                               DataFlowGraph::VertexHook::BOTH};
+    PrefixRegistry<prefix_entry_t,PATH_SEPARATOR> registry;
+    std::vector<std::string> keys;
+    for (uint32_t p = 0; p < num_paths; p++) {
+        std::string prefix(1,PATH_SEPARATOR);
+        for (uint32_t d = 0; d < depth; d++) {
+            prefix += ((d == 0) ? "pool" + std::to_string(p) : "level" + std::to_string(d)) + PATH_SEPARATOR;
+            for (uint32_t u = 0; u < num_udls; u++) {
+                register_udl(registry,prefix,"udl" + std::to_string(u),hooks[u % 3]);
+            }
+        }
+        keys.emplace_back(prefix + "a_key_long_enough_to_be_on_the_heap");
+    }
+    // the plans are built at registration.
+    PrefixDispatchPlans plans;
+    plans.rebuild(registry);
+
+    // the value shared by the actions, like the one held by the store.
+    auto value = std::make_shared<const ObjectWithStringKey>(keys.front(),reinterpret_cast<const uint8_t*>("value"),5);
+    ActionQueue<Action> queue(ACTION_BUFFER_SIZE);
+    std::vector<Action> actions;
+    actions.reserve(static_cast<std::size_t>(depth) * num_udls);
+
+    uint64_t expected = 0;
+    uint64_t found = 0;
+    for (const auto& key : keys) {
+        expected += copy_and_filter(registry,key,value,is_trigger,queue,actions);
+        found += dispatch_with_plan(plans,registry,key,value,is_trigger,queue,actions);
+    }
+
+    uint64_t sum = 0;
+    uint64_t allocations_before = num_allocations.load();
+    uint64_t start_ns = get_time_ns(false);
+    if (mode == "copy") {
+        for (uint64_t i = 0; i < num_lookups; i++) {
+            sum += copy_and_filter(registry,keys[i % num_paths],value,is_trigger,queue,actions);
+        }
+    } else {
+        for (uint64_t i = 0; i < num_lookups; i++) {
+            sum += dispatch_with_plan(plans,registry,keys[i % num_paths],value,is_trigger,queue,actions);
+        }
+    }
+    uint64_t duration_ns = get_time_ns(false) - start_ns;
+    uint64_t allocations = num_allocations.load() - allocations_before;
+
+    std::cout << "mode=" << mode << ", paths:" << num_paths << ", depth:" << depth << ", udls per prefix:" << num_udls
+              << ", hook:" << (is_trigger ? "trigger put" : "ordered put") << std::endl;
+    std::cout << "dispatch latency:" << static_cast<double>(duration_ns) / num_lookups << " ns, allocations per dispatch:"
+              << static_cast<double>(allocations) / num_lookups << " (checksum " << sum << ")" << std::endl;
+    if (found != expected) {
+        std::cerr << "FAILED: the dispatch plan does not match the prefix entries." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief The main entry.
+ */
+int main(int argc, char** argv) {
+    static struct option long_options[] = {
+        {"mode",        required_argument,  0,  'm'},
+        {"paths",       required_argument,  0,  'p'},
+        {"depth",       required_argument,  0,  'd'},
+        {"udls",        required_argument,  0,  'u'},
+        {"num_lookups", required_argument,  0,  'n'},
+        {"trigger",     no_argument,        0,  't'},
+        {"help",        no_argument,        0,  'h'},
+        {0,0,0,0}
+    };
+
+    int c;
+    std::string mode = "plan";
+    uint32_t    num_paths = 64;
+    uint32_t    depth = 4;
+    uint32_t    num_udls = 3;
+    uint64_t    num_lookups = 1000000;
+    bool        is_trigger = false;
+
+    while (true) {
+        int option_index = 0;
+        c = getopt_long(argc,argv,"m:p:d:u:n:th",long_options,&option_index);
+
+        if (c == -1) {
+            break;
+        }
+
+        switch(c) {
+        case 'm':
+            mode = optarg;
+            break;
+        case 'p':
+            num_paths = std::stoul(optarg);
+            break;
+        case 'd':
+            depth = std::stoul(optarg);
+            break;
+        case 'u':
+            num_udls = std::stoul(optarg);
+            break;
+        case 'n':
+            num_lookups = std::stoull(optarg);
+            break;
+        case 't':
+            is_trigger = true;
+            break;
+        case 'h':
+            std::cout << help_string << std::endl;
+            return 0;
+        case '?':
+        default:
+            std::cout << "unknown options." << std::endl;
+            std::cout << help_string << std::endl;
+            return -1;
+        }
+    }
+
+    if (num_paths == 0 || depth == 0 || num_lookups == 0) {
+        std::cerr << "num_paths, depth, and num_lookups must be positive." << std::endl;
+        return -1;
+    }
+    if (mode != "copy" && mode != "plan") {
+        std::cerr << "unknown mode:" << mode << std::endl;
+        return -1;
+    }
+    return evaluate(mode, num_paths, depth, num_udls, num_lookups, is_trigger) ? 0 : -1;
+}
@@ -0,0 +1,206 @@
+#include <getopt.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <cascade/service_types.hpp>
+#include <cascade/utils.hpp>
+
+/**
+ * @file range_sharding_perf.cpp
+ *
+ * HASH vs RANGE Sharding Performance Tester
+ *
+ * This tester emulates the shards of an object pool with one kv_map per shard. Each key belongs to a group, like
+ * "/pool/group_00042/item_00007", and the tester puts all keys to their shards under the HASH and the RANGE sharding
+ * policies. It then scans random groups by their prefix: under HASH, every shard has to be scanned, while under
+ * RANGE, only the shards returned by prefix_to_shard_range() are. It reports the put cost, the shard balance, and the
+ * number of shards and the latency of a prefix scan.
+ */
+
+using namespace derecho::cascade;
+
+using OPM = ObjectPoolMetadata<VolatileCascadeStoreWithStringKey, PersistentCascadeStoreWithStringKey, TriggerCascadeNoStoreWithStringKey>;
+using ShardMap = ConcurrentOrderedMap<std::string, ObjectWithStringKey>;
+
+/**
+ * @brief Help string.
+ */
+const char* help_string =
+    "HASH vs RANGE Sharding Performance Tester\n"
+    "-----------------------------------------\n"
+    "Options:\n"
+    "\t--(s)hards <num_shards>                      number of shards, default: 16\n"
+    "\t--(g)roups <num_groups>                      number of key groups, default: 10000\n"
+    "\t--(k)eys <keys_per_group>                    number of keys in each group, default: 100\n"
+    "\t--si(z)e <value_size>                        value size in bytes, default: 64\n"
+    "\t--s(c)ans <num_scans>                        number of prefix scans, default: 10000\n"
+    "\t--(h)elp                                     help information\n"
+    ;
+
+inline std::string group_prefix(uint32_t group) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "/pool/group_%08" PRIu32, group);
+    return buf;
+}
+
+/**
+ * @brief Evaluate one sharding policy.
+ *
+ * @param[in]   opm             The object pool metadata with the sharding policy.
+ * @param[in]   num_shards      The number of shards.
+ * @param[in]   keys            The keys to put.
+ * @param[in]   value_size      The value size in bytes.
+ * @param[in]   scan_groups     The groups to scan.
+ */
+void evaluate_policy(const OPM& opm, uint32_t num_shards, const std::vector<std::string>& keys, uint32_t value_size,
+                     const std::vector<uint32_t>& scan_groups) {
+    std::vector<ShardMap> shards(num_shards);
+    std::vector<uint8_t> data(value_size, 'v');
+
+    // put
+    uint64_t start_ns = get_time_ns(false);
+    for(const auto& key : keys) {
+        uint32_t shard_index = opm.key_to_shard_index(key, std::string_view{}, num_shards, false);
+        shards[shard_index].insert_or_assign(key, ObjectWithStringKey(key, data.data(), value_size));
+    }
+    double put_ns = static_cast<double>(get_time_ns(false) - start_ns) / keys.size();
+    std::size_t max_shard_size = 0;
+    for(const auto& shard : shards) {
+        max_shard_size = std::max(max_shard_size, shard.size());
+    }
+    double imbalance = static_cast<double>(max_shard_size) * num_shards / keys.size();
+
+    // prefix scans
+    uint64_t shards_touched = 0;
+    uint64_t objects_found = 0;
+    start_ns = get_time_ns(false);
+    for(const auto group : scan_groups) {
+        std::string prefix = group_prefix(group);
+        auto shard_range = opm.prefix_to_shard_range(prefix, num_shards);
+        for(uint32_t shard_index = shard_range.first; shard_index <= shard_range.second; shard_index++) {
+            auto page = scan_by_prefix(shards[shard_index], prefix, ObjectWithStringKey::IK, ObjectWithStringKey::IK, 0, 0);
+            objects_found += std::get<0>(page).size();
+            shards_touched++;
+        }
+    }
+    double scan_us = static_cast<double>(get_time_ns(false) - start_ns) / scan_groups.size() / 1e3;
+
+    std::cout << (opm.sharding_policy == HASH ? "HASH" : "RANGE") << "\t" << put_ns << "\t\t" << imbalance << "\t\t"
+              << static_cast<double>(shards_touched) / scan_groups.size() << "\t\t" << scan_us << "\t\t"
+              << static_cast<double>(objects_found) / scan_groups.size() << std::endl;
+}
+
+/**
+ * @brief Evaluate both sharding policies.
+ *
+ * @param[in]   num_shards      The number of shards.
+ * @param[in]   num_groups      The number of key groups.
+ * @param[in]   keys_per_group  The number of keys in each group.
+ * @param[in]   value_size      The value size in bytes.
+ * @param[in]   num_scans       The number of prefix scans.
+ */
+void evaluate(uint32_t num_shards, uint32_t num_groups, uint32_t keys_per_group, uint32_t value_size, uint32_t num_scans) {
+    std::vector<std::string> keys;
+    keys.reserve(static_cast<std::size_t>(num_groups) * keys_per_group);
+    for(uint32_t g = 0; g < num_groups; g++) {
+        for(uint32_t k = 0; k < keys_per_group; k++) {
+            keys.emplace_back(group_prefix(g) + "/item_" + std::to_string(k));
+        }
+    }
+    // the split points cut the sorted keys into shards of the same size.
+    std::vector<std::string> sorted_keys(keys);
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+    std::vector<std::string> range_split_points;
+    for(uint32_t s = 1; s < num_shards; s++) {
+        range_split_points.emplace_back(sorted_keys[sorted_keys.size() * s / num_shards]);
+    }
+    // put in random order.
+    std::mt19937_64 rng(0);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    std::uniform_int_distribution<uint32_t> dist(0, num_groups - 1);
+    std::vector<uint32_t> scan_groups;
+    for(uint32_t i = 0; i < num_scans; i++) {
+        scan_groups.emplace_back(dist(rng));
+    }
+
+    OPM hash_opm("/pool", 0, 0, HASH, {}, "", false);
+    OPM range_opm("/pool", 0, 0, RANGE, {}, "", false, range_split_points);
+    if(!range_opm.check_range_split_points()) {
+        std::cerr << "ERROR: the range split points are not strictly increasing." << std::endl;
+        return;
+    }
+
+    std::cout << "shards=" << num_shards << ", keys=" << keys.size() << ", value_size=" << value_size << std::endl;
+    std::cout << "policy\tput(ns/key)\tmax/avg load\tshards/scan\tscan(us)\tobjects/scan" << std::endl;
+    evaluate_policy(hash_opm, num_shards, keys, value_size, scan_groups);
+    evaluate_policy(range_opm, num_shards, keys, value_size, scan_groups);
+}
+
+/**
+ * @brief The main entry.
+ */
+int main(int argc, char** argv) {
+    static struct option long_options[] = {
+        {"shards",      required_argument,  0,  's'},
+        {"groups",      required_argument,  0,  'g'},
+        {"keys",        required_argument,  0,  'k'},
+        {"size",        required_argument,  0,  'z'},
+        {"scans",       required_argument,  0,  'c'},
+        {"help",        no_argument,        0,  'h'},
+        {0,0,0,0}
+    };
+
+    int c;
+    uint32_t    num_shards = 16;
+    uint32_t    num_groups = 10000;
+    uint32_t    keys_per_group = 100;
+    uint32_t    value_size = 64;
+    uint32_t    num_scans = 10000;
+
+    while (true) {
+        int option_index = 0;
+        c = getopt_long(argc,argv,"s:g:k:z:c:h",long_options,&option_index);
+
+        if (c == -1) {
+            break;
+        }
+
+        switch(c) {
+        case 's':
+            num_shards = std::stoul(optarg);
+            break;
+        case 'g':
+            num_groups = std::stoul(optarg);
+            break;
+        case 'k':
+            keys_per_group = std::stoul(optarg);
+            break;
+        case 'z':
+            value_size = std::stoul(optarg);
+            break;
+        case 'c':
+            num_scans = std::stoul(optarg);
+            break;
+        case 'h':
+            std::cout << help_string << std::endl;
+            return 0;
+        case '?':
+        default:
+            std::cout << "unknown options." << std::endl;
+            std::cout << help_string << std::endl;
+            return -1;
+        }
+    }
+
+    if (num_shards == 0 || num_groups == 0 || keys_per_group == 0 || num_scans == 0) {
+        std::cerr << "num_shards, num_groups, keys_per_group, and num_scans must be positive." << std::endl;
+        return -1;
+    }
+    evaluate(num_shards, num_groups, keys_per_group, value_size, num_scans);
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <cascade/detail/stable_hash.hpp>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace derecho::cascade;
+
+/**
+ * @file stable_hash.cpp
+ *
+ * Stable Hash Tester
+ *
+ * The placement of the objects in a JUMP_HASH sharded object pool must not change across builds and platforms, so it
+ * pins xxhash64 to the XXH64 reference values, covering the short and the long input paths and the seed, and checks
+ * that jump_consistent_hash only moves keys to the new bucket when the number of buckets grows.
+ */
+
+static uint32_t num_failures = 0;
+
+#define CHECK(cond) \
+    if (!(cond)) { \
+        std::cout << "FAILED: " << __func__ << ":" << __LINE__ << ": " #cond << std::endl; \
+        num_failures++; \
+    }
+
+void test_xxhash64() {
+    // the reference values of the XXH64 specification.
+    CHECK(xxhash64(std::string_view("")) == 0xef46db3751d8e999ull);
+    CHECK(xxhash64(std::string_view("abc")) == 0x44bc2cf5ad770999ull);
+    // the 8, 4, and 1 byte tails.
+    CHECK(xxhash64(std::string_view("/pool/object_0")) == 0xf10e24edb6ea11e8ull);
+    // the 32 byte stripes.
+    CHECK(xxhash64(std::string_view("The quick brown fox jumps over the lazy dog, twice over.")) == 0xfb9f56ced8ad4fc4ull);
+    // the seed.
+    CHECK(xxhash64("abc",3,1) == 0xbea9ca8199328908ull);
+}
+
+void test_jump_consistent_hash() {
+    const uint32_t max_buckets = 64;
+    uint32_t num_wrong = 0;
+    for (uint32_t i = 0; i < 10000; i++) {
+        const uint64_t hash = xxhash64(std::string_view("/pool/object_" + std::to_string(i)));
+        if (jump_consistent_hash(hash,1) != 0) {
+            num_wrong++;
+        }
+        uint32_t bucket = 0;
+        for (uint32_t num_buckets = 2; num_buckets <= max_buckets; num_buckets++) {
+            const uint32_t next_bucket = jump_consistent_hash(hash,num_buckets);
+            // a key either stays, or moves to the new bucket.
+            if (next_bucket != bucket && next_bucket != num_buckets - 1) {
+                num_wrong++;
+            }
+            bucket = next_bucket;
+        }
+    }
+    CHECK(num_wrong == 0);
+}
+
+int main(int argc, char** argv) {
+    test_xxhash64();
+    test_jump_consistent_hash();
+    if (num_failures > 0) {
+        std::cout << num_failures << " checks failed." << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed." << std::endl;
+    return 0;
+}
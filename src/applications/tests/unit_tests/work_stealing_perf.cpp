@@ -0,0 +1,259 @@
+#include <getopt.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cascade/detail/action_queue.hpp>
+#include <cascade/utils.hpp>
+#include <cascade/detail/work_stealing_scheduler.hpp>
+
+/**
+ * @file work_stealing_perf.cpp
+ *
+ * Work Stealing Scheduler Tester
+ *
+ * This tester posts stateless actions at a fixed rate from one thread, which stands for the critical data path, to a
+ * number of worker threads. Most actions are cheap, but a few are slow. It reports the latency from posting an action
+ * to finishing it. The WorkStealingScheduler used for the stateless workers of the ExecutionEngine is compared with
+ * posting the actions round-robin to per-worker queues, as the ExecutionEngine did before, where an action posted
+ * behind a slow one waits for it even if the other workers are idle.
+ */
+
+using namespace derecho::cascade;
+
+/**
+ * @brief Help string.
+ */
+const char* help_string =
+    "Work Stealing Scheduler Tester\n"
+    "------------------------------\n"
+    "Options:\n"
+    "\t--(s)cheduler <stealing|roundrobin>          the scheduler to test, default: stealing\n"
+    "\t--(w)orkers <num_workers>                    number of worker threads, default: 4\n"
+    "\t--(n)um_actions <num_actions>                number of actions to post, default: 100000\n"
+    "\t--(r)ate <actions_per_second>                the posting rate, default: 50000\n"
+    "\t--(c)ost <cost_us>                           the cost of a cheap action in microseconds, default: 5\n"
+    "\t--slow_(p)ercent <percent>                   the percentage of slow actions, default: 1\n"
+    "\t--slow_c(o)st <cost_us>                      the cost of a slow action in microseconds, default: 1000\n"
+    "\t--(h)elp                                     help information\n"
+    ;
+
+/**
+ * @brief The action posted by the tester.
+ */
+struct test_action_t {
+    uint64_t post_ns = 0;
+    uint64_t cost_ns = 0;
+    std::shared_ptr<uint64_t> value_ptr;
+};
+
+#define TEST_QUEUE_SIZE (8192)
+
+/**
+ * @brief Per-worker queues fed round-robin, where a worker only takes the actions in its own queue.
+ */
+class RoundRobinScheduler {
+    std::vector<std::unique_ptr<ActionQueue<test_action_t>>> queues;
+    std::atomic<uint32_t> next_queue{0};
+
+public:
+    RoundRobinScheduler(uint32_t num_workers) {
+        for (uint32_t i = 0; i < num_workers; i++) {
+            queues.emplace_back(std::make_unique<ActionQueue<test_action_t>>(TEST_QUEUE_SIZE));
+        }
+    }
+
+    void enqueue(test_action_t&& action) {
+        queues[next_queue.fetch_add(1) % queues.size()]->enqueue(std::move(action));
+    }
+
+    bool dequeue(uint32_t worker_id, test_action_t& action, const std::atomic<bool>& is_running) {
+        return queues[worker_id]->dequeue(action,is_running);
+    }
+
+    void notify_all() {
+        for (auto& queue : queues) {
+            queue->notify_all();
+        }
+    }
+};
+
+/**
+ * @brief Print the percentiles of a set of latencies.
+ */
+void print_percentiles(const std::string& name, std::vector<uint64_t>& latencies_ns) {
+    if (latencies_ns.empty()) {
+        return;
+    }
+    std::sort(latencies_ns.begin(),latencies_ns.end());
+    auto at = [&latencies_ns](double p) {
+        return latencies_ns[std::min(latencies_ns.size() - 1,static_cast<std::size_t>(p * latencies_ns.size()))];
+    };
+    std::cout << name << " latency(us): p50=" << at(0.5) / 1000 << ", p99=" << at(0.99) / 1000
+              << ", p99.9=" << at(0.999) / 1000 << ", max=" << latencies_ns.back() / 1000 << std::endl;
+}
+
+/**
+ * @brief Run the test.
+ *
+ * @tparam      SchedulerType       The scheduler type, with enqueue(), dequeue(), and notify_all().
+ * @param[in]   scheduler           The scheduler.
+ * @param[in]   num_workers         The number of worker threads.
+ * @param[in]   num_actions         The number of actions to post.
+ * @param[in]   rate                The posting rate.
+ * @param[in]   cost_ns             The cost of a cheap action.
+ * @param[in]   slow_percent        The percentage of slow actions.
+ * @param[in]   slow_cost_ns        The cost of a slow action.
+ *
+ * @return true if every action is processed exactly once.
+ */
+template <typename SchedulerType>
+bool evaluate(SchedulerType& scheduler, uint32_t num_workers, uint64_t num_actions, uint64_t rate,
+              uint64_t cost_ns, double slow_percent, uint64_t slow_cost_ns) {
+    std::atomic<bool> is_running{true};
+    std::vector<std::vector<uint64_t>> latencies_ns(num_workers);
+    std::vector<uint64_t> sums(num_workers,0);
+    std::atomic<uint64_t> num_done{0};
+
+    std::vector<std::thread> workers;
+    for (uint32_t w = 0; w < num_workers; w++) {
+        workers.emplace_back([&,w]() {
+            latencies_ns[w].reserve(num_actions / num_workers + 1);
+            test_action_t action;
+            while (scheduler.dequeue(w,action,is_running)) {
+                uint64_t deadline_ns = get_time_ns(false) + action.cost_ns;
+                while (get_time_ns(false) < deadline_ns);
+                sums[w] += *action.value_ptr;
+                action.value_ptr.reset();
+                latencies_ns[w].emplace_back(get_time_ns(false) - action.post_ns);
+                num_done.fetch_add(1,std::memory_order_relaxed);
+            }
+        });
+    }
+
+    std::mt19937_64 rng(0);
+    std::uniform_real_distribution<double> percent(0.0,100.0);
+    uint64_t interval_ns = 1000000000ull / rate;
+    uint64_t start_ns = get_time_ns(false);
+    for (uint64_t i = 1; i <= num_actions; i++) {
+        uint64_t target_ns = start_ns + i * interval_ns;
+        while (get_time_ns(false) < target_ns);
+        test_action_t action;
+        action.cost_ns = (percent(rng) < slow_percent) ? slow_cost_ns : cost_ns;
+        action.value_ptr = std::make_shared<uint64_t>(i);
+        action.post_ns = get_time_ns(false);
+        scheduler.enqueue(std::move(action));
+    }
+    while (num_done.load() < num_actions) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    is_running.store(false);
+    scheduler.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    uint64_t sum = 0;
+    std::vector<uint64_t> all_latencies_ns;
+    for (uint32_t w = 0; w < num_workers; w++) {
+        sum += sums[w];
+        all_latencies_ns.insert(all_latencies_ns.end(),latencies_ns[w].begin(),latencies_ns[w].end());
+    }
+    std::cout << "actions:" << num_actions << ", workers:" << num_workers << ", rate:" << rate << "/s" << std::endl;
+    print_percentiles("post-to-finish",all_latencies_ns);
+    if (num_done.load() != num_actions || sum != num_actions * (num_actions + 1) / 2) {
+        std::cerr << "FAILED: the actions are lost or duplicated." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief The main entry.
+ */
+int main(int argc, char** argv) {
+    static struct option long_options[] = {
+        {"scheduler",   required_argument,  0,  's'},
+        {"workers",     required_argument,  0,  'w'},
+        {"num_actions", required_argument,  0,  'n'},
+        {"rate",        required_argument,  0,  'r'},
+        {"cost",        required_argument,  0,  'c'},
+        {"slow_percent",required_argument,  0,  'p'},
+        {"slow_cost",   required_argument,  0,  'o'},
+        {"help",        no_argument,        0,  'h'},
+        {0,0,0,0}
+    };
+
+    int c;
+    std::string scheduler_type = "stealing";
+    uint32_t    num_workers = 4;
+    uint64_t    num_actions = 100000;
+    uint64_t    rate = 50000;
+    uint64_t    cost_us = 5;
+    double      slow_percent = 1;
+    uint64_t    slow_cost_us = 1000;
+
+    while (true) {
+        int option_index = 0;
+        c = getopt_long(argc,argv,"s:w:n:r:c:p:o:h",long_options,&option_index);
+
+        if (c == -1) {
+            break;
+        }
+
+        switch(c) {
+        case 's':
+            scheduler_type = optarg;
+            break;
+        case 'w':
+            num_workers = std::stoul(optarg);
+            break;
+        case 'n':
+            num_actions = std::stoull(optarg);
+            break;
+        case 'r':
+            rate = std::stoull(optarg);
+            break;
+        case 'c':
+            cost_us = std::stoull(optarg);
+            break;
+        case 'p':
+            slow_percent = std::stod(optarg);
+            break;
+        case 'o':
+            slow_cost_us = std::stoull(optarg);
+            break;
+        case 'h':
+            std::cout << help_string << std::endl;
+            return 0;
+        case '?':
+        default:
+            std::cout << "unknown options." << std::endl;
+            std::cout << help_string << std::endl;
+            return -1;
+        }
+    }
+
+    if (num_workers == 0 || num_actions == 0 || rate == 0) {
+        std::cerr << "num_workers, num_actions, and rate must be positive." << std::endl;
+        return -1;
+    }
+    std::cout << "scheduler=" << scheduler_type << std::endl;
+    if (scheduler_type == "stealing") {
+        WorkStealingScheduler<test_action_t> scheduler(num_workers,TEST_QUEUE_SIZE);
+        bool ok = evaluate(scheduler, num_workers, num_actions, rate, cost_us * 1000, slow_percent, slow_cost_us * 1000);
+        std::cout << "steals:" << scheduler.get_num_steals() << std::endl;
+        return ok ? 0 : -1;
+    } else if (scheduler_type == "roundrobin") {
+        RoundRobinScheduler scheduler(num_workers);
+        return evaluate(scheduler, num_workers, num_actions, rate, cost_us * 1000, slow_percent, slow_cost_us * 1000) ? 0 : -1;
+    }
+    std::cerr << "unknown scheduler:" << scheduler_type << std::endl;
+    return -1;
+}
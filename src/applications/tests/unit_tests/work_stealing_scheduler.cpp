@@ -0,0 +1,155 @@
+#include <cascade/detail/work_stealing_scheduler.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace derecho::cascade;
+
+/**
+ * @file work_stealing_scheduler.cpp
+ *
+ * WorkStealingScheduler Tester
+ *
+ * It checks that a worker takes from its own queue before stealing from the others, that every element is delivered
+ * exactly once to a pool of concurrent workers, and that the waiting dequeues return at their deadline and at
+ * shutdown.
+ */
+
+static uint32_t num_failures = 0;
+
+#define CHECK(cond) \
+    if (!(cond)) { \
+        std::cout << "FAILED: " << __func__ << ":" << __LINE__ << ": " #cond << std::endl; \
+        num_failures++; \
+    }
+
+void test_steal_order() {
+    WorkStealingScheduler<uint32_t> scheduler(2,16);
+    CHECK(scheduler.get_num_workers() == 2);
+    uint32_t value = 0;
+    CHECK(!scheduler.try_dequeue(0,value));
+
+    // round-robin: 0 and 2 go to worker 0, 1 and 3 go to worker 1.
+    for (uint32_t i = 0; i < 4; i++) {
+        scheduler.enqueue(uint32_t{i});
+    }
+    CHECK(scheduler.size() == 4);
+    // worker 0 drains its own queue first, then steals the oldest elements of worker 1.
+    std::vector<uint32_t> expected{0,2,1,3};
+    for (uint32_t i = 0; i < expected.size(); i++) {
+        CHECK(scheduler.try_dequeue(0,value) && value == expected[i]);
+    }
+    CHECK(!scheduler.try_dequeue(0,value));
+    CHECK(!scheduler.try_dequeue(1,value));
+    CHECK(scheduler.get_num_steals() == 2);
+    CHECK(scheduler.size() == 0);
+}
+
+void test_full_queue_fallback() {
+    WorkStealingScheduler<uint32_t> scheduler(2,4);
+    // a full queue spills over to the other one instead of blocking the producer.
+    for (uint32_t i = 0; i < 8; i++) {
+        scheduler.enqueue(uint32_t{i});
+    }
+    CHECK(scheduler.size() == 8);
+    uint32_t value = 0;
+    uint32_t num_dequeued = 0;
+    while (scheduler.try_dequeue(1,value)) {
+        num_dequeued++;
+    }
+    CHECK(num_dequeued == 8);
+}
+
+void test_exactly_once() {
+    const uint32_t num_workers = 4;
+    const uint32_t num_elements = 200000;
+    WorkStealingScheduler<uint32_t> scheduler(num_workers,1024);
+    std::atomic<bool> is_running{true};
+    std::vector<std::atomic<uint32_t>> deliveries(num_elements);
+    for (auto& count : deliveries) {
+        count.store(0);
+    }
+    std::atomic<uint32_t> num_delivered{0};
+
+    std::vector<std::thread> workers;
+    for (uint32_t worker_id = 0; worker_id < num_workers; worker_id++) {
+        workers.emplace_back([&,worker_id]() {
+            uint32_t value = 0;
+            while (scheduler.dequeue(worker_id,value,is_running)) {
+                deliveries[value].fetch_add(1);
+                num_delivered.fetch_add(1);
+            }
+        });
+    }
+    for (uint32_t i = 0; i < num_elements; i++) {
+        scheduler.enqueue(uint32_t{i});
+    }
+    while (num_delivered.load() < num_elements) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    is_running.store(false);
+    scheduler.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    uint32_t num_wrong = 0;
+    for (auto& count : deliveries) {
+        if (count.load() != 1) {
+            num_wrong++;
+        }
+    }
+    CHECK(num_wrong == 0);
+    CHECK(num_delivered.load() == num_elements);
+    CHECK(scheduler.size() == 0);
+}
+
+void test_deadline_and_shutdown() {
+    WorkStealingScheduler<uint32_t> scheduler(2,16);
+    std::atomic<bool> is_running{true};
+    uint32_t value = 0;
+
+    // an empty scheduler returns at the deadline.
+    auto start = std::chrono::steady_clock::now();
+    CHECK(!scheduler.dequeue_until(0,value,is_running,start + std::chrono::milliseconds(50)));
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+
+    // a waiting worker gets an element enqueued after it parks.
+    std::thread producer([&scheduler]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        scheduler.enqueue(7);
+    });
+    CHECK(scheduler.dequeue_until(1,value,is_running,std::chrono::steady_clock::now() + std::chrono::seconds(10))
+          && value == 7);
+    producer.join();
+
+    // a parked worker returns at shutdown.
+    std::atomic<bool> returned{false};
+    std::thread worker([&]() {
+        uint32_t v = 0;
+        CHECK(!scheduler.dequeue(0,v,is_running));
+        returned.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(!returned.load());
+    is_running.store(false);
+    scheduler.notify_all();
+    worker.join();
+    CHECK(returned.load());
+}
+
+int main(int argc, char** argv) {
+    test_steal_order();
+    test_full_queue_fallback();
+    test_exactly_once();
+    test_deadline_and_shutdown();
+    if (num_failures > 0) {
+        std::cout << num_failures << " checks failed." << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed." << std::endl;
+    return 0;
+}
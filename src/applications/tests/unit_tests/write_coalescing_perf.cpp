@@ -0,0 +1,245 @@
+#include <getopt.h>
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cascade/object.hpp>
+#include <cascade/utils.hpp>
+#include <cascade/detail/delta_store_core.hpp>
+#include <cascade/detail/write_coalescer.hpp>
+
+/**
+ * @file write_coalescing_perf.cpp
+ *
+ * put_and_forget Write Coalescing Tester
+ *
+ * This tester writes tiny objects from a number of producer threads through a WriteCoalescer to a number of shards.
+ * The sender does what a put_batch_and_forget does to a shard in process: it marshals the batch, unmarshals it, applies
+ * it to the shard's DeltaCascadeStoreCore in order under one version, the way the shard's ordered_put_batch_and_forget
+ * does, and serializes the delta for the log. It reports the write throughput and the average batch size, and checks
+ * that the writes to every key reach the shard in the order they were written and that every key ends with its last
+ * write. With a batch size of 1, every write is sent on its own, like put_and_forget without coalescing.
+ */
+
+using namespace derecho::cascade;
+
+using StoreCore = DeltaCascadeStoreCore<std::string, ObjectWithStringKey, &ObjectWithStringKey::IK, &ObjectWithStringKey::IV>;
+
+/**
+ * @brief A shard: its state, and the version of its last update. Its updates are serialized like the ordered updates
+ * of a shard.
+ */
+struct shard_t {
+    std::mutex mutex;
+    StoreCore core;
+    persistent::version_t version = 0;
+    std::vector<uint8_t> delta_buffer;
+};
+
+/**
+ * @brief Help string.
+ */
+const char* help_string =
+    "put_and_forget Write Coalescing Tester\n"
+    "--------------------------------------\n"
+    "Options:\n"
+    "\t--(p)roducers <num_producers>                number of producer threads, default: 4\n"
+    "\t--(s)hards <num_shards>                      number of shards, default: 4\n"
+    "\t--(k)eys <num_keys>                          number of keys per producer, default: 64\n"
+    "\t--(w)rites <num_writes>                      number of writes per producer, default: 1000000\n"
+    "\t--(b)atch <max_batch_objects>                the object count threshold, default: 1024\n"
+    "\t--(l)inger <linger_us>                       the linger timeout in microseconds, default: 20\n"
+    "\t--(h)elp                                     help information\n"
+    ;
+
+/**
+ * @brief Run the test.
+ *
+ * @param[in]   num_producers       The number of producer threads.
+ * @param[in]   num_shards          The number of shards.
+ * @param[in]   num_keys            The number of keys per producer.
+ * @param[in]   num_writes          The number of writes per producer.
+ * @param[in]   max_batch_objects   The object count threshold.
+ * @param[in]   linger_us           The linger timeout.
+ *
+ * @return true if the writes to every key are applied in order.
+ */
+bool evaluate(uint32_t num_producers, uint32_t num_shards, uint32_t num_keys, uint32_t num_writes,
+              std::size_t max_batch_objects, uint64_t linger_us) {
+    std::vector<std::unique_ptr<shard_t>> shards;
+    for (uint32_t s = 0; s < num_shards; s++) {
+        shards.emplace_back(std::make_unique<shard_t>());
+    }
+    std::atomic<uint64_t> num_received{0};
+    std::atomic<uint64_t> num_batches{0};
+    std::atomic<bool> in_order{true};
+
+    WriteCoalescer<ObjectWithStringKey> coalescer(
+        [&](uint32_t subgroup_index, uint32_t shard_index, const std::vector<ObjectWithStringKey>& objects, bool as_trigger) {
+            // marshal the batch like the RPC.
+            std::vector<uint8_t> message(mutils::bytes_size(objects));
+            mutils::to_bytes(objects, message.data());
+            auto batch = mutils::from_bytes<std::vector<ObjectWithStringKey>>(nullptr, message.data());
+
+            auto& shard = *shards[shard_index];
+            std::lock_guard<std::mutex> lck(shard.mutex);
+            shard.version++;
+            for (const auto& object : *batch) {
+                object.set_version(shard.version);
+                object.set_timestamp(get_time_ns(false) / 1000);
+            }
+            // the previous write to a key is in the state already, unless it is earlier in this batch.
+            std::unordered_map<std::string,uint64_t> last_in_batch;
+            for (const auto& object : *batch) {
+                uint64_t sequence_number;
+                std::memcpy(&sequence_number, object.blob.bytes, sizeof(sequence_number));
+                auto it = last_in_batch.find(object.get_key_ref());
+                uint64_t last = 0;
+                if (it != last_in_batch.end()) {
+                    last = it->second;
+                } else {
+                    shard.core.kv_map.read(object.get_key_ref(), [&last](const ObjectWithStringKey& value) {
+                        std::memcpy(&last, value.blob.bytes, sizeof(last));
+                    });
+                }
+                if (sequence_number <= last) {
+                    in_order = false;
+                }
+                last_in_batch[object.get_key_ref()] = sequence_number;
+            }
+            auto applied = shard.core.ordered_put_batch_in_order(*batch, shard.version - 1, as_trigger);
+            for (bool a : applied) {
+                if (!a) {
+                    in_order = false;
+                }
+            }
+            shard.delta_buffer.resize(shard.core.currentDeltaSize());
+            shard.core.currentDeltaToBytes(shard.delta_buffer.data(), shard.delta_buffer.size());
+            num_received += batch->size();
+            num_batches ++;
+        },
+        max_batch_objects, 1024*1024, linger_us);
+
+    uint64_t start_ns = get_time_ns(false);
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < num_producers; p++) {
+        producers.emplace_back([&,p]() {
+            std::vector<std::string> keys;
+            for (uint32_t k = 0; k < num_keys; k++) {
+                keys.emplace_back("/telemetry/" + std::to_string(p) + "/" + std::to_string(k));
+            }
+            for (uint64_t w = 1; w <= num_writes; w++) {
+                uint32_t k = static_cast<uint32_t>(w % num_keys);
+                ObjectWithStringKey object(keys[k], reinterpret_cast<const uint8_t*>(&w), sizeof(w));
+                coalescer.put(0, std::hash<std::string>{}(keys[k]) % num_shards, object, false);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    coalescer.flush();
+    uint64_t duration_ns = get_time_ns(false) - start_ns;
+
+    // every key ends with its last write.
+    for (uint32_t p = 0; p < num_producers; p++) {
+        for (uint32_t k = 0; k < num_keys && k < num_writes; k++) {
+            std::string key = "/telemetry/" + std::to_string(p) + "/" + std::to_string(k);
+            uint64_t last_write = num_writes - ((num_writes - k) % num_keys);
+            uint64_t stored = 0;
+            shards[std::hash<std::string>{}(key) % num_shards]->core.kv_map.read(key, [&stored](const ObjectWithStringKey& value) {
+                std::memcpy(&stored, value.blob.bytes, sizeof(stored));
+            });
+            if (stored != last_write) {
+                in_order = false;
+            }
+        }
+    }
+
+    uint64_t num_writes_total = static_cast<uint64_t>(num_producers) * num_writes;
+    std::cout << "batch=" << max_batch_objects << ", linger=" << linger_us << "us" << std::endl;
+    std::cout << "writes:" << num_writes_total << ", sent:" << num_received.load()
+              << ", batches:" << num_batches.load()
+              << ", average batch size:" << static_cast<double>(num_received.load()) / num_batches.load() << std::endl;
+    std::cout << "throughput:" << static_cast<double>(num_writes_total) * 1e3 / duration_ns << " M writes/s" << std::endl;
+    if (num_received.load() != num_writes_total || !in_order.load()) {
+        std::cerr << "FAILED: the writes are lost or out of order." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief The main entry.
+ */
+int main(int argc, char** argv) {
+    static struct option long_options[] = {
+        {"producers",   required_argument,  0,  'p'},
+        {"shards",      required_argument,  0,  's'},
+        {"keys",        required_argument,  0,  'k'},
+        {"writes",      required_argument,  0,  'w'},
+        {"batch",       required_argument,  0,  'b'},
+        {"linger",      required_argument,  0,  'l'},
+        {"help",        no_argument,        0,  'h'},
+        {0,0,0,0}
+    };
+
+    int c;
+    uint32_t    num_producers = 4;
+    uint32_t    num_shards = 4;
+    uint32_t    num_keys = 64;
+    uint32_t    num_writes = 1000000;
+    std::size_t max_batch_objects = 1024;
+    uint64_t    linger_us = 20;
+
+    while (true) {
+        int option_index = 0;
+        c = getopt_long(argc,argv,"p:s:k:w:b:l:h",long_options,&option_index);
+
+        if (c == -1) {
+            break;
+        }
+
+        switch(c) {
+        case 'p':
+            num_producers = std::stoul(optarg);
+            break;
+        case 's':
+            num_shards = std::stoul(optarg);
+            break;
+        case 'k':
+            num_keys = std::stoul(optarg);
+            break;
+        case 'w':
+            num_writes = std::stoul(optarg);
+            break;
+        case 'b':
+            max_batch_objects = std::stoul(optarg);
+            break;
+        case 'l':
+            linger_us = std::stoul(optarg);
+            break;
+        case 'h':
+            std::cout << help_string << std::endl;
+            return 0;
+        case '?':
+        default:
+            std::cout << "unknown options." << std::endl;
+            std::cout << help_string << std::endl;
+            return -1;
+        }
+    }
+
+    if (num_producers == 0 || num_shards == 0 || num_keys == 0 || num_writes == 0 || max_batch_objects == 0) {
+        std::cerr << "num_producers, num_shards, num_keys, num_writes, and max_batch_objects must be positive." << std::endl;
+        return -1;
+    }
+    return evaluate(num_producers, num_shards, num_keys, num_writes, max_batch_objects, linger_us) ? 0 : -1;
+}
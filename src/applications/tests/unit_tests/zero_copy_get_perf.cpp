@@ -0,0 +1,155 @@
+#include <getopt.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cascade/object.hpp>
+#include <cascade/utils.hpp>
+#include <cascade/detail/store_util.hpp>
+
+/**
+ * @file zero_copy_get_perf.cpp
+ *
+ * Zero-copy get Performance Tester
+ *
+ * For object sizes from 1KB to 64MB, this tester measures the cost of a current-version get on the server side, from
+ * looking up the key in kv_map to serializing the object into an RPC reply buffer. It compares the thread_local copy
+ * used by lockless_get before, which copies the object data twice before serialization, against lockless_get_view(),
+ * which serializes the object data directly from a shared handle to the stored object.
+ */
+
+using namespace derecho::cascade;
+
+/**
+ * @brief Help string.
+ */
+const char* help_string =
+    "Zero-copy get Performance Tester\n"
+    "--------------------------------\n"
+    "Options:\n"
+    "\t--(m)in-size <bytes>                         the smallest object size, growing by 4x, default: 1024\n"
+    "\t--ma(x)-size <bytes>                         the largest object size, default: 67108864\n"
+    "\t--(v)olume <MB>                              the amount of object data to get for each size, default: 4096\n"
+    "\t--(h)elp                                     help information\n"
+    ;
+
+/**
+ * @brief get the value of a key the way lockless_get did before lockless_get_view().
+ */
+const ObjectWithStringKey thread_local_copy_get(const ConcurrentOrderedMap<std::string, ObjectWithStringKey>& kv_map, const std::string& key) {
+    static thread_local ObjectWithStringKey copied_out;
+    if(!kv_map.read(key, [](const ObjectWithStringKey& value) { copied_out.copy_from(value); })) {
+        copied_out.copy_from(ObjectWithStringKey::IV);
+    }
+    return copied_out;
+}
+
+/**
+ * @brief Evaluate one get path for one object size.
+ *
+ * @tparam GetFunc              ObjectWithStringKey(const std::string&)
+ * @param[in]   get             The get path.
+ * @param[in]   key             The key to get.
+ * @param[in]   num_iterations  The number of gets.
+ * @param[in]   buffer          The reply buffer, large enough for the serialized object.
+ *
+ * @return The average latency of a get and the serialization of its result, in microseconds.
+ */
+template <typename GetFunc>
+double evaluate_get(const GetFunc& get, const std::string& key, uint64_t num_iterations, uint8_t* buffer) {
+    uint64_t start_ns = get_time_ns(false);
+    for(uint64_t i = 0; i < num_iterations; i++) {
+        const ObjectWithStringKey obj = get(key);
+        obj.to_bytes(buffer);
+    }
+    return static_cast<double>(get_time_ns(false) - start_ns) / num_iterations / 1e3;
+}
+
+/**
+ * @brief Evaluate both get paths for the object sizes.
+ *
+ * @param[in]   min_size    The smallest object size.
+ * @param[in]   max_size    The largest object size.
+ * @param[in]   volume      The amount of object data to get for each size, in bytes.
+ */
+void evaluate(uint64_t min_size, uint64_t max_size, uint64_t volume) {
+    ConcurrentOrderedMap<std::string, ObjectWithStringKey> kv_map;
+    const std::string key = "/pool/key";
+
+    std::cout << "size(bytes)\titerations\tcopy(us)\tzero_copy(us)\tspeedup" << std::endl;
+    for(uint64_t size = min_size; size <= max_size; size *= 4) {
+        std::vector<uint8_t> data(size, 'v');
+        kv_map.insert_or_assign(key, ObjectWithStringKey(key, data.data(), size));
+        uint64_t num_iterations = std::max(volume / size, static_cast<uint64_t>(8));
+        std::size_t reply_size = kv_map.at(key).bytes_size();
+        uint8_t* buffer = static_cast<uint8_t*>(malloc(reply_size));
+        // touch the reply buffer and warm up both paths.
+        thread_local_copy_get(kv_map, key).to_bytes(buffer);
+        lockless_get_view(kv_map, key, ObjectWithStringKey::IV).to_bytes(buffer);
+
+        double copy_us = evaluate_get([&kv_map](const std::string& k) { return thread_local_copy_get(kv_map, k); },
+                                      key, num_iterations, buffer);
+        double view_us = evaluate_get([&kv_map](const std::string& k) { return lockless_get_view(kv_map, k, ObjectWithStringKey::IV); },
+                                      key, num_iterations, buffer);
+        free(buffer);
+        std::cout << size << "\t\t" << num_iterations << "\t\t" << copy_us << "\t\t" << view_us << "\t\t"
+                  << copy_us / view_us << std::endl;
+    }
+}
+
+/**
+ * @brief The main entry.
+ */
+int main(int argc, char** argv) {
+    static struct option long_options[] = {
+        {"min-size",    required_argument,  0,  'm'},
+        {"max-size",    required_argument,  0,  'x'},
+        {"volume",      required_argument,  0,  'v'},
+        {"help",        no_argument,        0,  'h'},
+        {0,0,0,0}
+    };
+
+    int c;
+    uint64_t    min_size = 1024;
+    uint64_t    max_size = 64ull << 20;
+    uint64_t    volume_mb = 4096;
+
+    while (true) {
+        int option_index = 0;
+        c = getopt_long(argc,argv,"m:x:v:h",long_options,&option_index);
+
+        if (c == -1) {
+            break;
+        }
+
+        switch(c) {
+        case 'm':
+            min_size = std::stoull(optarg);
+            break;
+        case 'x':
+            max_size = std::stoull(optarg);
+            break;
+        case 'v':
+            volume_mb = std::stoull(optarg);
+            break;
+        case 'h':
+            std::cout << help_string << std::endl;
+            return 0;
+        case '?':
+        default:
+            std::cout << "unknown options." << std::endl;
+            std::cout << help_string << std::endl;
+            return -1;
+        }
+    }
+
+    if (min_size == 0) {
+        std::cerr << "min_size must be positive." << std::endl;
+        return -1;
+    }
+    evaluate(min_size, max_size, volume_mb << 20);
+    return 0;
+}
@@ -75,9 +75,25 @@ Blob::Blob(const blob_generator_func_t& generator, const decltype(size) s):
     // no data is generated here.
 }
 
+Blob::Blob(const uint8_t* b, const decltype(size) s, const std::shared_ptr<const void>& owner) :
+    bytes(b), size(s), capacity(s), shared_owner(owner), memory_mode(object_memory_mode_t::SHARED) {
+    if (size == 0) {
+        bytes = nullptr;
+        shared_owner.reset();
+        memory_mode = object_memory_mode_t::DEFAULT;
+    }
+}
+
 Blob::Blob(const Blob& other) :
     bytes(nullptr), size(0), capacity(0), memory_mode(object_memory_mode_t::DEFAULT) {
-    if(other.size > 0) {
+    if (other.memory_mode == object_memory_mode_t::SHARED) {
+        // the shared data never changes, so the copy shares it, too.
+        bytes = other.bytes;
+        size = other.size;
+        capacity = other.size;
+        shared_owner = other.shared_owner;
+        memory_mode = object_memory_mode_t::SHARED;
+    } else if(other.size > 0) {
         uint8_t* t_bytes = static_cast<uint8_t*>(malloc(other.size));
         if (other.memory_mode == object_memory_mode_t::BLOB_GENERATOR) {
             // instantiate data.
@@ -101,7 +117,7 @@ Blob::Blob(const Blob& other) :
 
 Blob::Blob(Blob&& other) : 
     bytes(other.bytes), size(other.size), capacity(other.size),
-    blob_generator(other.blob_generator), memory_mode(other.memory_mode) {
+    blob_generator(other.blob_generator), shared_owner(std::move(other.shared_owner)), memory_mode(other.memory_mode) {
     other.bytes = nullptr;
     other.size = 0;
     other.capacity = 0;
@@ -121,6 +137,7 @@ Blob& Blob::operator=(Blob&& other) {
     auto swp_cap  = other.capacity;
     auto swp_blob_generator = other.blob_generator;
     auto swp_memory_mode = other.memory_mode;
+    other.shared_owner.swap(shared_owner);
     other.bytes = bytes;
     other.size = size;
     other.capacity = capacity;
@@ -135,6 +152,15 @@ Blob& Blob::operator=(Blob&& other) {
 }
 
 Blob& Blob::operator=(const Blob& other) {
+    // 0) a SHARED blob lets go of the shared data, and owns a copy instead.
+    if (memory_mode == object_memory_mode_t::SHARED) {
+        bytes = nullptr;
+        size = 0;
+        capacity = 0;
+        shared_owner.reset();
+        memory_mode = object_memory_mode_t::DEFAULT;
+    }
+
     // 1) this->is_emplaced has to be false;
     if (memory_mode != object_memory_mode_t::DEFAULT) {
         throw std::runtime_error("Copy to a Blob that does not own the data (object_memory_mode_T::DEFAULT) is prohibited.");
@@ -426,6 +452,26 @@ bool ObjectWithUInt64Key::verify_previous_version(persistent::version_t prev_ver
            ((this->previous_version_by_key == persistent::INVALID_VERSION)?true:(this->previous_version_by_key >= prev_ver_by_key));
 }
 
+ObjectWithUInt64Key ObjectWithUInt64Key::create_shared_view(const std::shared_ptr<const ObjectWithUInt64Key>& self) const {
+    if (self->blob.size == 0) {
+        return *self;
+    }
+    ObjectWithUInt64Key view(
+#ifdef ENABLE_EVALUATION
+        self->message_id,
+#endif
+        self->version,
+        self->timestamp_us,
+        self->previous_version,
+        self->previous_version_by_key,
+        self->key,
+        static_cast<const uint8_t*>(nullptr),
+        0);
+    // The blob refers to the data of the shared object, which it keeps alive.
+    view.blob = Blob(self->blob.bytes, self->blob.size, self);
+    return view;
+}
+
 #ifdef ENABLE_EVALUATION
 void ObjectWithUInt64Key::set_message_id(uint64_t id) const {
     this->message_id = id;
@@ -779,6 +825,26 @@ bool ObjectWithStringKey::verify_previous_version(persistent::version_t prev_ver
            ((this->previous_version_by_key == persistent::INVALID_VERSION)?true:(this->previous_version_by_key >= prev_ver_by_key));
 }
 
+ObjectWithStringKey ObjectWithStringKey::create_shared_view(const std::shared_ptr<const ObjectWithStringKey>& self) const {
+    if (self->blob.size == 0) {
+        return *self;
+    }
+    ObjectWithStringKey view(
+#ifdef ENABLE_EVALUATION
+        self->message_id,
+#endif
+        self->version,
+        self->timestamp_us,
+        self->previous_version,
+        self->previous_version_by_key,
+        self->key,
+        static_cast<const uint8_t*>(nullptr),
+        0);
+    // The blob refers to the data of the shared object, which it keeps alive.
+    view.blob = Blob(self->blob.bytes, self->blob.size, self);
+    return view;
+}
+
 #ifdef ENABLE_EVALUATION
 void ObjectWithStringKey::set_message_id(uint64_t id) const {
     this->message_id = id;
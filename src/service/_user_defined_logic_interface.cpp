@@ -3,31 +3,25 @@
 namespace derecho {
 namespace cascade {
 
-void DefaultOffCriticalDataPathObserver::operator() (
-        const node_id_t sender,
-        const std::string& full_key_string,
-        const uint32_t prefix_length,
-        persistent::version_t,
-        const mutils::ByteRepresentable* const value_ptr,
-        const std::unordered_map<std::string,bool>& outputs,
-        ICascadeContext* ctxt,
-        uint32_t worker_id) {
-    auto* typed_ctxt = dynamic_cast<DefaultCascadeContextType*>(ctxt);
-    const auto* object_ptr = dynamic_cast<const ObjectWithStringKey*>(value_ptr);
-    std::string object_pool_pathname = full_key_string.substr(0,prefix_length);
+/**
+ * Split a full key into the object pool pathname and the key inside the object pool.
+ */
+static void split_full_key(const std::string& full_key_string, const uint32_t prefix_length,
+                           std::string& object_pool_pathname, std::string& key_string) {
+    object_pool_pathname = full_key_string.substr(0,prefix_length);
     while (object_pool_pathname.back() == PATH_SEPARATOR && !object_pool_pathname.empty()) {
         object_pool_pathname.pop_back();
     }
-    std::string key_string = full_key_string.substr(prefix_length);
+    key_string = full_key_string.substr(prefix_length);
+}
 
-    // call typed handler
-    dbg_default_trace("DefaultOffCriticalDataPathObserver: calling typed handler for key={}...", full_key_string);
-    this->ocdpo_handler(
-            sender,
-            object_pool_pathname,
-            key_string,
-            *object_ptr,
-            [&](const std::string&    key,
+/**
+ * Create the emit function sending the output to the destinations of a UDL.
+ */
+static emit_func_t make_emit(const std::unordered_map<std::string,bool>& outputs,
+                             DefaultCascadeContextType* typed_ctxt) {
+    return [&outputs,typed_ctxt](
+                const std::string&    key,
                 persistent::version_t version,
                 uint64_t              timestamp_us,
                 persistent::version_t previous_version,
@@ -58,11 +52,73 @@ void DefaultOffCriticalDataPathObserver::operator() (
                         typed_ctxt->get_service_client_ref().put_and_forget(obj_to_send);
                     }
                 }
-            },
+            };
+}
+
+void DefaultOffCriticalDataPathObserver::operator() (
+        const node_id_t sender,
+        const std::string& full_key_string,
+        const uint32_t prefix_length,
+        persistent::version_t,
+        const mutils::ByteRepresentable* const value_ptr,
+        const std::unordered_map<std::string,bool>& outputs,
+        ICascadeContext* ctxt,
+        uint32_t worker_id) {
+    auto* typed_ctxt = dynamic_cast<DefaultCascadeContextType*>(ctxt);
+    const auto* object_ptr = dynamic_cast<const ObjectWithStringKey*>(value_ptr);
+    std::string object_pool_pathname;
+    std::string key_string;
+    split_full_key(full_key_string,prefix_length,object_pool_pathname,key_string);
+
+    // call typed handler
+    dbg_default_trace("DefaultOffCriticalDataPathObserver: calling typed handler for key={}...", full_key_string);
+    this->ocdpo_handler(
+            sender,
+            object_pool_pathname,
+            key_string,
+            *object_ptr,
+            make_emit(outputs,typed_ctxt),
             typed_ctxt,
             worker_id);
     dbg_default_trace("DefaultOffCriticalDataPathObserver: calling typed handler for key={}...done", full_key_string);
 }
 
+void DefaultOffCriticalDataPathObserver::handle_batch(
+        const Action* actions,
+        const std::size_t num_actions,
+        ICascadeContext* ctxt,
+        uint32_t worker_id) {
+    auto* typed_ctxt = dynamic_cast<DefaultCascadeContextType*>(ctxt);
+    std::vector<ocdpo_batch_entry_t> batch(num_actions);
+    for (std::size_t i = 0; i < num_actions; i++) {
+        batch[i].sender = actions[i].sender;
+        split_full_key(actions[i].key_string,actions[i].prefix_length,
+                       batch[i].object_pool_pathname,batch[i].key_string);
+        batch[i].object = dynamic_cast<const ObjectWithStringKey*>(actions[i].value_ptr.get());
+        batch[i].emit = make_emit(actions[i].outputs,typed_ctxt);
+    }
+
+    // call typed batch handler
+    dbg_default_trace("DefaultOffCriticalDataPathObserver: calling typed batch handler for {} objects...", num_actions);
+    this->ocdpo_batch_handler(batch,typed_ctxt,worker_id);
+    dbg_default_trace("DefaultOffCriticalDataPathObserver: calling typed batch handler for {} objects...done", num_actions);
+}
+
+void DefaultOffCriticalDataPathObserver::ocdpo_batch_handler(
+        const std::vector<ocdpo_batch_entry_t>& batch,
+        DefaultCascadeContextType* typed_ctxt,
+        uint32_t worker_id) {
+    for (const auto& entry : batch) {
+        this->ocdpo_handler(
+                entry.sender,
+                entry.object_pool_pathname,
+                entry.key_string,
+                *entry.object,
+                entry.emit,
+                typed_ctxt,
+                worker_id);
+    }
+}
+
 }
 }
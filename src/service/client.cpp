@@ -1,7 +1,11 @@
 #include <cascade/service_client_api.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <thread>
 #include <typeindex>
 #include <stdio.h>
 #include <readline/readline.h>
@@ -98,6 +102,8 @@ static const char* policy_names[] = {
     "RoundRobin",
     "KeyHashing",
     "UserSpecified",
+    "LeastOutstandingRequests",
+    "PowerOfTwoChoices",
     nullptr
 };
 
@@ -223,6 +229,40 @@ void put_and_forget(ServiceClientAPI& capi, const std::string& key, const std::s
     std::cout << "put done." << std::endl;
 }
 
+template <typename SubgroupType>
+void put_batch(ServiceClientAPI& capi, const std::vector<std::string>& kv_tokens, uint32_t subgroup_index, uint32_t shard_index) {
+    std::vector<typename SubgroupType::ObjectType> objs;
+    for (size_t i = 0; i + 1 < kv_tokens.size(); i += 2) {
+        typename SubgroupType::ObjectType obj;
+        if constexpr (std::is_same<typename SubgroupType::KeyType,uint64_t>::value) {
+            obj.key = static_cast<uint64_t>(std::stol(kv_tokens[i],nullptr,0));
+        } else if constexpr (std::is_same<typename SubgroupType::KeyType,std::string>::value) {
+            obj.key = kv_tokens[i];
+        } else {
+            print_red(std::string("Unhandled KeyType:") + typeid(typename SubgroupType::KeyType).name());
+            return;
+        }
+        obj.blob = Blob(reinterpret_cast<const uint8_t*>(kv_tokens[i+1].c_str()),kv_tokens[i+1].length());
+        objs.emplace_back(std::move(obj));
+    }
+    derecho::rpc::QueryResults<derecho::cascade::version_tuple> result = capi.template put_batch<SubgroupType>(objs, subgroup_index, shard_index);
+    check_put_and_remove_result(result);
+}
+
+void op_put_batch(ServiceClientAPI& capi, const std::vector<std::string>& kv_tokens) {
+    std::vector<ObjectWithStringKey> objs;
+    for (size_t i = 0; i + 1 < kv_tokens.size(); i += 2) {
+        ObjectWithStringKey obj;
+        obj.key = kv_tokens[i];
+        obj.blob = Blob(reinterpret_cast<const uint8_t*>(kv_tokens[i+1].c_str()),kv_tokens[i+1].length());
+        objs.emplace_back(std::move(obj));
+    }
+    auto results = capi.put_batch(objs,false);
+    for (auto& result : results) {
+        check_put_and_remove_result((*result));
+    }
+}
+
 void op_put(ServiceClientAPI& capi, const std::string& key, const std::string& value, persistent::version_t pver, persistent::version_t pver_bk) {
     ObjectWithStringKey obj;
     obj.key = key;
@@ -290,17 +330,31 @@ void op_put_file_and_forget(ServiceClientAPI& capi, const std::string& key, cons
 
 template <typename SubgroupType>
 void create_object_pool(ServiceClientAPI& capi, const std::string& id, uint32_t subgroup_index,
-                        const std::string& affinity_set_regex) {
+                        const std::string& affinity_set_regex, sharding_policy_t sharding_policy) {
     auto result = capi.template create_object_pool<SubgroupType>(
             id,
             subgroup_index,
-            sharding_policy_type::HASH,
+            sharding_policy,
             {},
             affinity_set_regex);
     check_put_and_remove_result(result);
     std::cout << "create_object_pool is done." << std::endl;
 }
 
+template <typename SubgroupType>
+void create_range_object_pool(ServiceClientAPI& capi, const std::string& id, uint32_t subgroup_index,
+                              const std::vector<std::string>& range_split_points) {
+    auto result = capi.template create_object_pool<SubgroupType>(
+            id,
+            subgroup_index,
+            sharding_policy_type::RANGE,
+            {},
+            "",
+            range_split_points);
+    check_put_and_remove_result(result);
+    std::cout << "create_range_object_pool is done." << std::endl;
+}
+
 template <typename SubgroupType>
 void trigger_put(ServiceClientAPI& capi, const std::string& key, const std::string& value, uint32_t subgroup_index, uint32_t shard_index) {
     typename SubgroupType::ObjectType obj;
@@ -507,8 +561,7 @@ void list_keys_by_time(ServiceClientAPI& capi, uint64_t ts_us, bool stable, uint
 //    "list_data_by_prefix <type> <prefix> [version] [subgroup_index] [shard_index\n\t test LINQ api\n]"
 template <typename SubgroupType>
 void list_data_by_prefix(ServiceClientAPI& capi, std::string prefix, persistent::version_t ver, uint32_t subgroup_index, uint32_t shard_index) {
-    std::vector<typename SubgroupType::KeyType> keys;
-    for (auto& obj : from_shard<SubgroupType,ServiceClientAPI>(keys,capi,subgroup_index,shard_index,ver).where([&prefix](typename SubgroupType::ObjectType o){
+    for (auto& obj : from_shard<SubgroupType,ServiceClientAPI>(capi,subgroup_index,shard_index,ver).where([&prefix](typename SubgroupType::ObjectType o){
                 if (o.blob.size < prefix.size()) {
                     return false;
                 } else {
@@ -611,14 +664,13 @@ void list_data_between_timestamps<TriggerCascadeNoStoreWithStringKey>(ServiceCli
 //    "list_data_in_subgroup <type> <subgroup_index> [version]\n\t test LINQ api - subgroup_iterator \n"
 template <typename SubgroupType>
 void list_data_in_subgroup(ServiceClientAPI& capi, uint32_t subgroup_index, persistent::version_t version) {
-    std::vector<typename SubgroupType::KeyType> keys;
     std::vector<CascadeShardLinq<SubgroupType, ServiceClientAPI>> shard_linq_list;
 
-    std::unordered_map<uint32_t, std::vector<typename SubgroupType::KeyType>> shardidx_to_keys;
-
-    for (auto &obj : from_subgroup<SubgroupType, ServiceClientAPI>(shardidx_to_keys, shard_linq_list, capi, subgroup_index, version).toStdVector()) {
-        std::cout << "Found:" << obj << std::endl;
-    }
+    // print the objects as the pages of each shard arrive, instead of collecting all of them first.
+    from_subgroup<SubgroupType, ServiceClientAPI>(shard_linq_list, capi, subgroup_index, version).for_each(
+        [](const typename SubgroupType::ObjectType& obj) {
+            std::cout << "Found:" << obj << std::endl;
+        });
 }
 
 template <>
@@ -779,6 +831,79 @@ bool perftest_ordered_put<TriggerCascadeNoStoreWithStringKey>(ServiceClientAPI &
     return false;
 }
 
+// The put throughput from a growing number of threads sharing this client
+template <typename SubgroupType>
+bool perftest_put_threads(ServiceClientAPI& capi,
+                          uint32_t message_size,
+                          uint32_t max_threads,
+                          uint64_t duration_sec,
+                          uint32_t subgroup_index,
+                          uint32_t shard_index) {
+    PerfTestClient ptc{capi};
+    return ptc.template perf_put_threads<SubgroupType>(message_size,max_threads,duration_sec,subgroup_index,shard_index);
+}
+
+/**
+ * @brief Measure how soon a newly created object pool is usable: create object pools one after another, and right
+ * after each creation returns, let a number of threads put an object into it at the same time. The latency of these
+ * first puts includes resolving the new object pool on the client.
+ *
+ * @param[in]   capi            The service client shared by the threads.
+ * @param[in]   num_pools       The number of object pools to create.
+ * @param[in]   num_threads     The number of threads putting to a new object pool.
+ * @param[in]   subgroup_index  The subgroup index of the object pools.
+ */
+template <typename SubgroupType>
+bool perftest_create_object_pool(ServiceClientAPI& capi,
+                                 uint32_t num_pools,
+                                 uint32_t num_threads,
+                                 uint32_t subgroup_index) {
+    debug_enter_func_with_args("num_pools={},num_threads={},subgroup_index={}.",num_pools,num_threads,subgroup_index);
+    const std::string value(64,'v');
+    const std::string prefix = "/perftest_create_object_pool_" + std::to_string(get_walltime());
+    uint64_t total_create_ns = 0;
+    uint64_t total_first_put_ns = 0;
+    uint64_t total_last_put_ns = 0;
+    for (uint32_t p = 0; p < num_pools; p++) {
+        const std::string pathname = prefix + "/pool_" + std::to_string(p);
+        uint64_t start_ns = get_walltime();
+        auto result = capi.template create_object_pool<SubgroupType>(pathname,subgroup_index,HASH,{});
+        for (auto& reply_future: result.get()) {
+            reply_future.second.get();
+        }
+        uint64_t created_ns = get_walltime();
+        std::vector<uint64_t> put_ns(num_threads,0);
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < num_threads; t++) {
+            threads.emplace_back([&,t]() {
+                typename SubgroupType::ObjectType obj;
+                obj.key = pathname + "/thread_" + std::to_string(t);
+                obj.blob = Blob(reinterpret_cast<const uint8_t*>(value.c_str()),value.length());
+                auto put_result = capi.put(obj,false);
+                for (auto& reply_future: put_result.get()) {
+                    reply_future.second.get();
+                }
+                put_ns[t] = get_walltime() - created_ns;
+            });
+        }
+        for (auto& th: threads) {
+            th.join();
+        }
+        total_create_ns += created_ns - start_ns;
+        total_first_put_ns += *std::min_element(put_ns.begin(),put_ns.end());
+        total_last_put_ns += *std::max_element(put_ns.begin(),put_ns.end());
+    }
+    for (uint32_t p = 0; p < num_pools; p++) {
+        capi.remove_object_pool(prefix + "/pool_" + std::to_string(p)).get();
+    }
+    std::cout << "pools=" << num_pools << ", threads=" << num_threads << std::endl;
+    std::cout << "create(us)\tfirst put(us)\tlast put(us)" << std::endl;
+    std::cout << total_create_ns/1e3/num_pools << "\t\t" << total_first_put_ns/1e3/num_pools << "\t\t"
+              << total_last_put_ns/1e3/num_pools << std::endl;
+    debug_leave_func();
+    return true;
+}
+
 template <typename SubgroupType>
 bool dump_timestamp(ServiceClientAPI &capi,
                     uint32_t subgroup_index,
@@ -832,7 +957,7 @@ inline bool do_command(ServiceClientAPI& capi, const std::vector<std::string>& c
 
 bool shell_is_active = true;
 #define SUBGROUP_TYPE_LIST "VCSS|PCSS|TCSS"
-#define SHARD_MEMBER_SELECTION_POLICY_LIST "FirstMember|LastMember|Random|FixedRandom|RoundRobin|KeyHashing|UserSpecified"
+#define SHARD_MEMBER_SELECTION_POLICY_LIST "FirstMember|LastMember|Random|FixedRandom|RoundRobin|KeyHashing|UserSpecified|LeastOutstandingRequests|PowerOfTwoChoices"
 #define CHECK_FORMAT(tks,argc) \
             if (tks.size() < argc) { \
                 print_red("Invalid command format. Please try help " + tks[0] + "."); \
@@ -1100,6 +1225,120 @@ std::vector<command_entry_t> commands =
             return true;
         }
     },
+    {
+        "set_read_hedging",
+        "Enable or disable hedged reads for current-version get, get_size, and list_keys.",
+        "set_read_hedging <delay percentile|off> [min delay in us]\n"
+            "delay percentile := a number in (0,1), e.g. 0.95",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,2);
+            if (cmd_tokens[1] == "off") {
+                capi.disable_read_hedging();
+                return true;
+            }
+            double delay_percentile = std::stod(cmd_tokens[1]);
+            uint64_t min_delay_us = 100;
+            if (cmd_tokens.size() >= 3) {
+                min_delay_us = std::stoul(cmd_tokens[2]);
+            }
+            if (delay_percentile <= 0.0 || delay_percentile >= 1.0) {
+                print_red("Invalid delay percentile:" + cmd_tokens[1]);
+                return false;
+            }
+            capi.enable_read_hedging(delay_percentile,min_delay_us);
+            return true;
+        }
+    },
+    {
+        "get_read_hedging_stats",
+        "Get the hedged read counters.",
+        "get_read_hedging_stats",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            auto stats = capi.get_read_hedging_stats();
+            std::cout << "hedgeable reads:" << std::get<0>(stats)
+                      << ", hedged reads:" << std::get<1>(stats)
+                      << ", won by the hedged read:" << std::get<2>(stats)
+                      << ", hedging delay:" << std::get<3>(stats)/1000 << "us" << std::endl;
+            return true;
+        }
+    },
+    {
+        "set_write_coalescing",
+        "Enable or disable write coalescing for put_and_forget.",
+        "set_write_coalescing <max batch objects|off> [max batch bytes] [linger in us]",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,2);
+            if (cmd_tokens[1] == "off") {
+                capi.disable_write_coalescing();
+                return true;
+            }
+            std::size_t max_batch_objects = std::stoul(cmd_tokens[1]);
+            std::size_t max_batch_bytes = 1024*1024;
+            uint64_t linger_us = 20;
+            if (cmd_tokens.size() >= 3) {
+                max_batch_bytes = std::stoul(cmd_tokens[2]);
+            }
+            if (cmd_tokens.size() >= 4) {
+                linger_us = std::stoul(cmd_tokens[3]);
+            }
+            if (max_batch_objects == 0 || max_batch_bytes == 0) {
+                print_red("The batch thresholds must be positive.");
+                return false;
+            }
+            capi.enable_write_coalescing(max_batch_objects,max_batch_bytes,linger_us);
+            return true;
+        }
+    },
+    {
+        "flush",
+        "Send the objects buffered by write coalescing.",
+        "flush",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            capi.flush();
+            return true;
+        }
+    },
+    {
+        "set_read_cache",
+        "Enable or disable the client read cache for get.",
+        "set_read_cache <capacity in bytes|off> [max staleness in us]\n"
+            "max staleness := how long a cached current version is served, default: 1000000",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,2);
+            if (cmd_tokens[1] == "off") {
+                capi.disable_read_cache();
+                return true;
+            }
+            std::size_t capacity_bytes = std::stoul(cmd_tokens[1]);
+            uint64_t max_staleness_us = 1000000;
+            if (cmd_tokens.size() >= 3) {
+                max_staleness_us = std::stoul(cmd_tokens[2]);
+            }
+            try {
+                capi.enable_read_cache(capacity_bytes,max_staleness_us);
+            } catch (derecho::derecho_exception& ex) {
+                print_red(ex.what());
+                return false;
+            }
+            return true;
+        }
+    },
+    {
+        "get_read_cache_stats",
+        "Get the client read cache counters.",
+        "get_read_cache_stats",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            auto stats = capi.get_read_cache_stats();
+            std::cout << "hits:" << stats.hits
+                      << ", misses:" << stats.misses
+                      << ", fills:" << stats.fills
+                      << ", evictions:" << stats.evictions
+                      << ", invalidations:" << stats.invalidations
+                      << ", entries:" << stats.entries
+                      << ", bytes:" << stats.bytes << std::endl;
+            return true;
+        }
+    },
     {
         "Object Pool Manipulation Commands","","",command_handler_t()
     },
@@ -1118,18 +1357,42 @@ std::vector<command_entry_t> commands =
     {
         "create_object_pool",
         "Create an object pool",
-        "create_object_pool <path> <type> <subgroup_index> [affinity_set_regex]\n"
+        "create_object_pool <path> <type> <subgroup_index> [affinity_set_regex] [sharding_policy]\n"
         "type := " SUBGROUP_TYPE_LIST "\n"
+        "sharding_policy := HASH|JUMP_HASH, defaulted to HASH. JUMP_HASH moves the fewest objects when the number of shards changes.\n"
         "Note: put.[version,timestamp_us] will be set.",
         [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
             CHECK_FORMAT(cmd_tokens,4);
             std::string opath = cmd_tokens[1];
             uint32_t subgroup_index = static_cast<uint32_t>(std::stoi(cmd_tokens[3],nullptr,0));
             std::string affinity_set_regex;
-            if (cmd_tokens.size() >= 5) {
-                affinity_set_regex = cmd_tokens[4];
+            sharding_policy_t sharding_policy = sharding_policy_type::HASH;
+            for (size_t pos = 4; pos < cmd_tokens.size(); pos++) {
+                if (cmd_tokens[pos] == "HASH") {
+                    sharding_policy = sharding_policy_type::HASH;
+                } else if (cmd_tokens[pos] == "JUMP_HASH") {
+                    sharding_policy = sharding_policy_type::JUMP_HASH;
+                } else {
+                    affinity_set_regex = cmd_tokens[pos];
+                }
             }
-            on_subgroup_type(cmd_tokens[2],create_object_pool,capi,opath,subgroup_index,affinity_set_regex);
+            on_subgroup_type(cmd_tokens[2],create_object_pool,capi,opath,subgroup_index,affinity_set_regex,sharding_policy);
+            return true;
+        }
+    },
+    {
+        "create_range_object_pool",
+        "Create an object pool with the RANGE sharding policy",
+        "create_range_object_pool <path> <type> <subgroup_index> [split_point1 split_point2 ...]\n"
+        "type := " SUBGROUP_TYPE_LIST "\n"
+        "split points := strictly increasing keys, where shard i owns the keys in [split_point_i, split_point_i+1)\n"
+        "Note: put.[version,timestamp_us] will be set.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,4);
+            std::string opath = cmd_tokens[1];
+            uint32_t subgroup_index = static_cast<uint32_t>(std::stoi(cmd_tokens[3],nullptr,0));
+            std::vector<std::string> range_split_points(cmd_tokens.begin()+4,cmd_tokens.end());
+            on_subgroup_type(cmd_tokens[2],create_range_object_pool,capi,opath,subgroup_index,range_split_points);
             return true;
         }
     },
@@ -1199,6 +1462,25 @@ std::vector<command_entry_t> commands =
             return true;
         }
     },
+    {
+        "put_batch",
+        "Put a batch of objects to a shard atomically, under one version.",
+        "put_batch <type> <subgroup_index> <shard_index> <key1> <value1> [<key2> <value2> ...]\n"
+            "type := " SUBGROUP_TYPE_LIST "\n"
+            "Note: put.[version,timestamp_us] will be set.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,6);
+            if (cmd_tokens.size() % 2 != 0) {
+                print_red("Every key must come with a value.");
+                return false;
+            }
+            uint32_t subgroup_index = static_cast<uint32_t>(std::stoi(cmd_tokens[2],nullptr,0));
+            uint32_t shard_index = static_cast<uint32_t>(std::stoi(cmd_tokens[3],nullptr,0));
+            std::vector<std::string> kv_tokens(cmd_tokens.begin() + 4, cmd_tokens.end());
+            on_subgroup_type(cmd_tokens[1],put_batch,capi,kv_tokens,subgroup_index,shard_index);
+            return true;
+        }
+    },
     {
         "op_put",
         "Put an object into an object pool",
@@ -1217,6 +1499,23 @@ std::vector<command_entry_t> commands =
             return true;
         }
     },
+    {
+        "op_put_batch",
+        "Put a batch of objects into object pools. The objects in the same shard are put atomically, under one version.",
+        "op_put_batch <key1> <value1> [<key2> <value2> ...]\n"
+        "Please note that cascade automatically decides the object pool path using the key's prefix.\n"
+        "Note: put.[version,timestamp_us] will be set.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,3);
+            if (cmd_tokens.size() % 2 != 1) {
+                print_red("Every key must come with a value.");
+                return false;
+            }
+            std::vector<std::string> kv_tokens(cmd_tokens.begin() + 1, cmd_tokens.end());
+            op_put_batch(capi,kv_tokens);
+            return true;
+        }
+    },
     {
         "op_put_file",
         "Put an object into an object pool, where object's value is from a file,",
@@ -1376,6 +1675,25 @@ std::vector<command_entry_t> commands =
             return true;
         }
     },
+    {
+        "op_multi_key_get",
+        "Get objects of multiple keys from the object pools, with one request per shard.",
+        "op_multi_key_get <stable> <version> <key1> [key2 ...]\n"
+        "stable := 0|1  using stable data or not.\n"
+        "version := the version to get, -1 for the current version.\n"
+        "Please note that cascade automatically decides the object pool path using the keys' prefix.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,4);
+            bool stable = static_cast<bool>(std::stoi(cmd_tokens[1],nullptr,0));
+            persistent::version_t version = static_cast<persistent::version_t>(std::stol(cmd_tokens[2],nullptr,0));
+            std::vector<std::string> keys(cmd_tokens.begin()+3,cmd_tokens.end());
+            auto objects = capi.multi_key_get(keys,version,stable);
+            for (const auto& object : objects) {
+                std::cout << "get returns:" << object << std::endl;
+            }
+            return true;
+        }
+    },
     {
         "op_get_file",
         "Get an object from an object pool (by version.) and save it to file.",
@@ -2098,6 +2416,47 @@ std::vector<command_entry_t> commands =
             return true;
         }
     },
+    {
+        "perftest_put_threads",
+        "Performance Test for put throughput from a growing number of client threads.",
+        "perftest_put_threads <type> <message_size> <max_threads> <duration_sec> <subgroup index> <shard_index>\n"
+            "type := " SUBGROUP_TYPE_LIST "\n"
+            "'max_threads' is the largest number of threads, starting from 1 and doubling each round\n"
+            "'duration_sec' is the span of each round",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,7);
+            uint32_t message_size = std::stoul(cmd_tokens[2],nullptr,0);
+            uint32_t max_threads = std::stoul(cmd_tokens[3],nullptr,0);
+            uint64_t duration_sec = std::stoul(cmd_tokens[4],nullptr,0);
+            uint32_t subgroup_index = std::stoul(cmd_tokens[5],nullptr,0);
+            uint32_t shard_index = std::stoul(cmd_tokens[6],nullptr,0);
+
+            bool ret = false;
+            on_subgroup_type(cmd_tokens[1], ret = perftest_put_threads, capi, message_size, max_threads, duration_sec, subgroup_index, shard_index);
+            return ret;
+        }
+    },
+    {
+        "perftest_create_object_pool",
+        "Performance Test for the latency of the first puts to a newly created object pool.",
+        "perftest_create_object_pool <type> <num_pools> <num_threads> <subgroup index>\n"
+            "type := " SUBGROUP_TYPE_LIST "\n"
+            "'num_threads' is the number of threads putting to each new object pool at the same time",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,5);
+            uint32_t num_pools = std::stoul(cmd_tokens[2],nullptr,0);
+            uint32_t num_threads = std::stoul(cmd_tokens[3],nullptr,0);
+            uint32_t subgroup_index = std::stoul(cmd_tokens[4],nullptr,0);
+            if (num_pools == 0 || num_threads == 0) {
+                print_red("num_pools and num_threads must be positive.");
+                return false;
+            }
+
+            bool ret = false;
+            on_subgroup_type(cmd_tokens[1], ret = perftest_create_object_pool, capi, num_pools, num_threads, subgroup_index);
+            return ret;
+        }
+    },
     {
         "dump_timestamp",
         "Dump timestamp for a given shard. Each node will write its timestamps to the given file.",
@@ -22,6 +22,8 @@ namespace Derecho.Cascade
         RoundRobin,     // use a member in round-robin order.
         KeyHashing,     // use the key's hashing 
         UserSpecified,  // user specify which member to contact.
+        LeastOutstandingRequests,   // use the member with the fewest RPCs in flight from this client.
+        PowerOfTwoChoices,          // sample two members and use the one with the lower EWMA reply latency.
         InvalidPolicy = -1
     };
 
@@ -380,6 +382,10 @@ namespace Derecho.Cascade
                     return "KeyHashing";
                 case ShardMemberSelectionPolicy.UserSpecified:
                     return "UserSpecified";
+                case ShardMemberSelectionPolicy.LeastOutstandingRequests:
+                    return "LeastOutstandingRequests";
+                case ShardMemberSelectionPolicy.PowerOfTwoChoices:
+                    return "PowerOfTwoChoices";
                 case ShardMemberSelectionPolicy.InvalidPolicy:
                     return "InvalidPolicy";
                 default:
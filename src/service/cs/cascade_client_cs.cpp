@@ -69,6 +69,8 @@ static const char* policy_names[] = {
         "RoundRobin",
         "KeyHashing",
         "UserSpecified",
+        "LeastOutstandingRequests",
+        "PowerOfTwoChoices",
         nullptr};
 
 /**
@@ -619,6 +621,12 @@ EXPORT PolicyMetadataInternal EXPORT_getMemberSelectionPolicy(ServiceClientAPI&
         case ShardMemberSelectionPolicy::UserSpecified:
             pol = "UserSpecified";
             break;
+        case ShardMemberSelectionPolicy::LeastOutstandingRequests:
+            pol = "LeastOutstandingRequests";
+            break;
+        case ShardMemberSelectionPolicy::PowerOfTwoChoices:
+            pol = "PowerOfTwoChoices";
+            break;
         case ShardMemberSelectionPolicy::InvalidPolicy:
             pol = "InvalidPolicy";
             break;
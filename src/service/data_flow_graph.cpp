@@ -76,6 +76,17 @@ DataFlowGraph::DataFlowGraph(const json& dfg_conf):
                 }
             }
 
+            // batching
+            dfgv.batching.emplace_back(DataFlowGraph::VertexBatching{});
+            if (it->contains(DFG_JSON_UDL_BATCH_LIST) && (*it)[DFG_JSON_UDL_BATCH_LIST].at(i).is_object()) {
+                const auto& batching_conf = (*it)[DFG_JSON_UDL_BATCH_LIST].at(i);
+                dfgv.batching[i].max_batch_size = batching_conf.value(DFG_JSON_MAX_BATCH_SIZE,1u);
+                dfgv.batching[i].max_wait_us = batching_conf.value(DFG_JSON_MAX_WAIT_US,0ul);
+                if (dfgv.batching[i].max_batch_size == 0) {
+                    dfgv.batching[i].max_batch_size = 1;
+                }
+            }
+
             // configurations
             if (it->contains(DFG_JSON_UDL_CONFIG_LIST)) {
                 dfgv.configurations.emplace_back((*it)[DFG_JSON_UDL_CONFIG_LIST].at(i));
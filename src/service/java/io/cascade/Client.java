@@ -159,6 +159,34 @@ public class Client implements AutoCloseable {
         return new QueryResults<Bundle>(res, 0);
     }
 
+    /**
+     * Put a batch of byte buffer keys and their corresponding values into a shard
+     * atomically. All key-value pairs are applied under one version, or none of
+     * them is applied if the batch is rejected.
+     * 
+     * @param type          The type of the subgroup.
+     * @param keys          The byte buffer keys of the key-value pairs, which must
+     *                      be distinct.
+     * @param bufs          Java direct byte buffers that hold the values, one for
+     *                      each key. Requires: {@code bufs} should have the same
+     *                      length as {@code keys}.
+     * @param subgroupIndex The index of the subgroup with type {@code type} to put
+     *                      the key-value pairs into.
+     * @param shardID       The index of the shard within the subgroup with type
+     *                      {@code type} and subgroup index {@code subgroupIndex} to
+     *                      put the key-value pairs into.
+     * @return A Future that stores a handle to a Bundle object that contains the
+     *         version and timestamp shared by the batch.
+     */
+    public QueryResults<Bundle> putBatch(ServiceType type, ByteBuffer[] keys, ByteBuffer[] bufs, long subgroupIndex,
+            long shardID) {
+        if (keys.length != bufs.length || keys.length == 0) {
+            throw new IllegalArgumentException("putBatch needs the same non-zero number of keys and values.");
+        }
+        long res = putBatchInternal(type, subgroupIndex, shardID, keys, bufs);
+        return new QueryResults<Bundle>(res, 0);
+    }
+
     /**
      * Get the value corresponding to the byte buffer key from cascade.
      * 
@@ -361,6 +389,23 @@ public class Client implements AutoCloseable {
     private native long putInternal(ServiceType type, long subgroupIndex, long shardIndex, ByteBuffer key,
             ByteBuffer val);
 
+    /**
+     * Internal interface for put batch operation.
+     * 
+     * @param type          The type of the subgroup.
+     * @param subgroupIndex The index of the subgroup with type {@code type} to put
+     *                      the key-value pairs into.
+     * @param shardIndex    The index of the shard within the subgroup with type
+     *                      {@code type} and subgroup index {@code subgroupIndex} to
+     *                      put the key-value pairs into.
+     * @param keys          The byte buffer keys of the key-value pairs.
+     * @param vals          The byte buffer values of the key-value pairs.
+     * @return A handle of the C++ future that stores the version and timestamp of
+     *         the operation.
+     */
+    private native long putBatchInternal(ServiceType type, long subgroupIndex, long shardIndex, ByteBuffer[] keys,
+            ByteBuffer[] vals);
+
     /**
      * Internal interface for get operation.
      * 
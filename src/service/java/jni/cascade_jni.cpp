@@ -392,6 +392,54 @@ JNIEXPORT jlong JNICALL Java_io_cascade_Client_putInternal(JNIEnv *env, jobject
     return -1;
 }
 
+/**
+ * Helper function to put a batch of objects into a shard atomically.
+ * @param f a lambda function that converts Java objects into C++ objects.
+ * @param env the Java environment to find JVM.
+ * @param capi the service client API for this client.
+ * @param subgroup_index the subgroup index to put the objects.
+ * @param shard_index the shard index to put the objects.
+ * @param keys the Java byte buffer keys to put.
+ * @param vals the Java byte buffer values to put.
+ * @return a handle of the future that stores the version and timestamp.
+ */
+template <typename T>
+jlong put_batch(std::function<std::unique_ptr<typename T::ObjectType>(JNIEnv *, jobject, jobject)> f, JNIEnv *env, derecho::cascade::ServiceClientAPI *capi, jlong subgroup_index, jlong shard_index, jobjectArray keys, jobjectArray vals)
+{
+    // translate Java objects to C++ objects.
+    jsize num_objects = env->GetArrayLength(keys);
+    std::vector<typename T::ObjectType> objs;
+    objs.reserve(num_objects);
+    for (jsize i = 0; i < num_objects; ++i){
+        jobject key = env->GetObjectArrayElement(keys, i);
+        jobject val = env->GetObjectArrayElement(vals, i);
+        objs.emplace_back(std::move(*f(env, key, val)));
+        env->DeleteLocalRef(key);
+        env->DeleteLocalRef(val);
+    }
+    // execute the put
+    derecho::rpc::QueryResults<derecho::cascade::version_tuple> res = capi->put_batch<T>(objs, subgroup_index, shard_index);
+    QueryResultHolder<derecho::cascade::version_tuple> *qrh = new QueryResultHolder<derecho::cascade::version_tuple>(res);
+    return reinterpret_cast<jlong>(qrh);
+}
+
+/*
+ * Class:     io_cascade_Client
+ * Method:    putBatchInternal
+ * Signature: (Lio/cascade/ServiceType;JJ[Ljava/nio/ByteBuffer;[Ljava/nio/ByteBuffer;)J
+ */
+JNIEXPORT jlong JNICALL Java_io_cascade_Client_putBatchInternal(JNIEnv *env, jobject obj, jobject j_service_type, jlong subgroup_index, jlong shard_index, jobjectArray keys, jobjectArray vals)
+{
+    derecho::cascade::ServiceClientAPI *capi = get_api(env, obj);
+    int service_type = get_int_value(env, j_service_type);
+
+    // executing the put
+    on_service_type(service_type, return put_batch, translate_str_obj, env, capi, subgroup_index, shard_index, keys, vals);
+
+    // if service_type does not match successfully, return -1
+    return -1;
+}
+
 /**
  * Helper function to get an object from a cascade store.
  * @param f a lambda function that converts Java keys into C++ keys.
@@ -735,6 +783,10 @@ JNIEXPORT jobject JNICALL Java_io_cascade_QueryResults_getReplyMap(JNIEnv *env,
 
     auto s_f = [env](derecho::cascade::ObjectWithStringKey obj) {
 
+        // A blob sharing the data of a stored or cached object does not own it; copy it for the buffer to take over.
+        if (obj.blob.memory_mode == derecho::cascade::object_memory_mode_t::SHARED) {
+            obj.blob = derecho::cascade::Blob(obj.blob.bytes, obj.blob.size);
+        }
         const char *data = reinterpret_cast<const char*>(obj.blob.bytes);
         std::size_t size = obj.blob.size;
 
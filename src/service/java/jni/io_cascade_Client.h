@@ -71,6 +71,14 @@ JNIEXPORT jlong JNICALL Java_io_cascade_Client_getNumberOfShards
 JNIEXPORT jlong JNICALL Java_io_cascade_Client_putInternal
   (JNIEnv *, jobject, jobject, jlong, jlong, jobject, jobject);
 
+/*
+ * Class:     io_cascade_Client
+ * Method:    putBatchInternal
+ * Signature: (Lio/cascade/ServiceType;JJ[Ljava/nio/ByteBuffer;[Ljava/nio/ByteBuffer;)J
+ */
+JNIEXPORT jlong JNICALL Java_io_cascade_Client_putBatchInternal
+  (JNIEnv *, jobject, jobject, jlong, jlong, jobjectArray, jobjectArray);
+
 /*
  * Class:     io_cascade_Client
  * Method:    getInternal
@@ -2,9 +2,13 @@
 #include "perftest.hpp"
 #include <derecho/conf/conf.hpp>
 #include <derecho/core/detail/rpc_utils.hpp>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include <type_traits>
 #include <optional>
 #include <queue>
+#include <tuple>
 #include <derecho/utils/time.h>
 #include <unistd.h>
 #include <fstream>
@@ -429,8 +433,8 @@ bool PerfTestServer::eval_get_by_time(uint64_t ms_in_past,
     uint32_t window_slots = window_size * 2;
     std::mutex window_slots_mutex;
     std::condition_variable window_slots_cv;
-    // Result future queue, which pairs message IDs with a future for that message
-    std::queue<std::pair<uint64_t, derecho::QueryResults<const ObjectType>>> futures;
+    // Result future queue, which holds message IDs, send times, and a future for that message
+    std::queue<std::tuple<uint64_t, uint64_t, derecho::QueryResults<const ObjectType>>> futures;
     std::mutex futures_mutex;
     std::condition_variable futures_cv;
     std::condition_variable window_cv;
@@ -438,6 +442,10 @@ bool PerfTestServer::eval_get_by_time(uint64_t ms_in_past,
     std::atomic<bool> all_sent(false);
     // Node ID, used for logger calls
     const node_id_t my_node_id = this->capi.get_my_id();
+    // Latency summary, touched by the future consuming thread only
+    uint64_t num_completed_gets = 0;
+    uint64_t total_latency_ns = 0;
+    uint64_t max_latency_ns = 0;
     // Future consuming thread
     std::thread query_thread(
             [&]() {
@@ -454,12 +462,16 @@ bool PerfTestServer::eval_get_by_time(uint64_t ms_in_past,
                     //|             QUEUE UNLOCKED            |
                     // wait for each future in pending_futures, leaving futures unlocked
                     while(pending_futures.size() > 0) {
-                        auto& replies = pending_futures.front().second.get();
-                        uint64_t message_id = pending_futures.front().first;
+                        auto& replies = std::get<2>(pending_futures.front()).get();
+                        uint64_t message_id = std::get<0>(pending_futures.front());
                         // Get only the first reply
                         for(auto& reply : replies) {
                             reply.second.get();
                             TimestampLogger::log(TLT_EC_GET_FINISHED, my_node_id, message_id);
+                            uint64_t latency_ns = get_walltime() - std::get<1>(pending_futures.front());
+                            num_completed_gets++;
+                            total_latency_ns += latency_ns;
+                            max_latency_ns = std::max(max_latency_ns, latency_ns);
                             break;
                         }
                         pending_futures.pop();
@@ -588,11 +600,12 @@ bool PerfTestServer::eval_get_by_time(uint64_t ms_in_past,
         }
         next_ns += interval_ns;
         // Since each loop iteration creates its own future_appender, capture the message_id by copy
+        const uint64_t send_ns = get_walltime();
         std::function<void(QueryResults<const ObjectType>&&)> future_appender =
-                [&futures, &futures_mutex, &futures_cv, message_id](
+                [&futures, &futures_mutex, &futures_cv, message_id, send_ns](
                         QueryResults<const ObjectType>&& query_results) {
                     std::unique_lock<std::mutex> lock{futures_mutex};
-                    futures.emplace(message_id, std::move(query_results));
+                    futures.emplace(message_id, send_ns, std::move(query_results));
                     lock.unlock();
                     futures_cv.notify_one();
                 };
@@ -609,9 +622,13 @@ bool PerfTestServer::eval_get_by_time(uint64_t ms_in_past,
         TimestampLogger::log(TLT_EC_SENT, my_node_id, message_id);
         message_id++;
     }
-    dbg_default_info("eval_get: All messages sent, waiting for queries to complete");
+    dbg_default_info("eval_get_by_time: All messages sent, waiting for queries to complete");
     // wait for all pending futures.
     query_thread.join();
+    if(num_completed_gets > 0) {
+        dbg_default_info("eval_get_by_time: {} gets completed, average latency {} us, maximum latency {} us",
+                         num_completed_gets, total_latency_ns / num_completed_gets / INT64_1E3, max_latency_ns / INT64_1E3);
+    }
     return true;
 }
 
@@ -1192,6 +1209,43 @@ void PerfTestClient::remove_server(const std::string& host, uint16_t port) {
 
 PerfTestClient::~PerfTestClient() {}
 
+void PerfTestClient::run_closed_loop_threads(uint32_t max_threads,
+                                             uint64_t duration_sec,
+                                             const std::function<std::function<void(uint64_t)>(uint32_t)>& make_thread_op) {
+    std::cout << "threads\tops\tops/sec\tops/sec/thread" << std::endl;
+    for (uint32_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        std::atomic<bool> stopped{false};
+        // A thread counts its operations in a local variable and stores the count once it stops, so that the threads
+        // do not write to a shared cache line in the loop.
+        std::vector<uint64_t> ops(num_threads,0);
+        std::vector<std::thread> threads;
+        uint64_t start_ns = get_walltime();
+        for (uint32_t t = 0; t < num_threads; t++) {
+            threads.emplace_back([&,t]() {
+                auto op = make_thread_op(t);
+                uint64_t num_ops = 0;
+                while (!stopped.load(std::memory_order_relaxed)) {
+                    op(num_ops);
+                    num_ops++;
+                }
+                ops[t] = num_ops;
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(duration_sec));
+        stopped.store(true);
+        for (auto& th: threads) {
+            th.join();
+        }
+        double elapsed_sec = static_cast<double>(get_walltime() - start_ns)/1e9;
+        uint64_t total_ops = 0;
+        for (const auto& n: ops) {
+            total_ops += n;
+        }
+        std::cout << num_threads << "\t" << total_ops << "\t" << total_ops/elapsed_sec << "\t"
+                  << total_ops/elapsed_sec/num_threads << std::endl;
+    }
+}
+
 bool PerfTestClient::check_rpc_futures(std::map<std::pair<std::string,uint16_t>,std::future<RPCLIB_MSGPACK::object_handle>>&& futures) {
     bool ret = true;
     for(auto& kv:futures) {
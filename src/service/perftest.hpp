@@ -1,5 +1,6 @@
 #pragma once
 #include <cascade/service_client_api.hpp>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <rpc/server.h>
@@ -188,6 +189,19 @@ private:
     bool check_rpc_futures(std::map<std::pair<std::string,uint16_t>,std::future<RPCLIB_MSGPACK::object_handle>>&& futures);
     /** download a file from the perftest server */
     bool download_file(const std::string& filename);
+    /**
+     * Run a closed-loop workload in a growing number of local threads, doubling from 1 to max_threads, for
+     * duration_sec seconds in each round, and print the throughput of each round.
+     *
+     * @param max_threads
+     * @param duration_sec
+     * @param make_thread_op
+     *        Called in each thread with the thread index, returns the operation the thread runs in a loop, which is
+     *        called with the number of operations the thread has done.
+     */
+    void run_closed_loop_threads(uint32_t max_threads,
+                                 uint64_t duration_sec,
+                                 const std::function<std::function<void(uint64_t)>(uint32_t)>& make_thread_op);
 
 public:
     /**
@@ -377,6 +391,25 @@ public:
     /**
      * Destructor
      */
+    /**
+     * Put throughput of this client shared by a growing number of application threads. Each thread puts to its own
+     * keys in a closed loop and waits for the reply of every put. The number of threads doubles from 1 to max_threads,
+     * and each round runs for duration_sec seconds.
+     *
+     * @param message_size      The size of the object data.
+     * @param max_threads       The largest number of threads.
+     * @param duration_sec      The span of each round in seconds.
+     * @param subgroup_index    The subgroup index.
+     * @param shard_index       The shard index.
+     * @return true for a successful run, false for a failed run.
+     */
+    template <typename SubgroupType>
+    bool perf_put_threads(uint32_t message_size,
+                          uint32_t max_threads,
+                          uint64_t duration_sec,
+                          uint32_t subgroup_index,
+                          uint32_t shard_index);
+
     virtual ~PerfTestClient();
 };
 
@@ -779,6 +812,34 @@ bool PerfTestClient::perf_get_by_time(uint32_t subgroup_index,
     debug_leave_func();
     return ret;
 }
+
+template <typename SubgroupType>
+bool PerfTestClient::perf_put_threads(uint32_t message_size,
+                                      uint32_t max_threads,
+                                      uint64_t duration_sec,
+                                      uint32_t subgroup_index,
+                                      uint32_t shard_index) {
+    debug_enter_func_with_args("message_size={},max_threads={},duration_sec={},subgroup_index={},shard_index={}.",
+                               message_size,max_threads,duration_sec,subgroup_index,shard_index);
+    const std::string value(message_size,'v');
+    run_closed_loop_threads(max_threads,duration_sec,[&](uint32_t t) -> std::function<void(uint64_t)> {
+        auto obj = std::make_shared<typename SubgroupType::ObjectType>();
+        obj->blob = Blob(reinterpret_cast<const uint8_t*>(value.c_str()),value.length());
+        return [this,obj,t,subgroup_index,shard_index](uint64_t op) {
+            if constexpr (std::is_same<typename SubgroupType::KeyType,uint64_t>::value) {
+                obj->key = (static_cast<uint64_t>(t) << 32) + (op % 1000);
+            } else {
+                obj->key = "thread_" + std::to_string(t) + "_key_" + std::to_string(op % 1000);
+            }
+            auto result = capi.template put<SubgroupType>(*obj, subgroup_index, shard_index);
+            for (auto& reply_future: result.get()) {
+                reply_future.second.get();
+            }
+        };
+    });
+    debug_leave_func();
+    return true;
+}
 }
 }
 
@@ -122,6 +122,8 @@ class CascadeClientShell(cmd.Cmd):
                         RoundRobin
                         KeyHashing
                         UserSpecified
+                        LeastOutstandingRequests
+                        PowerOfTwoChoices
         node_id:        if policy is 'UserSpecified', you need to specify the corresponding node id.
         '''
         self.check_capi()
@@ -592,6 +594,60 @@ class CascadeClientShell(cmd.Cmd):
                 print(bcolors.FAIL + "Something went wrong, get returns null." + bcolors.RESET)
         pass
 
+    def do_scan_shard(self, arg):
+        '''
+        scan_shard <subgroup_type> [subgroup_index= shard_index= prefix= max_items= max_bytes= stable= version=]
+        ==========
+        List the objects in a shard, one page at a time
+        subgroup_type:      
+                                    VolatileCascadeStoreWithStringKey
+                                    PersistentCascadeStoreWithStringKey
+                                    TriggerCascadeNoStoreWithStringKey
+
+        *** optional key arguments ***
+        subgroup_index:             the subgroup index, default to 0
+        shard_index:                the shard index, default to 0
+        prefix:                     only list the objects in this object pool pathname, default to all
+        max_items:                  the maximum number of objects in a page, default to 256
+        max_bytes:                  the maximum size of the objects in a page, default to 1MB
+        stable:                     If this is a stable read or not, default to stable.
+        version:                    the version. For versioned scan only
+        '''
+        self.check_capi()
+        args = arg.split()
+        if len(args) < 1:
+            print(bcolors.FAIL + 'At least one argument is required.' + bcolors.RESET)
+        else:
+            options = {}
+            argpos = 1
+            while argpos < len(args):
+                extra_option = args[argpos].split('=')
+                if len(extra_option) != 2:
+                    print(bcolors.FAIL + "Unknown argument:" + args[argpos] + bcolors.RESET)
+                    return
+                elif extra_option[0] == 'prefix':
+                    options['prefix'] = extra_option[1]
+                elif extra_option[0] == 'stable':
+                    options['stable'] = extra_option[1].lower() not in ('false','no','off','0')
+                elif extra_option[0] in ('subgroup_index','shard_index','max_items','max_bytes','version'):
+                    options[extra_option[0]] = int(extra_option[1],0)
+                argpos = argpos + 1
+            cursor = ''
+            while True:
+                res = self.capi.scan_shard(args[0],cursor=cursor,**options)
+                if not res:
+                    print(bcolors.FAIL + "Something went wrong, scan returns null." + bcolors.RESET)
+                    return
+                page = res.get_result()
+                for obj in page['objects']:
+                    print(bcolors.OK + f"{str(obj)}" + bcolors.RESET)
+                cursor = page['cursor']
+                if cursor == '':
+                    break
+                # read the following pages at the version of this page.
+                options['version'] = page['version']
+        pass
+
     def do_list_keys_in_object_pool(self, arg):
         '''
         list_keys_in_object_pool <object_pool_pathname> [stable= version= timestamp=]
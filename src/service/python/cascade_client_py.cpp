@@ -50,6 +50,8 @@ static const char* policy_names[] = {
         "RoundRobin",
         "KeyHashing",
         "UserSpecified",
+        "LeastOutstandingRequests",
+        "PowerOfTwoChoices",
         nullptr};
 
 /**
@@ -79,6 +81,29 @@ std::function<py::dict(const ObjectWithStringKey&)> object_unwrapper = [](const
     return object_dict;
 };
 
+/**
+ * Lambda function for handling the unwrapping of a vector of ObjectWithStringKey
+ */
+std::function<py::list(std::vector<ObjectWithStringKey>&)> objects_unwrapper = [](std::vector<ObjectWithStringKey>& objs)->py::list {
+    py::list object_list;
+    for(const auto& obj:objs) {
+        object_list.append(object_unwrapper(obj));
+    }
+    return object_list;
+};
+
+/**
+ * Lambda function for handling the unwrapping of a scan page
+ */
+std::function<py::dict(scan_page_tuple<std::string, ObjectWithStringKey>&)> scan_page_unwrapper =
+        [](scan_page_tuple<std::string, ObjectWithStringKey>& page)->py::dict {
+    py::dict page_dict;
+    page_dict["objects"] = objects_unwrapper(std::get<0>(page));
+    page_dict["cursor"] = std::get<1>(page);
+    page_dict["version"] = std::get<2>(page);
+    return page_dict;
+};
+
 /**
  * Lambda function for handling the unwrapping of vector
  */
@@ -172,6 +197,24 @@ auto put(ServiceClientAPI& capi, const typename SubgroupType::ObjectType& obj, u
     return py::cast(s);
 }
 
+/**
+    Put a batch of objects into a shard atomically.
+
+    @param capi             the service client API for this client.
+    @param objs             the objects, which must belong to the shard.
+    @param subgroup_index
+    @param shard_index
+    @param as_trigger
+    @return QueryResultsStore that handles the tuple of version and ts_us shared by the batch.
+*/
+template <typename SubgroupType>
+auto put_batch(ServiceClientAPI& capi, const std::vector<typename SubgroupType::ObjectType>& objs, uint32_t subgroup_index, uint32_t shard_index, bool as_trigger) {
+    derecho::rpc::QueryResults<derecho::cascade::version_tuple> result = capi.template put_batch<SubgroupType>(objs, subgroup_index, shard_index, as_trigger);
+
+    QueryResultsStore<derecho::cascade::version_tuple, std::vector<long>>* s = new QueryResultsStore<derecho::cascade::version_tuple, std::vector<long>>(std::move(result), bundle_f);
+    return py::cast(s);
+}
+
 /**
     Put objects into cascade store and return immediately
     Please note that if subgroup_index is not specified, we will use the object_pool API.
@@ -262,6 +305,23 @@ auto get(ServiceClientAPI& capi, const std::string& key, persistent::version_t v
     return py::cast(s);
 }
 
+/**
+    Get the objects of multiple keys in a shard with one request.
+    @param capi the service client API for this client.
+    @param keys the keys, which must belong to the shard.
+    @param ver version of the objects you want to get.
+    @param stable using stable get or not.
+    @param subgroup_index
+    @param shard_index
+    @return QueryResultsStore that handles the list of objects in the order of the keys.
+*/
+template <typename SubgroupType>
+auto multi_key_get(ServiceClientAPI& capi, const std::vector<std::string>& keys, persistent::version_t ver, bool stable, uint32_t subgroup_index = 0, uint32_t shard_index = 0) {
+    auto result = capi.template multi_key_get<SubgroupType>(keys, ver, stable, subgroup_index, shard_index);
+    auto s = new QueryResultsStore<std::vector<typename SubgroupType::ObjectType>, py::list>(std::move(result), objects_unwrapper);
+    return py::cast(s);
+}
+
 /**
     Get objects from cascade store using multi_get.
     @param capi the service client API for this client.
@@ -347,6 +407,27 @@ auto list_keys_by_time(ServiceClientAPI& capi, uint64_t ts_us, bool stable, uint
     return py::cast(s);
 }
 
+/**
+    Scan a page of the objects in a shard.
+    @param capi the service client API for this client.
+    @param prefix only the objects in this object pool pathname are returned.
+    @param cursor the cursor returned with the previous page, or an empty string to start.
+    @param max_items the maximum number of objects in the page, 0 for no limit.
+    @param max_bytes the maximum size of the objects in the page, 0 for no limit.
+    @param version version of the objects you want to scan.
+    @param stable using stable scan or not.
+    @param subgroup_index
+    @param shard_index
+    @return QueryResultsStore that handles the page.
+*/
+template <typename SubgroupType>
+auto scan(ServiceClientAPI& capi, const std::string& prefix, const std::string& cursor, uint32_t max_items, uint64_t max_bytes,
+          persistent::version_t version, bool stable, uint32_t subgroup_index = 0, uint32_t shard_index = 0) {
+    auto result = capi.template scan<SubgroupType>(prefix, cursor, max_items, max_bytes, version, stable, subgroup_index, shard_index);
+    auto s = new QueryResultsStore<scan_page_tuple<typename SubgroupType::KeyType, typename SubgroupType::ObjectType>, py::dict>(std::move(result), scan_page_unwrapper);
+    return py::cast(s);
+}
+
 template <typename SubgroupType>
 auto multi_list_keys(ServiceClientAPI& capi, uint32_t subgroup_index = 0, uint32_t shard_index = 0) {
     derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>> result = capi.template multi_list_keys<SubgroupType>(subgroup_index, shard_index);
@@ -361,12 +442,15 @@ auto multi_list_keys(ServiceClientAPI& capi, uint32_t subgroup_index = 0, uint32
  * @param   object_pool_pathname
  * @param   subgroup_index
  * @param   affinity_set_regex, default to empty string
+ * @param   sharding_policy, default to HASH
+ * @param   range_split_points, the split points for the RANGE sharding policy, default to empty
  * @return  QueryResultsStore that handles the return type
 */
 template <typename SubgroupType>
-auto create_object_pool(ServiceClientAPI& capi, const std::string& object_pool_pathname, uint32_t subgroup_index, const std::string& affinity_set_regex="") {
+auto create_object_pool(ServiceClientAPI& capi, const std::string& object_pool_pathname, uint32_t subgroup_index, const std::string& affinity_set_regex="",
+                        sharding_policy_t sharding_policy = sharding_policy_t::HASH, const std::vector<std::string>& range_split_points = {}) {
     derecho::rpc::QueryResults<derecho::cascade::version_tuple> result =
-        capi.template create_object_pool<SubgroupType>(object_pool_pathname, subgroup_index, sharding_policy_t::HASH, {}, affinity_set_regex);
+        capi.template create_object_pool<SubgroupType>(object_pool_pathname, subgroup_index, sharding_policy, {}, affinity_set_regex, range_split_points);
     QueryResultsStore<derecho::cascade::version_tuple, std::vector<long>>* s = new QueryResultsStore<derecho::cascade::version_tuple, std::vector<long>>(std::move(result), bundle_f);
     return py::cast(s);
 }
@@ -408,6 +492,11 @@ auto get_object_pool(ServiceClientAPI& capi, const std::string& object_pool_path
     opm["object_locations"] = object_locations;
     opm["affinity_set_regex"] = py::str(copm.affinity_set_regex);
     opm["deleted"] = py::bool_(copm.deleted);
+    py::list range_split_points;
+    for(const auto& split_point : copm.range_split_points) {
+        range_split_points.append(py::str(split_point));
+    }
+    opm["range_split_points"] = range_split_points;
     return opm;
 }
 
@@ -555,7 +644,9 @@ PYBIND11_MODULE(member_client, m) {
                     "\t                         FixedRandom | \n",
                     "\t                         RoundRobin | \n",
                     "\t                         KeyHashing | \n",
-                    "\t                         UserSpecified \n",
+                    "\t                         UserSpecified | \n",
+                    "\t                         LeastOutstandingRequests | \n",
+                    "\t                         PowerOfTwoChoices \n",
                     "\t@arg4    usernode        The node id for 'UserSpecified' policy"
                 )
             .def(
@@ -587,6 +678,12 @@ PYBIND11_MODULE(member_client, m) {
                             case ShardMemberSelectionPolicy::UserSpecified:
                                 pol = "UserSpecified";
                                 break;
+                            case ShardMemberSelectionPolicy::LeastOutstandingRequests:
+                                pol = "LeastOutstandingRequests";
+                                break;
+                            case ShardMemberSelectionPolicy::PowerOfTwoChoices:
+                                pol = "PowerOfTwoChoices";
+                                break;
                             case ShardMemberSelectionPolicy::InvalidPolicy:
                                 pol = "InvalidPolicy";
                                 break;
@@ -694,6 +791,76 @@ PYBIND11_MODULE(member_client, m) {
 #endif
                     "\t@return  a future of the (version,timestamp) for blocking put; or 'False' object for non-blocking put."
             )
+            .def(
+                    "put_batch",
+                    [](ServiceClientAPI_PythonWrapper& capi, py::list objects, py::kwargs kwargs) {
+                        std::string subgroup_type;
+                        uint32_t subgroup_index = 0;
+                        uint32_t shard_index = 0;
+                        bool as_trigger = false;
+                        if (kwargs.contains("subgroup_index")) {
+                            subgroup_index = kwargs["subgroup_index"].cast<uint32_t>();
+                        }
+                        if (kwargs.contains("shard_index")) {
+                            shard_index = kwargs["shard_index"].cast<uint32_t>();
+                        }
+                        if (kwargs.contains("subgroup_type")) {
+                            subgroup_type = kwargs["subgroup_type"].cast<std::string>();
+                        }
+                        if (kwargs.contains("as_trigger")) {
+                            as_trigger = kwargs["as_trigger"].cast<bool>();
+                        }
+
+                        std::vector<ObjectWithStringKey> objs;
+                        for (auto item : objects) {
+                            py::dict object_dict = item.cast<py::dict>();
+                            persistent::version_t previous_version = CURRENT_VERSION;
+                            persistent::version_t previous_version_by_key = CURRENT_VERSION;
+                            if (object_dict.contains("previous_version")) {
+                                previous_version = object_dict["previous_version"].cast<persistent::version_t>();
+                            }
+                            if (object_dict.contains("previous_version_by_key")) {
+                                previous_version_by_key = object_dict["previous_version_by_key"].cast<persistent::version_t>();
+                            }
+                            ObjectWithStringKey obj;
+                            obj.key = object_dict["key"].cast<std::string>();
+                            obj.set_previous_version(previous_version,previous_version_by_key);
+                            std::string value = object_dict["value"].cast<std::string>();
+                            obj.blob = Blob(reinterpret_cast<const uint8_t*>(value.c_str()),value.size());
+                            objs.emplace_back(std::move(obj));
+                        }
+                        if (objs.empty()) {
+                            print_red("put_batch needs at least one object.");
+                            return py::cast(NULL);
+                        }
+
+                        if (subgroup_type.empty()) {
+                            py::list results;
+                            for (auto& result : capi.ref.put_batch(objs,as_trigger)) {
+                                results.append(py::cast(new QueryResultsStore<derecho::cascade::version_tuple, std::vector<long>>(std::move(*result), bundle_f)));
+                            }
+                            return py::object(std::move(results));
+                        } else {
+                            on_all_subgroup_type(subgroup_type, return put_batch, capi.ref, objs, subgroup_index, shard_index, as_trigger);
+                        }
+
+                        return py::cast(NULL);
+                    },
+                    "Put a batch of objects atomically. \n"
+                    "The objects in the same shard are applied under one version, or rejected together if any of them \n"
+                    "fails the previous version verification.\n"
+                    "\t@arg0    objects         a list of dicts with 'key', 'value', and optionally 'previous_version' and \n"
+                    "\t                         'previous_version_by_key'.\n"
+                    "\t** Optional keyword argument: ** \n"
+                    "\t@argX    subgroup_type   VolatileCascadeStoreWithStringKey | \n"
+                    "\t                         PersistentCascadeStoreWithStringKey | \n"
+                    "\t                         TriggerCascadeNoStoreWithStringKey \n"
+                    "\t@argX    subgroup_index  \n"
+                    "\t@argX    shard_index     \n"
+                    "\t@argX    as_trigger      If true, the values will ONLY trigger the UDL and NOT apply to the K/V. Defaulted to false\n"
+                    "\t@return  a future of the (version,timestamp) if subgroup_type is specified; otherwise, a list of futures,\n"
+                    "\t         one for each shard the objects go to."
+            )
             .def(
                     "remove",
                     [](ServiceClientAPI_PythonWrapper& capi, std::string& key, py::kwargs kwargs) {
@@ -794,6 +961,57 @@ PYBIND11_MODULE(member_client, m) {
                     "\t@argX    timestamp       Specify timestamp (as an integer in unix epoch microsecond) for a timestampped get.\n"
                     "\t@return  a dict version of the object."
             )
+            .def(
+                    "multi_key_get",
+                    [](ServiceClientAPI_PythonWrapper& capi, std::vector<std::string>& keys, py::kwargs kwargs) {
+                        std::string subgroup_type;
+                        uint32_t subgroup_index = 0;
+                        uint32_t shard_index = 0;
+                        persistent::version_t version = CURRENT_VERSION;
+                        bool stable = true;
+                        if (kwargs.contains("subgroup_type")) {
+                            subgroup_type = kwargs["subgroup_type"].cast<std::string>();
+                        }
+                        if (kwargs.contains("subgroup_index")) {
+                            subgroup_index = kwargs["subgroup_index"].cast<uint32_t>();
+                        }
+                        if (kwargs.contains("shard_index")) {
+                            shard_index = kwargs["shard_index"].cast<uint32_t>();
+                        }
+                        if (kwargs.contains("version")) {
+                            version = kwargs["version"].cast<persistent::version_t>();
+                        }
+                        if (kwargs.contains("stable")) {
+                            stable = kwargs["stable"].cast<bool>();
+                        }
+                        if (keys.empty()) {
+                            print_red("multi_key_get needs at least one key.");
+                            return py::cast(NULL);
+                        }
+
+                        if (subgroup_type.empty()) {
+                            auto objs = capi.ref.multi_key_get(keys,version,stable);
+                            return py::object(objects_unwrapper(objs));
+                        } else {
+                            on_all_subgroup_type(subgroup_type, return multi_key_get, capi.ref, keys, version, stable, subgroup_index, shard_index);
+                        }
+
+                        return py::cast(NULL);
+                    },
+                    "Get the objects of multiple keys. \n"
+                    "The keys are grouped by shard and each shard is queried with one request.\n"
+                    "\t@arg0    keys            a list of keys \n"
+                    "\t** Optional keyword argument: ** \n"
+                    "\t@argX    subgroup_type   VolatileCascadeStoreWithStringKey | \n"
+                    "\t                         PersistentCascadeStoreWithStringKey | \n"
+                    "\t                         TriggerCascadeNoStoreWithStringKey \n"
+                    "\t@argX    subgroup_index  \n"
+                    "\t@argX    shard_index     \n"
+                    "\t@argX    version         Specify version for a versioned get.\n"
+                    "\t@argX    stable          Specify if using stable get or not. Defaulted to true.\n"
+                    "\t@return  a list of dict version of the objects in the order of the keys if subgroup_type is not\n"
+                    "\t         specified; otherwise, a future of the list, and the keys must belong to the shard."
+            )
             .def(
                     "multi_get",
                     [](ServiceClientAPI_PythonWrapper& capi, std::string& key, py::kwargs kwargs) {
@@ -1000,6 +1218,62 @@ PYBIND11_MODULE(member_client, m) {
                     "\t@argX    shard_index     default to 0\n"
                     "\t@return  the list of keys."
             )
+            .def(
+                    "scan_shard",
+                    [](ServiceClientAPI_PythonWrapper& capi, std::string& subgroup_type, py::kwargs kwargs) {
+                        uint32_t subgroup_index = 0;
+                        uint32_t shard_index = 0;
+                        std::string prefix;
+                        std::string cursor;
+                        uint32_t max_items = 256;
+                        uint64_t max_bytes = 1ull << 20;
+                        persistent::version_t version = CURRENT_VERSION;
+                        bool stable = true;
+                        if (kwargs.contains("subgroup_index")) {
+                            subgroup_index = kwargs["subgroup_index"].cast<uint32_t>();
+                        }
+                        if (kwargs.contains("shard_index")) {
+                            shard_index = kwargs["shard_index"].cast<uint32_t>();
+                        }
+                        if (kwargs.contains("prefix")) {
+                            prefix = kwargs["prefix"].cast<std::string>();
+                        }
+                        if (kwargs.contains("cursor")) {
+                            cursor = kwargs["cursor"].cast<std::string>();
+                        }
+                        if (kwargs.contains("max_items")) {
+                            max_items = kwargs["max_items"].cast<uint32_t>();
+                        }
+                        if (kwargs.contains("max_bytes")) {
+                            max_bytes = kwargs["max_bytes"].cast<uint64_t>();
+                        }
+                        if (kwargs.contains("version")) {
+                            version = kwargs["version"].cast<persistent::version_t>();
+                        }
+                        if (kwargs.contains("stable")) {
+                            stable = kwargs["stable"].cast<bool>();
+                        }
+
+                        on_all_subgroup_type(subgroup_type, return scan, capi.ref, prefix, cursor, max_items, max_bytes, version, stable, subgroup_index, shard_index);
+                        return py::cast(NULL);
+                    },
+                    "Scan a page of the objects in a shard, in key order. \n"
+                    "Call it again with the returned cursor and version for the next page, until the returned cursor is empty.\n"
+                    "\t@arg0    subgroup_type   VolatileCascadeStoreWithStringKey | \n"
+                    "\t                         PersistentCascadeStoreWithStringKey | \n"
+                    "\t                         TriggerCascadeNoStoreWithStringKey \n"
+                    "\t** Optional keyword argument: ** \n"
+                    "\t@argX    subgroup_index  default to 0\n"
+                    "\t@argX    shard_index     default to 0\n"
+                    "\t@argX    prefix          Only scan the objects in this object pool pathname. Defaulted to all.\n"
+                    "\t@argX    cursor          The cursor returned with the previous page. Defaulted to start a new scan.\n"
+                    "\t@argX    max_items       The maximum number of objects in a page, 0 for no limit. Defaulted to 256.\n"
+                    "\t@argX    max_bytes       The maximum size of the objects in a page, 0 for no limit. Defaulted to 1MB.\n"
+                    "\t@argX    version         Specify version for a versioned scan.\n"
+                    "\t@argX    stable          Specify if using stable scan or not. Defaulted to true.\n"
+                    "\t@return  a dict with the list of objects in 'objects', the cursor of the next page in 'cursor', and the\n"
+                    "\t         version to read the next page at in 'version'."
+            )
             .def(
                     "list_keys_in_object_pool",
                     [](ServiceClientAPI_PythonWrapper& capi, std::string& object_pool_pathname, py::kwargs kwargs) {
@@ -1064,7 +1338,23 @@ PYBIND11_MODULE(member_client, m) {
                         if (kwargs.contains("affinity_set_regex")) {
                             affinity_set_regex = kwargs["affinity_set_regex"].cast<std::string>();
                         }
-                        on_all_subgroup_type(service_type, return create_object_pool, capi.ref, object_pool_pathname, subgroup_index, affinity_set_regex);
+                        sharding_policy_t sharding_policy = sharding_policy_t::HASH;
+                        if (kwargs.contains("sharding_policy")) {
+                            std::string policy = kwargs["sharding_policy"].cast<std::string>();
+                            if (policy == "RANGE") {
+                                sharding_policy = sharding_policy_t::RANGE;
+                            } else if (policy == "JUMP_HASH") {
+                                sharding_policy = sharding_policy_t::JUMP_HASH;
+                            } else if (policy != "HASH") {
+                                throw derecho::derecho_exception("Unknown sharding policy:" + policy);
+                            }
+                        }
+                        std::vector<std::string> range_split_points;
+                        if (kwargs.contains("range_split_points")) {
+                            range_split_points = kwargs["range_split_points"].cast<std::vector<std::string>>();
+                        }
+                        on_all_subgroup_type(service_type, return create_object_pool, capi.ref, object_pool_pathname, subgroup_index, affinity_set_regex,
+                                             sharding_policy, range_split_points);
                         return py::cast(NULL);
                     },
                     "Create an Object Pool. \n"
@@ -1076,6 +1366,11 @@ PYBIND11_MODULE(member_client, m) {
                     "\t@arg2    subgroup_index \n"
                     "\t** Optional keyword argument: ** \n"
                     "\t@argX    affinity_set_regex \n"
+                    "\t@argX    sharding_policy     'HASH', 'JUMP_HASH', or 'RANGE'. Defaulted to 'HASH'. \n"
+                    "\t         'JUMP_HASH' places the objects with jump consistent hashing over xxHash64, which moves \n"
+                    "\t         the fewest objects when the number of shards changes. \n"
+                    "\t@argX    range_split_points  The strictly increasing split points of the RANGE policy, \n"
+                    "\t         where shard i owns the keys in [range_split_points[i-1],range_split_points[i]). \n"
                     "\t@return  a future of the (version,timestamp)"
             )
             .def(
@@ -1133,6 +1428,18 @@ PYBIND11_MODULE(member_client, m) {
                         return qrs.get_result();
                     },
                     "Get result from QueryResultsStore for ObjectWithUInt64Key");
+    py::class_<QueryResultsStore<std::vector<ObjectWithStringKey>, py::list>>(m, "QueryResultsStoreObjectList")
+            .def(
+                    "get_result", [](QueryResultsStore<std::vector<ObjectWithStringKey>, py::list>& qrs) {
+                        return qrs.get_result();
+                    },
+                    "Get result from QueryResultsStore for a list of ObjectWithStringKey.");
+    py::class_<QueryResultsStore<scan_page_tuple<std::string, ObjectWithStringKey>, py::dict>>(m, "QueryResultsStoreScanPage")
+            .def(
+                    "get_result", [](QueryResultsStore<scan_page_tuple<std::string, ObjectWithStringKey>, py::dict>& qrs) {
+                        return qrs.get_result();
+                    },
+                    "Get result from QueryResultsStore for a scan page.");
     py::class_<QueryResultsStore<uint64_t,uint64_t>>(m, "QueryResultsStoreSize")
             .def(
                     "get_result", [](QueryResultsStore<uint64_t,uint64_t>& qrs) {
@@ -25,11 +25,12 @@ int main(int argc, char** argv) {
     CascadeServiceCDPO<PersistentCascadeStoreWithStringKey> cdpo_pcss;
     CascadeServiceCDPO<TriggerCascadeNoStoreWithStringKey> cdpo_tcss;
 
-    auto meta_factory = [](persistent::PersistentRegistry* pr, derecho::subgroup_id_t, ICascadeContext* context_ptr) {
-        // critical data path for metadata service is currently disabled. But we can leverage it later for object pool
-        // metadata handling.
+    CascadeMetadataServiceCDPO<VolatileCascadeStoreWithStringKey, PersistentCascadeStoreWithStringKey, TriggerCascadeNoStoreWithStringKey> cdpo_meta;
+
+    auto meta_factory = [&cdpo_meta](persistent::PersistentRegistry* pr, derecho::subgroup_id_t, ICascadeContext* context_ptr) {
+        // the critical data path of the metadata service pushes object pool metadata deltas to the clients.
         return std::make_unique<CascadeMetadataService<VolatileCascadeStoreWithStringKey, PersistentCascadeStoreWithStringKey, TriggerCascadeNoStoreWithStringKey>>(
-                pr, nullptr, context_ptr);
+                pr, &cdpo_meta, context_ptr);
     };
     auto vcss_factory = [&cdpo_vcss](persistent::PersistentRegistry*, derecho::subgroup_id_t, ICascadeContext* context_ptr) {
         return std::make_unique<VolatileCascadeStoreWithStringKey>(&cdpo_vcss, context_ptr);
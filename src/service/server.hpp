@@ -6,8 +6,18 @@
 #include <cascade/service_types.hpp>
 #include <cascade/utils.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #ifndef NDEBUG
 inline void dump_layout(const json& layout) {
@@ -26,6 +36,85 @@ inline void dump_layout(const json& layout) {
 using derecho::cascade::CriticalDataPathObserver;
 using derecho::cascade::ICascadeContext;
 
+/**
+ * The capacity of the queue of a SubscriberNotifier.
+ */
+#define SUBSCRIBER_NOTIFIER_QUEUE_CAPACITY (65536)
+
+/**
+ * A thread sending the notifications of a CDPO to the subscribed external clients, so that the predicate thread only
+ * queues them and never waits for a p2p send. The notifications are sent in the order they are queued. If the queue is
+ * full, a new notification is dropped.
+ */
+class SubscriberNotifier {
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<std::function<void()>> queue;
+    bool stopping = false;
+    uint64_t num_dropped = 0;
+    std::once_flag thread_flag;
+    std::thread thread;
+
+    void run() {
+        pthread_setname_np(pthread_self(), "cs_notifier");
+        std::unique_lock<std::mutex> lck(queue_mutex);
+        while(true) {
+            queue_cv.wait(lck, [this]() { return stopping || !queue.empty(); });
+            if(stopping) {
+                break;
+            }
+            auto notification = std::move(queue.front());
+            queue.pop_front();
+            lck.unlock();
+            try {
+                notification();
+            } catch(std::exception& ex) {
+                dbg_default_warn("Failed to send a notification to the subscribers:{}", ex.what());
+            }
+            lck.lock();
+        }
+    }
+
+public:
+    /**
+     * Queue a notification, starting the thread on first use.
+     *
+     * @param[in] notification  Sends the notification. It handles its own send failures.
+     */
+    void post(std::function<void()>&& notification) {
+        std::call_once(thread_flag, [this]() {
+            thread = std::thread(&SubscriberNotifier::run, this);
+        });
+        {
+            std::lock_guard<std::mutex> lck(queue_mutex);
+            if(queue.size() >= SUBSCRIBER_NOTIFIER_QUEUE_CAPACITY) {
+                if((num_dropped++ % SUBSCRIBER_NOTIFIER_QUEUE_CAPACITY) == 0) {
+                    dbg_default_warn("The subscriber notification queue is full. {} notifications dropped so far.",
+                                     num_dropped);
+                }
+                return;
+            }
+            queue.emplace_back(std::move(notification));
+        }
+        queue_cv.notify_one();
+    }
+
+    /**
+     * Destructor
+     * Stops the thread. The notifications still queued are dropped, since the service is shut down already.
+     */
+    virtual ~SubscriberNotifier() {
+        {
+            std::lock_guard<std::mutex> lck(queue_mutex);
+            stopping = true;
+        }
+        queue_cv.notify_one();
+        if(thread.joinable()) {
+            thread.join();
+        }
+    }
+};
+
 /**
  * Define the CDPO
  * @tparam CascadeType  the subgroup type
@@ -34,13 +123,92 @@ using derecho::cascade::ICascadeContext;
  */
 template <typename CascadeType>
 class CascadeServiceCDPO : public CriticalDataPathObserver<CascadeType> {
-    virtual void operator()(const uint32_t sgidx,
-                            const uint32_t shidx,
-                            const derecho::node_id_t sender_id,
-                            const typename CascadeType::KeyType& key,
-                            const typename CascadeType::ObjectType& value,
-                            ICascadeContext* cascade_ctxt,
-                            bool is_trigger = false) override {
+    /**
+     * The external clients subscribed to the cache invalidations of this node's shard, by subgroup index. A client
+     * subscribes with a trigger_put of CACHE_INVALIDATION_SUBSCRIPTION_KEY, and is sent the key and the new version of
+     * every update or removal applied on this node from then on, by the notifier thread. A client that cannot be
+     * reached is unsubscribed. The invalidations are best effort: a lost one is covered by the staleness bound every
+     * client read cache has.
+     */
+    std::mutex cache_subscribers_mutex;
+    std::unordered_map<uint32_t, std::unordered_set<derecho::node_id_t>> cache_subscribers;
+    std::atomic<bool> has_cache_subscribers{false};
+    SubscriberNotifier cache_notifier;
+
+    /**
+     * The members of the shards this node applies ordered puts for, with the view they are read in, keyed by subgroup
+     * and shard index. A member list is read again only for an update in a new view, so that dispatching an update to
+     * the observers registered with the ONE shard dispatcher does not copy it.
+     */
+    struct shard_members_t {
+        uint64_t view_id = UINT64_MAX;
+        std::vector<derecho::node_id_t> members;
+    };
+    std::mutex shard_members_mutex;
+    std::unordered_map<uint64_t, shard_members_t> shard_members;
+
+    /**
+     * Test if this node is the shard member a key is hashed to.
+     *
+     * @param[in]   version     The version of the update, whose upper 32 bits are the view id.
+     */
+    template <typename ServiceClientType>
+    bool is_hashed_member(ServiceClientType& service_client,
+                          const uint32_t sgidx,
+                          const uint32_t shidx,
+                          const std::string& key,
+                          const persistent::version_t& version) {
+        uint64_t view_id = static_cast<uint64_t>(version) >> 32;
+        std::lock_guard<std::mutex> lck(shard_members_mutex);
+        auto& cached = shard_members[(static_cast<uint64_t>(sgidx) << 32) | shidx];
+        if(cached.view_id != view_id) {
+            cached.members = service_client.template get_shard_members<CascadeType>(sgidx, shidx);
+            cached.view_id = view_id;
+        }
+        return !cached.members.empty() &&
+               cached.members[std::hash<std::string>{}(key) % cached.members.size()] == service_client.get_my_id();
+    }
+
+    template <typename ServiceClientType>
+    void notify_cache_subscribers(ServiceClientType& service_client,
+                                  const uint32_t sgidx,
+                                  const std::string& key,
+                                  const persistent::version_t& version) {
+        std::vector<derecho::node_id_t> clients;
+        {
+            std::lock_guard<std::mutex> lck(cache_subscribers_mutex);
+            auto it = cache_subscribers.find(sgidx);
+            if(it == cache_subscribers.end()) {
+                return;
+            }
+            clients.assign(it->second.cbegin(), it->second.cend());
+        }
+        for(const auto client : clients) {
+            try {
+                service_client.template notify_cache_invalidation<CascadeType>(key, version, sgidx, client);
+            } catch(derecho::derecho_exception& ex) {
+                dbg_default_warn("Failed to send the cache invalidation of {} to client {}:{}. Unsubscribe it.",
+                                 key, client, ex.what());
+                std::lock_guard<std::mutex> lck(cache_subscribers_mutex);
+                cache_subscribers[sgidx].erase(client);
+            }
+        }
+    }
+
+    /**
+     * Post the actions of the UDLs matching an update.
+     *
+     * @param[in]   share_value     The function returning a shared handle to the value held by the store, or nullptr
+     *                              if there is none, in which case the value is copied for the actions.
+     */
+    void dispatch(const uint32_t sgidx,
+                  const uint32_t shidx,
+                  const derecho::node_id_t sender_id,
+                  const typename CascadeType::KeyType& key,
+                  const typename CascadeType::ObjectType& value,
+                  const typename CriticalDataPathObserver<CascadeType>::share_value_func_t* share_value,
+                  ICascadeContext* cascade_ctxt,
+                  bool is_trigger) {
         if constexpr(std::is_convertible<typename CascadeType::KeyType, std::string>::value) {
             using namespace derecho::cascade;
 
@@ -49,112 +217,181 @@ class CascadeServiceCDPO : public CriticalDataPathObserver<CascadeType> {
                             VolatileCascadeStoreWithStringKey,
                             PersistentCascadeStoreWithStringKey,
                             TriggerCascadeNoStoreWithStringKey>*>(cascade_ctxt);
-            size_t pos = key.rfind(PATH_SEPARATOR);
-            std::string prefix;
-            if(pos != std::string::npos) {
-                // important: we need to keep the trailing PATH_SEPARATOR
-                prefix = key.substr(0, pos + 1);
-            }
-            auto handlers = engine->get_prefix_handlers(prefix);
-            if(handlers.empty()) {
+            if(is_trigger && key == CACHE_INVALIDATION_SUBSCRIPTION_KEY) {
+                std::lock_guard<std::mutex> lck(cache_subscribers_mutex);
+                cache_subscribers[sgidx].emplace(sender_id);
+                has_cache_subscribers.store(true, std::memory_order_release);
+                dbg_default_debug("client {} subscribed to the cache invalidations of shard {}/{}.", sender_id, sgidx, shidx);
                 return;
             }
-            // filter for normal put (put/put_and_forget)
-            bool new_actions = false;
-            bool has_mproc_udl = false;
-            {
-                auto shard_members = engine->get_service_client_ref().template get_shard_members<CascadeType>(sgidx, shidx);
-                bool icare = (shard_members[std::hash<std::string>{}(key) % shard_members.size()] == engine->get_service_client_ref().get_my_id());
-                for(auto& per_prefix : handlers) {
-                    // per_prefix.first is the matching prefix
-                    // per_prefix.second is an object of prefix_entry_t
-                    for(auto& dfg_ocdpos : per_prefix.second) {
-                        // dfg_ocdpos.first is dfg_id
-                        // dfg_ocdpos.second is a set of ocdpo info object of type prefix_ocdpo_info_t.
-                        for(auto oiit = dfg_ocdpos.second.begin(); oiit != dfg_ocdpos.second.end();) {
-                            if((oiit->hook != DataFlowGraph::VertexHook::BOTH) && (
-                                (oiit->hook == DataFlowGraph::VertexHook::ORDERED_PUT && is_trigger) || 
-                                (oiit->hook == DataFlowGraph::VertexHook::TRIGGER_PUT && !is_trigger))) {
-                                // not my hook, skip it.
-                                oiit = dfg_ocdpos.second.erase(oiit);
-                            } else if (is_trigger) {
-                                new_actions = true;
-                                if (oiit->execution_environment != 
-                                    DataFlowGraph::VertexExecutionEnvironment::PTHREAD) {
-                                    has_mproc_udl = true;
-                                }
-                                oiit++;
-                            } else {
-                                // matched ordered put data path
-                                // test dispatcher:
-                                switch(oiit->shard_dispatcher) {
-                                    case DataFlowGraph::VertexShardDispatcher::ONE:
-                                        if(icare) {
-                                            new_actions = true;
-                                            oiit++;
-                                        } else {
-                                            oiit = dfg_ocdpos.second.erase(oiit);
-                                        }
-                                        break;
-                                    case DataFlowGraph::VertexShardDispatcher::ALL:
-                                        new_actions = true;
-                                        oiit++;
-                                        break;
-                                    default:
-                                        // unknown dispatcher.
-                                        oiit = dfg_ocdpos.second.erase(oiit);
-                                        break;
-                                }
-                            }
-                        }
-                    }
+            if(!is_trigger && has_cache_subscribers.load(std::memory_order_acquire)) {
+                // the p2p sends happen in the notifier thread, off the predicate thread.
+                auto& service_client = engine->get_service_client_ref();
+                cache_notifier.post([this, &service_client, sgidx, key = std::string(key), version = value.get_version()]() {
+                    notify_cache_subscribers(service_client, sgidx, key, version);
+                });
+            }
+            // the plan is pre-filtered by hook and shard dispatcher, and built when the prefixes are registered; looking
+            // it up and iterating it allocates nothing.
+            auto plan = engine->get_dispatch_plan(key);
+            const std::vector<prefix_dispatch_target_t>* target_lists[2] = {nullptr, nullptr};
+            if(is_trigger) {
+                target_lists[0] = &plan->trigger_put_targets;
+            } else {
+                target_lists[0] = &plan->ordered_put_targets_for_all;
+                if(!plan->ordered_put_targets_for_one.empty()
+                   && is_hashed_member(engine->get_service_client_ref(), sgidx, shidx, key, value.get_version())) {
+                    target_lists[1] = &plan->ordered_put_targets_for_one;
                 }
             }
+            bool new_actions = false;
+            for(const auto* targets : target_lists) {
+                new_actions = new_actions || (targets != nullptr && !targets->empty());
+            }
             if(!new_actions) {
                 return;
             }
-            // copy data TODO: test has_mproc_udl, if has_mproc_udl == true, copy it to shared space,
-            // otherwise, use simple make_shared() call.
-            auto value_ptr = std::make_shared<typename CascadeType::ObjectType>(value);
-            // create actions
-            for(auto& per_prefix : handlers) {
-                // per_prefix.first is the matching prefix
-                // per_prefix.second is an object of prefix_entry_t
-                for(const auto& dfg_ocdpos : per_prefix.second) {
-                    // dfg_ocdpos.first is dfg_id
-                    // dfg_ocdpos.second is a set of ocdpo info object of type prefix_ocdpo_info_t.
-                    for (const auto& oi : dfg_ocdpos.second) {
-                        Action action(
-                                sender_id,
-                                key,
-                                per_prefix.first.size(),
-                                value.get_version(),
-                                oi.ocdpo,  // ocdpo
-                                value_ptr,
-                                oi.output_map  // outputs
-                        );
-    
-#ifdef ENABLE_EVALUATION
-                        ActionPostExtraInfo apei;
-                        apei.uint64_val = 0;
-                        apei.info.is_trigger = is_trigger;
-#endif
-    
+            // share the value held by the store if there is one, otherwise copy it.
+            // TODO: test plan->has_mproc_udl_for_trigger_put, if it is true, copy it to shared space.
+            std::shared_ptr<const typename CascadeType::ObjectType> value_ptr;
+            if(share_value != nullptr && engine->is_sharing_stored_values()) {
+                value_ptr = (*share_value)();
+            }
+            if(!value_ptr) {
+                value_ptr = std::make_shared<const typename CascadeType::ObjectType>(value);
+            }
+            // create actions, which share the value and the outputs; each of them copies the key.
+            for(const auto* targets : target_lists) {
+                if(targets == nullptr) {
+                    continue;
+                }
+                for(const auto& target : *targets) {
+                    const auto& oi = *target.info;
+                    Action action(
+                            sender_id,
+                            key,
+                            target.prefix_length,
+                            value.get_version(),
+                            oi.ocdpo,  // ocdpo
+                            value_ptr,
+                            oi.output_map,  // outputs, shared
+                            oi.batching
+                    );
+
 #ifdef ENABLE_EVALUATION
-                        apei.info.stateful = oi.statefulness;
+                    ActionPostExtraInfo apei;
+                    apei.uint64_val = 0;
+                    apei.info.is_trigger = is_trigger;
+                    apei.info.stateful = oi.statefulness;
 #endif
-                        TimestampLogger::log(TLT_ACTION_POST_START,
-                                             engine->get_service_client_ref().get_my_id(),
-                                             dynamic_cast<const IHasMessageID*>(&value)->get_message_id(),
-                                             apei.uint64_val);
-                        engine->post(std::move(action), oi.statefulness, is_trigger);
-                        TimestampLogger::log(TLT_ACTION_POST_END,
-                                             engine->get_service_client_ref().get_my_id(),
-                                             dynamic_cast<const IHasMessageID*>(&value)->get_message_id(),
-                                             apei.uint64_val);
-                    }
+                    TimestampLogger::log(TLT_ACTION_POST_START,
+                                         engine->get_service_client_ref().get_my_id(),
+                                         dynamic_cast<const IHasMessageID*>(&value)->get_message_id(),
+                                         apei.uint64_val);
+                    engine->post(std::move(action), oi.statefulness, is_trigger);
+                    TimestampLogger::log(TLT_ACTION_POST_END,
+                                         engine->get_service_client_ref().get_my_id(),
+                                         dynamic_cast<const IHasMessageID*>(&value)->get_message_id(),
+                                         apei.uint64_val);
                 }
             }
         }
     }
+
+    virtual void operator()(const uint32_t sgidx,
+                            const uint32_t shidx,
+                            const derecho::node_id_t sender_id,
+                            const typename CascadeType::KeyType& key,
+                            const typename CascadeType::ObjectType& value,
+                            ICascadeContext* cascade_ctxt,
+                            bool is_trigger = false) override {
+        dispatch(sgidx, shidx, sender_id, key, value, nullptr, cascade_ctxt, is_trigger);
+    }
+
+    virtual void observe_shared(const uint32_t sgidx,
+                                const uint32_t shidx,
+                                const derecho::node_id_t sender_id,
+                                const typename CascadeType::KeyType& key,
+                                const typename CascadeType::ObjectType& value,
+                                const typename CriticalDataPathObserver<CascadeType>::share_value_func_t& share_value,
+                                ICascadeContext* cascade_ctxt) override {
+        dispatch(sgidx, shidx, sender_id, key, value, &share_value, cascade_ctxt, false);
+    }
+};
+
+/**
+ * Define the CDPO of the metadata service, which pushes object pool metadata deltas to the subscribed external clients.
+ * An external client subscribes with a trigger_put of METADATA_SERVICE_SUBSCRIPTION_KEY to every member of every
+ * metadata service shard. From then on, every object pool metadata update or removal applied on this node is sent to
+ * it by the notifier thread, as a notification carrying the versioned metadata object. A client that cannot be reached
+ * is unsubscribed; the client subscribes again with its next metadata refresh.
+ *
+ * @tparam CascadeTypes     the subgroup types
+ */
+template <typename... CascadeTypes>
+class CascadeMetadataServiceCDPO : public CriticalDataPathObserver<derecho::cascade::CascadeMetadataService<CascadeTypes...>> {
+    std::mutex subscribers_mutex;
+    std::unordered_set<derecho::node_id_t> subscribers;
+    SubscriberNotifier notifier;
+
+    template <typename ServiceClientType>
+    void notify_subscribers(ServiceClientType& service_client,
+                            const uint32_t sgidx,
+                            const std::string& key,
+                            const derecho::cascade::ObjectPoolMetadata<CascadeTypes...>& value) {
+        using namespace derecho::cascade;
+        std::vector<derecho::node_id_t> clients;
+        {
+            std::lock_guard<std::mutex> lck(subscribers_mutex);
+            clients.assign(subscribers.cbegin(), subscribers.cend());
+        }
+        std::vector<uint8_t> buffer(mutils::bytes_size(value));
+        mutils::to_bytes(value, buffer.data());
+        Blob delta(buffer.data(), buffer.size());
+        for(const auto client : clients) {
+            try {
+                service_client.template notify<CascadeMetadataService<CascadeTypes...>>(delta, sgidx, client);
+            } catch(derecho::derecho_exception& ex) {
+                dbg_default_warn("Failed to push the object pool metadata delta of {} to client {}:{}. Unsubscribe it.",
+                                 key, client, ex.what());
+                std::lock_guard<std::mutex> lck(subscribers_mutex);
+                subscribers.erase(client);
+            }
+        }
+    }
+
+    virtual void operator()(const uint32_t sgidx,
+                            const uint32_t shidx,
+                            const derecho::node_id_t sender_id,
+                            const std::string& key,
+                            const derecho::cascade::ObjectPoolMetadata<CascadeTypes...>& value,
+                            ICascadeContext* cascade_ctxt,
+                            bool is_trigger = false) override {
+        using namespace derecho::cascade;
+        if(is_trigger) {
+            if(key == METADATA_SERVICE_SUBSCRIPTION_KEY) {
+                std::lock_guard<std::mutex> lck(subscribers_mutex);
+                subscribers.emplace(sender_id);
+                dbg_default_debug("client {} subscribed to the object pool metadata deltas of shard {}.", sender_id, shidx);
+            }
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lck(subscribers_mutex);
+            if(subscribers.empty()) {
+                return;
+            }
+        }
+        auto* engine = dynamic_cast<ExecutionEngine<CascadeTypes...>*>(cascade_ctxt);
+        if(engine == nullptr) {
+            dbg_default_error("{}: the cascade context is not an ExecutionEngine. The delta of {} is not pushed.",
+                              __PRETTY_FUNCTION__, key);
+            return;
+        }
+        // the serialization and the p2p sends happen in the notifier thread, off the predicate thread.
+        auto& service_client = engine->get_service_client_ref();
+        notifier.post([this, &service_client, sgidx, key, value]() {
+            notify_subscribers(service_client, sgidx, key, value);
+        });
+    }
 };
@@ -28,6 +28,12 @@ std::ostream& operator<<(std::ostream& stream, const ShardMemberSelectionPolicy&
         case ShardMemberSelectionPolicy::UserSpecified:
             stream << "UserSpecified";
             break;
+        case ShardMemberSelectionPolicy::LeastOutstandingRequests:
+            stream << "LeastOutstandingRequests";
+            break;
+        case ShardMemberSelectionPolicy::PowerOfTwoChoices:
+            stream << "PowerOfTwoChoices";
+            break;
         case ShardMemberSelectionPolicy::InvalidPolicy:
         default:
             stream << "InvalidPolicy";